@@ -33,9 +33,12 @@
 #include "WebCoreArgumentCoders.h"
 #include "WebIDBConnectionToServerMessages.h"
 #include "WebIDBResult.h"
+#include "WebIDBValue.h"
 #include <WebCore/IDBError.h>
 #include <WebCore/IDBGetAllRecordsData.h>
 #include <WebCore/IDBGetRecordData.h>
+#include <WebCore/IDBGetResult.h>
+#include <WebCore/IDBIterateCursorData.h>
 #include <WebCore/IDBResultData.h>
 #include <WebCore/IDBValue.h>
 #include <WebCore/ThreadSafeDataBuffer.h>
@@ -45,6 +48,11 @@ using namespace WebCore;
 
 namespace WebKit {
 
+// A prefetch batch stops growing once its values add up to this many bytes, so cursors over large
+// records get short batches and cursors over small records get long ones.
+static const size_t maximumPrefetchedBytes = 256 * 1024;
+static const uint32_t maximumPrefetchCount = 128;
+
 Ref<WebIDBConnectionToClient> WebIDBConnectionToClient::create(DatabaseToWebProcessConnection& connection, uint64_t serverConnectionIdentifier, WebCore::SessionID sessionID)
 {
     return adoptRef(*new WebIDBConnectionToClient(connection, serverConnectionIdentifier, sessionID));
@@ -66,6 +74,7 @@ WebIDBConnectionToClient::~WebIDBConnectionToClient()
 
 void WebIDBConnectionToClient::disconnectedFromWebProcess()
 {
+    m_cursorPrefetches.clear();
     DatabaseProcess::singleton().idbServer(m_sessionID).unregisterConnection(*m_connectionToClient);
 }
 
@@ -91,11 +100,13 @@ void WebIDBConnectionToClient::didOpenDatabase(const WebCore::IDBResultData& res
 
 void WebIDBConnectionToClient::didAbortTransaction(const WebCore::IDBResourceIdentifier& transactionIdentifier, const WebCore::IDBError& error)
 {
+    sendPendingCursorPrefetches(transactionIdentifier);
     send(Messages::WebIDBConnectionToServer::DidAbortTransaction(transactionIdentifier, error));
 }
 
 void WebIDBConnectionToClient::didCommitTransaction(const WebCore::IDBResourceIdentifier& transactionIdentifier, const WebCore::IDBError& error)
 {
+    sendPendingCursorPrefetches(transactionIdentifier);
     send(Messages::WebIDBConnectionToServer::DidCommitTransaction(transactionIdentifier, error));
 }
 
@@ -194,7 +205,71 @@ void WebIDBConnectionToClient::didOpenCursor(const WebCore::IDBResultData& resul
 
 void WebIDBConnectionToClient::didIterateCursor(const WebCore::IDBResultData& resultData)
 {
-    handleGetResult<Messages::WebIDBConnectionToServer::DidIterateCursor>(resultData);
+    auto iterator = m_cursorPrefetches.find(resultData.requestIdentifier());
+    if (iterator == m_cursorPrefetches.end()) {
+        sendIterateCursorResult(resultData, { });
+        return;
+    }
+
+    auto& prefetch = iterator->value;
+    bool isError = resultData.type() == IDBResultType::Error;
+    if (!prefetch.result)
+        prefetch.result = resultData;
+    else if (!isError) {
+        if (auto* data = resultData.getResult().value().data().data())
+            prefetch.prefetchedBytes += data->size();
+        prefetch.prefetchedResults.append(resultData);
+    }
+
+    // A failed prefetch is dropped rather than reported; the WebProcess will run into the same
+    // error when it asks for that record itself.
+    bool reachedEnd = isError || resultData.getResult().keyData().isNull();
+    if (!reachedEnd && prefetch.prefetchedResults.size() < prefetch.prefetchCount && prefetch.prefetchedBytes < maximumPrefetchedBytes) {
+        IDBIterateCursorData data;
+        data.count = 1;
+        DatabaseProcess::singleton().idbServer(m_sessionID).iterateCursor(prefetch.requestData, data);
+        return;
+    }
+
+    auto finishedPrefetch = WTFMove(iterator->value);
+    m_cursorPrefetches.remove(iterator);
+    sendIterateCursorResult(*finishedPrefetch.result, WTFMove(finishedPrefetch.prefetchedResults));
+}
+
+void WebIDBConnectionToClient::sendIterateCursorResult(const WebCore::IDBResultData& resultData, Vector<WebCore::IDBResultData>&& prefetchedResults)
+{
+    WebIDBResult result(resultData, WTFMove(prefetchedResults));
+    auto blobFilePaths = result.blobFilePaths();
+    if (blobFilePaths.isEmpty()) {
+        send(Messages::WebIDBConnectionToServer::DidIterateCursor(result));
+        return;
+    }
+
+#if ENABLE(SANDBOX_EXTENSIONS)
+    RefPtr<WebIDBConnectionToClient> protector(this);
+    DatabaseProcess::singleton().getSandboxExtensionsForBlobFiles(blobFilePaths, [protector, this, resultData, prefetchedResults = result.prefetchedResults()](SandboxExtension::HandleArray&& handles) mutable {
+        send(Messages::WebIDBConnectionToServer::DidIterateCursor({ resultData, WTFMove(prefetchedResults), WTFMove(handles) }));
+    });
+#else
+    send(Messages::WebIDBConnectionToServer::DidIterateCursor(result));
+#endif
+}
+
+void WebIDBConnectionToClient::sendPendingCursorPrefetches(const WebCore::IDBResourceIdentifier& transactionIdentifier)
+{
+    // Once the transaction is over the server will not answer any more prefetch iterations, so send
+    // whatever has been gathered so far ahead of the transaction result.
+    Vector<CursorPrefetch> finishedPrefetches;
+    m_cursorPrefetches.removeIf([&](auto& entry) {
+        if (entry.value.requestData.transactionIdentifier() != transactionIdentifier)
+            return false;
+        if (entry.value.result)
+            finishedPrefetches.append(WTFMove(entry.value));
+        return true;
+    });
+
+    for (auto& prefetch : finishedPrefetches)
+        sendIterateCursorResult(*prefetch.result, WTFMove(prefetch.prefetchedResults));
 }
 
 void WebIDBConnectionToClient::fireVersionChangeEvent(WebCore::IDBServer::UniqueIDBDatabaseConnection& connection, const WebCore::IDBResourceIdentifier& requestIdentifier, uint64_t requestedVersion)
@@ -282,7 +357,7 @@ void WebIDBConnectionToClient::renameIndex(const IDBRequestData& request, uint64
     DatabaseProcess::singleton().idbServer(m_sessionID).renameIndex(request, objectStoreIdentifier, indexIdentifier, newName);
 }
 
-void WebIDBConnectionToClient::putOrAdd(const IDBRequestData& request, const IDBKeyData& key, const IDBValue& value, unsigned overwriteMode)
+void WebIDBConnectionToClient::putOrAdd(const IDBRequestData& request, const IDBKeyData& key, const WebIDBValue& value, unsigned overwriteMode)
 {
     if (overwriteMode != static_cast<unsigned>(IndexedDB::ObjectStoreOverwriteMode::NoOverwrite)
         && overwriteMode != static_cast<unsigned>(IndexedDB::ObjectStoreOverwriteMode::Overwrite)
@@ -294,7 +369,7 @@ void WebIDBConnectionToClient::putOrAdd(const IDBRequestData& request, const IDB
 
     IndexedDB::ObjectStoreOverwriteMode mode = static_cast<IndexedDB::ObjectStoreOverwriteMode>(overwriteMode);
 
-    DatabaseProcess::singleton().idbServer(m_sessionID).putOrAdd(request, key, value, mode);
+    DatabaseProcess::singleton().idbServer(m_sessionID).putOrAdd(request, key, value.value(), mode);
 }
 
 void WebIDBConnectionToClient::getRecord(const IDBRequestData& request, const IDBGetRecordData& getRecordData)
@@ -322,8 +397,11 @@ void WebIDBConnectionToClient::openCursor(const IDBRequestData& request, const I
     DatabaseProcess::singleton().idbServer(m_sessionID).openCursor(request, info);
 }
 
-void WebIDBConnectionToClient::iterateCursor(const IDBRequestData& request, const IDBIterateCursorData& data)
+void WebIDBConnectionToClient::iterateCursor(const IDBRequestData& request, const IDBIterateCursorData& data, uint32_t prefetchCount)
 {
+    if (prefetchCount)
+        m_cursorPrefetches.set(request.requestIdentifier(), CursorPrefetch { request, std::min(prefetchCount, maximumPrefetchCount) });
+
     DatabaseProcess::singleton().idbServer(m_sessionID).iterateCursor(request, data);
 }
 
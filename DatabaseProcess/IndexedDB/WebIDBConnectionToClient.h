@@ -30,16 +30,18 @@
 #include "DatabaseToWebProcessConnection.h"
 #include "MessageSender.h"
 #include <WebCore/IDBConnectionToClient.h>
+#include <WebCore/IDBRequestData.h>
+#include <WebCore/IDBResourceIdentifier.h>
+#include <WebCore/IDBResultData.h>
 #include <WebCore/SessionID.h>
+#include <wtf/HashMap.h>
 
 namespace WebCore {
 class IDBCursorInfo;
 class IDBIndexInfo;
 class IDBKeyData;
 class IDBObjectStoreInfo;
-class IDBRequestData;
 class IDBTransactionInfo;
-class IDBValue;
 class SerializedScriptValue;
 struct IDBGetAllRecordsData;
 struct IDBGetRecordData;
@@ -50,6 +52,8 @@ struct SecurityOriginData;
 
 namespace WebKit {
 
+class WebIDBValue;
+
 class WebIDBConnectionToClient final : public WebCore::IDBServer::IDBConnectionToClientDelegate, public IPC::MessageSender, public RefCounted<WebIDBConnectionToClient> {
 public:
     static Ref<WebIDBConnectionToClient> create(DatabaseToWebProcessConnection&, uint64_t serverConnectionIdentifier, WebCore::SessionID);
@@ -103,13 +107,13 @@ public:
     void createIndex(const WebCore::IDBRequestData&, const WebCore::IDBIndexInfo&);
     void deleteIndex(const WebCore::IDBRequestData&, uint64_t objectStoreIdentifier, const String& indexName);
     void renameIndex(const WebCore::IDBRequestData&, uint64_t objectStoreIdentifier, uint64_t indexIdentifier, const String& newName);
-    void putOrAdd(const WebCore::IDBRequestData&, const WebCore::IDBKeyData&, const WebCore::IDBValue&, unsigned overwriteMode);
+    void putOrAdd(const WebCore::IDBRequestData&, const WebCore::IDBKeyData&, const WebIDBValue&, unsigned overwriteMode);
     void getRecord(const WebCore::IDBRequestData&, const WebCore::IDBGetRecordData&);
     void getAllRecords(const WebCore::IDBRequestData&, const WebCore::IDBGetAllRecordsData&);
     void getCount(const WebCore::IDBRequestData&, const WebCore::IDBKeyRangeData&);
     void deleteRecord(const WebCore::IDBRequestData&, const WebCore::IDBKeyRangeData&);
     void openCursor(const WebCore::IDBRequestData&, const WebCore::IDBCursorInfo&);
-    void iterateCursor(const WebCore::IDBRequestData&, const WebCore::IDBIterateCursorData&);
+    void iterateCursor(const WebCore::IDBRequestData&, const WebCore::IDBIterateCursorData&, uint32_t prefetchCount);
 
     void establishTransaction(uint64_t databaseConnectionIdentifier, const WebCore::IDBTransactionInfo&);
     void databaseConnectionPendingClose(uint64_t databaseConnectionIdentifier);
@@ -132,11 +136,24 @@ private:
 
     template<class MessageType> void handleGetResult(const WebCore::IDBResultData&);
 
+    struct CursorPrefetch {
+        WebCore::IDBRequestData requestData;
+        uint32_t prefetchCount { 0 };
+        size_t prefetchedBytes { 0 };
+        std::optional<WebCore::IDBResultData> result;
+        Vector<WebCore::IDBResultData> prefetchedResults;
+    };
+    void sendIterateCursorResult(const WebCore::IDBResultData&, Vector<WebCore::IDBResultData>&& prefetchedResults);
+    void sendPendingCursorPrefetches(const WebCore::IDBResourceIdentifier& transactionIdentifier);
+
     Ref<DatabaseToWebProcessConnection> m_connection;
 
     uint64_t m_identifier;
     WebCore::SessionID m_sessionID;
     RefPtr<WebCore::IDBServer::IDBConnectionToClient> m_connectionToClient;
+
+    // Keyed by the identifier of the iterate request that asked for the prefetch.
+    HashMap<WebCore::IDBResourceIdentifier, CursorPrefetch> m_cursorPrefetches;
 };
 
 } // namespace WebKit
@@ -44,8 +44,10 @@
 #include "NetworkSocketStreamMessages.h"
 #include "RemoteNetworkingContext.h"
 #include "SessionTracker.h"
+#include "WebCookieManager.h"
 #include "WebCoreArgumentCoders.h"
 #include "WebsiteDataStoreParameters.h"
+#include <WebCore/Cookie.h>
 #include <WebCore/NetworkStorageSession.h>
 #include <WebCore/PingHandle.h>
 #include <WebCore/PlatformCookieJar.h>
@@ -299,9 +301,40 @@ void NetworkConnectionToWebProcess::convertMainResourceLoadToDownload(SessionID
     loader->convertToDownload(downloadID, request, response);
 }
 
-void NetworkConnectionToWebProcess::cookiesForDOM(SessionID sessionID, const URL& firstParty, const URL& url, String& result)
+static bool canCacheCookiesInWebProcess(const NetworkStorageSession& session, SessionID sessionID)
 {
-    result = WebCore::cookiesForDOM(storageSession(sessionID), firstParty, url);
+    // storageSession() may have fallen back to the default session, whose change notifications would not reach a cache keyed by sessionID.
+    if (session.sessionID() != sessionID)
+        return false;
+
+    return NetworkProcess::singleton().supplement<WebCookieManager>()->observeCookieChangesForWebProcesses(sessionID);
+}
+
+// Returns the time, in milliseconds since the epoch, until which a cookie string for this URL can be served
+// from the web process cache. Change notifications do not cover expiration, so this is bounded by the
+// earliest expiring cookie.
+static std::optional<double> cookieCacheExpirationTime(const NetworkStorageSession& session, SessionID sessionID, const URL& firstParty, const URL& url)
+{
+    if (!canCacheCookiesInWebProcess(session, sessionID))
+        return std::nullopt;
+
+    Vector<Cookie> cookies;
+    if (!WebCore::getRawCookies(session, firstParty, url, cookies))
+        return std::nullopt;
+
+    double expirationTime = std::numeric_limits<double>::infinity();
+    for (auto& cookie : cookies) {
+        if (!cookie.session)
+            expirationTime = std::min(expirationTime, cookie.expires);
+    }
+    return expirationTime;
+}
+
+void NetworkConnectionToWebProcess::cookiesForDOM(SessionID sessionID, const URL& firstParty, const URL& url, String& result, std::optional<double>& cacheExpirationTime)
+{
+    auto& session = storageSession(sessionID);
+    result = WebCore::cookiesForDOM(session, firstParty, url);
+    cacheExpirationTime = cookieCacheExpirationTime(session, sessionID, firstParty, url);
 }
 
 void NetworkConnectionToWebProcess::setCookiesFromDOM(SessionID sessionID, const URL& firstParty, const URL& url, const String& cookieString)
@@ -309,14 +342,18 @@ void NetworkConnectionToWebProcess::setCookiesFromDOM(SessionID sessionID, const
     WebCore::setCookiesFromDOM(storageSession(sessionID), firstParty, url, cookieString);
 }
 
-void NetworkConnectionToWebProcess::cookiesEnabled(SessionID sessionID, const URL& firstParty, const URL& url, bool& result)
+void NetworkConnectionToWebProcess::cookiesEnabled(SessionID sessionID, const URL& firstParty, const URL& url, bool& result, bool& isCacheable)
 {
-    result = WebCore::cookiesEnabled(storageSession(sessionID), firstParty, url);
+    auto& session = storageSession(sessionID);
+    result = WebCore::cookiesEnabled(session, firstParty, url);
+    isCacheable = canCacheCookiesInWebProcess(session, sessionID);
 }
 
-void NetworkConnectionToWebProcess::cookieRequestHeaderFieldValue(SessionID sessionID, const URL& firstParty, const URL& url, String& result)
+void NetworkConnectionToWebProcess::cookieRequestHeaderFieldValue(SessionID sessionID, const URL& firstParty, const URL& url, String& result, std::optional<double>& cacheExpirationTime)
 {
-    result = WebCore::cookieRequestHeaderFieldValue(storageSession(sessionID), firstParty, url);
+    auto& session = storageSession(sessionID);
+    result = WebCore::cookieRequestHeaderFieldValue(session, firstParty, url);
+    cacheExpirationTime = cookieCacheExpirationTime(session, sessionID, firstParty, url);
 }
 
 void NetworkConnectionToWebProcess::getRawCookies(SessionID sessionID, const URL& firstParty, const URL& url, Vector<Cookie>& result)
@@ -35,6 +35,7 @@
 #include "LegacyCustomProtocolManager.h"
 #include "Logging.h"
 #include "NetworkConnectionToWebProcess.h"
+#include "NetworkProcessConnectionMessages.h"
 #include "NetworkProcessCreationParameters.h"
 #include "NetworkProcessPlatformStrategies.h"
 #include "NetworkProcessProxyMessages.h"
@@ -115,6 +116,11 @@ NetworkProcess::NetworkProcess()
 #if USE(NETWORK_SESSION) && PLATFORM(COCOA)
     NetworkSessionCocoa::setLegacyCustomProtocolManager(supplement<LegacyCustomProtocolManager>());
 #endif
+
+    supplement<WebCookieManager>()->setCookiesDidChangeHandler([this](SessionID sessionID) {
+        for (auto& connection : m_webProcessConnections)
+            connection->connection().send(Messages::NetworkProcessConnection::CookiesDidChange(sessionID), 0);
+    });
 }
 
 NetworkProcess::~NetworkProcess()
@@ -225,7 +231,8 @@ void NetworkProcess::initializeNetworkProcess(NetworkProcessCreationParameters&&
 #if ENABLE(NETWORK_CAPTURE)
     NetworkCapture::Manager::singleton().initialize(
         parameters.recordReplayMode,
-        parameters.recordReplayCacheLocation);
+        parameters.recordReplayCacheLocation,
+        parameters.recordReplayUsesRecordedTiming);
 #endif
 
     m_diskCacheIsDisabledForTesting = parameters.shouldUseTestingNetworkSession;
@@ -322,6 +329,7 @@ void NetworkProcess::didGrantSandboxExtensionsToDatabaseProcessForBlobs(uint64_t
 void NetworkProcess::updateCookiePartitioningForTopPrivatelyOwnedDomains(const Vector<String>& domainsToRemove, const Vector<String>& domainsToAdd,  bool shouldClearFirst)
 {
     NetworkStorageSession::defaultStorageSession().setShouldPartitionCookiesForHosts(domainsToRemove, domainsToAdd, shouldClearFirst);
+    invalidateWebProcessCookieCaches();
 }
 #endif
 
@@ -697,6 +705,12 @@ void NetworkProcess::processDidResume()
         connection->endSuspension();
 }
 
+void NetworkProcess::invalidateWebProcessCookieCaches()
+{
+    for (auto& connection : m_webProcessConnections)
+        connection->connection().send(Messages::NetworkProcessConnection::AllCookiesDidChange(), 0);
+}
+
 void NetworkProcess::prefetchDNS(const String& hostname)
 {
     WebCore::prefetchDNS(hostname);
@@ -113,6 +113,8 @@ public:
 
     void prefetchDNS(const String&);
 
+    void invalidateWebProcessCookieCaches();
+
     void ensurePrivateBrowsingSession(WebsiteDataStoreParameters&&);
 
     void grantSandboxExtensionsToDatabaseProcessForBlobs(const Vector<String>& filenames, Function<void ()>&& completionHandler);
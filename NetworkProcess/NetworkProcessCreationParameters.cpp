@@ -53,6 +53,8 @@ void NetworkProcessCreationParameters::encode(IPC::Encoder& encoder) const
 #if ENABLE(NETWORK_CACHE_SPECULATIVE_REVALIDATION)
     encoder << shouldEnableNetworkCacheSpeculativeRevalidation;
 #endif
+    encoder << shouldUseNetworkCachePackedStorage;
+    encoder.encodeEnum(networkCacheEvictionPolicy);
 #endif
 #if PLATFORM(MAC)
     encoder << uiProcessCookieStorageIdentifier;
@@ -99,6 +101,7 @@ void NetworkProcessCreationParameters::encode(IPC::Encoder& encoder) const
 #if ENABLE(NETWORK_CAPTURE)
     encoder << recordReplayMode;
     encoder << recordReplayCacheLocation;
+    encoder << recordReplayUsesRecordedTiming;
 #endif
 }
 
@@ -125,6 +128,10 @@ bool NetworkProcessCreationParameters::decode(IPC::Decoder& decoder, NetworkProc
     if (!decoder.decode(result.shouldEnableNetworkCacheSpeculativeRevalidation))
         return false;
 #endif
+    if (!decoder.decode(result.shouldUseNetworkCachePackedStorage))
+        return false;
+    if (!decoder.decodeEnum(result.networkCacheEvictionPolicy))
+        return false;
 #endif
 #if PLATFORM(MAC)
     if (!decoder.decode(result.uiProcessCookieStorageIdentifier))
@@ -204,6 +211,8 @@ bool NetworkProcessCreationParameters::decode(IPC::Decoder& decoder, NetworkProc
         return false;
     if (!decoder.decode(result.recordReplayCacheLocation))
         return false;
+    if (!decoder.decode(result.recordReplayUsesRecordedTiming))
+        return false;
 #endif
 
     return true;
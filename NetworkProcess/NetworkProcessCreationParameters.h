@@ -27,6 +27,7 @@
 
 #include "Attachment.h"
 #include "CacheModel.h"
+#include "DiskCacheEvictionPolicy.h"
 #include "SandboxExtension.h"
 #include <wtf/Vector.h>
 #include <wtf/text/WTFString.h>
@@ -62,6 +63,8 @@ struct NetworkProcessCreationParameters {
 #if ENABLE(NETWORK_CACHE_SPECULATIVE_REVALIDATION)
     bool shouldEnableNetworkCacheSpeculativeRevalidation { false };
 #endif
+    bool shouldUseNetworkCachePackedStorage { false };
+    DiskCacheEvictionPolicy networkCacheEvictionPolicy { DiskCacheEvictionPolicy::Random };
 #endif
 #if PLATFORM(MAC)
     Vector<uint8_t> uiProcessCookieStorageIdentifier;
@@ -113,6 +116,7 @@ struct NetworkProcessCreationParameters {
 #if ENABLE(NETWORK_CAPTURE)
     String recordReplayMode;
     String recordReplayCacheLocation;
+    bool recordReplayUsesRecordedTiming { false };
 #endif
 };
 
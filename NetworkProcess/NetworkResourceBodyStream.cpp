@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkResourceBodyStream.h"
+
+#include <WebCore/SharedBuffer.h>
+
+namespace WebKit {
+
+size_t NetworkResourceBodyStream::availableCapacity() const
+{
+    size_t capacity = (maximumChunkCount - m_chunks.size()) * chunkSize;
+    for (auto& chunk : m_chunks)
+        capacity += chunkSize - chunk.size;
+    return capacity;
+}
+
+size_t NetworkResourceBodyStream::nextWritableChunkIndex() const
+{
+    if (m_currentChunkIndex < m_chunks.size() && m_chunks[m_currentChunkIndex].size < chunkSize)
+        return m_currentChunkIndex;
+
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        if (!m_chunks[i].size)
+            return i;
+    }
+
+    ASSERT_NOT_REACHED();
+    return m_currentChunkIndex;
+}
+
+void NetworkResourceBodyStream::sendSegment(size_t chunkIndex, size_t offset, size_t size, const SegmentCallback& callback)
+{
+    auto& chunk = m_chunks[chunkIndex];
+
+    SharedMemory::Handle handle;
+    if (!chunk.handleWasSent) {
+        if (!chunk.sharedMemory->createHandle(handle, SharedMemory::Protection::ReadOnly))
+            RELEASE_ASSERT_NOT_REACHED();
+        chunk.handleWasSent = true;
+    }
+
+    callback(chunkIndex + 1, handle, offset, size);
+}
+
+bool NetworkResourceBodyStream::write(const WebCore::SharedBuffer& buffer, const SegmentCallback& callback)
+{
+    size_t capacity = availableCapacity();
+    if (buffer.size() > capacity)
+        return false;
+
+    // Allocate all the chunks needed up front, so that a failure doesn't leave part of the buffer sent.
+    size_t freeCapacity = capacity - (maximumChunkCount - m_chunks.size()) * chunkSize;
+    while (freeCapacity < buffer.size()) {
+        auto sharedMemory = SharedMemory::allocate(chunkSize);
+        if (!sharedMemory)
+            return false;
+        m_chunks.append({ WTFMove(sharedMemory), 0, false });
+        freeCapacity += chunkSize;
+    }
+
+    m_currentChunkIndex = nextWritableChunkIndex();
+    size_t segmentOffset = m_chunks[m_currentChunkIndex].size;
+
+    for (const auto& element : buffer) {
+        auto* data = reinterpret_cast<const uint8_t*>(element.segment->data());
+        size_t remaining = element.segment->size();
+
+        while (remaining) {
+            if (m_chunks[m_currentChunkIndex].size == chunkSize) {
+                m_currentChunkIndex = nextWritableChunkIndex();
+                segmentOffset = 0;
+            }
+
+            auto& chunk = m_chunks[m_currentChunkIndex];
+            size_t length = std::min(remaining, chunkSize - chunk.size);
+            memcpy(static_cast<uint8_t*>(chunk.sharedMemory->data()) + chunk.size, data, length);
+            chunk.size += length;
+            data += length;
+            remaining -= length;
+
+            if (chunk.size == chunkSize)
+                sendSegment(m_currentChunkIndex, segmentOffset, chunkSize - segmentOffset, callback);
+        }
+    }
+
+    auto& lastChunk = m_chunks[m_currentChunkIndex];
+    if (lastChunk.size < chunkSize && lastChunk.size > segmentOffset)
+        sendSegment(m_currentChunkIndex, segmentOffset, lastChunk.size - segmentOffset, callback);
+
+    return true;
+}
+
+void NetworkResourceBodyStream::didConsumeChunk(uint64_t chunkIdentifier)
+{
+    if (!chunkIdentifier || chunkIdentifier > m_chunks.size())
+        return;
+
+    // Only full chunks are ever acknowledged.
+    auto& chunk = m_chunks[chunkIdentifier - 1];
+    if (chunk.size != chunkSize)
+        return;
+    chunk.size = 0;
+}
+
+} // namespace WebKit
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "SharedMemory.h"
+#include <wtf/Function.h>
+#include <wtf/Vector.h>
+
+namespace WebCore {
+class SharedBuffer;
+}
+
+namespace WebKit {
+
+// Chain of shared memory chunks that response bytes of a single load are written into, so that
+// the WebResourceLoader can consume them in place instead of receiving a copy in every message.
+// Chunks are filled in order. A full chunk is not written to again until the WebProcess
+// acknowledges that it consumed it, which bounds the memory used by a load.
+class NetworkResourceBodyStream {
+    WTF_MAKE_NONCOPYABLE(NetworkResourceBodyStream); WTF_MAKE_FAST_ALLOCATED;
+public:
+    static const size_t chunkSize = 256 * 1024;
+    static const size_t maximumChunkCount = 4;
+
+    NetworkResourceBodyStream() = default;
+
+    // The handle is only non-null the first time a chunk is used.
+    typedef Function<void (uint64_t chunkIdentifier, const SharedMemory::Handle&, size_t offset, size_t size)> SegmentCallback;
+
+    // Returns false without writing anything if there isn't enough room for the whole buffer.
+    bool write(const WebCore::SharedBuffer&, const SegmentCallback&);
+    void didConsumeChunk(uint64_t chunkIdentifier);
+
+private:
+    struct Chunk {
+        RefPtr<SharedMemory> sharedMemory;
+        size_t size { 0 };
+        bool handleWasSent { false };
+    };
+
+    size_t availableCapacity() const;
+    size_t nextWritableChunkIndex() const;
+    void sendSegment(size_t chunkIndex, size_t offset, size_t size, const SegmentCallback&);
+
+    // A chunk identifier is its index in this vector plus one.
+    Vector<Chunk, maximumChunkCount> m_chunks;
+    size_t m_currentChunkIndex { 0 };
+};
+
+} // namespace WebKit
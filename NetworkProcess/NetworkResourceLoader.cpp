@@ -347,6 +347,7 @@ auto NetworkResourceLoader::didReceiveResponse(ResourceResponse&& receivedRespon
 
     bool shouldWaitContinueDidReceiveResponse = isMainResource();
     if (shouldSendDidReceiveResponse) {
+        invalidateWebProcessCookieCacheIfNeeded(m_response);
         if (isSynchronous())
             m_synchronousLoadData->response = m_response;
         else
@@ -469,6 +470,7 @@ void NetworkResourceLoader::willSendRedirectedRequest(ResourceRequest&& request,
         continueWillSendRequest(WTFMove(overridenRequest), false);
         return;
     }
+    invalidateWebProcessCookieCacheIfNeeded(redirectResponse);
     send(Messages::WebResourceLoader::WillSendRequest(redirectRequest, redirectResponse));
 
 #if ENABLE(NETWORK_CACHE)
@@ -479,6 +481,17 @@ void NetworkResourceLoader::willSendRedirectedRequest(ResourceRequest&& request,
 #endif
 }
 
+void NetworkResourceLoader::invalidateWebProcessCookieCacheIfNeeded(const ResourceResponse& response)
+{
+    // Cookie change notifications can arrive after the response on some platforms. The web process must not
+    // answer document.cookie from its cache once it has seen a response that set cookies, so invalidate it first.
+    // This is dispatched even while a synchronous load is waiting for its reply.
+    if (response.httpHeaderField(HTTPHeaderName::SetCookie).isNull())
+        return;
+
+    m_connection->connection().send(Messages::NetworkProcessConnection::CookiesDidChangeForHost(sessionID(), response.url().host()), 0, IPC::SendOption::DispatchMessageEvenWhenWaitingForSyncReply);
+}
+
 void NetworkResourceLoader::continueWillSendRequest(ResourceRequest&& newRequest, bool isAllowedToAskUserForCredentials)
 {
     RELEASE_LOG_IF_ALLOWED("continueWillSendRequest: (pageID = %" PRIu64 ", frameID = %" PRIu64 ", resourceID = %" PRIu64 ")", m_parameters.webPageID, m_parameters.webFrameID, m_parameters.identifier);
@@ -539,23 +552,42 @@ void NetworkResourceLoader::bufferingTimerFired()
     if (m_bufferedData->isEmpty())
         return;
 
-    IPC::SharedBufferDataReference dataReference(m_bufferedData.get());
+    auto bufferedData = m_bufferedData.releaseNonNull();
     size_t encodedLength = m_bufferedDataEncodedDataLength;
 
     m_bufferedData = SharedBuffer::create();
     m_bufferedDataEncodedDataLength = 0;
 
-    send(Messages::WebResourceLoader::DidReceiveData(dataReference, encodedLength));
+    sendBuffer(bufferedData, encodedLength);
 }
 
 void NetworkResourceLoader::sendBuffer(SharedBuffer& buffer, size_t encodedDataLength)
 {
     ASSERT(!isSynchronous());
 
+    // Small buffers fit inline in the IPC message, so writing them to shared memory doesn't save anything.
+    const size_t minimumSizeForBodyStream = 4096;
+    if (buffer.size() >= minimumSizeForBodyStream) {
+        size_t remainingSize = buffer.size();
+        bool wasWritten = m_bodyStream.write(buffer, [this, &remainingSize, encodedDataLength](uint64_t chunkIdentifier, const SharedMemory::Handle& handle, size_t offset, size_t size) {
+            remainingSize -= size;
+            // Report the whole encoded length with the last segment.
+            int64_t segmentEncodedDataLength = remainingSize ? 0 : encodedDataLength;
+            send(Messages::WebResourceLoader::DidReceiveDataChunk(chunkIdentifier, handle, offset, size, segmentEncodedDataLength));
+        });
+        if (wasWritten)
+            return;
+    }
+
     IPC::SharedBufferDataReference dataReference(&buffer);
     send(Messages::WebResourceLoader::DidReceiveData(dataReference, encodedDataLength));
 }
 
+void NetworkResourceLoader::didConsumeDataChunk(uint64_t chunkIdentifier)
+{
+    m_bodyStream.didConsumeChunk(chunkIdentifier);
+}
+
 #if ENABLE(NETWORK_CACHE)
 void NetworkResourceLoader::tryStoreAsCacheEntry()
 {
@@ -30,6 +30,7 @@
 #include "MessageSender.h"
 #include "NetworkConnectionToWebProcessMessages.h"
 #include "NetworkLoadClient.h"
+#include "NetworkResourceBodyStream.h"
 #include "NetworkResourceLoadParameters.h"
 #include "ShareableResource.h"
 #include <WebCore/Timer.h>
@@ -73,6 +74,7 @@ public:
     void continueCanAuthenticateAgainstProtectionSpace(bool);
 #endif
     void continueWillSendRequest(WebCore::ResourceRequest&& newRequest, bool isAllowedToAskUserForCredentials);
+    void didConsumeDataChunk(uint64_t chunkIdentifier);
 
     const WebCore::ResourceResponse& response() const { return m_response; }
 
@@ -128,6 +130,7 @@ private:
     void cleanup();
     
     void platformDidReceiveResponse(const WebCore::ResourceResponse&);
+    void invalidateWebProcessCookieCacheIfNeeded(const WebCore::ResourceResponse&);
 
     void startBufferingTimerIfNeeded();
     void bufferingTimerFired();
@@ -147,6 +150,7 @@ private:
     size_t m_bytesReceived { 0 };
     size_t m_bufferedDataEncodedDataLength { 0 };
     RefPtr<WebCore::SharedBuffer> m_bufferedData;
+    NetworkResourceBodyStream m_bodyStream;
     unsigned m_redirectCount { 0 };
 
     std::unique_ptr<SynchronousLoadData> m_synchronousLoadData;
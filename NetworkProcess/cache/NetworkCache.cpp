@@ -77,7 +77,16 @@ static void dumpFileChanged(Cache* cache)
 
 bool Cache::initialize(const String& cachePath, OptionSet<Option> options)
 {
-    m_storage = Storage::open(cachePath, options.contains(Option::TestingMode) ? Storage::Mode::Testing : Storage::Mode::Normal);
+    auto mode = options.contains(Option::TestingMode) ? Storage::Mode::Testing : Storage::Mode::Normal;
+    auto backend = options.contains(Option::PackedRecordStorage) ? Storage::Backend::Packed : Storage::Backend::Files;
+    m_storage = Storage::open(cachePath, mode, backend);
+
+    if (m_storage) {
+        if (options.contains(Option::GreedyDualSizeFrequencyEviction))
+            m_storage->setEvictionPolicy(EvictionPolicy::Type::GreedyDualSizeFrequency);
+        else if (options.contains(Option::LeastRecentlyUsedEviction))
+            m_storage->setEvictionPolicy(EvictionPolicy::Type::LeastRecentlyUsed);
+    }
 
 #if ENABLE(NETWORK_CACHE_SPECULATIVE_REVALIDATION)
     if (options.contains(Option::SpeculativeRevalidation)) {
@@ -359,8 +368,10 @@ void Cache::retrieve(const WebCore::ResourceRequest& request, const GlobalFrameI
         if (!record) {
             LOG(NetworkCache, "(NetworkProcess) not found in storage");
 
-            if (m_statistics)
+            if (m_statistics) {
                 m_statistics->recordRetrievalFailure(frameID.first, storageKey, request);
+                m_statistics->recordContentsFilterStatistics(m_storage->contentsFilterStatistics());
+            }
 
             completionHandler(nullptr);
             return false;
@@ -102,6 +102,11 @@ public:
 #if ENABLE(NETWORK_CACHE_SPECULATIVE_REVALIDATION)
         SpeculativeRevalidation = 1 << 2,
 #endif
+        // Store records in a few large segment files instead of a file per record.
+        PackedRecordStorage = 1 << 3,
+        // Shrink by evicting the least valuable records instead of randomly. GDSF wins if both are set.
+        LeastRecentlyUsedEviction = 1 << 4,
+        GreedyDualSizeFrequencyEviction = 1 << 5,
     };
     bool initialize(const String& cachePath, OptionSet<Option>);
     void setCapacity(size_t);
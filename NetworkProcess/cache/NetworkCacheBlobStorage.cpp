@@ -127,12 +127,12 @@ BlobStorage::Blob BlobStorage::get(const String& path)
     return { data, computeSHA1(data, m_salt) };
 }
 
-void BlobStorage::remove(const String& path)
+bool BlobStorage::remove(const String& path)
 {
     ASSERT(!RunLoop::isMain());
 
     auto linkPath = WebCore::fileSystemRepresentation(path);
-    unlink(linkPath.data());
+    return !unlink(linkPath.data());
 }
 
 unsigned BlobStorage::shareCount(const String& path)
@@ -49,12 +49,14 @@ public:
     Blob add(const String& path, const Data&);
     Blob get(const String& path);
 
-    // Blob won't be removed until synchronization.
-    void remove(const String& path);
+    // Blob won't be removed until synchronization. Returns false if there was no blob at the path.
+    bool remove(const String& path);
 
     unsigned shareCount(const String& path);
 
     size_t approximateSize() const { return m_approximateSize; }
+    // Used when the size is restored from a checkpoint instead of by synchronize().
+    void setApproximateSize(size_t size) { m_approximateSize = size; }
 
     void synchronize();
 
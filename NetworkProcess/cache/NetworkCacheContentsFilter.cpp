@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkCacheContentsFilter.h"
+
+#if ENABLE(NETWORK_CACHE)
+
+#include <wtf/MathExtras.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+static const unsigned slotsPerBucket = 4;
+static const unsigned minimumBucketCount = 1024;
+static const unsigned maximumBucketCount = 1 << 24;
+static const unsigned maximumRelocationCount = 500;
+static const size_t maximumStashSize = 16;
+static const double maximumLoad = 0.9;
+
+static uint32_t indexForHash(const Key::HashType& hash)
+{
+    uint32_t index;
+    memcpy(&index, hash.data(), sizeof(index));
+    return index;
+}
+
+static uint16_t fingerprintForHash(const Key::HashType& hash)
+{
+    uint16_t fingerprint;
+    memcpy(&fingerprint, hash.data() + sizeof(uint32_t), sizeof(fingerprint));
+    // Zero marks an empty slot.
+    return fingerprint ? fingerprint : 1;
+}
+
+ContentsFilter::Table::Table(unsigned bucketCount)
+    : bucketCount(bucketCount)
+    , slots(bucketCount * slotsPerBucket, 0)
+{
+    ASSERT(bucketCount && !(bucketCount & (bucketCount - 1)));
+}
+
+uint32_t ContentsFilter::Table::alternateBucketIndex(uint32_t bucket, uint16_t fingerprint) const
+{
+    // Applying this twice gives back the original bucket so relocation doesn't need the full hash.
+    return bucketIndex(bucket ^ (static_cast<uint32_t>(fingerprint) * 0x5bd1e995u));
+}
+
+bool ContentsFilter::Table::bucketContains(uint32_t bucket, uint16_t fingerprint) const
+{
+    for (unsigned i = 0; i < slotsPerBucket; ++i) {
+        if (slots[bucket * slotsPerBucket + i] == fingerprint)
+            return true;
+    }
+    return false;
+}
+
+bool ContentsFilter::Table::insertIntoBucket(uint32_t bucket, uint16_t fingerprint)
+{
+    for (unsigned i = 0; i < slotsPerBucket; ++i) {
+        auto& slot = slots[bucket * slotsPerBucket + i];
+        if (!slot) {
+            slot = fingerprint;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ContentsFilter::Table::removeFromBucket(uint32_t bucket, uint16_t fingerprint)
+{
+    for (unsigned i = 0; i < slotsPerBucket; ++i) {
+        auto& slot = slots[bucket * slotsPerBucket + i];
+        if (slot == fingerprint) {
+            slot = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ContentsFilter::Table::contains(uint32_t index, uint16_t fingerprint) const
+{
+    auto bucket = bucketIndex(index);
+    auto alternateBucket = alternateBucketIndex(bucket, fingerprint);
+    if (bucketContains(bucket, fingerprint) || bucketContains(alternateBucket, fingerprint))
+        return true;
+    for (auto& entry : stash) {
+        if (entry.second == fingerprint && (entry.first == bucket || entry.first == alternateBucket))
+            return true;
+    }
+    return false;
+}
+
+bool ContentsFilter::Table::remove(uint32_t index, uint16_t fingerprint)
+{
+    auto bucket = bucketIndex(index);
+    auto alternateBucket = alternateBucketIndex(bucket, fingerprint);
+    bool removed = removeFromBucket(bucket, fingerprint) || removeFromBucket(alternateBucket, fingerprint);
+    if (!removed) {
+        auto position = stash.findMatching([&](auto& entry) {
+            return entry.second == fingerprint && (entry.first == bucket || entry.first == alternateBucket);
+        });
+        if (position == notFound)
+            return false;
+        stash.remove(position);
+    }
+    --itemCount;
+    return true;
+}
+
+void ContentsFilter::Table::insert(uint32_t index, uint16_t fingerprint)
+{
+    auto bucket = bucketIndex(index);
+    if (!insertIntoBucket(bucket, fingerprint)) {
+        bucket = alternateBucketIndex(bucket, fingerprint);
+        if (!insertIntoBucket(bucket, fingerprint)) {
+            // Kick out existing fingerprints to their alternate buckets. The slot choice is deterministic to avoid randomness during testing.
+            unsigned relocationCount = 0;
+            for (; relocationCount < maximumRelocationCount; ++relocationCount) {
+                std::swap(slots[bucket * slotsPerBucket + relocationCount % slotsPerBucket], fingerprint);
+                bucket = alternateBucketIndex(bucket, fingerprint);
+                if (insertIntoBucket(bucket, fingerprint))
+                    break;
+            }
+            if (relocationCount == maximumRelocationCount)
+                stash.append({ bucket, fingerprint });
+        }
+    }
+    ++itemCount;
+}
+
+bool ContentsFilter::Table::isFull() const
+{
+    return itemCount >= bucketCount * slotsPerBucket * maximumLoad || stash.size() >= maximumStashSize;
+}
+
+ContentsFilter::ContentsFilter(size_t expectedItemCount)
+{
+    size_t bucketCount = std::min<size_t>(std::max<size_t>(expectedItemCount / (slotsPerBucket * maximumLoad), minimumBucketCount), maximumBucketCount);
+    m_tables.append(Table(roundUpToPowerOfTwo(bucketCount)));
+}
+
+void ContentsFilter::add(const Key::HashType& hash)
+{
+    if (m_tables.last().isFull())
+        m_tables.append(Table(std::min(m_tables.last().bucketCount * 2, maximumBucketCount)));
+    m_tables.last().insert(indexForHash(hash), fingerprintForHash(hash));
+}
+
+void ContentsFilter::remove(const Key::HashType& hash)
+{
+    auto index = indexForHash(hash);
+    auto fingerprint = fingerprintForHash(hash);
+    for (size_t i = m_tables.size(); i--;) {
+        if (m_tables[i].remove(index, fingerprint))
+            return;
+    }
+}
+
+bool ContentsFilter::mayContain(const Key::HashType& hash) const
+{
+    auto index = indexForHash(hash);
+    auto fingerprint = fingerprintForHash(hash);
+    for (auto& table : m_tables) {
+        if (table.contains(index, fingerprint))
+            return true;
+    }
+    return false;
+}
+
+void ContentsFilter::clear()
+{
+    unsigned bucketCount = m_tables.first().bucketCount;
+    m_tables.clear();
+    m_tables.append(Table(bucketCount));
+}
+
+size_t ContentsFilter::itemCount() const
+{
+    size_t count = 0;
+    for (auto& table : m_tables)
+        count += table.itemCount;
+    return count;
+}
+
+double ContentsFilter::expectedFalsePositiveRate() const
+{
+    // A lookup compares against the two buckets of each table and each occupied slot matches with probability 1/2^16.
+    double rate = 0;
+    for (auto& table : m_tables)
+        rate += 2. * table.itemCount / (table.bucketCount * static_cast<double>(std::numeric_limits<uint16_t>::max()));
+    return std::min(rate, 1.);
+}
+
+template<typename T> static void appendValue(Vector<uint8_t>& buffer, T value)
+{
+    buffer.append(reinterpret_cast<const uint8_t*>(&value), sizeof(value));
+}
+
+template<typename T> static bool readValue(const uint8_t*& data, const uint8_t* end, T& value)
+{
+    if (static_cast<size_t>(end - data) < sizeof(value))
+        return false;
+    memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+void ContentsFilter::encode(Vector<uint8_t>& buffer) const
+{
+    appendValue<uint32_t>(buffer, m_tables.size());
+    for (auto& table : m_tables) {
+        appendValue<uint32_t>(buffer, table.bucketCount);
+        appendValue<uint64_t>(buffer, table.itemCount);
+        appendValue<uint32_t>(buffer, table.stash.size());
+        buffer.append(reinterpret_cast<const uint8_t*>(table.slots.data()), table.slots.size() * sizeof(uint16_t));
+        for (auto& entry : table.stash) {
+            appendValue<uint32_t>(buffer, entry.first);
+            appendValue<uint32_t>(buffer, entry.second);
+        }
+    }
+}
+
+std::unique_ptr<ContentsFilter> ContentsFilter::decode(const uint8_t* data, size_t size)
+{
+    auto* end = data + size;
+    uint32_t tableCount;
+    if (!readValue(data, end, tableCount) || !tableCount)
+        return nullptr;
+
+    auto filter = std::unique_ptr<ContentsFilter>(new ContentsFilter);
+    for (uint32_t i = 0; i < tableCount; ++i) {
+        uint32_t bucketCount;
+        uint64_t itemCount;
+        uint32_t stashSize;
+        if (!readValue(data, end, bucketCount) || !readValue(data, end, itemCount) || !readValue(data, end, stashSize))
+            return nullptr;
+        if (!bucketCount || bucketCount > maximumBucketCount || (bucketCount & (bucketCount - 1)) || stashSize > maximumStashSize)
+            return nullptr;
+
+        Table table(bucketCount);
+        size_t slotsSize = table.slots.size() * sizeof(uint16_t);
+        if (static_cast<size_t>(end - data) < slotsSize)
+            return nullptr;
+        memcpy(table.slots.data(), data, slotsSize);
+        data += slotsSize;
+        table.itemCount = itemCount;
+
+        for (uint32_t j = 0; j < stashSize; ++j) {
+            uint32_t bucket;
+            uint32_t fingerprint;
+            if (!readValue(data, end, bucket) || !readValue(data, end, fingerprint) || bucket >= bucketCount)
+                return nullptr;
+            table.stash.append({ bucket, static_cast<uint16_t>(fingerprint) });
+        }
+        filter->m_tables.append(WTFMove(table));
+    }
+    if (data != end)
+        return nullptr;
+    return filter;
+}
+
+}
+}
+
+#endif
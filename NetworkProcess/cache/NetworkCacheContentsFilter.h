@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#if ENABLE(NETWORK_CACHE)
+
+#include "NetworkCacheKey.h"
+#include <wtf/Vector.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+// ContentsFilter is a cuckoo filter over key hashes. Unlike a Bloom filter it supports removal.
+// When a table gets full a twice larger one is chained so the filter grows with the cache.
+// A 16 bit fingerprint gives a false positive rate of about 0.01% per table.
+// Fingerprints are counted: a key added twice stays in the filter until it is removed twice. Since colliding keys
+// can't be told apart, only keys that were actually added may be removed.
+class ContentsFilter {
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    explicit ContentsFilter(size_t expectedItemCount);
+
+    void add(const Key::HashType&);
+    void remove(const Key::HashType&);
+    bool mayContain(const Key::HashType&) const;
+    void clear();
+
+    size_t itemCount() const;
+    double expectedFalsePositiveRate() const;
+
+    void encode(Vector<uint8_t>&) const;
+    static std::unique_ptr<ContentsFilter> decode(const uint8_t*, size_t);
+
+private:
+    ContentsFilter() = default;
+
+    struct Table {
+        explicit Table(unsigned bucketCount);
+
+        bool contains(uint32_t index, uint16_t fingerprint) const;
+        bool remove(uint32_t index, uint16_t fingerprint);
+        void insert(uint32_t index, uint16_t fingerprint);
+        bool isFull() const;
+
+        uint32_t bucketIndex(uint32_t index) const { return index & (bucketCount - 1); }
+        uint32_t alternateBucketIndex(uint32_t bucket, uint16_t fingerprint) const;
+        bool insertIntoBucket(uint32_t bucket, uint16_t fingerprint);
+        bool removeFromBucket(uint32_t bucket, uint16_t fingerprint);
+        bool bucketContains(uint32_t bucket, uint16_t fingerprint) const;
+
+        unsigned bucketCount;
+        size_t itemCount { 0 };
+        Vector<uint16_t> slots;
+        // Fingerprints that didn't find a place after the maximum number of relocations.
+        Vector<std::pair<uint32_t, uint16_t>> stash;
+    };
+
+    Vector<Table> m_tables;
+};
+
+}
+}
+
+#endif
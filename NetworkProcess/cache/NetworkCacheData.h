@@ -70,7 +70,9 @@ public:
     const uint8_t* data() const;
     size_t size() const { return m_size; }
     bool isMap() const { return m_isMap; }
+    // For a subrange of a map, the shared memory covers the whole map and the data starts at mapOffset().
     RefPtr<SharedMemory> tryCreateSharedMemory() const;
+    size_t mapOffset() const { return m_mapOffset; }
 
     Data subrange(size_t offset, size_t) const;
 
@@ -92,9 +94,11 @@ private:
 #if USE(SOUP)
     mutable GRefPtr<SoupBuffer> m_buffer;
     int m_fileDescriptor { -1 };
+    size_t m_mapSize { 0 };
 #endif
     mutable const uint8_t* m_data { nullptr };
     size_t m_size { 0 };
+    size_t m_mapOffset { 0 };
     bool m_isMap { false };
 };
 
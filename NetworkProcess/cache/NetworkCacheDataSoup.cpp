@@ -49,6 +49,7 @@ Data::Data(const uint8_t* data, size_t size)
 Data::Data(GRefPtr<SoupBuffer>&& buffer, int fd)
     : m_buffer(buffer)
     , m_fileDescriptor(fd)
+    , m_mapSize(buffer ? buffer->length : 0)
     , m_size(buffer ? buffer->length : 0)
     , m_isMap(m_size && fd != -1)
 {
@@ -84,7 +85,14 @@ Data Data::subrange(size_t offset, size_t size) const
         return { };
 
     GRefPtr<SoupBuffer> subBuffer = adoptGRef(soup_buffer_new_subbuffer(m_buffer.get(), offset, size));
-    return { WTFMove(subBuffer) };
+    if (!m_isMap)
+        return { WTFMove(subBuffer) };
+
+    // The subbuffer keeps the map and its file descriptor alive.
+    Data subrangeData = { WTFMove(subBuffer), m_fileDescriptor };
+    subrangeData.m_mapSize = m_mapSize;
+    subrangeData.m_mapOffset = m_mapOffset + offset;
+    return subrangeData;
 }
 
 Data concatenate(const Data& a, const Data& b)
@@ -133,7 +141,7 @@ RefPtr<SharedMemory> Data::tryCreateSharedMemory() const
     if (isNull() || !isMap())
         return nullptr;
 
-    return SharedMemory::wrapMap(const_cast<char*>(m_buffer->data), m_buffer->length, m_fileDescriptor);
+    return SharedMemory::wrapMap(const_cast<char*>(m_buffer->data) - m_mapOffset, m_mapSize, m_fileDescriptor);
 }
 
 } // namespace NetworkCache
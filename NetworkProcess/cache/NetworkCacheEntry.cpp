@@ -153,7 +153,7 @@ void Entry::initializeShareableResourceHandleFromStorageRecord() const
     if (!sharedMemory)
         return;
 
-    auto shareableResource = ShareableResource::create(sharedMemory.releaseNonNull(), 0, m_sourceStorageRecord.body.size());
+    auto shareableResource = ShareableResource::create(sharedMemory.releaseNonNull(), m_sourceStorageRecord.body.mapOffset(), m_sourceStorageRecord.body.size());
     shareableResource->createHandle(m_shareableResourceHandle);
 }
 #endif
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkCacheEvictionPolicy.h"
+
+#if ENABLE(NETWORK_CACHE)
+
+#include <algorithm>
+#include <mutex>
+
+namespace WebKit {
+namespace NetworkCache {
+
+class LeastRecentlyUsedEvictionPolicy final : public EvictionPolicy {
+private:
+    double priority(const Candidate& candidate, const AccessInfo* accessInfo) const override
+    {
+        auto lastAccessTime = accessInfo ? std::max(accessInfo->lastAccessTime, candidate.lastAccessTime) : candidate.lastAccessTime;
+        return std::chrono::duration<double>(lastAccessTime.time_since_epoch()).count();
+    }
+};
+
+class GreedyDualSizeFrequencyEvictionPolicy final : public EvictionPolicy {
+private:
+    double priority(const Candidate& candidate, const AccessInfo* accessInfo) const override
+    {
+        // H = L + frequency * cost / size, with a unit cost so the policy optimizes the hit rate.
+        const double sizeUnit = 1024;
+        double size = std::max<double>(candidate.size, 1) / sizeUnit;
+        if (!accessInfo)
+            return 1 / size;
+        return accessInfo->inflationAtLastAccess + std::max(accessInfo->frequency, 1u) / size;
+    }
+
+    void didEvict(double priority) override
+    {
+        // Age the remaining records by raising the baseline for future accesses.
+        m_inflation = std::max(m_inflation, priority);
+    }
+
+    double inflation() const override { return m_inflation; }
+
+    double m_inflation { 0 };
+};
+
+std::unique_ptr<EvictionPolicy> EvictionPolicy::create(Type type)
+{
+    switch (type) {
+    case Type::LeastRecentlyUsed:
+        return std::make_unique<LeastRecentlyUsedEvictionPolicy>();
+    case Type::GreedyDualSizeFrequency:
+        return std::make_unique<GreedyDualSizeFrequencyEvictionPolicy>();
+    }
+    ASSERT_NOT_REACHED();
+    return nullptr;
+}
+
+uint64_t EvictionPolicy::accessLogKey(const Key::HashType& hash)
+{
+    uint64_t key;
+    memcpy(&key, hash.data(), sizeof(key));
+    // 0 and the maximum value are reserved by HashMap.
+    if (!key || key == std::numeric_limits<uint64_t>::max())
+        return 1;
+    return key;
+}
+
+void EvictionPolicy::recordAccess(const Key::HashType& hash)
+{
+    std::lock_guard<Lock> locker(m_lock);
+    auto& accessInfo = m_accessLog.add(accessLogKey(hash), AccessInfo { }).iterator->value;
+    accessInfo.lastAccessTime = std::chrono::system_clock::now();
+    ++accessInfo.frequency;
+    accessInfo.inflationAtLastAccess = inflation();
+}
+
+void EvictionPolicy::recordRemoval(const Key::HashType& hash)
+{
+    std::lock_guard<Lock> locker(m_lock);
+    m_accessLog.remove(accessLogKey(hash));
+}
+
+void EvictionPolicy::clear()
+{
+    std::lock_guard<Lock> locker(m_lock);
+    m_accessLog.clear();
+}
+
+Vector<size_t> EvictionPolicy::selectRecordsToEvict(const Vector<Candidate>& candidates, size_t bytesToFree)
+{
+    std::lock_guard<Lock> locker(m_lock);
+
+    Vector<std::pair<double, size_t>> priorities;
+    priorities.reserveInitialCapacity(candidates.size());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        auto it = m_accessLog.find(accessLogKey(candidates[i].hash));
+        auto* accessInfo = it != m_accessLog.end() ? &it->value : nullptr;
+        priorities.uncheckedAppend({ priority(candidates[i], accessInfo), i });
+    }
+    // Ties are broken by the candidate order so the result is deterministic.
+    std::sort(priorities.begin(), priorities.end());
+
+    Vector<size_t> indices;
+    size_t freedBytes = 0;
+    for (auto& priority : priorities) {
+        if (freedBytes >= bytesToFree)
+            break;
+        indices.append(priority.second);
+        freedBytes += candidates[priority.second].size;
+        didEvict(priority.first);
+    }
+    for (auto index : indices)
+        m_accessLog.remove(accessLogKey(candidates[index].hash));
+
+    return indices;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#if ENABLE(NETWORK_CACHE)
+
+#include "NetworkCacheKey.h"
+#include <chrono>
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
+#include <wtf/Vector.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+// EvictionPolicy decides which records to delete when the cache goes over capacity.
+// It keeps an in-memory log of record accesses. Records that were not accessed since launch
+// fall back to the access time known by the storage.
+class EvictionPolicy {
+    WTF_MAKE_NONCOPYABLE(EvictionPolicy); WTF_MAKE_FAST_ALLOCATED;
+public:
+    enum class Type {
+        LeastRecentlyUsed,
+        // Greedy-Dual-Size-Frequency favors small and frequently used records.
+        GreedyDualSizeFrequency,
+    };
+    static std::unique_ptr<EvictionPolicy> create(Type);
+    virtual ~EvictionPolicy() { }
+
+    // These are thread safe.
+    void recordAccess(const Key::HashType&);
+    void recordRemoval(const Key::HashType&);
+    void clear();
+
+    struct Candidate {
+        Key::HashType hash;
+        size_t size;
+        std::chrono::system_clock::time_point lastAccessTime;
+    };
+    // Returns the indices of the candidates to evict to free at least the given number of bytes, in eviction order.
+    Vector<size_t> selectRecordsToEvict(const Vector<Candidate>&, size_t bytesToFree);
+
+protected:
+    EvictionPolicy() = default;
+
+    struct AccessInfo {
+        std::chrono::system_clock::time_point lastAccessTime;
+        unsigned frequency { 0 };
+        double inflationAtLastAccess { 0 };
+    };
+    // Records with lower priority are evicted first.
+    virtual double priority(const Candidate&, const AccessInfo*) const = 0;
+    virtual void didEvict(double) { }
+    virtual double inflation() const { return 0; }
+
+private:
+    static uint64_t accessLogKey(const Key::HashType&);
+
+    Lock m_lock;
+    HashMap<uint64_t, AccessInfo> m_accessLog;
+};
+
+}
+}
+
+#endif
@@ -45,6 +45,7 @@
 #if USE(SOUP)
 #include <gio/gio.h>
 #include <wtf/glib/GRefPtr.h>
+#include <wtf/glib/GUniquePtr.h>
 #endif
 
 namespace WebKit {
@@ -121,6 +122,17 @@ FileTimes fileTimes(const String& path)
 #endif
 }
 
+void setFileCreationTimeIfNeeded(const String& path)
+{
+#if !HAVE(STAT_BIRTHTIME) && USE(SOUP)
+    GRefPtr<GFile> file = adoptGRef(g_file_new_for_path(WebCore::fileSystemRepresentation(path).data()));
+    GUniquePtr<char> birthtimeString(g_strdup_printf("%" G_GUINT64_FORMAT, std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())));
+    g_file_set_attribute_string(file.get(), "xattr::birthtime", birthtimeString.get(), G_FILE_QUERY_INFO_NONE, nullptr, nullptr);
+#else
+    UNUSED_PARAM(path);
+#endif
+}
+
 void updateFileModificationTimeIfNeeded(const String& path)
 {
     auto times = fileTimes(path);
@@ -43,6 +43,8 @@ struct FileTimes {
     std::chrono::system_clock::time_point modification;
 };
 FileTimes fileTimes(const String& path);
+// Records the creation time of a new file where the file system doesn't keep it.
+void setFileCreationTimeIfNeeded(const String& path);
 void updateFileModificationTimeIfNeeded(const String& path);
 
 bool canUseSharedMemoryForPath(const String& path);
@@ -77,6 +77,8 @@ private:
     GRefPtr<GInputStream> m_inputStream;
     GRefPtr<GOutputStream> m_outputStream;
     GRefPtr<GFileIOStream> m_ioStream;
+    // Size of the file when it was opened for reading, used to map it through m_fileDescriptor.
+    size_t m_fileSize { 0 };
 #endif
 };
 
@@ -29,15 +29,20 @@
 #if ENABLE(NETWORK_CACHE)
 
 #include "NetworkCacheFileSystem.h"
+#include <fcntl.h>
+#include <gio/gfiledescriptorbased.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <wtf/MainThread.h>
 #include <wtf/RunLoop.h>
-#include <wtf/glib/GUniquePtr.h>
 #include <wtf/glib/RunLoopSourcePriority.h>
 
 namespace WebKit {
 namespace NetworkCache {
 
 static const size_t gDefaultReadBufferSize = 4096;
+// Files at least this large are mapped instead of being copied to heap buffers. The map can also be shared with the web process.
+static const size_t gMappedReadThreshold = 16 * 1024;
 
 IOChannel::IOChannel(const String& filePath, Type type)
     : m_path(filePath)
@@ -49,10 +54,7 @@ IOChannel::IOChannel(const String& filePath, Type type)
     case Type::Create: {
         g_file_delete(file.get(), nullptr, nullptr);
         m_outputStream = adoptGRef(G_OUTPUT_STREAM(g_file_create(file.get(), static_cast<GFileCreateFlags>(G_FILE_CREATE_PRIVATE), nullptr, nullptr)));
-#if !HAVE(STAT_BIRTHTIME)
-        GUniquePtr<char> birthtimeString(g_strdup_printf("%" G_GUINT64_FORMAT, std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())));
-        g_file_set_attribute_string(file.get(), "xattr::birthtime", birthtimeString.get(), G_FILE_QUERY_INFO_NONE, nullptr, nullptr);
-#endif
+        setFileCreationTimeIfNeeded(filePath);
         break;
     }
     case Type::Write: {
@@ -61,6 +63,13 @@ IOChannel::IOChannel(const String& filePath, Type type)
     }
     case Type::Read:
         m_inputStream = adoptGRef(G_INPUT_STREAM(g_file_read(file.get(), nullptr, nullptr)));
+        // Local files are read through a file descriptor, which lets large reads map the file.
+        if (m_inputStream && G_IS_FILE_DESCRIPTOR_BASED(m_inputStream.get())) {
+            m_fileDescriptor = g_file_descriptor_based_get_fd(G_FILE_DESCRIPTOR_BASED(m_inputStream.get()));
+            struct stat stat;
+            if (!fstat(m_fileDescriptor, &stat))
+                m_fileSize = stat.st_size;
+        }
         break;
     }
 }
@@ -153,6 +162,19 @@ static void inputStreamReadReadyCallback(GInputStream* stream, GAsyncResult* res
         reinterpret_cast<GAsyncReadyCallback>(inputStreamReadReadyCallback), asyncData.release());
 }
 
+static Data mapFileForReading(int fileDescriptor, size_t fileSize, size_t size)
+{
+    size_t mapSize = std::min(fileSize, size);
+    if (mapSize < gMappedReadThreshold)
+        return { };
+
+    // The map keeps its own file descriptor so the data can be turned into shared memory after the channel is gone.
+    int fd = fcntl(fileDescriptor, F_DUPFD_CLOEXEC, 0);
+    if (fd < 0)
+        return { };
+    return adoptAndMapFile(fd, 0, mapSize);
+}
+
 void IOChannel::read(size_t offset, size_t size, WorkQueue* queue, Function<void (Data&, int error)>&& completionHandler)
 {
     RefPtr<IOChannel> channel(this);
@@ -164,6 +186,16 @@ void IOChannel::read(size_t offset, size_t size, WorkQueue* queue, Function<void
         return;
     }
 
+    if (!offset) {
+        auto data = mapFileForReading(m_fileDescriptor, m_fileSize, size);
+        if (!data.isNull()) {
+            runTaskInQueue([channel, data = WTFMove(data), completionHandler = WTFMove(completionHandler)] () mutable {
+                completionHandler(data, 0);
+            }, queue);
+            return;
+        }
+    }
+
     if (!RunLoop::isMain()) {
         readSyncInThread(offset, size, queue, WTFMove(completionHandler));
         return;
@@ -81,6 +81,7 @@ public:
     static bool stringToHash(const String&, HashType&);
 
     static size_t hashStringLength() { return 2 * sizeof(m_hash); }
+    static String hashAsString(const HashType&);
     String hashAsString() const { return hashAsString(m_hash); }
     String partitionHashAsString() const { return hashAsString(m_partitionHash); }
 
@@ -91,7 +92,6 @@ public:
     bool operator!=(const Key& other) const { return !(*this == other); }
 
 private:
-    static String hashAsString(const HashType&);
     HashType computeHash(const Salt&) const;
     HashType computePartitionHash(const Salt&) const;
 
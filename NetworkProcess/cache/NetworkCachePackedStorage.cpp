@@ -0,0 +1,699 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkCachePackedStorage.h"
+
+#if ENABLE(NETWORK_CACHE)
+
+#include "Logging.h"
+#include "NetworkCacheFileSystem.h"
+#include <WebCore/FileSystem.h>
+#include <fcntl.h>
+#include <limits>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <wtf/RunLoop.h>
+#include <wtf/text/CString.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+static const char indexFileName[] = "index";
+static const char newIndexFileName[] = "index.new";
+static const char segmentFilePrefix[] = "segment-";
+
+static const uint32_t indexMagic = 0x4b435057; // "WPCK"
+static const uint32_t indexVersion = 1;
+static const size_t initialIndexCapacity = 4096;
+static const size_t maximumSegmentSize = 4 * 1024 * 1024;
+static const size_t maximumRecordSize = maximumSegmentSize;
+static const size_t compactionThreshold = maximumSegmentSize;
+
+struct PackedStorage::IndexHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t liveCount;
+    uint64_t deletedCount;
+};
+
+enum class IndexEntryState : uint8_t { Empty, Live, Deleted };
+
+struct PackedStorage::IndexEntry {
+    Key::HashType hash;
+    IndexEntryState state;
+    uint8_t padding[3];
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t reserved;
+    int64_t creationTime;
+    int64_t accessTime;
+};
+static_assert(sizeof(PackedStorage::IndexEntry) == 56, "Index entries are persisted");
+
+struct PackedStorage::Segment : public ThreadSafeRefCounted<Segment> {
+    Segment(unsigned number, int fileDescriptor, size_t size)
+        : number(number)
+        , fileDescriptor(fileDescriptor)
+        , size(size)
+    {
+    }
+
+    ~Segment()
+    {
+        close(fileDescriptor);
+    }
+
+    const unsigned number;
+    const int fileDescriptor;
+    // These are protected by the storage lock.
+    size_t size;
+    size_t liveSize { 0 };
+    unsigned pendingWriteCount { 0 };
+    bool isRemoved { false };
+};
+
+static bool isValidSegmentNumber(unsigned number)
+{
+    // 0 and the maximum value are reserved by the segment HashMap.
+    return number && number != std::numeric_limits<unsigned>::max();
+}
+
+static int64_t toSeconds(std::chrono::system_clock::time_point time)
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+static std::chrono::system_clock::time_point fromSeconds(int64_t seconds)
+{
+    return std::chrono::system_clock::time_point(std::chrono::seconds(seconds));
+}
+
+static size_t indexFileSize(size_t capacity)
+{
+    return sizeof(PackedStorage::IndexHeader) + capacity * sizeof(PackedStorage::IndexEntry);
+}
+
+static size_t slotForHash(const Key::HashType& hash, size_t capacity)
+{
+    uint64_t value;
+    memcpy(&value, hash.data(), sizeof(value));
+    return value & (capacity - 1);
+}
+
+static bool writeAll(int fd, const Data& data, size_t offset)
+{
+    bool success = true;
+    data.apply([fd, &offset, &success](const uint8_t* bytes, size_t size) {
+        while (size) {
+            ssize_t written = pwrite(fd, bytes, size, offset);
+            if (written < 0) {
+                if (errno == EINTR)
+                    continue;
+                success = false;
+                return false;
+            }
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+        return true;
+    });
+    return success;
+}
+
+std::unique_ptr<PackedStorage> PackedStorage::open(const String& directoryPath)
+{
+    if (!WebCore::makeAllDirectories(directoryPath))
+        return nullptr;
+
+    auto storage = std::unique_ptr<PackedStorage>(new PackedStorage(directoryPath));
+    std::lock_guard<Lock> locker(storage->m_lock);
+    if (!storage->mapIndex(0))
+        return nullptr;
+    if (!storage->openSegments())
+        return nullptr;
+
+    LOG(NetworkCacheStorage, "(NetworkProcess) opened packed storage count=%u size=%zu", storage->recordCount(), storage->approximateSize());
+    return storage;
+}
+
+PackedStorage::PackedStorage(const String& directoryPath)
+    : m_directoryPath(directoryPath.isolatedCopy())
+{
+}
+
+PackedStorage::~PackedStorage()
+{
+    if (m_indexMap)
+        munmap(m_indexMap, m_indexMapSize);
+    if (m_indexFileDescriptor != -1)
+        close(m_indexFileDescriptor);
+}
+
+PackedStorage::IndexHeader& PackedStorage::indexHeader() const
+{
+    return *static_cast<IndexHeader*>(m_indexMap);
+}
+
+PackedStorage::IndexEntry* PackedStorage::indexEntries() const
+{
+    return reinterpret_cast<IndexEntry*>(static_cast<uint8_t*>(m_indexMap) + sizeof(IndexHeader));
+}
+
+String PackedStorage::segmentPath(unsigned number) const
+{
+    return WebCore::pathByAppendingComponent(m_directoryPath, segmentFilePrefix + String::number(number));
+}
+
+// Maps the existing index if capacity is 0, otherwise builds a new index with the given capacity out of the current one.
+bool PackedStorage::mapIndex(size_t capacity)
+{
+    auto indexPath = WebCore::fileSystemRepresentation(WebCore::pathByAppendingComponent(m_directoryPath, indexFileName));
+
+    if (!capacity) {
+        int fd = ::open(indexPath.data(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+            return false;
+
+        struct stat stat;
+        IndexHeader header;
+        if (!fstat(fd, &stat) && static_cast<size_t>(stat.st_size) >= sizeof(header) && pread(fd, &header, sizeof(header), 0) == sizeof(header)) {
+            bool isValid = header.magic == indexMagic && header.version == indexVersion && header.capacity && !(header.capacity & (header.capacity - 1))
+                && static_cast<size_t>(stat.st_size) == indexFileSize(header.capacity);
+            if (isValid) {
+                void* map = mmap(nullptr, stat.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                if (map == MAP_FAILED) {
+                    close(fd);
+                    return false;
+                }
+                m_indexFileDescriptor = fd;
+                m_indexMap = map;
+                m_indexMapSize = stat.st_size;
+                return true;
+            }
+        }
+        close(fd);
+
+        // The index is missing or unusable. Segments can't be interpreted without it so start over.
+        LOG(NetworkCacheStorage, "(NetworkProcess) creating packed storage index");
+        capacity = initialIndexCapacity;
+    }
+
+    auto newIndexPath = WebCore::fileSystemRepresentation(WebCore::pathByAppendingComponent(m_directoryPath, newIndexFileName));
+    int fd = ::open(newIndexPath.data(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return false;
+
+    size_t size = indexFileSize(capacity);
+    if (ftruncate(fd, size) < 0) {
+        close(fd);
+        unlink(newIndexPath.data());
+        return false;
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        unlink(newIndexPath.data());
+        return false;
+    }
+
+    auto& header = *static_cast<IndexHeader*>(map);
+    header = { indexMagic, indexVersion, capacity, 0, 0 };
+    auto* entries = reinterpret_cast<IndexEntry*>(static_cast<uint8_t*>(map) + sizeof(IndexHeader));
+
+    if (m_indexMap) {
+        auto& oldHeader = indexHeader();
+        auto* oldEntries = indexEntries();
+        for (size_t i = 0; i < oldHeader.capacity; ++i) {
+            if (oldEntries[i].state != IndexEntryState::Live)
+                continue;
+            size_t slot = slotForHash(oldEntries[i].hash, capacity);
+            while (entries[slot].state != IndexEntryState::Empty)
+                slot = (slot + 1) & (capacity - 1);
+            entries[slot] = oldEntries[i];
+            ++header.liveCount;
+        }
+    }
+
+    // The current index stays in use if the new one can't replace it.
+    if (rename(newIndexPath.data(), indexPath.data()) < 0) {
+        munmap(map, size);
+        close(fd);
+        unlink(newIndexPath.data());
+        return false;
+    }
+
+    if (m_indexMap) {
+        munmap(m_indexMap, m_indexMapSize);
+        close(m_indexFileDescriptor);
+    }
+
+    m_indexFileDescriptor = fd;
+    m_indexMap = map;
+    m_indexMapSize = size;
+    return true;
+}
+
+bool PackedStorage::growIndexIfNeeded()
+{
+    auto& header = indexHeader();
+    // Keep the load factor, including removed entries, under 3/4.
+    if ((header.liveCount + header.deletedCount + 1) * 4 <= header.capacity * 3)
+        return true;
+
+    // If the table is mostly holding removed entries, rebuilding it at the same capacity is enough.
+    size_t capacity = header.liveCount * 2 > header.capacity ? header.capacity * 2 : header.capacity;
+    return mapIndex(capacity);
+}
+
+PackedStorage::IndexEntry* PackedStorage::findEntry(const Key::HashType& hash) const
+{
+    auto& header = indexHeader();
+    auto* entries = indexEntries();
+    for (size_t slot = slotForHash(hash, header.capacity); entries[slot].state != IndexEntryState::Empty; slot = (slot + 1) & (header.capacity - 1)) {
+        if (entries[slot].state == IndexEntryState::Live && entries[slot].hash == hash)
+            return &entries[slot];
+    }
+    return nullptr;
+}
+
+PackedStorage::IndexEntry& PackedStorage::findSlotForInsertion(const Key::HashType& hash)
+{
+    auto& header = indexHeader();
+    auto* entries = indexEntries();
+    IndexEntry* firstDeletedEntry = nullptr;
+    size_t slot = slotForHash(hash, header.capacity);
+    for (; entries[slot].state != IndexEntryState::Empty; slot = (slot + 1) & (header.capacity - 1)) {
+        if (entries[slot].state == IndexEntryState::Live && entries[slot].hash == hash)
+            return entries[slot];
+        if (entries[slot].state == IndexEntryState::Deleted && !firstDeletedEntry)
+            firstDeletedEntry = &entries[slot];
+    }
+    return firstDeletedEntry ? *firstDeletedEntry : entries[slot];
+}
+
+void PackedStorage::removeEntry(IndexEntry& entry)
+{
+    ASSERT(entry.state == IndexEntryState::Live);
+
+    if (auto* segment = m_segments.get(entry.segment))
+        segment->liveSize -= entry.size;
+    m_liveSize -= entry.size;
+    --m_liveCount;
+    m_removedSizeSinceCompaction += entry.size;
+
+    auto& header = indexHeader();
+    --header.liveCount;
+    ++header.deletedCount;
+    entry.state = IndexEntryState::Deleted;
+}
+
+bool PackedStorage::openSegments()
+{
+    traverseDirectory(m_directoryPath, [this](const String& fileName, DirectoryEntryType type) {
+        if (type != DirectoryEntryType::File || !fileName.startsWith(segmentFilePrefix))
+            return;
+        bool success;
+        unsigned number = fileName.substring(strlen(segmentFilePrefix)).toUIntStrict(&success);
+        if (!success || !isValidSegmentNumber(number))
+            return;
+
+        auto path = WebCore::fileSystemRepresentation(segmentPath(number));
+        int fd = ::open(path.data(), O_RDWR, 0);
+        if (fd < 0)
+            return;
+        struct stat stat;
+        if (fstat(fd, &stat) < 0) {
+            close(fd);
+            return;
+        }
+        m_segments.add(number, adoptRef(*new Segment(number, fd, stat.st_size)));
+    });
+
+    auto& header = indexHeader();
+    auto* entries = indexEntries();
+    for (size_t i = 0; i < header.capacity; ++i) {
+        auto& entry = entries[i];
+        if (entry.state != IndexEntryState::Live)
+            continue;
+        auto* segment = isValidSegmentNumber(entry.segment) ? m_segments.get(entry.segment) : nullptr;
+        if (!segment || static_cast<size_t>(entry.offset) + entry.size > segment->size) {
+            --header.liveCount;
+            ++header.deletedCount;
+            entry.state = IndexEntryState::Deleted;
+            continue;
+        }
+        segment->liveSize += entry.size;
+        m_liveSize += entry.size;
+        ++m_liveCount;
+    }
+
+    // Drop segments that hold no records anymore, including leftovers from a discarded index.
+    Vector<unsigned> emptySegmentNumbers;
+    for (auto& segment : m_segments.values()) {
+        if (!segment->liveSize)
+            emptySegmentNumbers.append(segment->number);
+        else
+            m_activeSegmentNumber = std::max(m_activeSegmentNumber, segment->number);
+    }
+    for (auto number : emptySegmentNumbers) {
+        unlink(WebCore::fileSystemRepresentation(segmentPath(number)).data());
+        m_segments.remove(number);
+    }
+
+    return true;
+}
+
+PackedStorage::Segment* PackedStorage::activeSegment()
+{
+    if (m_activeSegmentNumber) {
+        auto* segment = m_segments.get(m_activeSegmentNumber);
+        if (segment && segment->size < maximumSegmentSize)
+            return segment;
+    }
+
+    unsigned number = 1;
+    for (auto existingNumber : m_segments.keys())
+        number = std::max(number, existingNumber + 1);
+
+    auto path = WebCore::fileSystemRepresentation(segmentPath(number));
+    int fd = ::open(path.data(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return nullptr;
+
+    auto* segment = m_segments.add(number, adoptRef(*new Segment(number, fd, 0))).iterator->value.get();
+    m_activeSegmentNumber = number;
+    return segment;
+}
+
+Data PackedStorage::readRecord(Segment& segment, uint32_t offset, uint32_t size) const
+{
+    Vector<uint8_t> buffer(size);
+    size_t bytesRead = 0;
+    while (bytesRead < size) {
+        ssize_t result = pread(segment.fileDescriptor, buffer.data() + bytesRead, size - bytesRead, offset + bytesRead);
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0)
+            return { };
+        bytesRead += result;
+    }
+    return { buffer.data(), buffer.size() };
+}
+
+Data PackedStorage::get(const Key::HashType& hash)
+{
+    ASSERT(!RunLoop::isMain());
+
+    RefPtr<Segment> segment;
+    uint32_t offset;
+    uint32_t size;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        auto* entry = findEntry(hash);
+        if (!entry)
+            return { };
+        segment = m_segments.get(entry->segment);
+        if (!segment)
+            return { };
+        offset = entry->offset;
+        size = entry->size;
+    }
+    return readRecord(*segment, offset, size);
+}
+
+bool PackedStorage::contains(const Key::HashType& hash)
+{
+    ASSERT(!RunLoop::isMain());
+
+    std::lock_guard<Lock> locker(m_lock);
+    return findEntry(hash);
+}
+
+bool PackedStorage::add(const Key::HashType& hash, const Data& recordData)
+{
+    ASSERT(!RunLoop::isMain());
+
+    if (recordData.isEmpty() || recordData.size() > maximumRecordSize)
+        return false;
+
+    RefPtr<Segment> segment;
+    size_t offset;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        segment = activeSegment();
+        if (!segment)
+            return false;
+        offset = segment->size;
+        segment->size += recordData.size();
+        ++segment->pendingWriteCount;
+    }
+
+    // Appends to the same segment don't overlap so they can proceed in parallel.
+    bool success = writeAll(segment->fileDescriptor, recordData, offset);
+
+    std::lock_guard<Lock> locker(m_lock);
+    --segment->pendingWriteCount;
+    if (!success || segment->isRemoved || !growIndexIfNeeded())
+        return false;
+
+    auto& entry = findSlotForInsertion(hash);
+    auto& header = indexHeader();
+    if (entry.state == IndexEntryState::Live)
+        removeEntry(entry);
+    if (entry.state == IndexEntryState::Deleted)
+        --header.deletedCount;
+
+    entry.hash = hash;
+    entry.segment = segment->number;
+    entry.offset = offset;
+    entry.size = recordData.size();
+    entry.creationTime = toSeconds(std::chrono::system_clock::now());
+    entry.accessTime = entry.creationTime;
+    entry.state = IndexEntryState::Live;
+    ++header.liveCount;
+
+    segment->liveSize += entry.size;
+    m_liveSize += entry.size;
+    ++m_liveCount;
+    return true;
+}
+
+size_t PackedStorage::remove(const Key::HashType& hash)
+{
+    ASSERT(!RunLoop::isMain());
+
+    std::lock_guard<Lock> locker(m_lock);
+    auto* entry = findEntry(hash);
+    if (!entry)
+        return 0;
+    size_t size = entry->size;
+    removeEntry(*entry);
+    return size;
+}
+
+void PackedStorage::updateAccessTime(const Key::HashType& hash)
+{
+    ASSERT(!RunLoop::isMain());
+
+    std::lock_guard<Lock> locker(m_lock);
+    if (auto* entry = findEntry(hash))
+        entry->accessTime = toSeconds(std::chrono::system_clock::now());
+}
+
+void PackedStorage::clear()
+{
+    ASSERT(!RunLoop::isMain());
+
+    std::lock_guard<Lock> locker(m_lock);
+    for (auto& segment : m_segments.values()) {
+        segment->isRemoved = true;
+        unlink(WebCore::fileSystemRepresentation(segmentPath(segment->number)).data());
+    }
+    m_segments.clear();
+    m_activeSegmentNumber = 0;
+
+    auto& header = indexHeader();
+    memset(indexEntries(), 0, header.capacity * sizeof(IndexEntry));
+    header.liveCount = 0;
+    header.deletedCount = 0;
+    m_liveSize = 0;
+    m_liveCount = 0;
+    m_removedSizeSinceCompaction = 0;
+}
+
+void PackedStorage::forEachRecordInfo(const Function<void (const RecordInfo&)>& function)
+{
+    ASSERT(!RunLoop::isMain());
+
+    Vector<RecordInfo> infos;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        auto& header = indexHeader();
+        auto* entries = indexEntries();
+        infos.reserveInitialCapacity(header.liveCount);
+        for (size_t i = 0; i < header.capacity; ++i) {
+            auto& entry = entries[i];
+            if (entry.state == IndexEntryState::Live)
+                infos.append(RecordInfo { entry.hash, entry.size, fromSeconds(entry.creationTime), fromSeconds(entry.accessTime) });
+        }
+    }
+
+    for (auto& info : infos)
+        function(info);
+}
+
+void PackedStorage::traverse(const TraverseHandler& handler)
+{
+    ASSERT(!RunLoop::isMain());
+
+    forEachRecordInfo([this, &handler](const RecordInfo& info) {
+        handler(info, [this, &info] {
+            return get(info.hash);
+        });
+    });
+}
+
+bool PackedStorage::moveRecord(Segment& sourceSegment, const Key::HashType& hash, uint32_t offset, uint32_t size)
+{
+    auto recordData = readRecord(sourceSegment, offset, size);
+    if (recordData.isNull())
+        return false;
+
+    RefPtr<Segment> targetSegment;
+    size_t targetOffset;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        targetSegment = activeSegment();
+        if (!targetSegment)
+            return false;
+        targetOffset = targetSegment->size;
+        targetSegment->size += size;
+        ++targetSegment->pendingWriteCount;
+    }
+
+    bool success = writeAll(targetSegment->fileDescriptor, recordData, targetOffset);
+
+    std::lock_guard<Lock> locker(m_lock);
+    --targetSegment->pendingWriteCount;
+    if (!success || targetSegment->isRemoved)
+        return false;
+
+    // The record may have been replaced or removed while it was copied, in which case the copy is just dead space.
+    auto* entry = findEntry(hash);
+    if (!entry || entry->segment != sourceSegment.number || entry->offset != offset)
+        return true;
+
+    sourceSegment.liveSize -= size;
+    targetSegment->liveSize += size;
+    entry->segment = targetSegment->number;
+    entry->offset = targetOffset;
+    return true;
+}
+
+void PackedStorage::compactSegment(Segment& segment)
+{
+    struct LiveRecord {
+        Key::HashType hash;
+        uint32_t offset;
+        uint32_t size;
+    };
+    Vector<LiveRecord> liveRecords;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        auto& header = indexHeader();
+        auto* entries = indexEntries();
+        for (size_t i = 0; i < header.capacity; ++i) {
+            auto& entry = entries[i];
+            if (entry.state == IndexEntryState::Live && entry.segment == segment.number)
+                liveRecords.append({ entry.hash, entry.offset, entry.size });
+        }
+    }
+
+    // The segment is no longer active so nothing is appended to it, and readers keep it alive while they use it.
+    for (auto& record : liveRecords) {
+        if (!moveRecord(segment, record.hash, record.offset, record.size))
+            break;
+    }
+
+    std::lock_guard<Lock> locker(m_lock);
+    if (segment.isRemoved)
+        return;
+
+    // Drop whatever couldn't be moved.
+    auto& header = indexHeader();
+    auto* entries = indexEntries();
+    for (size_t i = 0; i < header.capacity; ++i) {
+        auto& entry = entries[i];
+        if (entry.state == IndexEntryState::Live && entry.segment == segment.number)
+            removeEntry(entry);
+    }
+
+    segment.isRemoved = true;
+    unlink(WebCore::fileSystemRepresentation(segmentPath(segment.number)).data());
+    m_segments.remove(segment.number);
+}
+
+void PackedStorage::compactIfNeeded()
+{
+    ASSERT(!RunLoop::isMain());
+
+    Vector<RefPtr<Segment>> segmentsToCompact;
+    {
+        std::lock_guard<Lock> locker(m_lock);
+        if (m_isCompacting || m_removedSizeSinceCompaction < compactionThreshold)
+            return;
+
+        for (auto& segment : m_segments.values()) {
+            if (segment->number == m_activeSegmentNumber || segment->pendingWriteCount)
+                continue;
+            // Compact segments that are mostly made of removed records.
+            if (segment->liveSize * 2 < segment->size)
+                segmentsToCompact.append(segment);
+        }
+        m_removedSizeSinceCompaction = 0;
+        if (segmentsToCompact.isEmpty())
+            return;
+        m_isCompacting = true;
+    }
+
+    for (auto& segment : segmentsToCompact) {
+        LOG(NetworkCacheStorage, "(NetworkProcess) compacting segment %u size=%zu liveSize=%zu", segment->number, segment->size, segment->liveSize);
+        compactSegment(*segment);
+    }
+
+    std::lock_guard<Lock> locker(m_lock);
+    m_isCompacting = false;
+}
+
+}
+}
+
+#endif
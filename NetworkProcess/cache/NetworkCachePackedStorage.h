@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#if ENABLE(NETWORK_CACHE)
+
+#include "NetworkCacheData.h"
+#include "NetworkCacheKey.h"
+#include <chrono>
+#include <wtf/Function.h>
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
+#include <wtf/ThreadSafeRefCounted.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+// PackedStorage stores records in a few append-only segment files instead of one file per record.
+// Records are located through an open addressing hash table kept in a memory-mapped index file,
+// so opening the store and enumerating its contents doesn't touch the file system per record.
+// Segments that mostly contain removed records are compacted in the background once enough data has been removed.
+class PackedStorage {
+    WTF_MAKE_NONCOPYABLE(PackedStorage); WTF_MAKE_FAST_ALLOCATED;
+public:
+    // Opening only maps the index and scans it, it is cheap enough to do at startup.
+    static std::unique_ptr<PackedStorage> open(const String& directoryPath);
+    ~PackedStorage();
+
+    // These are all synchronous, thread safe and should not be used from the main thread.
+    Data get(const Key::HashType&);
+    bool contains(const Key::HashType&);
+    // Replaces any existing record with the same hash.
+    bool add(const Key::HashType&, const Data& recordData);
+    // Returns the size of the removed record.
+    size_t remove(const Key::HashType&);
+    void updateAccessTime(const Key::HashType&);
+    void clear();
+
+    struct RecordInfo {
+        Key::HashType hash;
+        size_t size;
+        std::chrono::system_clock::time_point creationTime;
+        std::chrono::system_clock::time_point accessTime;
+    };
+    // Record data is only read if the handler asks for it.
+    using TraverseHandler = Function<void (const RecordInfo&, const Function<Data ()>& readRecord)>;
+    void traverse(const TraverseHandler&);
+    void forEachRecordInfo(const Function<void (const RecordInfo&)>&);
+
+    size_t approximateSize() const { return m_liveSize; }
+    unsigned recordCount() const { return m_liveCount; }
+
+    // Cheap unless enough data was removed since the last compaction. Records are copied without holding
+    // the lock, so reads and writes proceed during compaction.
+    void compactIfNeeded();
+
+    struct IndexHeader;
+    struct IndexEntry;
+
+private:
+    struct Segment;
+
+    explicit PackedStorage(const String& directoryPath);
+
+    IndexHeader& indexHeader() const;
+    IndexEntry* indexEntries() const;
+    bool mapIndex(size_t capacity);
+    bool growIndexIfNeeded();
+    IndexEntry* findEntry(const Key::HashType&) const;
+    IndexEntry& findSlotForInsertion(const Key::HashType&);
+    void removeEntry(IndexEntry&);
+
+    bool openSegments();
+    Segment* activeSegment();
+    String segmentPath(unsigned number) const;
+    Data readRecord(Segment&, uint32_t offset, uint32_t size) const;
+    void compactSegment(Segment&);
+    bool moveRecord(Segment& sourceSegment, const Key::HashType&, uint32_t offset, uint32_t size);
+
+    const String m_directoryPath;
+
+    mutable Lock m_lock;
+    int m_indexFileDescriptor { -1 };
+    void* m_indexMap { nullptr };
+    size_t m_indexMapSize { 0 };
+    HashMap<unsigned, RefPtr<Segment>> m_segments;
+    unsigned m_activeSegmentNumber { 0 };
+    size_t m_removedSizeSinceCompaction { 0 };
+    bool m_isCompacting { false };
+
+    std::atomic<size_t> m_liveSize { 0 };
+    std::atomic<unsigned> m_liveCount { 0 };
+};
+
+}
+}
+
+#endif
@@ -319,6 +319,20 @@ void Statistics::recordRevalidationSuccess(uint64_t webPageID, const Key& key, c
     NetworkProcess::singleton().logDiagnosticMessageWithResult(webPageID, WebCore::DiagnosticLoggingKeys::networkCacheKey(), WebCore::DiagnosticLoggingKeys::revalidatingKey(), WebCore::DiagnosticLoggingResultPass, WebCore::ShouldSample::Yes);
 }
 
+void Statistics::recordContentsFilterStatistics(const Storage::ContentsFilterStatistics& statistics)
+{
+    m_contentsFilterStatistics = statistics;
+
+    LOG(NetworkCache, "(NetworkProcess) contents filter records=%zu false positive rate=%f expected=%f", statistics.recordCount, contentsFilterFalsePositiveRate(), statistics.expectedFalsePositiveRate);
+}
+
+double Statistics::contentsFilterFalsePositiveRate() const
+{
+    if (!m_contentsFilterStatistics.positiveCount)
+        return 0;
+    return static_cast<double>(m_contentsFilterStatistics.falsePositiveCount) / m_contentsFilterStatistics.positiveCount;
+}
+
 void Statistics::markAsRequested(const String& hash)
 {
     ASSERT(RunLoop::isMain());
@@ -54,6 +54,11 @@ public:
     void recordRetrievalFailure(uint64_t webPageID, const Key&, const WebCore::ResourceRequest&);
     void recordRetrievedCachedEntry(uint64_t webPageID, const Key&, const WebCore::ResourceRequest&, UseDecision);
     void recordRevalidationSuccess(uint64_t webPageID, const Key&, const WebCore::ResourceRequest&);
+    void recordContentsFilterStatistics(const Storage::ContentsFilterStatistics&);
+
+    // Share of storage lookups that passed the contents filter but didn't find a record.
+    double contentsFilterFalsePositiveRate() const;
+    double expectedContentsFilterFalsePositiveRate() const { return m_contentsFilterStatistics.expectedFalsePositiveRate; }
 
 private:
     WorkQueue& serialBackgroundIOQueue() { return m_serialBackgroundIOQueue.get(); }
@@ -78,6 +83,7 @@ private:
     };
 
     std::atomic<size_t> m_approximateEntryCount { 0 };
+    Storage::ContentsFilterStatistics m_contentsFilterStatistics { 0, 0, 0, 0 };
 
     mutable Ref<WorkQueue> m_serialBackgroundIOQueue;
     mutable HashSet<std::unique_ptr<const EverRequestedQuery>> m_activeQueries;
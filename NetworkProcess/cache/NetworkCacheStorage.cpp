@@ -32,7 +32,10 @@
 #include "NetworkCacheCoders.h"
 #include "NetworkCacheFileSystem.h"
 #include "NetworkCacheIOChannel.h"
+#include "NetworkCacheWriteBatch.h"
+#include <fcntl.h>
 #include <mutex>
+#include <unistd.h>
 #include <wtf/Condition.h>
 #include <wtf/Lock.h>
 #include <wtf/RandomNumber.h>
@@ -47,6 +50,28 @@ static const char versionDirectoryPrefix[] = "Version ";
 static const char recordsDirectoryName[] = "Records";
 static const char blobsDirectoryName[] = "Blobs";
 static const char blobSuffix[] = "-blob";
+static const char packedDirectoryName[] = "Packed";
+static const char packedBlobLinksDirectoryName[] = "BlobLinks";
+static const char indexFileName[] = "Index";
+static const char newIndexFileSuffix[] = ".new";
+
+static const uint32_t indexMagic = 0x58444e49; // "INDX"
+static const uint32_t indexFormatVersion = 2;
+
+struct IndexFileHeader {
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint32_t isDirty;
+    uint32_t isPacked;
+    // The checksum covers the fields below and the filters that follow the header.
+    SHA1::Digest checksum;
+    uint32_t recordFilterSize;
+    uint32_t blobFilterSize;
+    uint32_t reserved;
+    uint64_t recordsSize;
+    uint64_t blobsSize;
+};
+static_assert(sizeof(IndexFileHeader) == 64, "IndexFileHeader must not have padding");
 
 static double computeRecordWorth(FileTimes);
 
@@ -69,6 +94,7 @@ public:
     BlobStorage::Blob resultBodyBlob;
     std::atomic<unsigned> activeCount { 0 };
     bool isCanceled { false };
+    bool isRecordMissing { false };
 };
 
 void Storage::ReadOperation::cancel()
@@ -144,12 +170,22 @@ static String makeBlobDirectoryPath(const String& baseDirectoryPath)
     return WebCore::pathByAppendingComponent(makeVersionedDirectoryPath(baseDirectoryPath), blobsDirectoryName);
 }
 
+static String makePackedDirectoryPath(const String& baseDirectoryPath)
+{
+    return WebCore::pathByAppendingComponent(makeVersionedDirectoryPath(baseDirectoryPath), packedDirectoryName);
+}
+
+static String makeIndexFilePath(const String& baseDirectoryPath)
+{
+    return WebCore::pathByAppendingComponent(makeVersionedDirectoryPath(baseDirectoryPath), indexFileName);
+}
+
 static String makeSaltFilePath(const String& baseDirectoryPath)
 {
     return WebCore::pathByAppendingComponent(makeVersionedDirectoryPath(baseDirectoryPath), saltFileName);
 }
 
-std::unique_ptr<Storage> Storage::open(const String& cachePath, Mode mode)
+std::unique_ptr<Storage> Storage::open(const String& cachePath, Mode mode, Backend backend)
 {
     ASSERT(RunLoop::isMain());
 
@@ -158,7 +194,26 @@ std::unique_ptr<Storage> Storage::open(const String& cachePath, Mode mode)
     auto salt = readOrMakeSalt(makeSaltFilePath(cachePath));
     if (!salt)
         return nullptr;
-    return std::unique_ptr<Storage>(new Storage(cachePath, mode, *salt));
+
+    std::unique_ptr<PackedStorage> packedStorage;
+    if (backend == Backend::Packed) {
+        auto packedDirectoryPath = makePackedDirectoryPath(cachePath);
+        auto blobLinksPath = WebCore::pathByAppendingComponent(packedDirectoryPath, packedBlobLinksDirectoryName);
+        if (!WebCore::makeAllDirectories(blobLinksPath))
+            return nullptr;
+        packedStorage = PackedStorage::open(packedDirectoryPath);
+        if (!packedStorage)
+            return nullptr;
+        // Links left behind by a discarded index would keep their blobs alive forever.
+        if (!packedStorage->recordCount()) {
+            traverseDirectory(blobLinksPath, [&blobLinksPath](const String& fileName, DirectoryEntryType type) {
+                if (type == DirectoryEntryType::File)
+                    WebCore::deleteFile(WebCore::pathByAppendingComponent(blobLinksPath, fileName));
+            });
+        }
+    }
+
+    return std::unique_ptr<Storage>(new Storage(cachePath, mode, *salt, WTFMove(packedStorage)));
 }
 
 void traverseRecordsFiles(const String& recordsPath, const String& expectedType, const RecordFileTraverseFunction& function)
@@ -207,7 +262,7 @@ static void deleteEmptyRecordsDirectories(const String& recordsPath)
     });
 }
 
-Storage::Storage(const String& baseDirectoryPath, Mode mode, Salt salt)
+Storage::Storage(const String& baseDirectoryPath, Mode mode, Salt salt, std::unique_ptr<PackedStorage> packedStorage)
     : m_basePath(baseDirectoryPath)
     , m_recordsPath(makeRecordsDirectoryPath(baseDirectoryPath))
     , m_mode(mode)
@@ -215,10 +270,12 @@ Storage::Storage(const String& baseDirectoryPath, Mode mode, Salt salt)
     , m_canUseSharedMemoryForBodyData(canUseSharedMemoryForPath(baseDirectoryPath))
     , m_readOperationTimeoutTimer(*this, &Storage::cancelAllReadOperations)
     , m_writeOperationDispatchTimer(*this, &Storage::dispatchPendingWriteOperations)
+    , m_indexCheckpointTimer(*this, &Storage::checkpointIndex)
     , m_ioQueue(WorkQueue::create("com.apple.WebKit.Cache.Storage", WorkQueue::Type::Concurrent))
     , m_backgroundIOQueue(WorkQueue::create("com.apple.WebKit.Cache.Storage.background", WorkQueue::Type::Concurrent, WorkQueue::QOS::Background))
     , m_serialBackgroundIOQueue(WorkQueue::create("com.apple.WebKit.Cache.Storage.serialBackground", WorkQueue::Type::Serial, WorkQueue::QOS::Background))
     , m_blobStorage(makeBlobDirectoryPath(baseDirectoryPath), m_salt)
+    , m_packedStorage(WTFMove(packedStorage))
 {
     deleteOldVersions();
     synchronize();
@@ -243,8 +300,15 @@ String Storage::recordsPath() const
     return m_recordsPath.isolatedCopy();
 }
 
+String Storage::indexPath() const
+{
+    return makeIndexFilePath(basePath());
+}
+
 size_t Storage::approximateSize() const
 {
+    if (m_packedStorage)
+        return m_packedStorage->approximateSize() + m_blobStorage.approximateSize();
     return m_approximateRecordsSize + m_blobStorage.approximateSize();
 }
 
@@ -256,62 +320,228 @@ void Storage::synchronize()
         return;
     m_synchronizationInProgress = true;
 
+    bool shouldSynchronizeFromIndex = m_shouldSynchronizeFromIndex;
+    m_shouldSynchronizeFromIndex = false;
+    size_t expectedRecordCount = this->expectedRecordCount();
+
     LOG(NetworkCacheStorage, "(NetworkProcess) synchronizing cache");
 
-    backgroundIOQueue().dispatch([this] {
-        auto recordFilter = std::make_unique<ContentsFilter>();
-        auto blobFilter = std::make_unique<ContentsFilter>();
+    backgroundIOQueue().dispatch([this, shouldSynchronizeFromIndex, expectedRecordCount] {
+        std::unique_ptr<ContentsFilter> recordFilter;
+        std::unique_ptr<ContentsFilter> blobFilter;
         size_t recordsSize = 0;
+        size_t blobsSize = 0;
         unsigned count = 0;
-        String anyType;
-        traverseRecordsFiles(recordsPath(), anyType, [&recordFilter, &blobFilter, &recordsSize, &count](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
-            auto filePath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
 
-            Key::HashType hash;
-            if (!Key::stringToHash(hashString, hash)) {
-                WebCore::deleteFile(filePath);
-                return;
-            }
-            long long fileSize = 0;
-            WebCore::getFileSize(filePath, fileSize);
-            if (!fileSize) {
-                WebCore::deleteFile(filePath);
-                return;
-            }
+        bool didLoadIndex = shouldSynchronizeFromIndex && loadIndex(recordFilter, blobFilter, recordsSize, blobsSize);
+        if (!didLoadIndex) {
+            recordFilter = std::make_unique<ContentsFilter>(expectedRecordCount);
+            blobFilter = std::make_unique<ContentsFilter>(expectedRecordCount);
+        }
 
-            if (isBlob) {
-                blobFilter->add(hash);
-                return;
-            }
+        if (didLoadIndex) {
+            // Unreferenced blobs and empty directories are cleaned up by the next full synchronization.
+            m_blobStorage.setApproximateSize(blobsSize);
+        } else if (m_packedStorage) {
+            // The packed index knows all the records so there is no need to walk the file system.
+            m_packedStorage->forEachRecordInfo([&recordFilter, &blobFilter, &recordsSize, &count](const PackedStorage::RecordInfo& info) {
+                recordFilter->add(info.hash);
+                // Whether the body is a blob is only known after decoding the record. A false positive just fails to open the link.
+                blobFilter->add(info.hash);
+                recordsSize += info.size;
+                ++count;
+            });
+        } else {
+            String anyType;
+            traverseRecordsFiles(recordsPath(), anyType, [&recordFilter, &blobFilter, &recordsSize, &count](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
+                auto filePath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
+
+                Key::HashType hash;
+                if (!Key::stringToHash(hashString, hash)) {
+                    WebCore::deleteFile(filePath);
+                    return;
+                }
+                long long fileSize = 0;
+                WebCore::getFileSize(filePath, fileSize);
+                if (!fileSize) {
+                    WebCore::deleteFile(filePath);
+                    return;
+                }
 
-            recordFilter->add(hash);
-            recordsSize += fileSize;
-            ++count;
-        });
+                if (isBlob) {
+                    blobFilter->add(hash);
+                    return;
+                }
 
-        RunLoop::main().dispatch([this, recordFilter = WTFMove(recordFilter), blobFilter = WTFMove(blobFilter), recordsSize]() mutable {
+                recordFilter->add(hash);
+                recordsSize += fileSize;
+                ++count;
+            });
+        }
+
+        RunLoop::main().dispatch([this, recordFilter = WTFMove(recordFilter), blobFilter = WTFMove(blobFilter), recordsSize, didLoadIndex]() mutable {
+            // Removals during synchronization are not replayed. The traversal may not have seen the deleted
+            // file, and removing a key that isn't in the filter could drop a colliding one. A stale positive is
+            // better than a missed entry.
             for (auto& recordFilterKey : m_recordFilterHashesAddedDuringSynchronization)
                 recordFilter->add(recordFilterKey);
             m_recordFilterHashesAddedDuringSynchronization.clear();
+            // Writes still in flight may land after the traversal and remove their extra entry when they finish.
+            addWriteOperationsToRecordFilter(*recordFilter);
 
             for (auto& hash : m_blobFilterHashesAddedDuringSynchronization)
                 blobFilter->add(hash);
             m_blobFilterHashesAddedDuringSynchronization.clear();
 
+
             m_recordFilter = WTFMove(recordFilter);
             m_blobFilter = WTFMove(blobFilter);
             m_approximateRecordsSize = recordsSize;
             m_synchronizationInProgress = false;
+
+            if (!didLoadIndex)
+                indexDidChange();
         });
 
+        if (didLoadIndex) {
+            LOG(NetworkCacheStorage, "(NetworkProcess) cache synchronized from index size=%zu", recordsSize);
+            return;
+        }
+
         m_blobStorage.synchronize();
 
-        deleteEmptyRecordsDirectories(recordsPath());
+        if (!m_packedStorage)
+            deleteEmptyRecordsDirectories(recordsPath());
 
         LOG(NetworkCacheStorage, "(NetworkProcess) cache synchronization completed size=%zu count=%u", recordsSize, count);
     });
 }
 
+static SHA1::Digest computeIndexChecksum(const uint8_t* indexData, size_t indexSize, const Salt& salt)
+{
+    size_t checksummedOffset = offsetof(IndexFileHeader, recordFilterSize);
+    return computeSHA1(Data(indexData + checksummedOffset, indexSize - checksummedOffset), salt);
+}
+
+bool Storage::loadIndex(std::unique_ptr<ContentsFilter>& recordFilter, std::unique_ptr<ContentsFilter>& blobFilter, size_t& recordsSize, size_t& blobsSize)
+{
+    ASSERT(!RunLoop::isMain());
+
+    auto indexData = mapFile(WebCore::fileSystemRepresentation(indexPath()).data());
+    if (indexData.size() < sizeof(IndexFileHeader))
+        return false;
+
+    IndexFileHeader header;
+    memcpy(&header, indexData.data(), sizeof(header));
+    if (header.magic != indexMagic || header.formatVersion != indexFormatVersion)
+        return false;
+    if (indexData.size() != sizeof(header) + header.recordFilterSize + header.blobFilterSize)
+        return false;
+    if (header.isDirty || header.isPacked != !!m_packedStorage) {
+        LOG(NetworkCacheStorage, "(NetworkProcess) index is stale");
+        return false;
+    }
+    if (header.checksum != computeIndexChecksum(indexData.data(), indexData.size(), m_salt)) {
+        LOG(NetworkCacheStorage, "(NetworkProcess) index checksum mismatch");
+        return false;
+    }
+
+    auto* filterData = indexData.data() + sizeof(header);
+    recordFilter = ContentsFilter::decode(filterData, header.recordFilterSize);
+    blobFilter = ContentsFilter::decode(filterData + header.recordFilterSize, header.blobFilterSize);
+    if (!recordFilter || !blobFilter)
+        return false;
+
+    recordsSize = header.recordsSize;
+    blobsSize = header.blobsSize;
+    return true;
+}
+
+void Storage::indexDidChange()
+{
+    ASSERT(RunLoop::isMain());
+
+    if (!m_indexFileIsDirty) {
+        m_indexFileIsDirty = true;
+        serialBackgroundIOQueue().dispatch([this] {
+            markIndexFileDirty();
+        });
+    }
+
+    // Changes are batched. The file stays marked dirty until the checkpoint is written.
+    static const Seconds indexCheckpointDelay = 5_s;
+    if (!m_indexCheckpointTimer.isActive())
+        m_indexCheckpointTimer.startOneShot(indexCheckpointDelay);
+}
+
+void Storage::checkpointIndex()
+{
+    ASSERT(RunLoop::isMain());
+
+    // Synchronization completion checkpoints again.
+    if (m_synchronizationInProgress || !m_recordFilter || !m_blobFilter)
+        return;
+
+    Vector<uint8_t> indexData(sizeof(IndexFileHeader));
+    m_recordFilter->encode(indexData);
+    size_t recordFilterSize = indexData.size() - sizeof(IndexFileHeader);
+    m_blobFilter->encode(indexData);
+
+    IndexFileHeader header { };
+    header.magic = indexMagic;
+    header.formatVersion = indexFormatVersion;
+    header.isPacked = !!m_packedStorage;
+    header.recordFilterSize = recordFilterSize;
+    header.blobFilterSize = indexData.size() - sizeof(IndexFileHeader) - recordFilterSize;
+    header.recordsSize = m_packedStorage ? m_packedStorage->approximateSize() : m_approximateRecordsSize;
+    header.blobsSize = m_blobStorage.approximateSize();
+    memcpy(indexData.data(), &header, sizeof(header));
+
+    m_indexFileIsDirty = false;
+
+    serialBackgroundIOQueue().dispatch([this, indexData = WTFMove(indexData)] () mutable {
+        writeIndex(WTFMove(indexData));
+    });
+}
+
+void Storage::writeIndex(Vector<uint8_t>&& indexData)
+{
+    ASSERT(!RunLoop::isMain());
+
+    auto checksum = computeIndexChecksum(indexData.data(), indexData.size(), m_salt);
+    memcpy(indexData.data() + offsetof(IndexFileHeader, checksum), checksum.data(), checksum.size());
+
+    auto path = WebCore::fileSystemRepresentation(indexPath());
+    auto newPath = WebCore::fileSystemRepresentation(indexPath() + newIndexFileSuffix);
+    if (Data(indexData.data(), indexData.size()).mapToFile(newPath.data()).isNull() || rename(newPath.data(), path.data()) < 0) {
+        // A leftover temporary file would make the next checkpoint fail as well.
+        unlink(newPath.data());
+        LOG(NetworkCacheStorage, "(NetworkProcess) failed to write index checkpoint");
+
+        // The index file on disk is still marked dirty, the next change schedules another checkpoint.
+        RunLoop::main().dispatch([this] {
+            m_indexFileIsDirty = true;
+        });
+        return;
+    }
+
+    LOG(NetworkCacheStorage, "(NetworkProcess) index checkpoint written");
+}
+
+void Storage::markIndexFileDirty()
+{
+    ASSERT(!RunLoop::isMain());
+
+    auto path = WebCore::fileSystemRepresentation(indexPath());
+    int fd = open(path.data(), O_WRONLY, 0);
+    if (fd < 0)
+        return;
+    uint32_t isDirty = 1;
+    if (pwrite(fd, &isDirty, sizeof(isDirty), offsetof(IndexFileHeader, isDirty)) != sizeof(isDirty))
+        unlink(path.data());
+    close(fd);
+}
+
 void Storage::addToRecordFilter(const Key& key)
 {
     ASSERT(RunLoop::isMain());
@@ -322,6 +552,50 @@ void Storage::addToRecordFilter(const Key& key)
     // If we get new entries during filter synchronization take care to add them to the new filter as well.
     if (m_synchronizationInProgress)
         m_recordFilterHashesAddedDuringSynchronization.append(key.hash());
+
+    indexDidChange();
+}
+
+void Storage::addWriteOperationsToRecordFilter(ContentsFilter& recordFilter)
+{
+    ASSERT(RunLoop::isMain());
+
+    // Every write operation stands for one entry in the record filter until it finishes.
+    for (auto& writeOperation : m_pendingWriteOperations)
+        recordFilter.add(writeOperation->record.key.hash());
+    for (auto& writeOperation : m_activeWriteOperations)
+        recordFilter.add(writeOperation->record.key.hash());
+}
+
+void Storage::removeFromFilters(const Key::HashType& hash, DeletedFiles deletedFiles)
+{
+    ASSERT(RunLoop::isMain());
+
+    if (m_recordFilter && deletedFiles.record)
+        m_recordFilter->remove(hash);
+    if (m_blobFilter && deletedFiles.blob)
+        m_blobFilter->remove(hash);
+
+    indexDidChange();
+}
+
+size_t Storage::expectedRecordCount() const
+{
+    const size_t assumedAverageRecordSize = 50 << 10;
+    const size_t maximumExpectedRecordCount = 1 << 20;
+    return std::min(m_capacity / assumedAverageRecordSize, maximumExpectedRecordCount);
+}
+
+auto Storage::contentsFilterStatistics() const -> ContentsFilterStatistics
+{
+    ASSERT(RunLoop::isMain());
+
+    return {
+        m_recordFilter ? m_recordFilter->itemCount() : 0,
+        m_recordFilter ? m_recordFilter->expectedFalsePositiveRate() : 1,
+        m_recordFilterPositiveCount,
+        m_recordFilterFalsePositiveCount
+    };
 }
 
 bool Storage::mayContain(const Key& key) const
@@ -352,8 +626,20 @@ static String blobPathForRecordPath(const String& recordPath)
     return recordPath + blobSuffix;
 }
 
+String Storage::packedBlobLinksPath() const
+{
+    return WebCore::pathByAppendingComponent(makePackedDirectoryPath(basePath()), packedBlobLinksDirectoryName);
+}
+
+String Storage::packedBlobPathForHash(const Key::HashType& hash) const
+{
+    return WebCore::pathByAppendingComponent(packedBlobLinksPath(), Key::hashAsString(hash));
+}
+
 String Storage::blobPathForKey(const Key& key) const
 {
+    if (m_packedStorage)
+        return packedBlobPathForHash(key.hash());
     return blobPathForRecordPath(recordPathForKey(key));
 }
 
@@ -485,6 +771,9 @@ std::optional<BlobStorage::Blob> Storage::storeBodyAsBlob(WriteOperation& writeO
 {
     auto blobPath = blobPathForKey(writeOperation.record.key);
 
+    // A replaced blob already has its entry in the blob filter.
+    bool blobExisted = WebCore::fileExists(blobPath);
+
     // Store the body.
     auto blob = m_blobStorage.add(blobPath, writeOperation.record.body);
     if (blob.data.isNull())
@@ -492,10 +781,10 @@ std::optional<BlobStorage::Blob> Storage::storeBodyAsBlob(WriteOperation& writeO
 
     ++writeOperation.activeCount;
 
-    RunLoop::main().dispatch([this, blob, &writeOperation] {
-        if (m_blobFilter)
+    RunLoop::main().dispatch([this, blob, blobExisted, &writeOperation] {
+        if (m_blobFilter && !blobExisted)
             m_blobFilter->add(writeOperation.record.key.hash());
-        if (m_synchronizationInProgress)
+        if (m_synchronizationInProgress && !blobExisted)
             m_blobFilterHashesAddedDuringSynchronization.append(writeOperation.record.key.hash());
 
         if (writeOperation.mappedBodyHandler)
@@ -506,7 +795,7 @@ std::optional<BlobStorage::Blob> Storage::storeBodyAsBlob(WriteOperation& writeO
     return blob;
 }
 
-Data Storage::encodeRecord(const Record& record, std::optional<BlobStorage::Blob> blob)
+Vector<Data> Storage::encodeRecordSegments(const Record& record, std::optional<BlobStorage::Blob> blob)
 {
     ASSERT(!blob || bytesEqual(blob.value().data, record.body));
 
@@ -518,13 +807,21 @@ Data Storage::encodeRecord(const Record& record, std::optional<BlobStorage::Blob
     metaData.bodySize = record.body.size();
     metaData.isBodyInline = !blob;
 
-    auto encodedMetaData = encodeRecordMetaData(metaData);
-    auto headerData = concatenate(encodedMetaData, record.header);
-
+    Vector<Data> segments;
+    segments.append(encodeRecordMetaData(metaData));
+    segments.append(record.header);
     if (metaData.isBodyInline)
-        return concatenate(headerData, record.body);
+        segments.append(record.body);
+    return segments;
+}
 
-    return { headerData };
+Data Storage::encodeRecord(const Record& record, std::optional<BlobStorage::Blob> blob)
+{
+    auto segments = encodeRecordSegments(record, blob);
+    Data recordData = segments[0];
+    for (size_t i = 1; i < segments.size(); ++i)
+        recordData = concatenate(recordData, segments[i]);
+    return recordData;
 }
 
 void Storage::removeFromPendingWriteOperations(const Key& key)
@@ -538,6 +835,9 @@ void Storage::removeFromPendingWriteOperations(const Key& key)
             break;
 
         m_pendingWriteOperations.remove(found);
+        // The store added the key to the record filter.
+        if (m_recordFilter)
+            m_recordFilter->remove(key.hash());
     }
 }
 
@@ -548,14 +848,21 @@ void Storage::remove(const Key& key)
     if (!mayContain(key))
         return;
 
-    // We can't remove the key from the Bloom filter (but some false positives are expected anyway).
-    // For simplicity we also don't reduce m_approximateSize on removals.
+    // For simplicity we don't reduce m_approximateSize on removals.
     // The next synchronization will update everything.
 
     removeFromPendingWriteOperations(key);
+    if (m_evictionPolicy)
+        m_evictionPolicy->recordRemoval(key.hash());
 
     serialBackgroundIOQueue().dispatch([this, key] {
-        deleteFiles(key);
+        auto deletedFiles = deleteFiles(key);
+        if (m_packedStorage)
+            m_packedStorage->compactIfNeeded();
+
+        RunLoop::main().dispatch([this, hash = key.hash(), deletedFiles] {
+            removeFromFilters(hash, deletedFiles);
+        });
     });
 }
 
@@ -570,24 +877,39 @@ void Storage::remove(const Vector<Key>& keys, Function<void ()>&& completionHand
         if (!mayContain(key))
             continue;
         removeFromPendingWriteOperations(key);
+        if (m_evictionPolicy)
+            m_evictionPolicy->recordRemoval(key.hash());
         keysToRemove.uncheckedAppend(key);
     }
 
     serialBackgroundIOQueue().dispatch([this, keysToRemove = WTFMove(keysToRemove), completionHandler = WTFMove(completionHandler)] () mutable {
+        Vector<DeletedFiles> deletedFiles;
+        deletedFiles.reserveInitialCapacity(keysToRemove.size());
         for (auto& key : keysToRemove)
-            deleteFiles(key);
-
-        if (completionHandler)
-            RunLoop::main().dispatch(WTFMove(completionHandler));
+            deletedFiles.uncheckedAppend(deleteFiles(key));
+        if (m_packedStorage)
+            m_packedStorage->compactIfNeeded();
+
+        RunLoop::main().dispatch([this, keysToRemove = WTFMove(keysToRemove), deletedFiles = WTFMove(deletedFiles), completionHandler = WTFMove(completionHandler)] {
+            for (size_t i = 0; i < keysToRemove.size(); ++i)
+                removeFromFilters(keysToRemove[i].hash(), deletedFiles[i]);
+            if (completionHandler)
+                completionHandler();
+        });
     });
 }
 
-void Storage::deleteFiles(const Key& key)
+auto Storage::deleteFiles(const Key& key) -> DeletedFiles
 {
     ASSERT(!RunLoop::isMain());
 
-    WebCore::deleteFile(recordPathForKey(key));
-    m_blobStorage.remove(blobPathForKey(key));
+    DeletedFiles deletedFiles;
+    if (m_packedStorage)
+        deletedFiles.record = m_packedStorage->remove(key.hash());
+    else
+        deletedFiles.record = WebCore::deleteFile(recordPathForKey(key));
+    deletedFiles.blob = m_blobStorage.remove(blobPathForKey(key));
+    return deletedFiles;
 }
 
 void Storage::updateFileModificationTime(const String& path)
@@ -597,6 +919,17 @@ void Storage::updateFileModificationTime(const String& path)
     });
 }
 
+void Storage::updateAccessTime(const Key& key)
+{
+    if (!m_packedStorage) {
+        updateFileModificationTime(recordPathForKey(key));
+        return;
+    }
+    serialBackgroundIOQueue().dispatch([this, hash = key.hash()] {
+        m_packedStorage->updateAccessTime(hash);
+    });
+}
+
 void Storage::dispatchReadOperation(std::unique_ptr<ReadOperation> readOperationPtr)
 {
     ASSERT(RunLoop::isMain());
@@ -614,18 +947,28 @@ void Storage::dispatchReadOperation(std::unique_ptr<ReadOperation> readOperation
     bool shouldGetBodyBlob = mayContainBlob(readOperation.key);
 
     ioQueue().dispatch([this, &readOperation, shouldGetBodyBlob] {
-        auto recordPath = recordPathForKey(readOperation.key);
-
         ++readOperation.activeCount;
         if (shouldGetBodyBlob)
             ++readOperation.activeCount;
 
-        auto channel = IOChannel::open(recordPath, IOChannel::Type::Read);
-        channel->read(0, std::numeric_limits<size_t>::max(), &ioQueue(), [this, &readOperation](const Data& fileData, int error) {
-            if (!error)
-                readRecord(readOperation, fileData);
+        if (m_packedStorage) {
+            auto recordData = m_packedStorage->get(readOperation.key.hash());
+            if (!recordData.isNull())
+                readRecord(readOperation, recordData);
+            else
+                readOperation.isRecordMissing = true;
             finishReadOperation(readOperation);
-        });
+        } else {
+            auto recordPath = recordPathForKey(readOperation.key);
+            auto channel = IOChannel::open(recordPath, IOChannel::Type::Read);
+            channel->read(0, std::numeric_limits<size_t>::max(), &ioQueue(), [this, &readOperation](const Data& fileData, int error) {
+                if (!error && !fileData.isEmpty())
+                    readRecord(readOperation, fileData);
+                else
+                    readOperation.isRecordMissing = true;
+                finishReadOperation(readOperation);
+            });
+        }
 
         if (shouldGetBodyBlob) {
             // Read the blob in parallel with the record read.
@@ -644,10 +987,15 @@ void Storage::finishReadOperation(ReadOperation& readOperation)
         return;
 
     RunLoop::main().dispatch([this, &readOperation] {
+        if (readOperation.isRecordMissing)
+            ++m_recordFilterFalsePositiveCount;
+
         bool success = readOperation.finish();
-        if (success)
-            updateFileModificationTime(recordPathForKey(readOperation.key));
-        else if (!readOperation.isCanceled)
+        if (success) {
+            updateAccessTime(readOperation.key);
+            if (m_evictionPolicy)
+                m_evictionPolicy->recordAccess(readOperation.key.hash());
+        } else if (!readOperation.isCanceled)
             remove(readOperation.key);
 
         ASSERT(m_activeReadOperations.contains(&readOperation));
@@ -717,15 +1065,22 @@ void Storage::dispatchPendingWriteOperations()
 {
     ASSERT(RunLoop::isMain());
 
-    const int maximumActiveWriteOperationCount { 1 };
+    m_writeOperationDispatchTimer.stop();
 
-    while (!m_pendingWriteOperations.isEmpty()) {
-        if (m_activeWriteOperations.size() >= maximumActiveWriteOperationCount) {
-            LOG(NetworkCacheStorage, "(NetworkProcess) limiting parallel writes");
-            return;
-        }
-        dispatchWriteOperation(m_pendingWriteOperations.takeLast());
+    // Only one batch is written at a time. Completing it dispatches the next one.
+    if (!m_activeWriteOperations.isEmpty()) {
+        LOG(NetworkCacheStorage, "(NetworkProcess) limiting parallel writes");
+        return;
     }
+    if (m_pendingWriteOperations.isEmpty())
+        return;
+
+    Vector<std::unique_ptr<WriteOperation>> batch;
+    size_t batchSize = std::max<size_t>(m_writeBatchConfiguration.maximumBatchSize, 1);
+    while (!m_pendingWriteOperations.isEmpty() && batch.size() < batchSize)
+        batch.append(m_pendingWriteOperations.takeLast());
+
+    dispatchWriteOperations(WTFMove(batch));
 }
 
 static bool shouldStoreBodyAsBlob(const Data& bodyData)
@@ -734,37 +1089,71 @@ static bool shouldStoreBodyAsBlob(const Data& bodyData)
     return bodyData.size() > maximumInlineBodySize;
 }
 
-void Storage::dispatchWriteOperation(std::unique_ptr<WriteOperation> writeOperationPtr)
+void Storage::dispatchWriteOperations(Vector<std::unique_ptr<WriteOperation>>&& writeOperationPtrs)
 {
     ASSERT(RunLoop::isMain());
 
-    auto& writeOperation = *writeOperationPtr;
-    m_activeWriteOperations.add(WTFMove(writeOperationPtr));
-
-    // This was added already when starting the store but filter might have been wiped.
-    addToRecordFilter(writeOperation.record.key);
-
-    backgroundIOQueue().dispatch([this, &writeOperation] {
-        auto recordDirectorPath = recordDirectoryPathForKey(writeOperation.record.key);
-        auto recordPath = recordPathForKey(writeOperation.record.key);
-
-        WebCore::makeAllDirectories(recordDirectorPath);
-
-        ++writeOperation.activeCount;
+    Vector<WriteOperation*> writeOperations;
+    for (auto& writeOperationPtr : writeOperationPtrs) {
+        auto& writeOperation = *writeOperationPtr;
+        writeOperations.append(&writeOperation);
+        m_activeWriteOperations.add(WTFMove(writeOperationPtr));
+    }
 
-        bool shouldStoreAsBlob = shouldStoreBodyAsBlob(writeOperation.record.body);
-        auto blob = shouldStoreAsBlob ? storeBodyAsBlob(writeOperation) : std::nullopt;
+    auto sync = m_writeBatchConfiguration.shouldSync ? WriteBatch::Sync::Yes : WriteBatch::Sync::No;
+    backgroundIOQueue().dispatch([this, writeOperations = WTFMove(writeOperations), sync] {
+        // Each store added its key to the record filter. That entry is removed again when the write replaced
+        // an existing record, which has its own entry, or when it failed.
+        Vector<Key::HashType> extraRecordFilterHashes;
+        Vector<std::pair<Key::HashType, bool>> batchRecords;
+
+        WriteBatch batch;
+        for (auto* writeOperation : writeOperations) {
+            if (!m_packedStorage)
+                WebCore::makeAllDirectories(recordDirectoryPathForKey(writeOperation->record.key));
+
+            ++writeOperation->activeCount;
+
+            bool shouldStoreAsBlob = shouldStoreBodyAsBlob(writeOperation->record.body);
+            auto blob = shouldStoreAsBlob ? storeBodyAsBlob(*writeOperation) : std::nullopt;
+
+            auto& hash = writeOperation->record.key.hash();
+            if (m_packedStorage) {
+                // Packed storage tracks its own size. A failed add leaves any previous record in place.
+                bool recordExisted = m_packedStorage->contains(hash);
+                bool success = m_packedStorage->add(hash, encodeRecord(writeOperation->record, blob));
+                if (!success)
+                    LOG(NetworkCacheStorage, "(NetworkProcess) packed write failed");
+                if (recordExisted || !success)
+                    extraRecordFilterHashes.append(hash);
+                continue;
+            }
+            auto recordPath = recordPathForKey(writeOperation->record.key);
+            batchRecords.append({ hash, WebCore::fileExists(recordPath) });
+            batch.add(recordPath, encodeRecordSegments(writeOperation->record, blob));
+        }
 
-        auto recordData = encodeRecord(writeOperation.record, blob);
+        // A failed write deletes the file, including any previous record.
+        size_t writtenSize = 0;
+        auto writtenSizes = batch.flush(sync);
+        for (size_t i = 0; i < writtenSizes.size(); ++i) {
+            if (batchRecords[i].second)
+                extraRecordFilterHashes.append(batchRecords[i].first);
+            if (!writtenSizes[i])
+                extraRecordFilterHashes.append(batchRecords[i].first);
+            writtenSize += writtenSizes[i];
+        }
 
-        auto channel = IOChannel::open(recordPath, IOChannel::Type::Create);
-        size_t recordSize = recordData.size();
-        channel->write(0, recordData, nullptr, [this, &writeOperation, recordSize](int error) {
-            // On error the entry still stays in the contents filter until next synchronization.
-            m_approximateRecordsSize += recordSize;
-            finishWriteOperation(writeOperation);
+        LOG(NetworkCacheStorage, "(NetworkProcess) batch of %zu writes complete", writeOperations.size());
 
-            LOG(NetworkCacheStorage, "(NetworkProcess) write complete error=%d", error);
+        RunLoop::main().dispatch([this, writeOperations, writtenSize, extraRecordFilterHashes = WTFMove(extraRecordFilterHashes)] {
+            m_approximateRecordsSize += writtenSize;
+            if (m_recordFilter) {
+                for (auto& hash : extraRecordFilterHashes)
+                    m_recordFilter->remove(hash);
+            }
+            for (auto* writeOperation : writeOperations)
+                finishWriteOperation(*writeOperation);
         });
     });
 }
@@ -781,6 +1170,8 @@ void Storage::finishWriteOperation(WriteOperation& writeOperation)
     m_activeWriteOperations.remove(&writeOperation);
     dispatchPendingWriteOperations();
 
+    indexDidChange();
+
     shrinkIfNeeded();
 }
 
@@ -805,6 +1196,8 @@ void Storage::retrieve(const Key& key, unsigned priority, RetrieveCompletionHand
     if (retrieveFromMemory(m_activeWriteOperations, key, completionHandler))
         return;
 
+    ++m_recordFilterPositiveCount;
+
     auto readOperation = std::make_unique<ReadOperation>(key, WTFMove(completionHandler));
     m_pendingReadOperationsByPriority[priority].prepend(WTFMove(readOperation));
     dispatchPendingReadOperations();
@@ -823,15 +1216,55 @@ void Storage::store(const Record& record, MappedBodyHandler&& mappedBodyHandler)
 
     // Add key to the filter already here as we do lookups from the pending operations too.
     addToRecordFilter(record.key);
+    if (m_evictionPolicy)
+        m_evictionPolicy->recordAccess(record.key.hash());
+
+    // Write as soon as a full batch is available.
+    if (m_pendingWriteOperations.size() >= m_writeBatchConfiguration.maximumBatchSize) {
+        dispatchPendingWriteOperations();
+        return;
+    }
 
     bool isInitialWrite = m_pendingWriteOperations.size() == 1;
     if (!isInitialWrite)
         return;
 
-    // Delay the start of writes a bit to avoid affecting early page load.
+    // Delay the start of writes a bit to avoid affecting early page load and to let batches fill up.
     // Completing writes will dispatch more writes without delay.
-    static const Seconds initialWriteDelay = 1_s;
-    m_writeOperationDispatchTimer.startOneShot(initialWriteDelay);
+    m_writeOperationDispatchTimer.startOneShot(m_writeBatchConfiguration.flushDeadline);
+}
+
+void Storage::setWriteBatchConfiguration(const WriteBatchConfiguration& configuration)
+{
+    ASSERT(RunLoop::isMain());
+
+    m_writeBatchConfiguration = configuration;
+}
+
+void Storage::traverseRecord(TraverseOperation& traverseOperation, const Data& recordData, double worth, unsigned bodyShareCount)
+{
+    RecordMetaData metaData;
+    Data headerData;
+    if (!decodeRecordHeader(recordData, metaData, headerData, m_salt))
+        return;
+    // Packed records are not sorted by type.
+    if (!traverseOperation.type.isEmpty() && metaData.key.type() != traverseOperation.type)
+        return;
+
+    Record record {
+        metaData.key,
+        metaData.timeStamp,
+        headerData,
+        { },
+        metaData.bodyHash
+    };
+    RecordInfo info {
+        static_cast<size_t>(metaData.bodySize),
+        worth,
+        bodyShareCount,
+        String::fromUTF8(SHA1::hexDigest(metaData.bodyHash))
+    };
+    traverseOperation.handler(&record, info);
 }
 
 void Storage::traverse(const String& type, TraverseFlags flags, TraverseHandler&& traverseHandler)
@@ -845,54 +1278,50 @@ void Storage::traverse(const String& type, TraverseFlags flags, TraverseHandler&
     m_activeTraverseOperations.add(WTFMove(traverseOperationPtr));
 
     ioQueue().dispatch([this, &traverseOperation] {
-        traverseRecordsFiles(recordsPath(), traverseOperation.type, [this, &traverseOperation](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
-            ASSERT(type == traverseOperation.type);
-            if (isBlob)
-                return;
+        if (m_packedStorage) {
+            m_packedStorage->traverse([this, &traverseOperation](const PackedStorage::RecordInfo& packedInfo, const Function<Data ()>& readRecordData) {
+                double worth = -1;
+                if (traverseOperation.flags & TraverseFlag::ComputeWorth)
+                    worth = computeRecordWorth({ packedInfo.creationTime, packedInfo.accessTime });
+                unsigned bodyShareCount = 0;
+                if (traverseOperation.flags & TraverseFlag::ShareCount)
+                    bodyShareCount = m_blobStorage.shareCount(packedBlobPathForHash(packedInfo.hash));
+
+                traverseRecord(traverseOperation, readRecordData(), worth, bodyShareCount);
+            });
+        } else {
+            traverseRecordsFiles(recordsPath(), traverseOperation.type, [this, &traverseOperation](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
+                ASSERT(type == traverseOperation.type);
+                if (isBlob)
+                    return;
 
-            auto recordPath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
+                auto recordPath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
 
-            double worth = -1;
-            if (traverseOperation.flags & TraverseFlag::ComputeWorth)
-                worth = computeRecordWorth(fileTimes(recordPath));
-            unsigned bodyShareCount = 0;
-            if (traverseOperation.flags & TraverseFlag::ShareCount)
-                bodyShareCount = m_blobStorage.shareCount(blobPathForRecordPath(recordPath));
+                double worth = -1;
+                if (traverseOperation.flags & TraverseFlag::ComputeWorth)
+                    worth = computeRecordWorth(fileTimes(recordPath));
+                unsigned bodyShareCount = 0;
+                if (traverseOperation.flags & TraverseFlag::ShareCount)
+                    bodyShareCount = m_blobStorage.shareCount(blobPathForRecordPath(recordPath));
 
-            std::unique_lock<Lock> lock(traverseOperation.activeMutex);
-            ++traverseOperation.activeCount;
+                std::unique_lock<Lock> lock(traverseOperation.activeMutex);
+                ++traverseOperation.activeCount;
 
-            auto channel = IOChannel::open(recordPath, IOChannel::Type::Read);
-            channel->read(0, std::numeric_limits<size_t>::max(), nullptr, [this, &traverseOperation, worth, bodyShareCount](Data& fileData, int) {
-                RecordMetaData metaData;
-                Data headerData;
-                if (decodeRecordHeader(fileData, metaData, headerData, m_salt)) {
-                    Record record {
-                        metaData.key,
-                        metaData.timeStamp,
-                        headerData,
-                        { },
-                        metaData.bodyHash
-                    };
-                    RecordInfo info {
-                        static_cast<size_t>(metaData.bodySize),
-                        worth,
-                        bodyShareCount,
-                        String::fromUTF8(SHA1::hexDigest(metaData.bodyHash))
-                    };
-                    traverseOperation.handler(&record, info);
-                }
+                auto channel = IOChannel::open(recordPath, IOChannel::Type::Read);
+                channel->read(0, std::numeric_limits<size_t>::max(), nullptr, [this, &traverseOperation, worth, bodyShareCount](Data& fileData, int) {
+                    traverseRecord(traverseOperation, fileData, worth, bodyShareCount);
 
-                std::lock_guard<Lock> lock(traverseOperation.activeMutex);
-                --traverseOperation.activeCount;
-                traverseOperation.activeCondition.notifyOne();
-            });
+                    std::lock_guard<Lock> lock(traverseOperation.activeMutex);
+                    --traverseOperation.activeCount;
+                    traverseOperation.activeCondition.notifyOne();
+                });
 
-            const unsigned maximumParallelReadCount = 5;
-            traverseOperation.activeCondition.wait(lock, [&traverseOperation] {
-                return traverseOperation.activeCount <= maximumParallelReadCount;
+                const unsigned maximumParallelReadCount = 5;
+                traverseOperation.activeCondition.wait(lock, [&traverseOperation] {
+                    return traverseOperation.activeCount <= maximumParallelReadCount;
+                });
             });
-        });
+        }
         {
             // Wait for all reads to finish.
             std::unique_lock<Lock> lock(traverseOperation.activeMutex);
@@ -911,15 +1340,6 @@ void Storage::setCapacity(size_t capacity)
 {
     ASSERT(RunLoop::isMain());
 
-#if !ASSERT_DISABLED
-    const size_t assumedAverageRecordSize = 50 << 10;
-    size_t maximumRecordCount = capacity / assumedAverageRecordSize;
-    // ~10 bits per element are required for <1% false positive rate.
-    size_t effectiveBloomFilterCapacity = ContentsFilter::tableSize / 10;
-    // If this gets hit it might be time to increase the filter size.
-    ASSERT(maximumRecordCount < effectiveBloomFilterCapacity);
-#endif
-
     m_capacity = capacity;
 
     shrinkIfNeeded();
@@ -930,25 +1350,56 @@ void Storage::clear(const String& type, std::chrono::system_clock::time_point mo
     ASSERT(RunLoop::isMain());
     LOG(NetworkCacheStorage, "(NetworkProcess) clearing cache");
 
-    if (m_recordFilter)
+    if (m_recordFilter) {
         m_recordFilter->clear();
+        // Writes in flight will still land and remove their entry if they replace a record.
+        addWriteOperationsToRecordFilter(*m_recordFilter);
+    }
     if (m_blobFilter)
         m_blobFilter->clear();
+    if (m_evictionPolicy)
+        m_evictionPolicy->clear();
     m_approximateRecordsSize = 0;
+    indexDidChange();
 
     ioQueue().dispatch([this, modifiedSinceTime, completionHandler = WTFMove(completionHandler), type = type.isolatedCopy()] () mutable {
-        auto recordsPath = this->recordsPath();
-        traverseRecordsFiles(recordsPath, type, [modifiedSinceTime](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
-            auto filePath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
-            if (modifiedSinceTime > std::chrono::system_clock::time_point::min()) {
-                auto times = fileTimes(filePath);
-                if (times.modification < modifiedSinceTime)
-                    return;
+        if (m_packedStorage) {
+            bool shouldFilter = !type.isEmpty() || modifiedSinceTime > std::chrono::system_clock::time_point::min();
+            if (shouldFilter) {
+                m_packedStorage->traverse([this, &type, modifiedSinceTime](const PackedStorage::RecordInfo& info, const Function<Data ()>& readRecordData) {
+                    if (info.accessTime < modifiedSinceTime)
+                        return;
+                    if (!type.isEmpty()) {
+                        RecordMetaData metaData;
+                        if (!decodeRecordMetaData(metaData, readRecordData()) || metaData.key.type() != type)
+                            return;
+                    }
+                    m_packedStorage->remove(info.hash);
+                    m_blobStorage.remove(packedBlobPathForHash(info.hash));
+                });
+                m_packedStorage->compactIfNeeded();
+            } else {
+                m_packedStorage->clear();
+                auto blobLinksPath = packedBlobLinksPath();
+                traverseDirectory(blobLinksPath, [&blobLinksPath](const String& fileName, DirectoryEntryType type) {
+                    if (type == DirectoryEntryType::File)
+                        WebCore::deleteFile(WebCore::pathByAppendingComponent(blobLinksPath, fileName));
+                });
             }
-            WebCore::deleteFile(filePath);
-        });
+        } else {
+            auto recordsPath = this->recordsPath();
+            traverseRecordsFiles(recordsPath, type, [modifiedSinceTime](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
+                auto filePath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
+                if (modifiedSinceTime > std::chrono::system_clock::time_point::min()) {
+                    auto times = fileTimes(filePath);
+                    if (times.modification < modifiedSinceTime)
+                        return;
+                }
+                WebCore::deleteFile(filePath);
+            });
 
-        deleteEmptyRecordsDirectories(recordsPath);
+            deleteEmptyRecordsDirectories(recordsPath);
+        }
 
         // This cleans unreferenced blobs.
         m_blobStorage.synchronize();
@@ -1019,29 +1470,52 @@ void Storage::shrink()
 
     LOG(NetworkCacheStorage, "(NetworkProcess) shrinking cache approximateSize=%zu capacity=%zu", approximateSize(), m_capacity);
 
+    if (m_evictionPolicy) {
+        // Shrink below the capacity so the next shrink doesn't follow immediately.
+        const double lowWatermarkRatio = 0.9;
+        size_t lowWatermark = m_capacity * lowWatermarkRatio;
+        size_t size = approximateSize();
+        shrinkWithEvictionPolicy(size > lowWatermark ? size - lowWatermark : 0);
+        return;
+    }
+
     backgroundIOQueue().dispatch([this] {
-        auto recordsPath = this->recordsPath();
-        String anyType;
-        traverseRecordsFiles(recordsPath, anyType, [this](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
-            if (isBlob)
-                return;
+        if (m_packedStorage) {
+            m_packedStorage->forEachRecordInfo([this](const PackedStorage::RecordInfo& info) {
+                auto blobPath = packedBlobPathForHash(info.hash);
+                unsigned bodyShareCount = m_blobStorage.shareCount(blobPath);
+                auto probability = deletionProbability({ info.creationTime, info.accessTime }, bodyShareCount);
+
+                if (randomNumber() < probability) {
+                    m_packedStorage->remove(info.hash);
+                    m_blobStorage.remove(blobPath);
+                }
+            });
+            m_packedStorage->compactIfNeeded();
+        } else {
+            auto recordsPath = this->recordsPath();
+            String anyType;
+            traverseRecordsFiles(recordsPath, anyType, [this](const String& fileName, const String& hashString, const String& type, bool isBlob, const String& recordDirectoryPath) {
+                if (isBlob)
+                    return;
 
-            auto recordPath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
-            auto blobPath = blobPathForRecordPath(recordPath);
+                auto recordPath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
+                auto blobPath = blobPathForRecordPath(recordPath);
 
-            auto times = fileTimes(recordPath);
-            unsigned bodyShareCount = m_blobStorage.shareCount(blobPath);
-            auto probability = deletionProbability(times, bodyShareCount);
+                auto times = fileTimes(recordPath);
+                unsigned bodyShareCount = m_blobStorage.shareCount(blobPath);
+                auto probability = deletionProbability(times, bodyShareCount);
 
-            bool shouldDelete = randomNumber() < probability;
+                bool shouldDelete = randomNumber() < probability;
 
-            LOG(NetworkCacheStorage, "Deletion probability=%f bodyLinkCount=%d shouldDelete=%d", probability, bodyShareCount, shouldDelete);
+                LOG(NetworkCacheStorage, "Deletion probability=%f bodyLinkCount=%d shouldDelete=%d", probability, bodyShareCount, shouldDelete);
 
-            if (shouldDelete) {
-                WebCore::deleteFile(recordPath);
-                m_blobStorage.remove(blobPath);
-            }
-        });
+                if (shouldDelete) {
+                    WebCore::deleteFile(recordPath);
+                    m_blobStorage.remove(blobPath);
+                }
+            });
+        }
 
         RunLoop::main().dispatch([this] {
             m_shrinkInProgress = false;
@@ -1053,6 +1527,76 @@ void Storage::shrink()
     });
 }
 
+void Storage::shrinkWithEvictionPolicy(size_t bytesToFree)
+{
+    ASSERT(RunLoop::isMain());
+    ASSERT(m_shrinkInProgress);
+
+    backgroundIOQueue().dispatch([this, bytesToFree] {
+        Vector<EvictionPolicy::Candidate> candidates;
+        Vector<String> recordPaths;
+        auto fileSize = [](const String& path) {
+            long long size = 0;
+            WebCore::getFileSize(path, size);
+            return static_cast<size_t>(size);
+        };
+
+        if (m_packedStorage) {
+            m_packedStorage->forEachRecordInfo([&](const PackedStorage::RecordInfo& info) {
+                auto blobPath = packedBlobPathForHash(info.hash);
+                unsigned bodyShareCount = m_blobStorage.shareCount(blobPath);
+                size_t size = info.size + (bodyShareCount ? fileSize(blobPath) / bodyShareCount : 0);
+                candidates.append(EvictionPolicy::Candidate { info.hash, size, info.accessTime });
+            });
+        } else {
+            auto recordsPath = this->recordsPath();
+            String anyType;
+            traverseRecordsFiles(recordsPath, anyType, [&](const String& fileName, const String& hashString, const String&, bool isBlob, const String& recordDirectoryPath) {
+                if (isBlob)
+                    return;
+                Key::HashType hash;
+                if (!Key::stringToHash(hashString, hash))
+                    return;
+
+                auto recordPath = WebCore::pathByAppendingComponent(recordDirectoryPath, fileName);
+                auto blobPath = blobPathForRecordPath(recordPath);
+                unsigned bodyShareCount = m_blobStorage.shareCount(blobPath);
+                size_t size = fileSize(recordPath) + (bodyShareCount ? fileSize(blobPath) / bodyShareCount : 0);
+                candidates.append(EvictionPolicy::Candidate { hash, size, fileTimes(recordPath).modification });
+                recordPaths.append(recordPath);
+            });
+        }
+
+        auto indices = m_evictionPolicy->selectRecordsToEvict(candidates, bytesToFree);
+        for (auto index : indices) {
+            if (m_packedStorage) {
+                m_packedStorage->remove(candidates[index].hash);
+                m_blobStorage.remove(packedBlobPathForHash(candidates[index].hash));
+            } else {
+                WebCore::deleteFile(recordPaths[index]);
+                m_blobStorage.remove(blobPathForRecordPath(recordPaths[index]));
+            }
+        }
+        if (m_packedStorage)
+            m_packedStorage->compactIfNeeded();
+
+        LOG(NetworkCacheStorage, "(NetworkProcess) cache shrink evicted %zu of %zu records", indices.size(), candidates.size());
+
+        RunLoop::main().dispatch([this] {
+            m_shrinkInProgress = false;
+            synchronize();
+        });
+    });
+}
+
+void Storage::setEvictionPolicy(std::optional<EvictionPolicy::Type> type)
+{
+    ASSERT(RunLoop::isMain());
+    ASSERT(!m_shrinkInProgress);
+
+    m_evictionPolicy = type ? EvictionPolicy::create(*type) : nullptr;
+}
+
 void Storage::deleteOldVersions()
 {
     backgroundIOQueue().dispatch([this] {
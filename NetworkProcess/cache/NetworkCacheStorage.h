@@ -29,14 +29,17 @@
 #if ENABLE(NETWORK_CACHE)
 
 #include "NetworkCacheBlobStorage.h"
+#include "NetworkCacheContentsFilter.h"
 #include "NetworkCacheData.h"
+#include "NetworkCacheEvictionPolicy.h"
 #include "NetworkCacheKey.h"
+#include "NetworkCachePackedStorage.h"
 #include <WebCore/Timer.h>
-#include <wtf/BloomFilter.h>
 #include <wtf/Deque.h>
 #include <wtf/Function.h>
 #include <wtf/HashSet.h>
 #include <wtf/Optional.h>
+#include <wtf/Seconds.h>
 #include <wtf/WorkQueue.h>
 #include <wtf/text/WTFString.h>
 
@@ -49,7 +52,9 @@ class Storage {
     WTF_MAKE_NONCOPYABLE(Storage);
 public:
     enum class Mode { Normal, Testing };
-    static std::unique_ptr<Storage> open(const String& cachePath, Mode);
+    // Packed backend keeps the records in a PackedStorage instead of a file per record.
+    enum class Backend { Files, Packed };
+    static std::unique_ptr<Storage> open(const String& cachePath, Mode, Backend = Backend::Files);
 
     struct Record {
         WTF_MAKE_FAST_ALLOCATED;
@@ -90,6 +95,18 @@ public:
     size_t capacity() const { return m_capacity; }
     size_t approximateSize() const;
 
+    // Without an eviction policy shrinking deletes records randomly, weighted by their age and worth.
+    void setEvictionPolicy(std::optional<EvictionPolicy::Type>);
+
+    struct WriteBatchConfiguration {
+        // Pending writes are dispatched together when this many are queued or when the deadline passes.
+        size_t maximumBatchSize { 32 };
+        Seconds flushDeadline { 1 };
+        // Sync each batch to disk after writing it.
+        bool shouldSync { false };
+    };
+    void setWriteBatchConfiguration(const WriteBatchConfiguration&);
+
     static const unsigned version = 11;
 #if PLATFORM(MAC)
     /// Allow the last stable version of the cache to co-exist with the latest development one.
@@ -99,24 +116,37 @@ public:
     String basePath() const;
     String versionPath() const;
     String recordsPath() const;
+    String indexPath() const;
 
     const Salt& salt() const { return m_salt; }
 
     bool canUseSharedMemoryForBodyData() const { return m_canUseSharedMemoryForBodyData; }
 
+    struct ContentsFilterStatistics {
+        size_t recordCount;
+        double expectedFalsePositiveRate;
+        // Lookups that passed the filter and the ones among them that didn't find a record.
+        uint64_t positiveCount;
+        uint64_t falsePositiveCount;
+    };
+    ContentsFilterStatistics contentsFilterStatistics() const;
+
     ~Storage();
 
 private:
-    Storage(const String& directoryPath, Mode, Salt);
+    Storage(const String& directoryPath, Mode, Salt, std::unique_ptr<PackedStorage>);
 
     String recordDirectoryPathForKey(const Key&) const;
     String recordPathForKey(const Key&) const;
     String blobPathForKey(const Key&) const;
+    String packedBlobLinksPath() const;
+    String packedBlobPathForHash(const Key::HashType&) const;
 
     void synchronize();
     void deleteOldVersions();
     void shrinkIfNeeded();
     void shrink();
+    void shrinkWithEvictionPolicy(size_t bytesToFree);
 
     struct ReadOperation;
     void dispatchReadOperation(std::unique_ptr<ReadOperation>);
@@ -125,15 +155,17 @@ private:
     void cancelAllReadOperations();
 
     struct WriteOperation;
-    void dispatchWriteOperation(std::unique_ptr<WriteOperation>);
+    void dispatchWriteOperations(Vector<std::unique_ptr<WriteOperation>>&&);
     void dispatchPendingWriteOperations();
     void finishWriteOperation(WriteOperation&);
 
     std::optional<BlobStorage::Blob> storeBodyAsBlob(WriteOperation&);
+    Vector<Data> encodeRecordSegments(const Record&, std::optional<BlobStorage::Blob>);
     Data encodeRecord(const Record&, std::optional<BlobStorage::Blob>);
     void readRecord(ReadOperation&, const Data&);
 
     void updateFileModificationTime(const String& path);
+    void updateAccessTime(const Key&);
     void removeFromPendingWriteOperations(const Key&);
 
     WorkQueue& ioQueue() { return m_ioQueue.get(); }
@@ -143,8 +175,19 @@ private:
     bool mayContain(const Key&) const;
     bool mayContainBlob(const Key&) const;
 
+    void indexDidChange();
+    void checkpointIndex();
+    void markIndexFileDirty();
+
     void addToRecordFilter(const Key&);
-    void deleteFiles(const Key&);
+    void addWriteOperationsToRecordFilter(ContentsFilter&);
+    struct DeletedFiles {
+        bool record { false };
+        bool blob { false };
+    };
+    // The filters count their entries, so they only drop a key for a file that was actually deleted.
+    DeletedFiles deleteFiles(const Key&);
+    void removeFromFilters(const Key::HashType&, DeletedFiles);
 
     const String m_basePath;
     const String m_recordsPath;
@@ -156,10 +199,17 @@ private:
     size_t m_capacity { std::numeric_limits<size_t>::max() };
     size_t m_approximateRecordsSize { 0 };
 
-    // 2^18 bit filter can support up to 26000 entries with false positive rate < 1%.
-    using ContentsFilter = BloomFilter<18>;
+    // The filters are sized from the capacity and grow if needed. Keys of deleted records are removed from them too.
     std::unique_ptr<ContentsFilter> m_recordFilter;
     std::unique_ptr<ContentsFilter> m_blobFilter;
+    size_t expectedRecordCount() const;
+
+    bool loadIndex(std::unique_ptr<ContentsFilter>& recordFilter, std::unique_ptr<ContentsFilter>& blobFilter, size_t& recordsSize, size_t& blobsSize);
+    void writeIndex(Vector<uint8_t>&& indexData);
+
+    // The filters and sizes are checkpointed to a file so startup doesn't need to traverse the records.
+    bool m_shouldSynchronizeFromIndex { true };
+    bool m_indexFileIsDirty { false };
 
     bool m_synchronizationInProgress { false };
     bool m_shrinkInProgress { false };
@@ -167,6 +217,9 @@ private:
     Vector<Key::HashType> m_recordFilterHashesAddedDuringSynchronization;
     Vector<Key::HashType> m_blobFilterHashesAddedDuringSynchronization;
 
+    uint64_t m_recordFilterPositiveCount { 0 };
+    uint64_t m_recordFilterFalsePositiveCount { 0 };
+
     static const int maximumRetrievePriority = 4;
     Deque<std::unique_ptr<ReadOperation>> m_pendingReadOperationsByPriority[maximumRetrievePriority + 1];
     HashSet<std::unique_ptr<ReadOperation>> m_activeReadOperations;
@@ -175,8 +228,12 @@ private:
     Deque<std::unique_ptr<WriteOperation>> m_pendingWriteOperations;
     HashSet<std::unique_ptr<WriteOperation>> m_activeWriteOperations;
     WebCore::Timer m_writeOperationDispatchTimer;
+    WriteBatchConfiguration m_writeBatchConfiguration;
+
+    WebCore::Timer m_indexCheckpointTimer;
 
     struct TraverseOperation;
+    void traverseRecord(TraverseOperation&, const Data& recordData, double worth, unsigned bodyShareCount);
     HashSet<std::unique_ptr<TraverseOperation>> m_activeTraverseOperations;
 
     Ref<WorkQueue> m_ioQueue;
@@ -184,6 +241,8 @@ private:
     Ref<WorkQueue> m_serialBackgroundIOQueue;
 
     BlobStorage m_blobStorage;
+    const std::unique_ptr<PackedStorage> m_packedStorage;
+    std::unique_ptr<EvictionPolicy> m_evictionPolicy;
 };
 
 // FIXME: Remove, used by NetworkCacheStatistics only.
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkCacheWriteBatch.h"
+
+#if ENABLE(NETWORK_CACHE)
+
+#include "NetworkCacheFileSystem.h"
+#include <WebCore/FileSystem.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <wtf/text/CString.h>
+
+namespace WebKit {
+namespace NetworkCache {
+
+void WriteBatch::add(const String& path, Vector<Data>&& segments)
+{
+    m_files.append(File { path.isolatedCopy(), WTFMove(segments) });
+}
+
+static bool writeSegments(int fd, const Vector<Data>& segments)
+{
+    Vector<struct iovec, 4> iovecs;
+    for (auto& segment : segments) {
+        if (segment.isEmpty())
+            continue;
+        iovecs.append({ const_cast<uint8_t*>(segment.data()), segment.size() });
+    }
+
+    // The file is new so a plain writev from the current offset is enough and works everywhere.
+    size_t index = 0;
+    while (index < iovecs.size()) {
+        int count = std::min<size_t>(iovecs.size() - index, IOV_MAX);
+        ssize_t written = writev(fd, &iovecs[index], count);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        // Skip the fully written segments and adjust the partially written one.
+        size_t remaining = written;
+        while (index < iovecs.size() && remaining >= iovecs[index].iov_len)
+            remaining -= iovecs[index++].iov_len;
+        if (remaining) {
+            iovecs[index].iov_base = static_cast<uint8_t*>(iovecs[index].iov_base) + remaining;
+            iovecs[index].iov_len -= remaining;
+        }
+    }
+    return true;
+}
+
+Vector<size_t> WriteBatch::flush(Sync sync)
+{
+    Vector<size_t> writtenSizes(m_files.size(), 0);
+    Vector<int> fileDescriptors(m_files.size(), -1);
+
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        auto& file = m_files[i];
+        auto path = WebCore::fileSystemRepresentation(file.path);
+        // Replace instead of truncating, an existing file may be mapped by a reader.
+        unlink(path.data());
+        int fd = open(path.data(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+        if (fd < 0)
+            continue;
+        fileDescriptors[i] = fd;
+        setFileCreationTimeIfNeeded(file.path);
+        if (!writeSegments(fd, file.segments))
+            continue;
+        size_t size = 0;
+        for (auto& segment : file.segments)
+            size += segment.size();
+        writtenSizes[i] = size;
+    }
+
+    // Sync after all the writes so the file system can schedule them together.
+    if (sync == Sync::Yes) {
+        for (size_t i = 0; i < m_files.size(); ++i) {
+            if (fileDescriptors[i] >= 0 && writtenSizes[i] && fsync(fileDescriptors[i]))
+                writtenSizes[i] = 0;
+        }
+    }
+
+    for (size_t i = 0; i < m_files.size(); ++i) {
+        if (fileDescriptors[i] >= 0)
+            close(fileDescriptors[i]);
+        if (!writtenSizes[i])
+            WebCore::deleteFile(m_files[i].path);
+    }
+
+    m_files.clear();
+    return writtenSizes;
+}
+
+}
+}
+
+#endif
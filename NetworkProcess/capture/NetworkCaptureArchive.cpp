@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "NetworkCaptureArchive.h"
+
+#if ENABLE(NETWORK_CAPTURE)
+
+#include "NetworkCaptureEvent.h"
+#include "NetworkCaptureLogging.h"
+#include "NetworkCaptureManager.h"
+#include <WebCore/FileHandle.h>
+#include <WebCore/URLParser.h>
+#include <wtf/SHA1.h>
+#include <wtf/persistence/Decoder.h>
+#include <wtf/text/CString.h>
+
+#include <algorithm>
+
+namespace WebKit {
+namespace NetworkCapture {
+
+static const uint32_t archiveMagic = 0x57484341; // 'WKCA'
+static const uint32_t archiveVersion = 1;
+
+static uint64_t hashForString(const String& string)
+{
+    SHA1 sha1;
+    sha1.addBytes(string.utf8());
+
+    SHA1::Digest digest;
+    sha1.computeHash(digest);
+
+    uint64_t hash;
+    static_assert(sizeof(hash) <= std::tuple_size<SHA1::Digest>::value, "hash must fit in the digest");
+    memcpy(&hash, digest.data(), sizeof(hash));
+    return hash;
+}
+
+static uint64_t roundUpToEntryAlignment(uint64_t offset)
+{
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+static bool rangeIsInFile(uint64_t offset, uint64_t size, uint64_t fileSize)
+{
+    return offset <= fileSize && size <= fileSize - offset;
+}
+
+std::unique_ptr<Archive> Archive::open(const String& path)
+{
+    bool success = false;
+    WebCore::MappedFileData file(path, success);
+    if (!success) {
+        RELEASE_LOG_ERROR(Network, "Unable to map archive: " STRING_SPECIFIER, DEBUG_STR(path));
+        return nullptr;
+    }
+
+    if (file.size() < sizeof(Header)) {
+        RELEASE_LOG_ERROR(Network, "Archive is too small: " STRING_SPECIFIER, DEBUG_STR(path));
+        return nullptr;
+    }
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != archiveMagic || header.version != archiveVersion) {
+        RELEASE_LOG_ERROR(Network, "Archive has an unknown format: " STRING_SPECIFIER, DEBUG_STR(path));
+        return nullptr;
+    }
+
+    // Validate every offset once here so the accessors can trust the file.
+    uint64_t fileSize = file.size();
+    uint64_t count = header.resourceCount;
+    bool tablesAreValid = count <= fileSize
+        && !(header.resourceTableOffset % 8) && !(header.urlIndexOffset % 8) && !(header.domainIndexOffset % 8)
+        && rangeIsInFile(header.resourceTableOffset, count * sizeof(ResourceEntry), fileSize)
+        && rangeIsInFile(header.urlIndexOffset, count * sizeof(IndexEntry), fileSize)
+        && rangeIsInFile(header.domainIndexOffset, count * sizeof(IndexEntry), fileSize);
+    if (!tablesAreValid) {
+        RELEASE_LOG_ERROR(Network, "Archive tables are out of bounds: " STRING_SPECIFIER, DEBUG_STR(path));
+        return nullptr;
+    }
+
+    auto* data = static_cast<const uint8_t*>(file.data());
+    auto* resources = reinterpret_cast<const ResourceEntry*>(data + header.resourceTableOffset);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (!rangeIsInFile(resources[i].urlOffset, resources[i].urlLength, fileSize) || !rangeIsInFile(resources[i].eventsOffset, resources[i].eventsSize, fileSize)) {
+            RELEASE_LOG_ERROR(Network, "Archive resource %llu is out of bounds: " STRING_SPECIFIER, static_cast<unsigned long long>(i), DEBUG_STR(path));
+            return nullptr;
+        }
+    }
+    for (auto indexOffset : { header.urlIndexOffset, header.domainIndexOffset }) {
+        auto* entries = reinterpret_cast<const IndexEntry*>(data + indexOffset);
+        for (uint64_t i = 0; i < count; ++i) {
+            if (entries[i].resourceIndex >= count || (i && entries[i - 1].hash > entries[i].hash)) {
+                RELEASE_LOG_ERROR(Network, "Archive index is corrupt: " STRING_SPECIFIER, DEBUG_STR(path));
+                return nullptr;
+            }
+        }
+    }
+
+    return std::unique_ptr<Archive>(new Archive(WTFMove(file), header));
+}
+
+Archive::Archive(WebCore::MappedFileData&& file, const Header& header)
+    : m_file(WTFMove(file))
+    , m_resourceCount(header.resourceCount)
+    , m_resourceTableOffset(header.resourceTableOffset)
+    , m_urlIndexOffset(header.urlIndexOffset)
+    , m_domainIndexOffset(header.domainIndexOffset)
+{
+}
+
+const Archive::ResourceEntry& Archive::resourceEntry(size_t resourceIndex) const
+{
+    ASSERT(resourceIndex < m_resourceCount);
+    return reinterpret_cast<const ResourceEntry*>(data() + m_resourceTableOffset)[resourceIndex];
+}
+
+String Archive::url(size_t resourceIndex) const
+{
+    const auto& entry = resourceEntry(resourceIndex);
+    return String::fromUTF8(data() + entry.urlOffset, entry.urlLength);
+}
+
+Archive::Events Archive::events(size_t resourceIndex) const
+{
+    const auto& entry = resourceEntry(resourceIndex);
+    return { data() + entry.eventsOffset, static_cast<size_t>(entry.eventsSize) };
+}
+
+std::pair<const Archive::IndexEntry*, const Archive::IndexEntry*> Archive::indexEntriesWithHash(uint64_t indexOffset, uint64_t hash) const
+{
+    auto* begin = reinterpret_cast<const IndexEntry*>(data() + indexOffset);
+    auto* end = begin + m_resourceCount;
+
+    auto* lower = std::lower_bound(begin, end, hash, [](const IndexEntry& entry, uint64_t hash) {
+        return entry.hash < hash;
+    });
+    auto* upper = std::upper_bound(lower, end, hash, [](uint64_t hash, const IndexEntry& entry) {
+        return hash < entry.hash;
+    });
+    return { lower, upper };
+}
+
+std::optional<size_t> Archive::findResourceWithURL(const String& url) const
+{
+    auto range = indexEntriesWithHash(m_urlIndexOffset, hashForString(url));
+    for (auto* entry = range.first; entry != range.second; ++entry) {
+        if (this->url(entry->resourceIndex) == url)
+            return static_cast<size_t>(entry->resourceIndex);
+    }
+    return std::nullopt;
+}
+
+Vector<size_t> Archive::resourcesWithCommonDomain(const String& urlIdentifyingCommonDomain) const
+{
+    // Hash collisions are harmless here: fuzzy matching rejects resources
+    // whose scheme, host, and port differ from the request's.
+    auto range = indexEntriesWithHash(m_domainIndexOffset, hashForString(urlIdentifyingCommonDomain));
+
+    Vector<size_t> resources;
+    resources.reserveInitialCapacity(range.second - range.first);
+    for (auto* entry = range.first; entry != range.second; ++entry)
+        resources.uncheckedAppend(entry->resourceIndex);
+    return resources;
+}
+
+static std::optional<String> urlForEventFile(const WebCore::MappedFileData& file)
+{
+    WTF::Persistence::Decoder decoder(static_cast<const uint8_t*>(file.data()), file.size());
+    auto event = decodeEvent(decoder);
+    if (!event || !WTF::holds_alternative<RequestSentEvent>(*event))
+        return std::nullopt;
+    return WTF::get<RequestSentEvent>(*event).request.url;
+}
+
+static bool writeToFile(WebCore::FileHandle& handle, const void* data, size_t size)
+{
+    return handle.write(data, size) == static_cast<int>(size);
+}
+
+bool Archive::build(const String& path, const Vector<String>& eventFilePaths)
+{
+    struct PendingResource {
+        String eventFilePath;
+        CString url;
+        uint64_t urlHash;
+        uint64_t domainHash;
+        uint64_t eventsSize;
+    };
+
+    // First pass: find the URL and size of every recorded resource so that
+    // the header, tables, and indexes can be laid out ahead of the events.
+
+    Vector<PendingResource> pendingResources;
+    for (const auto& eventFilePath : eventFilePaths) {
+        bool success = false;
+        WebCore::MappedFileData file(eventFilePath, success);
+        if (!success) {
+            RELEASE_LOG_ERROR(Network, "Unable to map event file: " STRING_SPECIFIER, DEBUG_STR(eventFilePath));
+            continue;
+        }
+
+        auto url = urlForEventFile(file);
+        if (!url) {
+            RELEASE_LOG_ERROR(Network, "Event file does not start with a requestSent event: " STRING_SPECIFIER, DEBUG_STR(eventFilePath));
+            continue;
+        }
+
+        auto domain = Manager::urlIdentifyingCommonDomain(WebCore::URLParser(*url).result());
+        pendingResources.append({ eventFilePath, url->utf8(), hashForString(*url), hashForString(domain), file.size() });
+    }
+
+    Header header { archiveMagic, archiveVersion, pendingResources.size(), 0, 0, 0 };
+    header.resourceTableOffset = sizeof(Header);
+    header.urlIndexOffset = header.resourceTableOffset + pendingResources.size() * sizeof(ResourceEntry);
+    header.domainIndexOffset = header.urlIndexOffset + pendingResources.size() * sizeof(IndexEntry);
+
+    Vector<ResourceEntry> resourceTable;
+    Vector<IndexEntry> urlIndex;
+    Vector<IndexEntry> domainIndex;
+    uint64_t offset = header.domainIndexOffset + pendingResources.size() * sizeof(IndexEntry);
+    for (size_t i = 0; i < pendingResources.size(); ++i) {
+        const auto& resource = pendingResources[i];
+        resourceTable.append({ offset, static_cast<uint32_t>(resource.url.length()), 0, 0, resource.eventsSize });
+        urlIndex.append({ resource.urlHash, static_cast<uint32_t>(i), 0 });
+        domainIndex.append({ resource.domainHash, static_cast<uint32_t>(i), 0 });
+        offset += resource.url.length();
+    }
+    offset = roundUpToEntryAlignment(offset);
+    for (auto& entry : resourceTable) {
+        entry.eventsOffset = offset;
+        offset = roundUpToEntryAlignment(offset + entry.eventsSize);
+    }
+
+    auto byHash = [](const IndexEntry& a, const IndexEntry& b) {
+        return a.hash < b.hash;
+    };
+    std::sort(urlIndex.begin(), urlIndex.end(), byHash);
+    std::sort(domainIndex.begin(), domainIndex.end(), byHash);
+
+    // Second pass: write everything out, copying each event file verbatim.
+
+    auto handle = Manager::singleton().openCacheFile(path, WebCore::OpenForWrite);
+    if (!handle)
+        return false;
+
+    static const uint8_t padding[8] = { };
+    uint64_t written = 0;
+    auto pad = [&] {
+        auto alignedOffset = roundUpToEntryAlignment(written);
+        bool success = writeToFile(handle, padding, alignedOffset - written);
+        written = alignedOffset;
+        return success;
+    };
+
+    bool success = writeToFile(handle, &header, sizeof(header))
+        && writeToFile(handle, resourceTable.data(), resourceTable.size() * sizeof(ResourceEntry))
+        && writeToFile(handle, urlIndex.data(), urlIndex.size() * sizeof(IndexEntry))
+        && writeToFile(handle, domainIndex.data(), domainIndex.size() * sizeof(IndexEntry));
+    written = header.domainIndexOffset + domainIndex.size() * sizeof(IndexEntry);
+
+    for (size_t i = 0; success && i < pendingResources.size(); ++i) {
+        const auto& url = pendingResources[i].url;
+        success = writeToFile(handle, url.data(), url.length());
+        written += url.length();
+    }
+
+    for (size_t i = 0; success && i < pendingResources.size(); ++i) {
+        success = pad();
+        if (!success)
+            break;
+
+        bool mapped = false;
+        WebCore::MappedFileData file(pendingResources[i].eventFilePath, mapped);
+        success = mapped && file.size() == resourceTable[i].eventsSize && writeToFile(handle, file.data(), file.size());
+        written += resourceTable[i].eventsSize;
+    }
+
+    handle.close();
+
+    if (!success) {
+        RELEASE_LOG_ERROR(Network, "Error writing archive: " STRING_SPECIFIER, DEBUG_STR(path));
+        WebCore::deleteFile(path);
+        return false;
+    }
+
+    RELEASE_LOG(Network, "Built archive with %d resources: " STRING_SPECIFIER, static_cast<int>(pendingResources.size()), DEBUG_STR(path));
+    return true;
+}
+
+} // namespace NetworkCapture
+} // namespace WebKit
+
+#endif // ENABLE(NETWORK_CAPTURE)
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#if ENABLE(NETWORK_CAPTURE)
+
+#include <WebCore/FileSystem.h>
+#include <wtf/Optional.h>
+#include <wtf/Vector.h>
+#include <wtf/text/WTFString.h>
+
+namespace WebKit {
+namespace NetworkCapture {
+
+/*
+ * NetworkCapture::Archive is the form a capture takes for replay: a single
+ * memory-mapped file holding the recorded events of every resource along with
+ * two indexes that are binary-searched in place:
+ *
+ *  * The URL index is keyed by a hash of the resource URL and answers exact
+ *    matches.
+ *  * The domain index is keyed by a hash of the URL's scheme, host, and port,
+ *    and yields the candidates for fuzzy matching.
+ *
+ * Archives are built from the per-resource event files written while
+ * recording.
+ */
+class Archive {
+    WTF_MAKE_NONCOPYABLE(Archive);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    struct Events {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    static std::unique_ptr<Archive> open(const String& path);
+    static bool build(const String& path, const Vector<String>& eventFilePaths);
+
+    size_t resourceCount() const { return m_resourceCount; }
+    String url(size_t resourceIndex) const;
+    Events events(size_t resourceIndex) const;
+
+    std::optional<size_t> findResourceWithURL(const String&) const;
+    Vector<size_t> resourcesWithCommonDomain(const String& urlIdentifyingCommonDomain) const;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t resourceCount;
+        uint64_t resourceTableOffset;
+        uint64_t urlIndexOffset;
+        uint64_t domainIndexOffset;
+    };
+
+    struct ResourceEntry {
+        uint64_t urlOffset;
+        uint32_t urlLength;
+        uint32_t padding;
+        uint64_t eventsOffset;
+        uint64_t eventsSize;
+    };
+
+    struct IndexEntry {
+        uint64_t hash;
+        uint32_t resourceIndex;
+        uint32_t padding;
+    };
+
+private:
+    Archive(WebCore::MappedFileData&&, const Header&);
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(m_file.data()); }
+    const ResourceEntry& resourceEntry(size_t resourceIndex) const;
+    std::pair<const IndexEntry*, const IndexEntry*> indexEntriesWithHash(uint64_t indexOffset, uint64_t hash) const;
+
+    WebCore::MappedFileData m_file;
+    size_t m_resourceCount;
+    uint64_t m_resourceTableOffset;
+    uint64_t m_urlIndexOffset;
+    uint64_t m_domainIndexOffset;
+};
+
+} // namespace NetworkCapture
+} // namespace WebKit
+
+#endif // ENABLE(NETWORK_CAPTURE)
@@ -28,18 +28,16 @@
 
 #if ENABLE(NETWORK_CAPTURE)
 
-#define JSON_NOEXCEPTION 1
-#undef __EXCEPTIONS
-
 #include "NetworkCaptureLogging.h"
-#include "json.hpp"
 #include <WebCore/ResourceError.h>
 #include <WebCore/ResourceRequest.h>
 #include <WebCore/ResourceResponse.h>
 #include <WebCore/URLParser.h>
 #include <wtf/Assertions.h>
 #include <wtf/Brigand.h>
-#include <wtf/text/Base64.h>
+#include <wtf/persistence/Coders.h>
+#include <wtf/persistence/Decoder.h>
+#include <wtf/persistence/Encoder.h>
 
 namespace WebKit {
 namespace NetworkCapture {
@@ -98,6 +96,7 @@ Response::Response(String&& url, String&& mimeType, long long expectedLength, St
     , mimeType(WTFMove(mimeType))
     , expectedLength(WTFMove(expectedLength))
     , textEncodingName(WTFMove(textEncodingName))
+    , version(WTFMove(version))
     , status(WTFMove(status))
     , reason(WTFMove(reason))
     , headers(WTFMove(headers))
@@ -160,343 +159,246 @@ Error::operator WebCore::ResourceError() const
 
 // ----------
 
-// SEE THE NOTE IN json.hpp REGARDING ITS USE IN THIS PROJECT. IN SHORT, DO NOT
-// USE json.hpp ANYWHERE ELSE. IT WILL BE GOING AWAY.
-using json = nlohmann::basic_json<>;
+// Events are stored with the WTF::Persistence coders: a one byte event type
+// followed by the event's time and fields.
 
 template<typename Type>
-struct JSONCoder {
-    static json encode(Type val)
-    {
-        return json(val);
-    }
-
-    static Type decode(const json& jVal)
-    {
-        return jVal.get<Type>();
-    }
-};
-
-template<>
-struct JSONCoder<const char*> {
-    static json encode(const char* val)
-    {
-        return json(val);
-    }
-};
-
-template<>
-struct JSONCoder<String> {
-    static json encode(const String& val)
-    {
-        return json(std::string(static_cast<const char*>(val.utf8().data()), val.length()));
-    }
-
-    static String decode(const json& jVal)
-    {
-        return String(jVal.get_ref<const std::string&>().c_str());
-    }
-};
-
-template<>
-struct JSONCoder<CaptureTimeType> {
-    static json encode(const CaptureTimeType& time)
-    {
-        return JSONCoder<double>::encode(time.secondsSinceEpoch().seconds());
-    }
-
-    static CaptureTimeType decode(const json& jTime)
-    {
-        return CaptureTimeType::fromRawSeconds(JSONCoder<double>::decode(jTime));
-    }
-};
-
-template<>
-struct JSONCoder<KeyValuePair> {
-    static json encode(const KeyValuePair& pair)
-    {
-        return json {
-            JSONCoder<String>::encode(pair.first),
-            JSONCoder<String>::encode(pair.second)
-        };
-    }
-
-    static KeyValuePair decode(const json& jPair)
-    {
-        return KeyValuePair {
-            JSONCoder<String>::decode(jPair[0]),
-            JSONCoder<String>::decode(jPair[1])
-        };
-    }
-};
-
-template<typename T>
-struct JSONCoder<Vector<T>> {
-    static json encode(const Vector<T>& vector)
-    {
-        json jVector;
-
-        for (const auto& element : vector)
-            jVector.push_back(JSONCoder<T>::encode(element));
-
-        return jVector;
-    }
-
-    static Vector<T> decode(const json& jVector)
-    {
-        Vector<T> vector;
-
-        for (const auto& element : jVector)
-            vector.append(JSONCoder<T>::decode(element));
-
-        return vector;
-    }
-};
+struct EventCoder;
 
 template<>
-struct JSONCoder<Request> {
-    static json encode(const Request& request)
+struct EventCoder<CaptureTimeType> {
+    static void encode(WTF::Persistence::Encoder& encoder, const CaptureTimeType& time)
     {
-        return json {
-            { "url", JSONCoder<String>::encode(request.url) },
-            { "referrer", JSONCoder<String>::encode(request.referrer) },
-            { "policy", JSONCoder<int>::encode(request.policy) },
-            { "method", JSONCoder<String>::encode(request.method) },
-            { "headers", JSONCoder<Headers>::encode(request.headers) }
-        };
+        encoder << time.secondsSinceEpoch().seconds();
     }
 
-    static Request decode(const json& jRequest)
+    static std::optional<CaptureTimeType> decode(WTF::Persistence::Decoder& decoder)
     {
-        return Request {
-            JSONCoder<String>::decode(jRequest["url"]),
-            JSONCoder<String>::decode(jRequest["referrer"]),
-            JSONCoder<int>::decode(jRequest["policy"]),
-            JSONCoder<String>::decode(jRequest["method"]),
-            JSONCoder<Headers>::decode(jRequest["headers"])
-        };
+        double seconds;
+        if (!decoder.decode(seconds))
+            return std::nullopt;
+        return CaptureTimeType::fromRawSeconds(seconds);
     }
 };
 
 template<>
-struct JSONCoder<Response> {
-    static json encode(const Response& response)
+struct EventCoder<Request> {
+    static void encode(WTF::Persistence::Encoder& encoder, const Request& request)
     {
-        return json {
-            { "url", JSONCoder<String>::encode(response.url) },
-            { "mimeType", JSONCoder<String>::encode(response.mimeType) },
-            { "expectedLength", JSONCoder<long long>::encode(response.expectedLength) },
-            { "textEncodingName", JSONCoder<String>::encode(response.textEncodingName) },
-            { "version", JSONCoder<String>::encode(response.version) },
-            { "status", JSONCoder<int>::encode(response.status) },
-            { "reason", JSONCoder<String>::encode(response.reason) },
-            { "headers", JSONCoder<Headers>::encode(response.headers) }
-        };
+        encoder << request.url;
+        encoder << request.referrer;
+        encoder << static_cast<int32_t>(request.policy);
+        encoder << request.method;
+        encoder << request.headers;
     }
 
-    static Response decode(const json& jResponse)
+    static std::optional<Request> decode(WTF::Persistence::Decoder& decoder)
     {
-        return Response {
-            JSONCoder<String>::decode(jResponse["url"]),
-            JSONCoder<String>::decode(jResponse["mimeType"]),
-            JSONCoder<long long>::decode(jResponse["expectedLength"]),
-            JSONCoder<String>::decode(jResponse["textEncodingName"]),
-            JSONCoder<String>::decode(jResponse["version"]),
-            JSONCoder<int>::decode(jResponse["status"]),
-            JSONCoder<String>::decode(jResponse["reason"]),
-            JSONCoder<Headers>::decode(jResponse["headers"])
-        };
+        String url;
+        String referrer;
+        int32_t policy;
+        String method;
+        Headers headers;
+        if (!decoder.decode(url) || !decoder.decode(referrer) || !decoder.decode(policy) || !decoder.decode(method) || !decoder.decode(headers))
+            return std::nullopt;
+        return Request { WTFMove(url), WTFMove(referrer), policy, WTFMove(method), WTFMove(headers) };
     }
 };
 
 template<>
-struct JSONCoder<Error> {
-    static json encode(const Error& error)
+struct EventCoder<Response> {
+    static void encode(WTF::Persistence::Encoder& encoder, const Response& response)
     {
-        return json {
-            { "domain", JSONCoder<String>::encode(error.domain) },
-            { "failingURL", JSONCoder<String>::encode(error.failingURL) },
-            { "localizedDescription", JSONCoder<String>::encode(error.localizedDescription) },
-            { "errorCode", JSONCoder<int>::encode(error.errorCode) },
-            { "type", JSONCoder<int>::encode(error.type) }
-        };
+        encoder << response.url;
+        encoder << response.mimeType;
+        encoder << static_cast<int64_t>(response.expectedLength);
+        encoder << response.textEncodingName;
+        encoder << response.version;
+        encoder << static_cast<int32_t>(response.status);
+        encoder << response.reason;
+        encoder << response.headers;
     }
 
-    static Error decode(const json& jError)
+    static std::optional<Response> decode(WTF::Persistence::Decoder& decoder)
     {
-        return Error {
-            JSONCoder<String>::decode(jError["domain"]),
-            JSONCoder<String>::decode(jError["failingURL"]),
-            JSONCoder<String>::decode(jError["localizedDescription"]),
-            JSONCoder<int>::decode(jError["errorCode"]),
-            JSONCoder<int>::decode(jError["type"])
-        };
+        String url;
+        String mimeType;
+        int64_t expectedLength;
+        String textEncodingName;
+        String version;
+        int32_t status;
+        String reason;
+        Headers headers;
+        if (!decoder.decode(url) || !decoder.decode(mimeType) || !decoder.decode(expectedLength) || !decoder.decode(textEncodingName)
+            || !decoder.decode(version) || !decoder.decode(status) || !decoder.decode(reason) || !decoder.decode(headers))
+            return std::nullopt;
+        return Response { WTFMove(url), WTFMove(mimeType), expectedLength, WTFMove(textEncodingName), WTFMove(version), status, WTFMove(reason), WTFMove(headers) };
     }
 };
 
 template<>
-struct JSONCoder<WebCore::SharedBuffer> {
-    static json encode(const WebCore::SharedBuffer& data)
+struct EventCoder<Error> {
+    static void encode(WTF::Persistence::Encoder& encoder, const Error& error)
     {
-        Vector<char> buffer;
-        base64Encode(data.data(), data.size(), buffer);
-        return json(std::string(&buffer[0], buffer.size()));
+        encoder << error.domain;
+        encoder << error.failingURL;
+        encoder << error.localizedDescription;
+        encoder << static_cast<int32_t>(error.errorCode);
+        encoder << static_cast<int32_t>(error.type);
     }
 
-    static Ref<WebCore::SharedBuffer> decode(const json& jData)
+    static std::optional<Error> decode(WTF::Persistence::Decoder& decoder)
     {
-        Vector<char> data;
-        const auto& str = jData.get_ref<const std::string&>();
-        auto result = base64Decode(str.c_str(), str.size(), data);
-        ASSERT_UNUSED(result, result);
-        return WebCore::SharedBuffer::create(WTFMove(data));
+        String domain;
+        String failingURL;
+        String localizedDescription;
+        int32_t errorCode;
+        int32_t type;
+        if (!decoder.decode(domain) || !decoder.decode(failingURL) || !decoder.decode(localizedDescription) || !decoder.decode(errorCode) || !decoder.decode(type))
+            return std::nullopt;
+        return Error { WTFMove(domain), WTFMove(failingURL), WTFMove(localizedDescription), errorCode, type };
     }
 };
 
 template<>
-struct JSONCoder<RequestSentEvent> {
-    static json encode(const RequestSentEvent& event)
+struct EventCoder<RequestSentEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const RequestSentEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "request", JSONCoder<Request>::encode(event.request) }
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        EventCoder<Request>::encode(encoder, event.request);
     }
 
-    static RequestSentEvent decode(const json& jEvent)
+    static std::optional<RequestSentEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return RequestSentEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<Request>::decode(jEvent["request"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        auto request = EventCoder<Request>::decode(decoder);
+        if (!time || !request)
+            return std::nullopt;
+        return RequestSentEvent { WTFMove(*time), WTFMove(*request) };
     }
 };
 
 template<>
-struct JSONCoder<ResponseReceivedEvent> {
-    static json encode(const ResponseReceivedEvent& event)
+struct EventCoder<ResponseReceivedEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const ResponseReceivedEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "response", JSONCoder<Response>::encode(event.response) }
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        EventCoder<Response>::encode(encoder, event.response);
     }
 
-    static ResponseReceivedEvent decode(const json& jEvent)
+    static std::optional<ResponseReceivedEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return ResponseReceivedEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<Response>::decode(jEvent["response"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        auto response = EventCoder<Response>::decode(decoder);
+        if (!time || !response)
+            return std::nullopt;
+        return ResponseReceivedEvent { WTFMove(*time), WTFMove(*response) };
     }
 };
 
 template<>
-struct JSONCoder<RedirectReceivedEvent> {
-    static json encode(const RedirectReceivedEvent& event)
+struct EventCoder<RedirectReceivedEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const RedirectReceivedEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "request", JSONCoder<Request>::encode(event.request) },
-            { "response", JSONCoder<Response>::encode(event.response) }
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        EventCoder<Request>::encode(encoder, event.request);
+        EventCoder<Response>::encode(encoder, event.response);
     }
 
-    static RedirectReceivedEvent decode(const json& jEvent)
+    static std::optional<RedirectReceivedEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return RedirectReceivedEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<Request>::decode(jEvent["request"]),
-            JSONCoder<Response>::decode(jEvent["response"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        auto request = EventCoder<Request>::decode(decoder);
+        auto response = EventCoder<Response>::decode(decoder);
+        if (!time || !request || !response)
+            return std::nullopt;
+        return RedirectReceivedEvent { WTFMove(*time), WTFMove(*request), WTFMove(*response) };
     }
 };
 
 template<>
-struct JSONCoder<RedirectSentEvent> {
-    static json encode(const RedirectSentEvent& event)
+struct EventCoder<RedirectSentEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const RedirectSentEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "request", JSONCoder<Request>::encode(event.request) },
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        EventCoder<Request>::encode(encoder, event.request);
     }
 
-    static RedirectSentEvent decode(const json& jEvent)
+    static std::optional<RedirectSentEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return RedirectSentEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<Request>::decode(jEvent["request"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        auto request = EventCoder<Request>::decode(decoder);
+        if (!time || !request)
+            return std::nullopt;
+        return RedirectSentEvent { WTFMove(*time), WTFMove(*request) };
     }
 };
 
 template<>
-struct JSONCoder<DataReceivedEvent> {
-    static json encode(const DataReceivedEvent& event)
+struct EventCoder<DataReceivedEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const DataReceivedEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "data", JSONCoder<WebCore::SharedBuffer>::encode(event.data.get()) }
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        encoder << static_cast<uint64_t>(event.data->size());
+        encoder.encodeFixedLengthData(reinterpret_cast<const uint8_t*>(event.data->data()), event.data->size());
     }
 
-    static DataReceivedEvent decode(const json& jEvent)
+    static std::optional<DataReceivedEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return DataReceivedEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<WebCore::SharedBuffer>::decode(jEvent["data"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        uint64_t size;
+        if (!time || !decoder.decode(size) || !decoder.bufferIsLargeEnoughToContain<uint8_t>(size))
+            return std::nullopt;
+
+        Vector<char> data(size);
+        if (!decoder.decodeFixedLengthData(reinterpret_cast<uint8_t*>(data.data()), size))
+            return std::nullopt;
+        return DataReceivedEvent { WTFMove(*time), WebCore::SharedBuffer::create(WTFMove(data)).get() };
     }
 };
 
 template<>
-struct JSONCoder<FinishedEvent> {
-    static json encode(const FinishedEvent& event)
+struct EventCoder<FinishedEvent> {
+    static void encode(WTF::Persistence::Encoder& encoder, const FinishedEvent& event)
     {
-        return json {
-            { "type", JSONCoder<const char*>::encode(event.typeName) },
-            { "time", JSONCoder<CaptureTimeType>::encode(event.time) },
-            { "error", JSONCoder<Error>::encode(event.error) }
-        };
+        EventCoder<CaptureTimeType>::encode(encoder, event.time);
+        EventCoder<Error>::encode(encoder, event.error);
     }
 
-    static FinishedEvent decode(const json& jEvent)
+    static std::optional<FinishedEvent> decode(WTF::Persistence::Decoder& decoder)
     {
-        return FinishedEvent {
-            JSONCoder<CaptureTimeType>::decode(jEvent["time"]),
-            JSONCoder<Error>::decode(jEvent["error"])
-        };
+        auto time = EventCoder<CaptureTimeType>::decode(decoder);
+        auto error = EventCoder<Error>::decode(decoder);
+        if (!time || !error)
+            return std::nullopt;
+        return FinishedEvent { WTFMove(*time), WTFMove(*error) };
     }
 };
 
-std::string eventToString(const CaptureEvent& event)
+void encodeEvent(WTF::Persistence::Encoder& encoder, const CaptureEvent& event)
 {
-    json result;
+    encoder << static_cast<uint8_t>(event.index());
 
-    WTF::visit([&result](const auto& event) {
+    WTF::visit([&encoder](const auto& event) {
         using EventType = std::decay_t<decltype(event)>;
-        result = JSONCoder<EventType>::encode(event);
+        EventCoder<EventType>::encode(encoder, event);
     }, event);
-
-    return result.dump(4);
 }
 
-OptionalCaptureEvent stringToEvent(const char* jsonStr)
+OptionalCaptureEvent decodeEvent(WTF::Persistence::Decoder& decoder)
 {
-    auto jValue = json::parse(jsonStr);
-    const auto& type = jValue["type"].get_ref<const std::string&>();
+    uint8_t type;
+    if (!decoder.decode(type))
+        return std::nullopt;
 
     OptionalCaptureEvent result { std::nullopt };
+    uint8_t index = 0;
     brigand::for_each<CaptureEvent>([&](auto T) {
         using Type = typename decltype(T)::type;
-        if (!result && type == Type::typeName)
-            result = OptionalCaptureEvent(JSONCoder<Type>::decode(jValue));
+        if (index++ != type)
+            return;
+        if (auto event = EventCoder<Type>::decode(decoder))
+            result = OptionalCaptureEvent(WTFMove(*event));
     });
     return result;
 }
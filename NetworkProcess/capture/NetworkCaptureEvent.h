@@ -33,6 +33,13 @@
 #include <wtf/Variant.h>
 #include <wtf/Vector.h>
 
+namespace WTF {
+namespace Persistence {
+class Decoder;
+class Encoder;
+}
+}
+
 namespace WebCore {
 class ResourceError;
 class ResourceRequest;
@@ -57,8 +64,8 @@ using CaptureTimeType = WTF::MonotonicTime;
 using KeyValuePair = std::pair<String, String>;
 using Headers = Vector<KeyValuePair>;
 
-std::string eventToString(const CaptureEvent&);
-OptionalCaptureEvent stringToEvent(const char*);
+void encodeEvent(WTF::Persistence::Encoder&, const CaptureEvent&);
+OptionalCaptureEvent decodeEvent(WTF::Persistence::Decoder&);
 
 struct Request {
     // See comment for RequestSentEvent for why we need this default constructor.
@@ -32,6 +32,7 @@
 #include "NetworkCaptureResource.h"
 #include "WebCore/ResourceRequest.h"
 #include "WebCore/URL.h"
+#include <wtf/HashSet.h>
 #include <wtf/MD5.h>
 #include <wtf/text/Base64.h>
 #include <wtf/text/StringBuilder.h>
@@ -50,6 +51,7 @@ static const char* kDirNameResources = "resources";
 static const char* kFileNameReportLoad = "report_load.txt";
 static const char* kFileNameReportRecord = "report_record.txt";
 static const char* kFileNameReportReplay = "report_replay.txt";
+static const char* kFileNameArchive = "capture.archive";
 
 static int kMaxMatch = std::numeric_limits<int>::max();
 static int kMinMatch = std::numeric_limits<int>::min();
@@ -60,7 +62,7 @@ Manager& Manager::singleton()
     return instance;
 }
 
-void Manager::initialize(const String& recordReplayMode, const String& recordReplayCacheLocation)
+void Manager::initialize(const String& recordReplayMode, const String& recordReplayCacheLocation, bool replaysWithRecordedTiming)
 {
     if (equalIgnoringASCIICase(recordReplayMode, "record")) {
         DEBUG_LOG("Initializing: recording mode");
@@ -76,6 +78,8 @@ void Manager::initialize(const String& recordReplayMode, const String& recordRep
     m_recordReplayCacheLocation = WebCore::pathByAppendingComponent(recordReplayCacheLocation, kDirNameRecordReplay);
     DEBUG_LOG("Cache location = " STRING_SPECIFIER, DEBUG_STR(m_recordReplayCacheLocation));
 
+    m_replaysWithRecordedTiming = isReplaying() && replaysWithRecordedTiming;
+
     if (isRecording()) {
         m_recordFileHandle = WebCore::FileHandle(reportRecordPath(), WebCore::OpenForWrite);
     } else if (isReplaying()) {
@@ -117,41 +121,37 @@ Resource* Manager::findMatch(const WebCore::ResourceRequest& request)
 
 Resource* Manager::findExactMatch(const WebCore::ResourceRequest& request)
 {
-    const auto& url = request.url();
-    auto lower = std::lower_bound(std::begin(m_cachedResources), std::end(m_cachedResources), url, [](auto& resource, const auto& url) {
-        return WTF::codePointCompareLessThan(resource.url().string(), url.string());
-    });
+    if (!m_archive)
+        return nullptr;
 
-    if (lower != std::end(m_cachedResources) && lower->url() == url) {
-        DEBUG_LOG_VERBOSE("Found exact match: " STRING_SPECIFIER, DEBUG_STR(lower->url().string()));
-        return &*lower;
-    }
+    auto resourceIndex = m_archive->findResourceWithURL(request.url().string());
+    if (!resourceIndex)
+        return nullptr;
 
-    return nullptr;
+    auto& resource = m_cachedResources[*resourceIndex];
+    DEBUG_LOG_VERBOSE("Found exact match: " STRING_SPECIFIER, DEBUG_STR(resource.urlString()));
+    return &resource;
 }
 
 Resource* Manager::findBestFuzzyMatch(const WebCore::ResourceRequest& request)
 {
-    const auto& url = request.url();
-    const auto& urlIdentifyingCommonDomain = Manager::urlIdentifyingCommonDomain(url);
+    if (!m_archive)
+        return nullptr;
 
-    const auto& lower = std::lower_bound(std::begin(m_cachedResources), std::end(m_cachedResources), urlIdentifyingCommonDomain, [](auto& resource, const auto& urlIdentifyingCommonDomain) {
-        return WTF::codePointCompareLessThan(resource.urlIdentifyingCommonDomain(), urlIdentifyingCommonDomain);
-    });
-    const auto& upper = std::upper_bound(lower, std::end(m_cachedResources), urlIdentifyingCommonDomain, [](const auto& urlIdentifyingCommonDomain, auto& resource) {
-        return WTF::codePointCompareLessThan(urlIdentifyingCommonDomain, resource.urlIdentifyingCommonDomain());
-    });
+    const auto& url = request.url();
+    auto candidates = m_archive->resourcesWithCommonDomain(Manager::urlIdentifyingCommonDomain(url));
 
     Resource* bestMatch = nullptr;
     int bestScore = kMinMatch;
     const auto& requestParameters = WebCore::URLParser::parseURLEncodedForm(url.query());
-    for (auto iResource = lower; iResource != upper; ++iResource) {
-        int thisScore = fuzzyMatchURLs(url, requestParameters, iResource->url(), iResource->queryParameters());
+    for (auto resourceIndex : candidates) {
+        auto& resource = m_cachedResources[resourceIndex];
+        int thisScore = fuzzyMatchURLs(url, requestParameters, resource.url(), resource.queryParameters());
         // TODO: Consider ignoring any matches < 0 as being too different.
         if (bestScore < thisScore) {
-            DEBUG_LOG("New best match (%d): " STRING_SPECIFIER, thisScore, DEBUG_STR(iResource->url().string()));
+            DEBUG_LOG("New best match (%d): " STRING_SPECIFIER, thisScore, DEBUG_STR(resource.url().string()));
             bestScore = thisScore;
-            bestMatch = &*iResource;
+            bestMatch = &resource;
             if (bestScore == kMaxMatch)
                 break;
         }
@@ -339,28 +339,60 @@ int Manager::fuzzyMatchURLs(const WebCore::URL& requestURL, const WebCore::URLPa
     return score;
 }
 
+static std::optional<time_t> fileModificationTime(const String& filePath)
+{
+    time_t time;
+    if (!WebCore::getFileModificationTime(filePath, time))
+        return std::nullopt;
+
+    return time;
+}
+
 void Manager::loadResources()
+{
+    // The archive is derived from the files written while recording, so
+    // rebuild it whenever a recording session has finished since it was made.
+
+    auto archivePath = this->archivePath();
+    auto archiveTime = fileModificationTime(archivePath);
+    auto recordTime = fileModificationTime(reportRecordPath());
+    if ((!archiveTime || (recordTime && *recordTime >= *archiveTime)) && !buildArchive(archivePath))
+        return;
+
+    m_archive = Archive::open(archivePath);
+    if (!m_archive)
+        return;
+
+    m_cachedResources.reserveInitialCapacity(m_archive->resourceCount());
+    for (size_t i = 0; i < m_archive->resourceCount(); ++i)
+        m_cachedResources.uncheckedAppend(Resource(*m_archive, i));
+
+    for (auto& resource : m_cachedResources)
+        logLoadedResource(resource);
+}
+
+bool Manager::buildArchive(const String& archivePath)
 {
     auto lines = readFile(reportRecordPath());
     if (!lines)
-        return;
+        return false;
 
+    // A resource recorded more than once has a single event file holding the
+    // last recording, so only archive it once.
+
+    HashSet<String> hashes;
+    Vector<String> eventFilePaths;
     for (const auto& line : *lines) {
         if (line.size() != 2) {
             DEBUG_LOG_ERROR("line.size == %d", (int) line.size());
             continue;
         }
 
-        Resource newResource(hashToPath(line[0]));
-        m_cachedResources.append(WTFMove(newResource));
+        if (hashes.add(line[0]).isNewEntry)
+            eventFilePaths.append(hashToPath(line[0]));
     }
 
-    std::sort(std::begin(m_cachedResources), std::end(m_cachedResources), [](auto& left, auto& right) {
-        return WTF::codePointCompareLessThan(left.url().string(), right.url().string());
-    });
-
-    for (auto& resource : m_cachedResources)
-        logLoadedResource(resource);
+    return Archive::build(archivePath, eventFilePaths);
 }
 
 String Manager::reportLoadPath()
@@ -378,6 +410,11 @@ String Manager::reportReplayPath()
     return WebCore::pathByAppendingComponent(m_recordReplayCacheLocation, kFileNameReportReplay);
 }
 
+String Manager::archivePath()
+{
+    return WebCore::pathByAppendingComponent(m_recordReplayCacheLocation, kFileNameArchive);
+}
+
 String Manager::requestToPath(const WebCore::ResourceRequest& request)
 {
     // TODO: come up with a more comprehensive hash that includes HTTP method
@@ -435,7 +472,7 @@ void Manager::logLoadedResource(Resource& resource)
 {
     // Log cached resources as they are loaded from disk.
 
-    m_loadFileHandle.printf("%s\n", DEBUG_STR(resource.url().string()));
+    m_loadFileHandle.printf("%s\n", DEBUG_STR(resource.urlString()));
 }
 
 void Manager::logPlayedBackResource(const WebCore::ResourceRequest& request, bool wasCacheMiss)
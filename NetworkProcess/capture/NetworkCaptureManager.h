@@ -27,6 +27,7 @@
 
 #if ENABLE(NETWORK_CAPTURE)
 
+#include "NetworkCaptureArchive.h"
 #include <WebCore/FileHandle.h>
 #include <WebCore/FileSystem.h>
 #include <WebCore/URLParser.h>
@@ -48,8 +49,8 @@ class Resource;
  * NetworkCapture::Manager serves three purposes:
  *
  *  * It keeps the state of whether we are recording, replaying, or neither.
- *  * It keeps the list of cached resources (if replaying), performs fuzzy
- *    matching on them.
+ *  * It keeps the archive of cached resources (if replaying) and performs
+ *    exact and fuzzy matching against its indexes.
  *  * It has utilities for logging and file management.
  *
  * TODO: Perhaps we should break this up into three classes?
@@ -67,12 +68,13 @@ public:
 
     static Manager& singleton();
 
-    void initialize(const String& recordReplayMode, const String& recordReplayCacheLocation);
+    void initialize(const String& recordReplayMode, const String& recordReplayCacheLocation, bool replaysWithRecordedTiming);
     void terminate();
 
     bool isRecording() const { return mode() == RecordReplayMode::Record; }
     bool isReplaying() const { return mode() == RecordReplayMode::Replay; }
     RecordReplayMode mode() const { return m_recordReplayMode; }
+    bool replaysWithRecordedTiming() const { return m_replaysWithRecordedTiming; }
 
     Resource* findMatch(const WebCore::ResourceRequest&);
 
@@ -94,10 +96,12 @@ private:
     int fuzzyMatchURLs(const WebCore::URL& requestURL, const WebCore::URLParser::URLEncodedForm& requestParameters, const WebCore::URL& resourceURL, const WebCore::URLParser::URLEncodedForm& resourceParameters);
 
     void loadResources();
+    bool buildArchive(const String& archivePath);
 
     String reportLoadPath();
     String reportRecordPath();
     String reportReplayPath();
+    String archivePath();
 
     String stringToHash(const String&);
     String hashToPath(const String& hash);
@@ -108,11 +112,13 @@ private:
 
     RecordReplayMode m_recordReplayMode { Disabled };
     String m_recordReplayCacheLocation;
+    bool m_replaysWithRecordedTiming { false };
 
     WebCore::FileHandle m_loadFileHandle;
     WebCore::FileHandle m_recordFileHandle;
     WebCore::FileHandle m_replayFileHandle;
 
+    std::unique_ptr<Archive> m_archive;
     Vector<Resource> m_cachedResources;
 };
 
@@ -32,6 +32,7 @@
 #include "NetworkCaptureManager.h"
 #include <WebCore/ResourceResponse.h>
 #include <WebCore/SharedBuffer.h>
+#include <wtf/persistence/Encoder.h>
 
 #define DEBUG_CLASS Recorder
 
@@ -135,16 +136,13 @@ void Recorder::writeEvents()
     if (!handle)
         return;
 
-    for (auto const& event : m_events) {
-        auto asString = eventToString(event);
-        // Write out the JSON string with the terminating NUL. This allows us
-        // to better find the separate JSON objects that we write to a single
-        // file. It also works better with JSON parsers that expect to find a
-        // NUL at the end of their input.
-        if (handle.write(asString.c_str(), asString.size() + 1) == -1) {
-            DEBUG_LOG_ERROR("Error trying to write to file for URL = " STRING_SPECIFIER, DEBUG_STR(m_initialRequest.url().string()));
-            return;
-        }
+    WTF::Persistence::Encoder encoder;
+    for (auto const& event : m_events)
+        encodeEvent(encoder, event);
+
+    if (handle.write(encoder.buffer(), encoder.bufferSize()) == -1) {
+        DEBUG_LOG_ERROR("Error trying to write to file for URL = " STRING_SPECIFIER, DEBUG_STR(m_initialRequest.url().string()));
+        return;
     }
 
     Manager::singleton().logRecordedResource(m_initialRequest);
@@ -28,33 +28,32 @@
 
 #if ENABLE(NETWORK_CAPTURE)
 
+#include "NetworkCaptureArchive.h"
 #include "NetworkCaptureEvent.h"
 #include "NetworkCaptureLogging.h"
 #include "NetworkCaptureManager.h"
 #include "NetworkCaptureRecorder.h"
+#include <wtf/persistence/Decoder.h>
 
 namespace WebKit {
 namespace NetworkCapture {
 
-Resource::Resource(const String& eventFilePath)
-    : m_eventFilePath(eventFilePath)
+Resource::Resource(const Archive& archive, size_t archiveIndex)
+    : m_archive(&archive)
+    , m_archiveIndex(archiveIndex)
 {
 }
 
+String Resource::urlString() const
+{
+    return m_archive->url(m_archiveIndex);
+}
+
 const WebCore::URL& Resource::url()
 {
     if (!m_url.isValid()) {
-        auto events = eventStream();
-        auto event = events.nextEvent();
-        if (!event)
-            DEBUG_LOG_ERROR("Event stream does not contain events: file = " STRING_SPECIFIER, DEBUG_STR(m_eventFilePath));
-        else if (!WTF::holds_alternative<RequestSentEvent>(*event))
-            DEBUG_LOG_ERROR("Event stream does not have a requestSent event: file = " STRING_SPECIFIER, DEBUG_STR(m_eventFilePath));
-        else {
-            auto requestSentEvent = WTF::get<RequestSentEvent>(*event);
-            WebCore::URLParser parser(requestSentEvent.request.url);
-            m_url = parser.result();
-        }
+        WebCore::URLParser parser(urlString());
+        m_url = parser.result();
     }
 
     return m_url;
@@ -78,36 +77,33 @@ WebCore::URLParser::URLEncodedForm Resource::queryParameters()
 
 Resource::EventStream Resource::eventStream()
 {
-    return EventStream(m_eventFilePath);
+    auto events = m_archive->events(m_archiveIndex);
+    return EventStream(events.data, events.size);
 }
 
-Resource::EventStream::EventStream(const String& eventFilePath)
-    : m_eventFilePath(eventFilePath)
-    , m_mappedEventFile(m_eventFilePath, m_haveMappedEventFile)
+Resource::EventStream::EventStream(const uint8_t* data, size_t size)
+    : m_data(data)
+    , m_size(size)
 {
 }
 
 OptionalCaptureEvent Resource::EventStream::nextEvent()
 {
-    if (m_offset == m_mappedEventFile.size()) {
-        DEBUG_LOG_ERROR("Unable to return event - at end of file: " STRING_SPECIFIER, DEBUG_STR(m_eventFilePath));
+    if (m_offset == m_size) {
+        DEBUG_LOG_ERROR("Unable to return event - at end of stream");
         return std::nullopt;
     }
 
-    const char* charBuffer = static_cast<const char*>(m_mappedEventFile.data());
-    const char* current = charBuffer + m_offset;
-
-    while (m_offset < m_mappedEventFile.size() && charBuffer[m_offset])
-        ++m_offset;
-
-    if (m_offset == m_mappedEventFile.size()) {
-        DEBUG_LOG_ERROR("Unable to return event - no terminating NUL: " STRING_SPECIFIER, DEBUG_STR(m_eventFilePath));
+    WTF::Persistence::Decoder decoder(m_data + m_offset, m_size - m_offset);
+    auto event = decodeEvent(decoder);
+    if (!event) {
+        DEBUG_LOG_ERROR("Unable to return event - could not decode event at offset %d", static_cast<int>(m_offset));
+        m_offset = m_size;
         return std::nullopt;
     }
 
-    ++m_offset;
-
-    return stringToEvent(current);
+    m_offset += decoder.currentOffset();
+    return event;
 }
 
 } // namespace NetworkCapture
@@ -28,7 +28,6 @@
 #if ENABLE(NETWORK_CAPTURE)
 
 #include "NetworkCaptureEvent.h"
-#include <WebCore/FileSystem.h>
 #include <WebCore/URL.h>
 #include <WebCore/URLParser.h>
 #include <wtf/Optional.h>
@@ -36,32 +35,35 @@
 namespace WebKit {
 namespace NetworkCapture {
 
+class Archive;
+
 class Resource {
 public:
     class EventStream {
     public:
         EventStream() = default;
-        EventStream(const String& eventFilePath);
+        EventStream(const uint8_t* data, size_t size);
 
         OptionalCaptureEvent nextEvent();
 
     private:
-        String m_eventFilePath;
-        bool m_haveMappedEventFile { false };
-        WebCore::MappedFileData m_mappedEventFile;
+        const uint8_t* m_data { nullptr };
+        size_t m_size { 0 };
         size_t m_offset { 0 };
     };
 
 public:
-    Resource(const String& eventFilePath);
+    Resource(const Archive&, size_t archiveIndex);
 
+    String urlString() const;
     const WebCore::URL& url();
     const String& urlIdentifyingCommonDomain();
     WebCore::URLParser::URLEncodedForm queryParameters();
     EventStream eventStream();
 
 private:
-    String m_eventFilePath;
+    const Archive* m_archive;
+    size_t m_archiveIndex;
     WebCore::URL m_url;
     String m_urlIdentifyingCommonDomain;
     std::optional<WebCore::URLParser::URLEncodedForm> m_queryParameters;
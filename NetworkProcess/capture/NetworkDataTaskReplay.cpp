@@ -30,6 +30,7 @@
 
 #include "NetworkCaptureEvent.h"
 #include "NetworkCaptureLogging.h"
+#include "NetworkCaptureManager.h"
 #include "NetworkCaptureResource.h"
 #include "NetworkLoadParameters.h"
 #include "NetworkSession.h"
@@ -129,7 +130,7 @@ void NetworkDataTaskReplay::enqueueEventHandler()
     RunLoop::main().dispatch([this, protectedThis = makeRef(*this)] {
         DEBUG_LOG("enqueueEventHandler callback");
 
-        if (m_state == State::Suspended)
+        if (m_state == State::Suspended || m_isWaitingForRecordedTime)
             return;
 
         if (m_state == State::Canceling || m_state == State::Completed || !m_client) {
@@ -149,37 +150,77 @@ void NetworkDataTaskReplay::enqueueEventHandler()
             return;
         }
 
-        auto event = m_eventStream.nextEvent();
+        auto event = m_pendingEvent ? std::exchange(m_pendingEvent, std::nullopt) : m_eventStream.nextEvent();
         if (!event) {
             DEBUG_LOG_ERROR("Error loading resource: nextEvent return null, URL = " STRING_SPECIFIER, DEBUG_STR(m_currentRequest.url().string()));
             didFinish(Error::NotFoundError); // TODO: Turn this into a 404?
             return;
         }
 
-        const auto visitor = WTF::makeVisitor(
-            [this](const RequestSentEvent& event) {
-                replayRequestSent(event);
-            },
-            [this](const ResponseReceivedEvent& event) {
-                replayResponseReceived(event);
-            },
-            [this](const RedirectReceivedEvent& event) {
-                replayRedirectReceived(event);
-            },
-            [this](const RedirectSentEvent& event) {
-                replayRedirectSent(event);
-            },
-            [this](const DataReceivedEvent& event) {
-                replayDataReceived(event);
-            },
-            [this](const FinishedEvent& event) {
-                replayFinished(event);
+        auto delay = delayUntilRecordedTime(*event);
+        if (delay > 0_s) {
+            // Hold on to the event rather than replaying it from the timer so
+            // that a suspension or cancellation in the meantime is honored.
+            m_pendingEvent = WTFMove(event);
+            m_isWaitingForRecordedTime = true;
+            RunLoop::main().dispatchAfter(delay, [this, protectedThis = makeRef(*this)] {
+                m_isWaitingForRecordedTime = false;
+                enqueueEventHandler();
             });
+            return;
+        }
 
-        WTF::visit(visitor, *event);
+        replayEvent(*event);
     });
 }
 
+Seconds NetworkDataTaskReplay::delayUntilRecordedTime(const CaptureEvent& event)
+{
+    if (!Manager::singleton().replaysWithRecordedTiming())
+        return 0_s;
+
+    // Events are replayed at the same offsets from the start of the load as
+    // they were recorded, which reproduces both the latency of the original
+    // response and the rate at which its data arrived.
+
+    auto recordedTime = WTF::visit([](const auto& event) {
+        return event.time;
+    }, event);
+
+    if (!m_recordedStartTime) {
+        m_recordedStartTime = recordedTime;
+        m_replayStartTime = MonotonicTime::now();
+        return 0_s;
+    }
+
+    return (recordedTime - *m_recordedStartTime) - (MonotonicTime::now() - m_replayStartTime);
+}
+
+void NetworkDataTaskReplay::replayEvent(const CaptureEvent& event)
+{
+    const auto visitor = WTF::makeVisitor(
+        [this](const RequestSentEvent& event) {
+            replayRequestSent(event);
+        },
+        [this](const ResponseReceivedEvent& event) {
+            replayResponseReceived(event);
+        },
+        [this](const RedirectReceivedEvent& event) {
+            replayRedirectReceived(event);
+        },
+        [this](const RedirectSentEvent& event) {
+            replayRedirectSent(event);
+        },
+        [this](const DataReceivedEvent& event) {
+            replayDataReceived(event);
+        },
+        [this](const FinishedEvent& event) {
+            replayFinished(event);
+        });
+
+    WTF::visit(visitor, event);
+}
+
 void NetworkDataTaskReplay::replayRequestSent(const RequestSentEvent& event)
 {
     DEBUG_LOG("URL = " STRING_SPECIFIER, DEBUG_STR(m_firstRequest.url().string()));
@@ -27,6 +27,7 @@
 
 #if ENABLE(NETWORK_CAPTURE)
 
+#include "NetworkCaptureEvent.h"
 #include "NetworkCaptureResource.h"
 #include "NetworkDataTask.h"
 #include <WebCore/ResourceRequest.h>
@@ -79,6 +80,8 @@ private:
     State state() const override { return m_state; }
 
     void enqueueEventHandler();
+    void replayEvent(const CaptureEvent&);
+    Seconds delayUntilRecordedTime(const CaptureEvent&);
 
     enum class Error {
         NoError = 0,
@@ -95,6 +98,10 @@ private:
     WebCore::ResourceRequest m_currentRequest;
     Resource* m_resource;
     Resource::EventStream m_eventStream;
+    OptionalCaptureEvent m_pendingEvent;
+    std::optional<CaptureTimeType> m_recordedStartTime;
+    MonotonicTime m_replayStartTime;
+    bool m_isWaitingForRecordedTime { false };
 };
 
 } // namespace NetworkCapture
@@ -117,6 +117,12 @@ void NetworkProcess::platformInitializeNetworkProcessCocoa(const NetworkProcessC
             if (parameters.shouldEnableNetworkCacheSpeculativeRevalidation)
                 cacheOptions |= NetworkCache::Cache::Option::SpeculativeRevalidation;
 #endif
+            if (parameters.shouldUseNetworkCachePackedStorage)
+                cacheOptions |= NetworkCache::Cache::Option::PackedRecordStorage;
+            if (parameters.networkCacheEvictionPolicy == DiskCacheEvictionPolicy::LeastRecentlyUsed)
+                cacheOptions |= NetworkCache::Cache::Option::LeastRecentlyUsedEviction;
+            else if (parameters.networkCacheEvictionPolicy == DiskCacheEvictionPolicy::GreedyDualSizeFrequency)
+                cacheOptions |= NetworkCache::Cache::Option::GreedyDualSizeFrequencyEviction;
             if (NetworkCache::singleton().initialize(m_diskCacheDirectory, cacheOptions)) {
                 auto urlCache(adoptNS([[NSURLCache alloc] initWithMemoryCapacity:0 diskCapacity:0 diskPath:nil]));
                 [NSURLCache setSharedURLCache:urlCache.get()];
@@ -202,6 +208,7 @@ void NetworkProcess::clearDiskCache(std::chrono::system_clock::time_point modifi
 void NetworkProcess::setCookieStoragePartitioningEnabled(bool enabled)
 {
     WebCore::NetworkStorageSession::setCookieStoragePartitioningEnabled(enabled);
+    invalidateWebProcessCookieCaches();
 }
 
 void NetworkProcess::syncAllCookies()
@@ -119,6 +119,12 @@ void NetworkProcess::platformInitializeNetworkProcess(const NetworkProcessCreati
     if (parameters.shouldEnableNetworkCacheSpeculativeRevalidation)
         cacheOptions |= NetworkCache::Cache::Option::SpeculativeRevalidation;
 #endif
+    if (parameters.shouldUseNetworkCachePackedStorage)
+        cacheOptions |= NetworkCache::Cache::Option::PackedRecordStorage;
+    if (parameters.networkCacheEvictionPolicy == DiskCacheEvictionPolicy::LeastRecentlyUsed)
+        cacheOptions |= NetworkCache::Cache::Option::LeastRecentlyUsedEviction;
+    else if (parameters.networkCacheEvictionPolicy == DiskCacheEvictionPolicy::GreedyDualSizeFrequency)
+        cacheOptions |= NetworkCache::Cache::Option::GreedyDualSizeFrequencyEviction;
 
     NetworkCache::singleton().initialize(m_diskCacheDirectory, cacheOptions);
 
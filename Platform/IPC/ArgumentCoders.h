@@ -204,6 +204,10 @@ template<typename KeyType, typename ValueType> struct ArgumentCoder<WTF::KeyValu
     }
 };
 
+// Types that are encoded as their in-memory representation, whatever the encoding format. Vectors
+// of these types are encoded with a single copy instead of element by element.
+template<typename T> struct IsTriviallyEncodable : std::is_arithmetic<T> { };
+
 template<bool fixedSizeElements, typename T, size_t inlineCapacity> struct VectorArgumentCoder;
 
 template<typename T, size_t inlineCapacity> struct VectorArgumentCoder<false, T, inlineCapacity> {
@@ -266,7 +270,7 @@ template<typename T, size_t inlineCapacity> struct VectorArgumentCoder<true, T,
     }
 };
 
-template<typename T, size_t inlineCapacity> struct ArgumentCoder<Vector<T, inlineCapacity>> : VectorArgumentCoder<std::is_arithmetic<T>::value, T, inlineCapacity> { };
+template<typename T, size_t inlineCapacity> struct ArgumentCoder<Vector<T, inlineCapacity>> : VectorArgumentCoder<IsTriviallyEncodable<T>::value, T, inlineCapacity> { };
 
 template<typename KeyArg, typename MappedArg, typename HashArg, typename KeyTraitsArg, typename MappedTraitsArg> struct ArgumentCoder<HashMap<KeyArg, MappedArg, HashArg, KeyTraitsArg, MappedTraitsArg>> {
     typedef HashMap<KeyArg, MappedArg, HashArg, KeyTraitsArg, MappedTraitsArg> HashMapType;
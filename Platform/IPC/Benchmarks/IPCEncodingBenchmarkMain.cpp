@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// IPCEncodingBenchmark encodes and decodes payloads shaped like the hottest IPC
+// messages with both the aligned and the packed encoding formats, and reports
+// the encoded size and the time taken per message for each.
+//
+// Usage: IPCEncodingBenchmark [--iterations <count>]
+
+#include "config.h"
+
+#include "ArgumentCoders.h"
+#include "Decoder.h"
+#include "Encoder.h"
+#include "WebCoreArgumentCoders.h"
+#include <WebCore/Color.h>
+#include <WebCore/FloatPoint.h>
+#include <WebCore/FloatRect.h>
+#include <WebCore/HTTPHeaderNames.h>
+#include <WebCore/IntRect.h>
+#include <WebCore/ResourceRequest.h>
+#include <WebCore/ResourceResponse.h>
+#include <WebCore/TransformationMatrix.h>
+#include <WebCore/URLParser.h>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wtf/MainThread.h>
+#include <wtf/MonotonicTime.h>
+#include <wtf/text/WTFString.h>
+
+using namespace IPC;
+using namespace WebCore;
+
+static const unsigned defaultIterations = 100000;
+
+// The properties a typical layer tree commit carries for a layer whose geometry changed.
+typedef std::tuple<uint64_t, uint32_t, FloatPoint, FloatRect, float, Color, TransformationMatrix, bool> LayerProperties;
+
+static ResourceResponse makeResponse()
+{
+    ResourceResponse response(URLParser(ASCIILiteral("https://www.example.com/static/js/application.min.js?v=20171017")).result(), ASCIILiteral("application/javascript"), 183245, ASCIILiteral("utf-8"));
+    response.setHTTPVersion(ASCIILiteral("HTTP/1.1"));
+    response.setHTTPStatusCode(200);
+    response.setHTTPStatusText(ASCIILiteral("OK"));
+    response.setHTTPHeaderField(HTTPHeaderName::ContentType, ASCIILiteral("application/javascript; charset=utf-8"));
+    response.setHTTPHeaderField(HTTPHeaderName::ContentLength, ASCIILiteral("183245"));
+    response.setHTTPHeaderField(HTTPHeaderName::CacheControl, ASCIILiteral("public, max-age=31536000"));
+    response.setHTTPHeaderField(HTTPHeaderName::Date, ASCIILiteral("Tue, 17 Oct 2017 09:21:44 GMT"));
+    response.setHTTPHeaderField(HTTPHeaderName::ETag, ASCIILiteral("\"5a0f3c8e-2cbcd\""));
+    response.setHTTPHeaderField(HTTPHeaderName::LastModified, ASCIILiteral("Mon, 16 Oct 2017 17:02:06 GMT"));
+    response.setHTTPHeaderField(HTTPHeaderName::AcceptRanges, ASCIILiteral("bytes"));
+    response.setHTTPHeaderField(HTTPHeaderName::Vary, ASCIILiteral("Accept-Encoding"));
+    response.setHTTPHeaderField(ASCIILiteral("Server"), ASCIILiteral("nginx"));
+    response.setHTTPHeaderField(ASCIILiteral("X-Cache"), ASCIILiteral("HIT"));
+    response.setHTTPHeaderField(ASCIILiteral("Strict-Transport-Security"), ASCIILiteral("max-age=31536000; includeSubDomains"));
+    return response;
+}
+
+static ResourceRequest makeRequest()
+{
+    ResourceRequest request(URLParser(ASCIILiteral("https://www.example.com/static/css/site.css")).result());
+    request.setFirstPartyForCookies(URLParser(ASCIILiteral("https://www.example.com/")).result());
+    request.setHTTPHeaderField(HTTPHeaderName::Accept, ASCIILiteral("text/css,*/*;q=0.1"));
+    request.setHTTPHeaderField(HTTPHeaderName::AcceptLanguage, ASCIILiteral("en-us"));
+    request.setHTTPHeaderField(HTTPHeaderName::Referer, ASCIILiteral("https://www.example.com/"));
+    request.setHTTPHeaderField(HTTPHeaderName::UserAgent, ASCIILiteral("Mozilla/5.0 (Macintosh; Intel Mac OS X 10_13) AppleWebKit/605.1.5 (KHTML, like Gecko)"));
+    return request;
+}
+
+static Vector<LayerProperties> makeLayerProperties()
+{
+    Vector<LayerProperties> layers;
+    for (unsigned i = 0; i < 64; ++i) {
+        TransformationMatrix transform;
+        transform.translate(i * 4, i * 2);
+        layers.append(LayerProperties { 1000 + i, 0x3f, FloatPoint(i * 10, i * 20), FloatRect(0, 0, 320, 48 + i), 1, Color(0xff336699), transform, !(i % 3) });
+    }
+    return layers;
+}
+
+static Vector<IntRect> makeDirtyRects()
+{
+    Vector<IntRect> rects;
+    for (int i = 0; i < 64; ++i)
+        rects.append(IntRect(i * 16, i * 12, 256, 32));
+    return rects;
+}
+
+static Vector<std::pair<uint64_t, uint32_t>> makeIdentifiers()
+{
+    Vector<std::pair<uint64_t, uint32_t>> identifiers;
+    for (unsigned i = 0; i < 256; ++i)
+        identifiers.append({ 4096 + i, i % 7 });
+    return identifiers;
+}
+
+static const char* formatName(EncodingFormat format)
+{
+    return format == EncodingFormat::Packed ? "packed" : "aligned";
+}
+
+template<typename T>
+static void runBenchmark(const char* name, const T& payload, unsigned iterations)
+{
+    size_t alignedSize = 0;
+    for (auto format : { EncodingFormat::Aligned, EncodingFormat::Packed }) {
+        size_t size = 0;
+        MonotonicTime encodeStart = MonotonicTime::now();
+        for (unsigned i = 0; i < iterations; ++i) {
+            Encoder encoder("IPCEncodingBenchmark", "Message", 0, format);
+            encoder << payload;
+            size = encoder.bufferSize();
+        }
+        Seconds encodeTime = MonotonicTime::now() - encodeStart;
+
+        Encoder encoder("IPCEncodingBenchmark", "Message", 0, format);
+        encoder << payload;
+
+        MonotonicTime decodeStart = MonotonicTime::now();
+        for (unsigned i = 0; i < iterations; ++i) {
+            Decoder decoder(encoder.buffer(), encoder.bufferSize(), nullptr, { });
+            T result;
+            if (!decoder.decode(result)) {
+                fprintf(stderr, "Failed to decode %s in the %s format\n", name, formatName(format));
+                exit(EXIT_FAILURE);
+            }
+        }
+        Seconds decodeTime = MonotonicTime::now() - decodeStart;
+
+        if (format == EncodingFormat::Aligned)
+            alignedSize = size;
+
+        printf("%-18s %-8s %8zu bytes (%5.1f%%) %10.1f ns encode %10.1f ns decode\n", name, formatName(format), size, 100.0 * size / alignedSize,
+            encodeTime.nanoseconds() / iterations, decodeTime.nanoseconds() / iterations);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = defaultIterations;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+            iterations = std::max(atoi(argv[++i]), 1);
+        else {
+            fprintf(stderr, "Usage: %s [--iterations <count>]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    WTF::initializeMainThread();
+
+    printf("%u iterations; sizes include the message header, times are per message.\n", iterations);
+    runBenchmark("ResourceResponse", makeResponse(), iterations);
+    runBenchmark("ResourceRequest", makeRequest(), iterations);
+    runBenchmark("LayerProperties", makeLayerProperties(), iterations);
+    runBenchmark("DirtyRects", makeDirtyRects(), iterations);
+    runBenchmark("Identifiers", makeIdentifiers(), iterations);
+
+    return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 #include "Connection.h"
 
 #include "Logging.h"
+#include "MessageStatistics.h"
 #include <memory>
 #include <wtf/CurrentTime.h>
 #include <wtf/HashSet.h>
@@ -40,6 +41,7 @@
 #endif
 
 #if USE(UNIX_DOMAIN_SOCKETS)
+#include "MessageBodyRing.h"
 #include "UnixMessage.h"
 #endif
 
@@ -245,6 +247,8 @@ Connection::Connection(Identifier identifier, bool isServer, Client& client)
 {
     ASSERT(RunLoop::isMain());
 
+    MessageStatistics::initializeFromEnvironment();
+
     platformInitialize(identifier);
 
 #if HAVE(QOS_CLASSES)
@@ -294,6 +298,18 @@ void Connection::removeWorkQueueMessageReceiver(StringReference messageReceiverN
 }
 
 void Connection::dispatchWorkQueueMessageReceiverMessage(WorkQueueMessageReceiver& workQueueMessageReceiver, Decoder& decoder)
+{
+    if (decoder.receiveTime()) {
+        auto dispatchStart = MonotonicTime::now();
+        dispatchWorkQueueMessageReceiverMessageWithoutStatistics(workQueueMessageReceiver, decoder);
+        MessageStatistics::didDispatchMessage(decoder, dispatchStart - decoder.receiveTime(), MonotonicTime::now() - dispatchStart);
+        return;
+    }
+
+    dispatchWorkQueueMessageReceiverMessageWithoutStatistics(workQueueMessageReceiver, decoder);
+}
+
+void Connection::dispatchWorkQueueMessageReceiverMessageWithoutStatistics(WorkQueueMessageReceiver& workQueueMessageReceiver, Decoder& decoder)
 {
     if (!decoder.isSyncMessage()) {
         workQueueMessageReceiver.didReceiveMessage(*this, decoder);
@@ -308,7 +324,7 @@ void Connection::dispatchWorkQueueMessageReceiverMessage(WorkQueueMessageReceive
         return;
     }
 
-    auto replyEncoder = std::make_unique<Encoder>("IPC", "SyncMessageReply", syncRequestID);
+    auto replyEncoder = createEncoder("IPC", "SyncMessageReply", syncRequestID);
 
     // Hand off both the decoder and encoder to the work queue message receiver.
     workQueueMessageReceiver.didReceiveSyncMessage(*this, decoder, replyEncoder);
@@ -362,9 +378,14 @@ void Connection::markCurrentlyDispatchedMessageAsInvalid()
     m_didReceiveInvalidMessage = true;
 }
 
+std::unique_ptr<Encoder> Connection::createEncoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID) const
+{
+    return std::make_unique<Encoder>(messageReceiverName, messageName, destinationID, encodingFormat());
+}
+
 std::unique_ptr<Encoder> Connection::createSyncMessageEncoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID, uint64_t& syncRequestID)
 {
-    auto encoder = std::make_unique<Encoder>(messageReceiverName, messageName, destinationID);
+    auto encoder = createEncoder(messageReceiverName, messageName, destinationID);
     encoder->setIsSyncMessage(true);
 
     // Encode the sync request ID.
@@ -523,6 +544,13 @@ std::unique_ptr<Decoder> Connection::sendSyncMessage(uint64_t syncRequestID, std
 
     ++m_inSendSyncCount;
 
+    // The names refer to static strings, so they outlive the encoder.
+    StringReference messageReceiverName = encoder->messageReceiverName();
+    StringReference messageName = encoder->messageName();
+    MonotonicTime sendStart;
+    if (MessageStatistics::isEnabled())
+        sendStart = MonotonicTime::now();
+
     // First send the message.
     sendMessage(WTFMove(encoder), IPC::SendOption::DispatchMessageEvenWhenWaitingForSyncReply);
 
@@ -531,6 +559,9 @@ std::unique_ptr<Decoder> Connection::sendSyncMessage(uint64_t syncRequestID, std
     Ref<Connection> protect(*this);
     std::unique_ptr<Decoder> reply = waitForSyncReply(syncRequestID, timeout, sendSyncOptions);
 
+    if (sendStart)
+        MessageStatistics::didWaitForSyncReply(messageReceiverName, messageName, MonotonicTime::now() - sendStart);
+
     --m_inSendSyncCount;
 
     // Finally, pop the pending sync reply information.
@@ -652,6 +683,9 @@ void Connection::processIncomingMessage(std::unique_ptr<Decoder> message)
         return;
     }
 
+    if (MessageStatistics::isEnabled())
+        message->setReceiveTime(MonotonicTime::now());
+
     if (!m_workQueueMessageReceivers.isValidKey(message->messageReceiverName())) {
         RefPtr<Connection> protectedThis(this);
         StringReference messageReceiverNameReference = message->messageReceiverName();
@@ -842,7 +876,7 @@ void Connection::dispatchSyncMessage(Decoder& decoder)
         return;
     }
 
-    auto replyEncoder = std::make_unique<Encoder>("IPC", "SyncMessageReply", syncRequestID);
+    auto replyEncoder = createEncoder("IPC", "SyncMessageReply", syncRequestID);
 
     if (decoder.messageReceiverName() == "IPC" && decoder.messageName() == "WrappedAsyncMessageForTesting") {
         if (!m_fullySynchronousModeIsAllowedForTesting) {
@@ -922,11 +956,18 @@ void Connection::dispatchMessage(std::unique_ptr<Decoder> message)
     bool oldDidReceiveInvalidMessage = m_didReceiveInvalidMessage;
     m_didReceiveInvalidMessage = false;
 
+    MonotonicTime dispatchStart;
+    if (message->receiveTime())
+        dispatchStart = MonotonicTime::now();
+
     if (message->isSyncMessage())
         dispatchSyncMessage(*message);
     else
         dispatchMessage(*message);
 
+    if (dispatchStart)
+        MessageStatistics::didDispatchMessage(*message, dispatchStart - message->receiveTime(), MonotonicTime::now() - dispatchStart);
+
     m_didReceiveInvalidMessage |= message->isInvalid();
     m_inDispatchMessageCount--;
 
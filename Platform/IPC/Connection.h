@@ -79,6 +79,7 @@ enum class WaitForOption {
 while (0)
 
 class MachMessage;
+class MessageBodyRing;
 class UnixMessage;
 
 class Connection : public ThreadSafeRefCounted<Connection> {
@@ -146,6 +147,11 @@ public:
     void setOnlySendMessagesAsDispatchWhenWaitingForSyncReplyWhenProcessingSuchAMessage(bool);
     void setShouldExitOnSyncMessageSendFailure(bool shouldExitOnSyncMessageSendFailure);
 
+    // Applies to messages sent from now on. Incoming messages are decoded in whatever format they were sent.
+    void setEncodingFormat(EncodingFormat encodingFormat) { m_encodingFormat.store(encodingFormat, std::memory_order_relaxed); }
+    EncodingFormat encodingFormat() const { return m_encodingFormat.load(std::memory_order_relaxed); }
+    std::unique_ptr<Encoder> createEncoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID) const;
+
     // The set callback will be called on the connection work queue when the connection is closed, 
     // before didCall is called on the client thread. Must be called before the connection is opened.
     // In the future we might want a more generic way to handle sync or async messages directly
@@ -202,6 +208,13 @@ public:
 
     void ignoreTimeoutsForTesting() { m_ignoreTimeoutsForTesting = true; }
 
+#if USE(UNIX_DOMAIN_SOCKETS)
+    // Out-of-line message bodies written to the MessageBodyRing, and those that had to fall back
+    // to a dedicated shared memory segment because the ring was full or unavailable.
+    uint64_t bodyRingHitCount() const { return m_bodyRingHitCount.load(std::memory_order_relaxed); }
+    uint64_t bodyRingFallbackCount() const { return m_bodyRingFallbackCount.load(std::memory_order_relaxed); }
+#endif
+
 private:
     Connection(Identifier, bool isServer, Client&);
     void platformInitialize(Identifier);
@@ -216,6 +229,7 @@ private:
     void processIncomingSyncReply(std::unique_ptr<Decoder>);
 
     void dispatchWorkQueueMessageReceiverMessage(WorkQueueMessageReceiver&, Decoder&);
+    void dispatchWorkQueueMessageReceiverMessageWithoutStatistics(WorkQueueMessageReceiver&, Decoder&);
 
     bool canSendOutgoingMessages() const;
     bool platformCanSendOutgoingMessages() const;
@@ -250,6 +264,7 @@ private:
 
     bool m_onlySendMessagesAsDispatchWhenWaitingForSyncReplyWhenProcessingSuchAMessage;
     bool m_shouldExitOnSyncMessageSendFailure;
+    std::atomic<EncodingFormat> m_encodingFormat { EncodingFormat::Aligned };
     DidCloseOnConnectionWorkQueueCallback m_didCloseOnConnectionWorkQueueCallback;
 
     bool m_isConnected;
@@ -306,11 +321,18 @@ private:
     void readyReadHandler();
     bool processMessage();
     bool sendOutputMessage(UnixMessage&);
+    bool writeBodyToRing(UnixMessage&);
 
     Vector<uint8_t> m_readBuffer;
     Vector<int> m_fileDescriptors;
     int m_socketDescriptor;
     std::unique_ptr<UnixMessage> m_pendingOutputMessage;
+    std::unique_ptr<MessageBodyRing> m_outgoingBodyRing;
+    std::unique_ptr<MessageBodyRing> m_incomingBodyRing;
+    bool m_didTryToCreateOutgoingBodyRing { false };
+    bool m_didSendOutgoingBodyRing { false };
+    std::atomic<uint64_t> m_bodyRingHitCount { 0 };
+    std::atomic<uint64_t> m_bodyRingFallbackCount { 0 };
 #if USE(GLIB)
     GRefPtr<GSocket> m_socket;
     GSocketMonitor m_readSocketMonitor;
@@ -338,7 +360,7 @@ bool Connection::send(T&& message, uint64_t destinationID, OptionSet<SendOption>
 {
     COMPILE_ASSERT(!T::isSync, AsyncMessageExpected);
 
-    auto encoder = std::make_unique<Encoder>(T::receiverName(), T::name(), destinationID);
+    auto encoder = createEncoder(T::receiverName(), T::name(), destinationID);
     encoder->encode(message.arguments());
     
     return sendMessage(WTFMove(encoder), sendOptions);
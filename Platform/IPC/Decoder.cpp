@@ -64,6 +64,9 @@ Decoder::Decoder(const uint8_t* buffer, size_t bufferSize, void (*bufferDealloca
 
     if (!decode(m_destinationID))
         return;
+
+    // The header is always aligned; only the message body can be packed.
+    m_usesPackedEncoding = m_messageFlags & UsesPackedEncoding;
 }
 
 Decoder::~Decoder()
@@ -138,6 +141,9 @@ static inline bool alignedBufferIsLargeEnoughToContain(const uint8_t* alignedPos
 
 bool Decoder::alignBufferPosition(unsigned alignment, size_t size)
 {
+    if (m_usesPackedEncoding)
+        alignment = 1;
+
     const uint8_t* alignedPosition = roundUpToAlignment(m_bufferPos, alignment);
     if (!alignedBufferIsLargeEnoughToContain(alignedPosition, m_bufferEnd, size)) {
         // We've walked off the end of this buffer.
@@ -151,6 +157,9 @@ bool Decoder::alignBufferPosition(unsigned alignment, size_t size)
 
 bool Decoder::bufferIsLargeEnoughToContain(unsigned alignment, size_t size) const
 {
+    if (m_usesPackedEncoding)
+        alignment = 1;
+
     return alignedBufferIsLargeEnoughToContain(roundUpToAlignment(m_bufferPos, alignment), m_bufferEnd, size);
 }
 
@@ -181,6 +190,62 @@ bool Decoder::decodeVariableLengthByteArray(DataReference& dataReference)
     return true;
 }
 
+bool Decoder::decodeVarint(uint64_t& result)
+{
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        if (m_bufferPos >= m_bufferEnd) {
+            markInvalid();
+            return false;
+        }
+
+        uint8_t byte = *m_bufferPos++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            // Reject bits that do not fit in 64 bits.
+            if (shift == 63 && byte > 1) {
+                markInvalid();
+                return false;
+            }
+            result = value;
+            return true;
+        }
+    }
+
+    markInvalid();
+    return false;
+}
+
+static inline int64_t zigZagDecode(uint64_t value)
+{
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+template<typename T>
+bool Decoder::decodeVarint(T& result)
+{
+    uint64_t value;
+    if (!decodeVarint(value))
+        return false;
+
+    if (std::is_signed<T>::value) {
+        int64_t signedValue = zigZagDecode(value);
+        if (signedValue < static_cast<int64_t>(std::numeric_limits<T>::min()) || signedValue > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+            markInvalid();
+            return false;
+        }
+        result = static_cast<T>(signedValue);
+        return true;
+    }
+
+    if (value > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+        markInvalid();
+        return false;
+    }
+    result = static_cast<T>(value);
+    return true;
+}
+
 template<typename Type>
 static void decodeValueFromBuffer(Type& value, const uint8_t*& bufferPosition)
 {
@@ -208,6 +273,9 @@ bool Decoder::decode(uint8_t& result)
 
 bool Decoder::decode(uint16_t& result)
 {
+    if (m_usesPackedEncoding)
+        return decodeVarint(result);
+
     if (!alignBufferPosition(sizeof(result), sizeof(result)))
         return false;
 
@@ -217,6 +285,9 @@ bool Decoder::decode(uint16_t& result)
 
 bool Decoder::decode(uint32_t& result)
 {
+    if (m_usesPackedEncoding)
+        return decodeVarint(result);
+
     if (!alignBufferPosition(sizeof(result), sizeof(result)))
         return false;
 
@@ -226,6 +297,9 @@ bool Decoder::decode(uint32_t& result)
 
 bool Decoder::decode(uint64_t& result)
 {
+    if (m_usesPackedEncoding)
+        return decodeVarint(result);
+
     if (!alignBufferPosition(sizeof(result), sizeof(result)))
         return false;
     
@@ -235,6 +309,9 @@ bool Decoder::decode(uint64_t& result)
 
 bool Decoder::decode(int32_t& result)
 {
+    if (m_usesPackedEncoding)
+        return decodeVarint(result);
+
     if (!alignBufferPosition(sizeof(result), sizeof(result)))
         return false;
     
@@ -244,6 +321,9 @@ bool Decoder::decode(int32_t& result)
 
 bool Decoder::decode(int64_t& result)
 {
+    if (m_usesPackedEncoding)
+        return decodeVarint(result);
+
     if (!alignBufferPosition(sizeof(result), sizeof(result)))
         return false;
 
@@ -29,6 +29,7 @@
 #include "Attachment.h"
 #include "StringReference.h"
 #include <wtf/EnumTraits.h>
+#include <wtf/MonotonicTime.h>
 #include <wtf/Vector.h>
 
 #if HAVE(QOS_CLASSES)
@@ -56,6 +57,7 @@ public:
     bool isSyncMessage() const;
     bool shouldDispatchMessageWhenWaitingForSyncReply() const;
     bool shouldUseFullySynchronousModeForTesting() const;
+    bool usesPackedEncoding() const { return m_usesPackedEncoding; }
 
 #if PLATFORM(MAC)
     void setImportanceAssertion(std::unique_ptr<ImportanceAssertion>);
@@ -69,6 +71,10 @@ public:
 
     size_t length() const { return m_bufferEnd - m_buffer; }
 
+    // Only set while MessageStatistics are enabled.
+    MonotonicTime receiveTime() const { return m_receiveTime; }
+    void setReceiveTime(MonotonicTime receiveTime) { m_receiveTime = receiveTime; }
+
     bool isInvalid() const { return m_bufferPos > m_bufferEnd; }
     void markInvalid() { m_bufferPos = m_bufferEnd + 1; }
 
@@ -115,7 +121,7 @@ public:
     template<typename T>
     bool bufferIsLargeEnoughToContain(size_t numElements) const
     {
-        static_assert(std::is_arithmetic<T>::value, "Type T must have a fixed, known encoded size!");
+        static_assert(std::is_trivially_copyable<T>::value, "Type T must have a fixed, known encoded size!");
 
         if (numElements > std::numeric_limits<size_t>::max() / sizeof(T))
             return false;
@@ -136,6 +142,8 @@ public:
 private:
     bool alignBufferPosition(unsigned alignment, size_t);
     bool bufferIsLargeEnoughToContain(unsigned alignment, size_t) const;
+    bool decodeVarint(uint64_t&);
+    template<typename T> bool decodeVarint(T&);
 
     const uint8_t* m_buffer;
     const uint8_t* m_bufferPos;
@@ -145,11 +153,14 @@ private:
     Vector<Attachment> m_attachments;
 
     uint8_t m_messageFlags;
+    bool m_usesPackedEncoding { false };
     StringReference m_messageReceiverName;
     StringReference m_messageName;
 
     uint64_t m_destinationID;
 
+    MonotonicTime m_receiveTime;
+
 #if PLATFORM(MAC)
     std::unique_ptr<ImportanceAssertion> m_importanceAssertion;
 #endif
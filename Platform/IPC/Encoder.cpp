@@ -61,7 +61,7 @@ static inline void freeBuffer(void* addr, size_t size)
 #endif
 }
 
-Encoder::Encoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID)
+Encoder::Encoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID, EncodingFormat encodingFormat)
     : m_messageReceiverName(messageReceiverName)
     , m_messageName(messageName)
     , m_destinationID(destinationID)
@@ -71,6 +71,11 @@ Encoder::Encoder(StringReference messageReceiverName, StringReference messageNam
     , m_bufferCapacity(sizeof(m_inlineBuffer))
 {
     encodeHeader();
+
+    if (encodingFormat == EncodingFormat::Packed) {
+        *buffer() |= UsesPackedEncoding;
+        m_encodingFormat = EncodingFormat::Packed;
+    }
 }
 
 Encoder::~Encoder()
@@ -165,6 +170,9 @@ void Encoder::encodeHeader()
 
 uint8_t* Encoder::grow(unsigned alignment, size_t size)
 {
+    if (m_encodingFormat == EncodingFormat::Packed)
+        alignment = 1;
+
     size_t alignedSize = roundUpToAlignment(m_bufferSize, alignment);
     reserve(alignedSize + size);
 
@@ -174,6 +182,25 @@ uint8_t* Encoder::grow(unsigned alignment, size_t size)
     return m_buffer + alignedSize;
 }
 
+void Encoder::encodeVarint(uint64_t value)
+{
+    uint8_t bytes[10];
+    size_t size = 0;
+    while (value >= 0x80) {
+        bytes[size++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    bytes[size++] = static_cast<uint8_t>(value);
+
+    uint8_t* buffer = grow(1, size);
+    memcpy(buffer, bytes, size);
+}
+
+static inline uint64_t zigZagEncode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
 void Encoder::encodeFixedLengthData(const uint8_t* data, size_t size, unsigned alignment)
 {
     ASSERT(!(reinterpret_cast<uintptr_t>(data) % alignment));
@@ -208,30 +235,55 @@ void Encoder::encode(uint8_t n)
 
 void Encoder::encode(uint16_t n)
 {
+    if (m_encodingFormat == EncodingFormat::Packed) {
+        encodeVarint(n);
+        return;
+    }
+
     uint8_t* buffer = grow(sizeof(n), sizeof(n));
     copyValueToBuffer(n, buffer);
 }
 
 void Encoder::encode(uint32_t n)
 {
+    if (m_encodingFormat == EncodingFormat::Packed) {
+        encodeVarint(n);
+        return;
+    }
+
     uint8_t* buffer = grow(sizeof(n), sizeof(n));
     copyValueToBuffer(n, buffer);
 }
 
 void Encoder::encode(uint64_t n)
 {
+    if (m_encodingFormat == EncodingFormat::Packed) {
+        encodeVarint(n);
+        return;
+    }
+
     uint8_t* buffer = grow(sizeof(n), sizeof(n));
     copyValueToBuffer(n, buffer);
 }
 
 void Encoder::encode(int32_t n)
 {
+    if (m_encodingFormat == EncodingFormat::Packed) {
+        encodeVarint(zigZagEncode(n));
+        return;
+    }
+
     uint8_t* buffer = grow(sizeof(n), sizeof(n));
     copyValueToBuffer(n, buffer);
 }
 
 void Encoder::encode(int64_t n)
 {
+    if (m_encodingFormat == EncodingFormat::Packed) {
+        encodeVarint(zigZagEncode(n));
+        return;
+    }
+
     uint8_t* buffer = grow(sizeof(n), sizeof(n));
     copyValueToBuffer(n, buffer);
 }
@@ -35,15 +35,20 @@ namespace IPC {
 
 class DataReference;
 
+// The message header always uses the aligned format. With the packed format, the rest of the message
+// is written without alignment padding and integers wider than a byte are written as varints.
+enum class EncodingFormat : bool { Aligned, Packed };
+
 class Encoder final {
     WTF_MAKE_FAST_ALLOCATED;
 public:
-    Encoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID);
+    Encoder(StringReference messageReceiverName, StringReference messageName, uint64_t destinationID, EncodingFormat = EncodingFormat::Aligned);
     ~Encoder();
 
     StringReference messageReceiverName() const { return m_messageReceiverName; }
     StringReference messageName() const { return m_messageName; }
     uint64_t destinationID() const { return m_destinationID; }
+    EncodingFormat encodingFormat() const { return m_encodingFormat; }
 
     void setIsSyncMessage(bool);
     bool isSyncMessage() const;
@@ -109,10 +114,12 @@ private:
     }
 
     void encodeHeader();
+    void encodeVarint(uint64_t);
 
     StringReference m_messageReceiverName;
     StringReference m_messageName;
     uint64_t m_destinationID;
+    EncodingFormat m_encodingFormat { EncodingFormat::Aligned };
 
     uint8_t m_inlineBuffer[512];
 
@@ -32,6 +32,7 @@ enum MessageFlags {
     SyncMessage = 1 << 0,
     DispatchMessageWhenWaitingForSyncReply = 1 << 1,
     UseFullySynchronousModeForTesting = 1 << 2,
+    UsesPackedEncoding = 1 << 3,
 };
 
 } // namespace IPC
@@ -43,7 +43,9 @@ public:
     {
         static_assert(!U::isSync, "Message is sync!");
 
-        auto encoder = std::make_unique<Encoder>(U::receiverName(), U::name(), destinationID);
+        // Messages queued before the connection exists are sent in the default format.
+        auto* connection = messageSenderConnection();
+        auto encoder = connection ? connection->createEncoder(U::receiverName(), U::name(), destinationID) : std::make_unique<Encoder>(U::receiverName(), U::name(), destinationID);
         encoder->encode(message.arguments());
         
         return sendMessage(WTFMove(encoder), sendOptions);
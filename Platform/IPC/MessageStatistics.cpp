@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "MessageStatistics.h"
+
+#include "Decoder.h"
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <wtf/HashMap.h>
+#include <wtf/Lock.h>
+#include <wtf/NeverDestroyed.h>
+#include <wtf/ProcessID.h>
+#include <wtf/StringHasher.h>
+#include <wtf/Threading.h>
+#include <wtf/text/CString.h>
+
+#if OS(UNIX)
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+namespace IPC {
+
+std::atomic<bool> MessageStatistics::s_isEnabled;
+
+struct MessageCounters {
+    bool matches(StringReference receiverName, StringReference name) const
+    {
+        return StringReference(messageReceiverName.data(), messageReceiverName.length()) == receiverName
+            && StringReference(messageName.data(), messageName.length()) == name;
+    }
+
+    std::atomic<bool> isInUse { false };
+    uint64_t hash { 0 };
+    CString messageReceiverName;
+    CString messageName;
+    std::atomic<uint64_t> count { 0 };
+    std::atomic<uint64_t> bytes { 0 };
+    std::atomic<uint64_t> queueingDelayNanoseconds { 0 };
+    std::atomic<uint64_t> dispatchNanoseconds { 0 };
+    std::atomic<uint64_t> syncSendCount { 0 };
+    std::atomic<uint64_t> syncWaitNanoseconds { 0 };
+};
+
+// Only the owning thread writes to its counters, so plain loads and stores
+// are enough; other threads may read them at any time to take a snapshot.
+static void addToCounter(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+static uint64_t nanoseconds(Seconds seconds)
+{
+    return seconds > 0_s ? static_cast<uint64_t>(seconds.nanoseconds()) : 0;
+}
+
+static uint64_t messageHash(StringReference messageReceiverName, StringReference messageName)
+{
+    uint64_t receiverHash = StringHasher::computeHash(messageReceiverName.data(), messageReceiverName.size());
+    uint64_t nameHash = StringHasher::computeHash(messageName.data(), messageName.size());
+    return receiverHash << 32 | nameHash;
+}
+
+// Totals keyed by message receiver name and message name.
+typedef HashMap<std::pair<String, String>, MessageStatistics::Entry> EntryMap;
+
+static void addToEntry(MessageStatistics::Entry& entry, const MessageCounters& counters)
+{
+    entry.count += counters.count.load(std::memory_order_relaxed);
+    entry.bytes += counters.bytes.load(std::memory_order_relaxed);
+    entry.queueingDelay += Seconds::fromNanoseconds(counters.queueingDelayNanoseconds.load(std::memory_order_relaxed));
+    entry.dispatchTime += Seconds::fromNanoseconds(counters.dispatchNanoseconds.load(std::memory_order_relaxed));
+    entry.syncSendCount += counters.syncSendCount.load(std::memory_order_relaxed);
+    entry.syncWaitTime += Seconds::fromNanoseconds(counters.syncWaitNanoseconds.load(std::memory_order_relaxed));
+}
+
+static Lock& registryLock()
+{
+    static NeverDestroyed<Lock> lock;
+    return lock;
+}
+
+class ThreadMessageStatistics;
+
+static Vector<ThreadMessageStatistics*>& registry()
+{
+    static NeverDestroyed<Vector<ThreadMessageStatistics*>> registry;
+    return registry;
+}
+
+// The counters of threads that have exited, so that their messages are still part of the totals.
+static EntryMap& exitedThreadTotals()
+{
+    static NeverDestroyed<EntryMap> totals;
+    return totals;
+}
+
+static EntryMap& baseline()
+{
+    static NeverDestroyed<EntryMap> baseline;
+    return baseline;
+}
+
+class ThreadMessageStatistics {
+    WTF_MAKE_NONCOPYABLE(ThreadMessageStatistics);
+    WTF_MAKE_FAST_ALLOCATED;
+public:
+    static const size_t capacity = 1024;
+
+    ThreadMessageStatistics()
+    {
+        std::lock_guard<Lock> lock(registryLock());
+        registry().append(this);
+    }
+
+    ~ThreadMessageStatistics()
+    {
+        std::lock_guard<Lock> lock(registryLock());
+        addTo(exitedThreadTotals());
+        registry().removeFirst(this);
+    }
+
+    MessageCounters* counters(StringReference messageReceiverName, StringReference messageName)
+    {
+        // Only this thread claims slots, so it can read them without synchronization.
+        uint64_t hash = messageHash(messageReceiverName, messageName);
+        for (size_t i = 0; i < capacity; ++i) {
+            auto& counters = m_counters[(hash + i) % capacity];
+            if (counters.isInUse.load(std::memory_order_relaxed)) {
+                if (counters.hash == hash && counters.matches(messageReceiverName, messageName))
+                    return &counters;
+                continue;
+            }
+
+            counters.hash = hash;
+            counters.messageReceiverName = messageReceiverName.toString();
+            counters.messageName = messageName.toString();
+            counters.isInUse.store(true, std::memory_order_release);
+            return &counters;
+        }
+
+        // The table is full; messages beyond the first thousand kinds seen by a thread go uncounted.
+        return nullptr;
+    }
+
+    // Must be called with the registry lock held.
+    void addTo(EntryMap& totals) const
+    {
+        for (auto& counters : m_counters) {
+            if (!counters.isInUse.load(std::memory_order_acquire))
+                continue;
+
+            auto key = std::make_pair(String::fromUTF8(counters.messageReceiverName.data()), String::fromUTF8(counters.messageName.data()));
+            auto& entry = totals.add(key, MessageStatistics::Entry()).iterator->value;
+            if (entry.messageReceiverName.isNull()) {
+                entry.messageReceiverName = key.first;
+                entry.messageName = key.second;
+            }
+            addToEntry(entry, counters);
+        }
+    }
+
+private:
+    std::array<MessageCounters, capacity> m_counters;
+};
+
+static ThreadMessageStatistics& statisticsForCurrentThread()
+{
+    // Destroyed when the thread exits, which folds its counters into exitedThreadTotals().
+    static thread_local std::unique_ptr<ThreadMessageStatistics> currentThreadStatistics;
+    if (!currentThreadStatistics)
+        currentThreadStatistics = std::make_unique<ThreadMessageStatistics>();
+    return *currentThreadStatistics;
+}
+
+void MessageStatistics::setEnabled(bool enabled)
+{
+    s_isEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void MessageStatistics::didDispatchMessage(const Decoder& decoder, Seconds queueingDelay, Seconds dispatchTime)
+{
+    auto* counters = statisticsForCurrentThread().counters(decoder.messageReceiverName(), decoder.messageName());
+    if (!counters)
+        return;
+
+    addToCounter(counters->count, 1);
+    addToCounter(counters->bytes, decoder.length());
+    addToCounter(counters->queueingDelayNanoseconds, nanoseconds(queueingDelay));
+    addToCounter(counters->dispatchNanoseconds, nanoseconds(dispatchTime));
+}
+
+void MessageStatistics::didWaitForSyncReply(StringReference messageReceiverName, StringReference messageName, Seconds waitTime)
+{
+    auto* counters = statisticsForCurrentThread().counters(messageReceiverName, messageName);
+    if (!counters)
+        return;
+
+    addToCounter(counters->syncSendCount, 1);
+    addToCounter(counters->syncWaitNanoseconds, nanoseconds(waitTime));
+}
+
+static EntryMap aggregatedStatistics()
+{
+    EntryMap totals;
+    for (auto& keyAndEntry : exitedThreadTotals()) {
+        // The strings were created by threads that have since exited, and the totals are handed out to other threads.
+        auto entry = keyAndEntry.value;
+        entry.messageReceiverName = entry.messageReceiverName.isolatedCopy();
+        entry.messageName = entry.messageName.isolatedCopy();
+        totals.add(std::make_pair(entry.messageReceiverName, entry.messageName), WTFMove(entry));
+    }
+    for (auto* threadStatistics : registry())
+        threadStatistics->addTo(totals);
+    return totals;
+}
+
+Vector<MessageStatistics::Entry> MessageStatistics::snapshot()
+{
+    std::lock_guard<Lock> lock(registryLock());
+
+    Vector<Entry> entries;
+    for (auto& keyAndEntry : aggregatedStatistics()) {
+        auto entry = keyAndEntry.value;
+        auto baselineEntry = baseline().get(keyAndEntry.key);
+        entry.count -= baselineEntry.count;
+        entry.bytes -= baselineEntry.bytes;
+        entry.queueingDelay -= baselineEntry.queueingDelay;
+        entry.dispatchTime -= baselineEntry.dispatchTime;
+        entry.syncSendCount -= baselineEntry.syncSendCount;
+        entry.syncWaitTime -= baselineEntry.syncWaitTime;
+        if (entry.count || entry.syncSendCount)
+            entries.append(WTFMove(entry));
+    }
+    return entries;
+}
+
+void MessageStatistics::reset()
+{
+    // Counters are never written by other threads, so instead of clearing
+    // them remember the current totals and report relative to those.
+    std::lock_guard<Lock> lock(registryLock());
+    baseline() = aggregatedStatistics();
+}
+
+void MessageStatistics::dump()
+{
+    auto entries = snapshot();
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.dispatchTime + a.syncWaitTime > b.dispatchTime + b.syncWaitTime;
+    });
+
+    WTFLogAlways("IPC message statistics for process %d (%zu message kinds):", getCurrentProcessID(), entries.size());
+    for (auto& entry : entries) {
+        WTFLogAlways("  %s::%s count=%llu bytes=%llu queueing=%.3fms dispatch=%.3fms syncSends=%llu syncWait=%.3fms",
+            entry.messageReceiverName.utf8().data(), entry.messageName.utf8().data(),
+            static_cast<unsigned long long>(entry.count), static_cast<unsigned long long>(entry.bytes),
+            entry.queueingDelay.milliseconds(), entry.dispatchTime.milliseconds(),
+            static_cast<unsigned long long>(entry.syncSendCount), entry.syncWaitTime.milliseconds());
+    }
+}
+
+#if OS(UNIX)
+static int dumpSignalPipe[2] = { -1, -1 };
+
+static void dumpSignalHandler(int)
+{
+    // Only async-signal-safe work is allowed here; the dump happens on the thread reading the pipe.
+    char byte = 0;
+    ssize_t result = write(dumpSignalPipe[1], &byte, 1);
+    UNUSED_VARIABLE(result);
+}
+
+static void installDumpSignalHandler()
+{
+    if (pipe(dumpSignalPipe) == -1)
+        return;
+
+    Thread::create("IPC::MessageStatistics dump", [] {
+        while (true) {
+            char byte;
+            ssize_t result = read(dumpSignalPipe[0], &byte, 1);
+            if (result == 1)
+                MessageStatistics::dump();
+            else if (result == -1 && errno == EINTR)
+                continue;
+            else
+                return;
+        }
+    })->detach();
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = dumpSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR2, &action, nullptr);
+}
+#endif
+
+void MessageStatistics::initializeFromEnvironment()
+{
+    static std::once_flag onceFlag;
+    std::call_once(onceFlag, [] {
+        if (!getenv("WEBKIT_IPC_STATISTICS"))
+            return;
+
+        setEnabled(true);
+#if OS(UNIX)
+        installDumpSignalHandler();
+#endif
+    });
+}
+
+} // namespace IPC
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "StringReference.h"
+#include <atomic>
+#include <wtf/Seconds.h>
+#include <wtf/Vector.h>
+#include <wtf/text/WTFString.h>
+
+namespace IPC {
+
+class Decoder;
+
+// Optional per-message instrumentation of every IPC::Connection in the process.
+// Each thread records into its own fixed-size table, so recording takes no
+// locks; only taking a snapshot walks the tables of all threads.
+class MessageStatistics {
+public:
+    struct Entry {
+        String messageReceiverName;
+        String messageName;
+        uint64_t count { 0 };
+        uint64_t bytes { 0 };
+        Seconds queueingDelay;
+        Seconds dispatchTime;
+        uint64_t syncSendCount { 0 };
+        Seconds syncWaitTime;
+    };
+
+    static bool isEnabled() { return s_isEnabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool);
+
+    // Enables the statistics if the WEBKIT_IPC_STATISTICS environment variable
+    // is set, and makes SIGUSR2 dump them to the log.
+    static void initializeFromEnvironment();
+
+    static Vector<Entry> snapshot();
+    static void reset();
+    static void dump();
+
+    // Totals for a received message, recorded on the thread that dispatched it.
+    static void didDispatchMessage(const Decoder&, Seconds queueingDelay, Seconds dispatchTime);
+    // Totals for a sent sync message, recorded on the thread that waited for the reply.
+    static void didWaitForSyncReply(StringReference messageReceiverName, StringReference messageName, Seconds waitTime);
+
+private:
+    static std::atomic<bool> s_isEnabled;
+};
+
+} // namespace IPC
@@ -29,6 +29,7 @@
 #include "Connection.h"
 
 #include "DataReference.h"
+#include "MessageBodyRing.h"
 #include "SharedMemory.h"
 #include "UnixMessage.h"
 #include <sys/socket.h>
@@ -120,6 +121,9 @@ void Connection::platformInvalidate()
 
     m_socketDescriptor = -1;
     m_isConnected = false;
+
+    m_outgoingBodyRing = nullptr;
+    m_incomingBodyRing = nullptr;
 }
 
 bool Connection::processMessage()
@@ -132,12 +136,12 @@ bool Connection::processMessage()
     memcpy(&messageInfo, messageData, sizeof(messageInfo));
     messageData += sizeof(messageInfo);
 
-    if (messageInfo.attachmentCount() > attachmentMaxAmount || (!messageInfo.isBodyOutOfLine() && messageInfo.bodySize() > messageMaxSize)) {
+    if (messageInfo.attachmentCount() > attachmentMaxAmount || (messageInfo.isBodyInline() && messageInfo.bodySize() > messageMaxSize)) {
         ASSERT_NOT_REACHED();
         return false;
     }
 
-    size_t messageLength = sizeof(MessageInfo) + messageInfo.attachmentCount() * sizeof(AttachmentInfo) + (messageInfo.isBodyOutOfLine() ? 0 : messageInfo.bodySize());
+    size_t messageLength = sizeof(MessageInfo) + messageInfo.attachmentCount() * sizeof(AttachmentInfo) + (messageInfo.isBodyInline() ? messageInfo.bodySize() : 0);
     if (m_readBuffer.size() < messageLength)
         return false;
 
@@ -163,7 +167,7 @@ bool Connection::processMessage()
             }
         }
 
-        if (messageInfo.isBodyOutOfLine())
+        if (messageInfo.isBodyOutOfLine() || messageInfo.carriesBodyRing())
             attachmentCount--;
     }
 
@@ -209,13 +213,39 @@ bool Connection::processMessage()
         }
     }
 
-    ASSERT(attachments.size() == (messageInfo.isBodyOutOfLine() ? messageInfo.attachmentCount() - 1 : messageInfo.attachmentCount()));
+    if (messageInfo.carriesBodyRing()) {
+        if (attachmentInfo[attachmentCount].isNull()) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+
+        WebKit::SharedMemory::Handle handle;
+        handle.adoptAttachment(IPC::Attachment(m_fileDescriptors[attachmentFileDescriptorCount - 1], attachmentInfo[attachmentCount].size()));
+
+        m_incomingBodyRing = MessageBodyRing::map(handle);
+        if (!m_incomingBodyRing) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+    }
+
+    ASSERT(attachments.size() == (messageInfo.isBodyOutOfLine() || messageInfo.carriesBodyRing() ? messageInfo.attachmentCount() - 1 : messageInfo.attachmentCount()));
 
-    uint8_t* messageBody = messageData;
+    const uint8_t* messageBody = messageData;
     if (messageInfo.isBodyOutOfLine())
         messageBody = reinterpret_cast<uint8_t*>(oolMessageBody->data());
+    else if (messageInfo.isBodyInRing()) {
+        messageBody = m_incomingBodyRing ? m_incomingBodyRing->bodyAt(messageInfo.ringPosition(), messageInfo.bodySize()) : nullptr;
+        if (!messageBody) {
+            ASSERT_NOT_REACHED();
+            return false;
+        }
+    }
 
+    // The decoder copies the body, so the ring space can be released right away.
     auto decoder = std::make_unique<Decoder>(messageBody, messageInfo.bodySize(), nullptr, WTFMove(attachments));
+    if (messageInfo.isBodyInRing())
+        m_incomingBodyRing->didConsume(messageInfo.ringPosition(), messageInfo.bodySize());
 
     processIncomingMessage(WTFMove(decoder));
 
@@ -382,6 +412,19 @@ bool Connection::sendOutgoingMessage(std::unique_ptr<Encoder> encoder)
 
     size_t messageSizeWithBodyInline = sizeof(MessageInfo) + (outputMessage.attachments().size() * sizeof(AttachmentInfo)) + outputMessage.bodySize();
     if (messageSizeWithBodyInline > messageMaxSize && outputMessage.bodySize()) {
+        if (writeBodyToRing(outputMessage)) {
+            ++m_bodyRingHitCount;
+            bool carriesBodyRing = outputMessage.messageInfo().carriesBodyRing();
+            if (!sendOutputMessage(outputMessage))
+                return false;
+            // Until a message carrying the ring has been sent, every ring message carries it. The
+            // receiver just maps the ring again if it gets it twice.
+            if (carriesBodyRing)
+                m_didSendOutgoingBodyRing = true;
+            return true;
+        }
+        ++m_bodyRingFallbackCount;
+
         RefPtr<WebKit::SharedMemory> oolMessageBody = WebKit::SharedMemory::allocate(encoder->bufferSize());
         if (!oolMessageBody)
             return false;
@@ -400,6 +443,35 @@ bool Connection::sendOutgoingMessage(std::unique_ptr<Encoder> encoder)
     return sendOutputMessage(outputMessage);
 }
 
+bool Connection::writeBodyToRing(UnixMessage& outputMessage)
+{
+    if (!m_outgoingBodyRing) {
+        if (m_didTryToCreateOutgoingBodyRing)
+            return false;
+
+        m_didTryToCreateOutgoingBodyRing = true;
+        m_outgoingBodyRing = MessageBodyRing::create();
+        if (!m_outgoingBodyRing)
+            return false;
+    }
+
+    WebKit::SharedMemory::Handle handle;
+    if (!m_didSendOutgoingBodyRing && !m_outgoingBodyRing->createHandle(handle))
+        return false;
+
+    auto position = m_outgoingBodyRing->write(outputMessage.body(), outputMessage.bodySize());
+    if (!position)
+        return false;
+
+    outputMessage.messageInfo().setBodyInRing(position.value());
+    if (!m_didSendOutgoingBodyRing) {
+        outputMessage.messageInfo().setCarriesBodyRing();
+        outputMessage.appendAttachment(handle.releaseAttachment());
+    }
+
+    return true;
+}
+
 bool Connection::sendOutputMessage(UnixMessage& outputMessage)
 {
     ASSERT(!m_pendingOutputMessage);
@@ -471,7 +543,7 @@ bool Connection::sendOutputMessage(UnixMessage& outputMessage)
         ++iovLength;
     }
 
-    if (!messageInfo.isBodyOutOfLine() && outputMessage.bodySize()) {
+    if (messageInfo.isBodyInline() && outputMessage.bodySize()) {
         iov[iovLength].iov_base = reinterpret_cast<void*>(outputMessage.body());
         iov[iovLength].iov_len = outputMessage.bodySize();
         ++iovLength;
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "MessageBodyRing.h"
+
+#if USE(UNIX_DOMAIN_SOCKETS)
+
+#include <atomic>
+#include <wtf/StdLibExtras.h>
+
+namespace IPC {
+
+struct MessageBodyRing::Header {
+    // Written by the consumer only, once a body has been copied out of the ring.
+    std::atomic<uint64_t> readPosition;
+};
+
+// Keep the data area on its own cache line, so that the producer writing bodies doesn't contend
+// with the consumer acknowledging them.
+static const size_t headerSize = 64;
+static_assert(sizeof(std::atomic<uint64_t>) <= headerSize, "Header must fit in the reserved space");
+
+std::unique_ptr<MessageBodyRing> MessageBodyRing::create(size_t capacity)
+{
+    ASSERT(!(capacity % WebKit::SharedMemory::systemPageSize()));
+
+    auto sharedMemory = WebKit::SharedMemory::allocate(headerSize + capacity);
+    if (!sharedMemory)
+        return nullptr;
+
+    auto ring = std::unique_ptr<MessageBodyRing>(new MessageBodyRing(sharedMemory.releaseNonNull(), capacity));
+    ring->header().readPosition.store(0, std::memory_order_relaxed);
+    return ring;
+}
+
+std::unique_ptr<MessageBodyRing> MessageBodyRing::map(const WebKit::SharedMemory::Handle& handle)
+{
+    auto sharedMemory = WebKit::SharedMemory::map(handle, WebKit::SharedMemory::Protection::ReadWrite);
+    if (!sharedMemory || sharedMemory->size() <= headerSize)
+        return nullptr;
+
+    size_t capacity = sharedMemory->size() - headerSize;
+    return std::unique_ptr<MessageBodyRing>(new MessageBodyRing(sharedMemory.releaseNonNull(), capacity));
+}
+
+MessageBodyRing::MessageBodyRing(Ref<WebKit::SharedMemory>&& sharedMemory, size_t capacity)
+    : m_sharedMemory(WTFMove(sharedMemory))
+    , m_capacity(capacity)
+{
+}
+
+MessageBodyRing::~MessageBodyRing()
+{
+}
+
+MessageBodyRing::Header& MessageBodyRing::header() const
+{
+    return *static_cast<Header*>(m_sharedMemory->data());
+}
+
+uint8_t* MessageBodyRing::data() const
+{
+    return static_cast<uint8_t*>(m_sharedMemory->data()) + headerSize;
+}
+
+std::optional<uint64_t> MessageBodyRing::write(const uint8_t* body, size_t bodySize)
+{
+    ASSERT(bodySize);
+    if (bodySize > maximumBodySize())
+        return std::nullopt;
+
+    // Bodies are never split across the end of the ring. If it doesn't fit in the remaining
+    // space, skip to the beginning; the skipped bytes are released along with this body.
+    uint64_t position = m_writePosition;
+    size_t offset = position % m_capacity;
+    if (offset + bodySize > m_capacity)
+        position += m_capacity - offset;
+
+    uint64_t endPosition = position + roundUpToMultipleOf<alignof(uint64_t)>(bodySize);
+    uint64_t readPosition = header().readPosition.load(std::memory_order_acquire);
+    if (endPosition - readPosition > m_capacity)
+        return std::nullopt;
+
+    memcpy(data() + (position % m_capacity), body, bodySize);
+    m_writePosition = endPosition;
+    return position;
+}
+
+bool MessageBodyRing::createHandle(WebKit::SharedMemory::Handle& handle)
+{
+    return m_sharedMemory->createHandle(handle, WebKit::SharedMemory::Protection::ReadWrite);
+}
+
+const uint8_t* MessageBodyRing::bodyAt(uint64_t position, size_t bodySize) const
+{
+    size_t offset = position % m_capacity;
+    if (!bodySize || bodySize > m_capacity - offset)
+        return nullptr;
+
+    return data() + offset;
+}
+
+void MessageBodyRing::didConsume(uint64_t position, size_t bodySize)
+{
+    header().readPosition.store(position + roundUpToMultipleOf<alignof(uint64_t)>(bodySize), std::memory_order_release);
+}
+
+} // namespace IPC
+
+#endif // USE(UNIX_DOMAIN_SOCKETS)
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#if USE(UNIX_DOMAIN_SOCKETS)
+
+#include "SharedMemory.h"
+#include <wtf/Noncopyable.h>
+#include <wtf/Optional.h>
+#include <wtf/RefPtr.h>
+
+namespace IPC {
+
+// Single-producer, single-consumer ring of shared memory carrying message bodies that don't fit
+// in a socket packet. The sending side of a connection owns the ring and sends its handle once,
+// along with the first body written to it. Bodies are then referenced by their position in the
+// ring, and the receiving side acknowledges each one by advancing the read position stored in the
+// ring header once the body has been copied out, so no further syscalls are needed on either side.
+class MessageBodyRing {
+    WTF_MAKE_NONCOPYABLE(MessageBodyRing); WTF_MAKE_FAST_ALLOCATED;
+public:
+    static const size_t defaultCapacity = 1024 * 1024;
+
+    static std::unique_ptr<MessageBodyRing> create(size_t capacity = defaultCapacity);
+    static std::unique_ptr<MessageBodyRing> map(const WebKit::SharedMemory::Handle&);
+
+    ~MessageBodyRing();
+
+    size_t capacity() const { return m_capacity; }
+    size_t maximumBodySize() const { return m_capacity / 4; }
+
+    // Producer side. Returns the position of the body, or std::nullopt if the ring is full.
+    std::optional<uint64_t> write(const uint8_t* body, size_t);
+    bool createHandle(WebKit::SharedMemory::Handle&);
+
+    // Consumer side. Bodies must be consumed in the order they were written.
+    const uint8_t* bodyAt(uint64_t position, size_t) const;
+    void didConsume(uint64_t position, size_t);
+
+private:
+    MessageBodyRing(Ref<WebKit::SharedMemory>&&, size_t capacity);
+
+    struct Header;
+    Header& header() const;
+    uint8_t* data() const;
+
+    Ref<WebKit::SharedMemory> m_sharedMemory;
+    size_t m_capacity;
+    uint64_t m_writePosition { 0 };
+};
+
+} // namespace IPC
+
+#endif // USE(UNIX_DOMAIN_SOCKETS)
@@ -44,20 +44,45 @@ public:
 
     void setBodyOutOfLine()
     {
-        ASSERT(!isBodyOutOfLine());
+        ASSERT(isBodyInline());
 
         m_isBodyOutOfLine = true;
         m_attachmentCount++;
     }
 
+    void setBodyInRing(uint64_t position)
+    {
+        ASSERT(isBodyInline());
+
+        m_isBodyInRing = true;
+        m_ringPosition = position;
+    }
+
+    // The handle of the sender's MessageBodyRing is sent as the last attachment, only once.
+    void setCarriesBodyRing()
+    {
+        ASSERT(m_isBodyInRing);
+        ASSERT(!carriesBodyRing());
+
+        m_carriesBodyRing = true;
+        m_attachmentCount++;
+    }
+
     bool isBodyOutOfLine() const { return m_isBodyOutOfLine; }
+    bool isBodyInRing() const { return m_isBodyInRing; }
+    bool isBodyInline() const { return !m_isBodyOutOfLine && !m_isBodyInRing; }
+    bool carriesBodyRing() const { return m_carriesBodyRing; }
+    uint64_t ringPosition() const { return m_ringPosition; }
     size_t bodySize() const { return m_bodySize; }
     size_t attachmentCount() const { return m_attachmentCount; }
 
 private:
     size_t m_bodySize { 0 };
     size_t m_attachmentCount { 0 };
+    uint64_t m_ringPosition { 0 };
     bool m_isBodyOutOfLine { false };
+    bool m_isBodyInRing { false };
+    bool m_carriesBodyRing { false };
 };
 
 class UnixMessage {
@@ -77,7 +102,7 @@ public:
         if (other.m_bodyOwned) {
             std::swap(m_body, other.m_body);
             std::swap(m_bodyOwned, other.m_bodyOwned);
-        } else if (!m_messageInfo.isBodyOutOfLine()) {
+        } else if (m_messageInfo.isBodyInline()) {
             m_body = static_cast<uint8_t*>(fastMalloc(m_messageInfo.bodySize()));
             memcpy(m_body, other.m_body, m_messageInfo.bodySize());
             m_bodyOwned = true;
@@ -43,6 +43,7 @@ list(APPEND WebKit2_SOURCES
     Platform/IPC/glib/GSocketMonitor.cpp
     Platform/IPC/unix/AttachmentUnix.cpp
     Platform/IPC/unix/ConnectionUnix.cpp
+    Platform/IPC/unix/MessageBodyRing.cpp
 
     Platform/classifier/ResourceLoadStatisticsClassifier.cpp
 
@@ -958,6 +959,7 @@ if (ENABLE_PLUGIN_PROCESS_GTK2)
         Platform/IPC/glib/GSocketMonitor.cpp
         Platform/IPC/unix/AttachmentUnix.cpp
         Platform/IPC/unix/ConnectionUnix.cpp
+        Platform/IPC/unix/MessageBodyRing.cpp
 
         Platform/glib/ModuleGlib.cpp
 
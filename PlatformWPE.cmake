@@ -68,6 +68,7 @@ list(APPEND WebKit2_SOURCES
 
     Platform/IPC/unix/AttachmentUnix.cpp
     Platform/IPC/unix/ConnectionUnix.cpp
+    Platform/IPC/unix/MessageBodyRing.cpp
 
     Platform/classifier/ResourceLoadStatisticsClassifier.cpp
 
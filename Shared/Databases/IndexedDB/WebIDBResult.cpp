@@ -29,20 +29,198 @@
 #if ENABLE(INDEXED_DATABASE)
 
 #include "WebCoreArgumentCoders.h"
+#include "WebIDBValue.h"
+#include <WebCore/IDBGetAllResult.h>
+#include <WebCore/IDBGetResult.h>
+#include <WebCore/IDBKeyData.h>
+#include <WebCore/ThreadSafeDataBuffer.h>
+
+using namespace WebCore;
 
 namespace WebKit {
 
+static bool hasValueData(const IDBResultData& resultData)
+{
+    switch (resultData.type()) {
+    case IDBResultType::GetRecordSuccess:
+    case IDBResultType::OpenCursorSuccess:
+    case IDBResultType::IterateCursorSuccess:
+        return resultData.getResult().isDefined();
+    case IDBResultType::GetAllRecordsSuccess:
+        return resultData.getAllResult().type() == IndexedDB::GetAllType::Values;
+    default:
+        return false;
+    }
+}
+
+static IDBValue valueWithData(const IDBValue& value, const ThreadSafeDataBuffer& data)
+{
+    return { data, value.blobURLs(), value.sessionID(), value.blobFilePaths() };
+}
+
+static IDBGetAllResult getAllResultWithValueData(const IDBGetAllResult& result, const Vector<ThreadSafeDataBuffer>& data)
+{
+    // The keys and key path go along unchanged, they are needed to inject primary keys into the values.
+    IDBGetAllResult getAllResult(result.type(), result.keyPath());
+    for (auto& key : result.keys())
+        getAllResult.addKey(IDBKeyData(key));
+
+    auto& values = result.values();
+    ASSERT(values.size() == data.size());
+    for (size_t i = 0; i < values.size(); ++i)
+        getAllResult.addValue(valueWithData(values[i], data[i]));
+
+    return getAllResult;
+}
+
+// Returns a copy of resultData that only differs in the data of its values, which is replaced by
+// the given data in the order the values appear in the result.
+static IDBResultData resultDataWithValueData(const IDBResultData& resultData, const Vector<ThreadSafeDataBuffer>& data)
+{
+    if (resultData.type() == IDBResultType::GetAllRecordsSuccess)
+        return IDBResultData::getAllRecordsSuccess(resultData.requestIdentifier(), getAllResultWithValueData(resultData.getAllResult(), data));
+
+    ASSERT(data.size() == 1);
+    auto& result = resultData.getResult();
+    IDBGetResult getResult(result.keyData(), result.primaryKeyData(), valueWithData(result.value(), data[0]), result.keyPath());
+    switch (resultData.type()) {
+    case IDBResultType::GetRecordSuccess:
+        return IDBResultData::getRecordSuccess(resultData.requestIdentifier(), getResult);
+    case IDBResultType::OpenCursorSuccess:
+        return IDBResultData::openCursorSuccess(resultData.requestIdentifier(), getResult);
+    case IDBResultType::IterateCursorSuccess:
+        return IDBResultData::iterateCursorSuccess(resultData.requestIdentifier(), getResult);
+    default:
+        RELEASE_ASSERT_NOT_REACHED();
+    }
+}
+
+static size_t valueCount(const IDBResultData& resultData)
+{
+    if (!hasValueData(resultData))
+        return 0;
+    return resultData.type() == IDBResultType::GetAllRecordsSuccess ? resultData.getAllResult().values().size() : 1;
+}
+
+static Vector<String> blobFilePathsForResult(const IDBResultData& resultData)
+{
+    switch (resultData.type()) {
+    case IDBResultType::GetRecordSuccess:
+    case IDBResultType::OpenCursorSuccess:
+    case IDBResultType::IterateCursorSuccess:
+        return resultData.getResult().value().blobFilePaths();
+    case IDBResultType::GetAllRecordsSuccess:
+        return resultData.getAllResult().allBlobFilePaths();
+    default:
+        return { };
+    }
+}
+
+Vector<String> WebIDBResult::blobFilePaths() const
+{
+    auto filePaths = blobFilePathsForResult(m_resultData);
+    for (auto& prefetchedResult : m_prefetchedResults)
+        filePaths.appendVector(blobFilePathsForResult(prefetchedResult));
+    return filePaths;
+}
+
+// Encodes resultData with empty values and appends the data of its values to valueData.
+static void encodeResultWithoutValueData(IPC::Encoder& encoder, const IDBResultData& resultData, Vector<ThreadSafeDataBuffer>& valueData)
+{
+    bool hasValues = hasValueData(resultData);
+    encoder << hasValues;
+    if (!hasValues) {
+        resultData.encode(encoder);
+        return;
+    }
+
+    size_t firstValue = valueData.size();
+    if (resultData.type() == IDBResultType::GetAllRecordsSuccess) {
+        for (auto& value : resultData.getAllResult().values())
+            valueData.append(value.data());
+    } else
+        valueData.append(resultData.getResult().value().data());
+
+    resultDataWithValueData(resultData, Vector<ThreadSafeDataBuffer>(valueData.size() - firstValue)).encode(encoder);
+}
+
+static bool decodeResultWithoutValueData(IPC::Decoder& decoder, IDBResultData& resultData)
+{
+    bool hasValues;
+    if (!decoder.decode(hasValues))
+        return false;
+
+    if (!IDBResultData::decode(decoder, resultData))
+        return false;
+
+    return hasValues == hasValueData(resultData);
+}
+
+static void fillInValueData(IDBResultData& resultData, const Vector<ThreadSafeDataBuffer>& valueData, size_t& nextValue)
+{
+    size_t count = valueCount(resultData);
+    if (!count)
+        return;
+
+    Vector<ThreadSafeDataBuffer> data;
+    data.append(valueData.data() + nextValue, count);
+    nextValue += count;
+    resultData = resultDataWithValueData(resultData, data);
+}
+
 void WebIDBResult::encode(IPC::Encoder& encoder) const
 {
-    m_resultData.encode(encoder);
+    // Record values are sent apart from the rest of the results so that large ones can go through
+    // shared memory, with the values of all the prefetched records sharing one region.
+    Vector<ThreadSafeDataBuffer> valueData;
+    encodeResultWithoutValueData(encoder, m_resultData, valueData);
+
+    encoder << static_cast<uint64_t>(m_prefetchedResults.size());
+    for (auto& prefetchedResult : m_prefetchedResults)
+        encodeResultWithoutValueData(encoder, prefetchedResult, valueData);
+
+    if (!valueData.isEmpty())
+        WebIDBValue::encodeData(encoder, valueData);
     m_handles.encode(encoder);
 }
 
 bool WebIDBResult::decode(IPC::Decoder& decoder, WebIDBResult& result)
 {
-    if (!WebCore::IDBResultData::decode(decoder, result.m_resultData))
+    if (!decodeResultWithoutValueData(decoder, result.m_resultData))
+        return false;
+    size_t totalValueCount = valueCount(result.m_resultData);
+
+    uint64_t prefetchedResultCount;
+    if (!decoder.decode(prefetchedResultCount))
         return false;
 
+    if (prefetchedResultCount && result.m_resultData.type() != IDBResultType::IterateCursorSuccess)
+        return false;
+
+    for (uint64_t i = 0; i < prefetchedResultCount; ++i) {
+        IDBResultData prefetchedResult;
+        if (!decodeResultWithoutValueData(decoder, prefetchedResult))
+            return false;
+        if (prefetchedResult.type() != IDBResultType::IterateCursorSuccess)
+            return false;
+        totalValueCount += valueCount(prefetchedResult);
+        result.m_prefetchedResults.append(WTFMove(prefetchedResult));
+    }
+
+    if (totalValueCount) {
+        Vector<ThreadSafeDataBuffer> valueData;
+        if (!WebIDBValue::decodeData(decoder, valueData))
+            return false;
+
+        if (valueData.size() != totalValueCount)
+            return false;
+
+        size_t nextValue = 0;
+        fillInValueData(result.m_resultData, valueData, nextValue);
+        for (auto& prefetchedResult : result.m_prefetchedResults)
+            fillInValueData(prefetchedResult, valueData, nextValue);
+    }
+
     if (!SandboxExtension::HandleArray::decode(decoder, result.m_handles))
         return false;
 
@@ -30,6 +30,7 @@
 #include "SandboxExtension.h"
 #include <WebCore/IDBResultData.h>
 #include <wtf/Noncopyable.h>
+#include <wtf/Vector.h>
 
 namespace WebKit {
 
@@ -51,14 +52,33 @@ public:
     {
     }
 
+    // Prefetched results are the cursor records that follow an IterateCursorSuccess result.
+    WebIDBResult(const WebCore::IDBResultData& resultData, Vector<WebCore::IDBResultData>&& prefetchedResults)
+        : m_resultData(resultData)
+        , m_prefetchedResults(WTFMove(prefetchedResults))
+    {
+    }
+
+    WebIDBResult(const WebCore::IDBResultData& resultData, Vector<WebCore::IDBResultData>&& prefetchedResults, SandboxExtension::HandleArray&& handles)
+        : m_resultData(resultData)
+        , m_prefetchedResults(WTFMove(prefetchedResults))
+        , m_handles(WTFMove(handles))
+    {
+    }
+
     const WebCore::IDBResultData& resultData() const { return m_resultData; }
+    const Vector<WebCore::IDBResultData>& prefetchedResults() const { return m_prefetchedResults; }
     const SandboxExtension::HandleArray& handles() const { return m_handles; }
 
+    // The blob files of the result and of the prefetched results, in the order of the handles.
+    Vector<String> blobFilePaths() const;
+
     void encode(IPC::Encoder&) const;
     static bool decode(IPC::Decoder&, WebIDBResult&);
 
 private:
     WebCore::IDBResultData m_resultData;
+    Vector<WebCore::IDBResultData> m_prefetchedResults;
     SandboxExtension::HandleArray m_handles;
 };
 
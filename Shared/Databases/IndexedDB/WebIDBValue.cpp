@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include "config.h"
+#include "WebIDBValue.h"
+
+#if ENABLE(INDEXED_DATABASE)
+
+#include "ArgumentCoders.h"
+#include "SharedMemory.h"
+#include <WebCore/ThreadSafeDataBuffer.h>
+#include <wtf/CheckedArithmetic.h>
+
+using namespace WebCore;
+
+namespace WebKit {
+
+static size_t dataSize(const ThreadSafeDataBuffer& data)
+{
+    auto* vector = data.data();
+    return vector ? vector->size() : 0;
+}
+
+void WebIDBValue::encode(IPC::Encoder& encoder) const
+{
+    encodeData(encoder, { m_value.data() });
+    encoder << m_value.blobURLs();
+    encoder << m_value.sessionID();
+    encoder << m_value.blobFilePaths();
+}
+
+bool WebIDBValue::decode(IPC::Decoder& decoder, WebIDBValue& result)
+{
+    Vector<ThreadSafeDataBuffer> data;
+    if (!decodeData(decoder, data) || data.size() != 1)
+        return false;
+
+    Vector<String> blobURLs;
+    if (!decoder.decode(blobURLs))
+        return false;
+
+    SessionID sessionID;
+    if (!decoder.decode(sessionID))
+        return false;
+
+    Vector<String> blobFilePaths;
+    if (!decoder.decode(blobFilePaths))
+        return false;
+
+    result.m_value = IDBValue(data[0], blobURLs, sessionID, blobFilePaths);
+    return true;
+}
+
+void WebIDBValue::encodeData(IPC::Encoder& encoder, const Vector<ThreadSafeDataBuffer>& data)
+{
+    Checked<size_t, RecordOverflow> totalSize = 0;
+    for (auto& buffer : data)
+        totalSize += dataSize(buffer);
+
+    RefPtr<SharedMemory> sharedMemory;
+    if (!totalSize.hasOverflowed() && totalSize.unsafeGet() >= sharedMemoryThreshold)
+        sharedMemory = SharedMemory::allocate(totalSize.unsafeGet());
+
+    SharedMemory::Handle handle;
+    if (!sharedMemory || !sharedMemory->createHandle(handle, SharedMemory::Protection::ReadOnly)) {
+        encoder << false;
+        encoder << data;
+        return;
+    }
+
+    // offsets[i] and offsets[i + 1] delimit the bytes of data[i] in the shared memory.
+    Vector<uint64_t> offsets;
+    offsets.reserveInitialCapacity(data.size() + 1);
+    auto* buffer = static_cast<uint8_t*>(sharedMemory->data());
+    uint64_t offset = 0;
+    for (auto& value : data) {
+        offsets.uncheckedAppend(offset);
+        if (auto* vector = value.data()) {
+            memcpy(buffer + offset, vector->data(), vector->size());
+            offset += vector->size();
+        }
+    }
+    offsets.uncheckedAppend(offset);
+
+    encoder << true;
+    encoder << handle;
+    encoder << offsets;
+}
+
+bool WebIDBValue::decodeData(IPC::Decoder& decoder, Vector<ThreadSafeDataBuffer>& data)
+{
+    bool isInSharedMemory;
+    if (!decoder.decode(isInSharedMemory))
+        return false;
+
+    if (!isInSharedMemory)
+        return decoder.decode(data);
+
+    SharedMemory::Handle handle;
+    if (!decoder.decode(handle))
+        return false;
+
+    Vector<uint64_t> offsets;
+    if (!decoder.decode(offsets) || offsets.isEmpty())
+        return false;
+
+    auto sharedMemory = SharedMemory::map(handle, SharedMemory::Protection::ReadOnly);
+    if (!sharedMemory || offsets.last() > sharedMemory->size())
+        return false;
+
+    auto* buffer = static_cast<const uint8_t*>(sharedMemory->data());
+    data.reserveInitialCapacity(offsets.size() - 1);
+    for (size_t i = 0; i + 1 < offsets.size(); ++i) {
+        if (offsets[i] > offsets[i + 1])
+            return false;
+
+        Vector<uint8_t> vector;
+        vector.append(buffer + offsets[i], offsets[i + 1] - offsets[i]);
+        data.uncheckedAppend(ThreadSafeDataBuffer::adoptVector(vector));
+    }
+    return true;
+}
+
+} // namespace WebKit
+
+#endif // ENABLE(INDEXED_DATABASE)
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#if ENABLE(INDEXED_DATABASE)
+
+#include <WebCore/IDBValue.h>
+#include <wtf/Vector.h>
+
+namespace IPC {
+class Decoder;
+class Encoder;
+}
+
+namespace WebCore {
+class ThreadSafeDataBuffer;
+}
+
+namespace WebKit {
+
+// Carries IDBValues between the WebProcess and the DatabaseProcess. Serialized values that add up
+// to sharedMemoryThreshold bytes or more are written once into a SharedMemory region with an offset
+// table, instead of being copied into the message and back out of it.
+class WebIDBValue {
+public:
+    static const size_t sharedMemoryThreshold = 64 * 1024;
+
+    WebIDBValue()
+    {
+    }
+
+    WebIDBValue(const WebCore::IDBValue& value)
+        : m_value(value)
+    {
+    }
+
+    const WebCore::IDBValue& value() const { return m_value; }
+
+    void encode(IPC::Encoder&) const;
+    static bool decode(IPC::Decoder&, WebIDBValue&);
+
+    static void encodeData(IPC::Encoder&, const Vector<WebCore::ThreadSafeDataBuffer>&);
+    static bool decodeData(IPC::Decoder&, Vector<WebCore::ThreadSafeDataBuffer>&);
+
+private:
+    WebCore::IDBValue m_value;
+};
+
+} // namespace WebKit
+
+#endif // ENABLE(INDEXED_DATABASE)
@@ -104,6 +104,7 @@ public:
     void paint(WebCore::GraphicsContext&, float scaleFactor, const WebCore::IntPoint& destination, const WebCore::IntRect& source);
 
     bool isBackedBySharedMemory() const { return m_sharedMemory; }
+    SharedMemory* sharedMemory() const { return m_sharedMemory.get(); }
 
     // This creates a bitmap image that directly references the shared bitmap data.
     // This is only safe to use when we know that the contents of the shareable bitmap won't change.
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "StorageAreaSnapshot.h"
+
+#include <wtf/CheckedArithmetic.h>
+#include <wtf/text/WTFString.h>
+
+namespace WebKit {
+namespace StorageAreaSnapshot {
+
+static const uint32_t is8BitFlag = 1u << 31;
+
+static size_t encodedStringSize(const String& string)
+{
+    return sizeof(uint32_t) + (string.is8Bit() ? string.length() : string.length() * sizeof(UChar));
+}
+
+static uint8_t* encodeString(uint8_t* buffer, const String& string)
+{
+    uint32_t header = string.length();
+    if (string.is8Bit())
+        header |= is8BitFlag;
+    memcpy(buffer, &header, sizeof(header));
+    buffer += sizeof(header);
+
+    if (string.is8Bit()) {
+        memcpy(buffer, string.characters8(), string.length());
+        return buffer + string.length();
+    }
+    memcpy(buffer, string.characters16(), string.length() * sizeof(UChar));
+    return buffer + string.length() * sizeof(UChar);
+}
+
+RefPtr<SharedMemory> encode(const HashMap<String, String>& items, uint64_t& encodedSize)
+{
+    Checked<size_t, RecordOverflow> size = sizeof(uint32_t);
+    for (auto& item : items) {
+        size += encodedStringSize(item.key);
+        size += encodedStringSize(item.value);
+    }
+    if (size.hasOverflowed())
+        return nullptr;
+
+    auto sharedMemory = SharedMemory::allocate(size.unsafeGet());
+    if (!sharedMemory)
+        return nullptr;
+
+    auto* buffer = static_cast<uint8_t*>(sharedMemory->data());
+    uint32_t count = items.size();
+    memcpy(buffer, &count, sizeof(count));
+    buffer += sizeof(count);
+
+    for (auto& item : items) {
+        buffer = encodeString(buffer, item.key);
+        buffer = encodeString(buffer, item.value);
+    }
+    ASSERT(buffer == static_cast<uint8_t*>(sharedMemory->data()) + size.unsafeGet());
+
+    encodedSize = size.unsafeGet();
+    return sharedMemory;
+}
+
+static bool decodeString(const uint8_t*& buffer, const uint8_t* end, String& string)
+{
+    uint32_t header;
+    if (static_cast<size_t>(end - buffer) < sizeof(header))
+        return false;
+    memcpy(&header, buffer, sizeof(header));
+    buffer += sizeof(header);
+
+    bool is8Bit = header & is8BitFlag;
+    size_t length = header & ~is8BitFlag;
+    size_t characterSize = is8Bit ? sizeof(LChar) : sizeof(UChar);
+    if (static_cast<size_t>(end - buffer) / characterSize < length)
+        return false;
+
+    if (is8Bit)
+        string = String(buffer, length);
+    else {
+        UChar* characters;
+        string = String::createUninitialized(length, characters);
+        memcpy(characters, buffer, length * sizeof(UChar));
+    }
+    buffer += length * characterSize;
+    return true;
+}
+
+bool decode(const SharedMemory& sharedMemory, uint64_t encodedSize, HashMap<String, String>& items)
+{
+    if (encodedSize > sharedMemory.size())
+        return false;
+
+    auto* buffer = static_cast<const uint8_t*>(sharedMemory.data());
+    auto* end = buffer + encodedSize;
+
+    uint32_t count;
+    if (encodedSize < sizeof(count))
+        return false;
+    memcpy(&count, buffer, sizeof(count));
+    buffer += sizeof(count);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        String key;
+        String value;
+        if (!decodeString(buffer, end, key) || !decodeString(buffer, end, value))
+            return false;
+        items.set(WTFMove(key), WTFMove(value));
+    }
+    return buffer == end;
+}
+
+} // namespace StorageAreaSnapshot
+} // namespace WebKit
@@ -41,6 +41,7 @@ void UpdateInfo::encode(IPC::Encoder& encoder) const
     encoder << updateScaleFactor;
     encoder << bitmapHandle;
     encoder << bitmapOffset;
+    encoder << bitmapPoolIndex;
 }
 
 bool UpdateInfo::decode(IPC::Decoder& decoder, UpdateInfo& result)
@@ -63,6 +64,8 @@ bool UpdateInfo::decode(IPC::Decoder& decoder, UpdateInfo& result)
         return false;
     if (!decoder.decode(result.bitmapOffset))
         return false;
+    if (!decoder.decode(result.bitmapPoolIndex))
+        return false;
 
     return true;
 }
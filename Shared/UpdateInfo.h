@@ -69,6 +69,11 @@ public:
 
     // The offset in the bitmap where the rendered contents are.
     WebCore::IntPoint bitmapOffset;
+
+    // The index of the buffer in the web process bitmap pool when the bitmap is pooled. The bitmap handle is
+    // only sent the first time a buffer is used, after that the UI process reuses its mapping. The buffer must
+    // be given back with a ReturnUpdateBitmap message.
+    std::optional<uint32_t> bitmapPoolIndex;
 };
 
 } // namespace WebKit
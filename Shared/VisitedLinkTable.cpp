@@ -33,9 +33,6 @@ using namespace WebCore;
 namespace WebKit {
 
 VisitedLinkTable::VisitedLinkTable()
-    : m_tableSize(0)
-    , m_tableSizeMask(0)
-    , m_table(nullptr)
 {
 }
 
@@ -54,16 +51,19 @@ static inline bool isPowerOf2(unsigned v)
 
 void VisitedLinkTable::setSharedMemory(Ref<SharedMemory>&& sharedMemory)
 {
-    m_sharedMemory = WTFMove(sharedMemory);
-    
-    ASSERT(m_sharedMemory);
-    ASSERT(!(m_sharedMemory->size() % sizeof(LinkHash)));
+    m_segments.clear();
+    appendSegment(WTFMove(sharedMemory));
+}
 
-    m_table = static_cast<LinkHash*>(m_sharedMemory->data());
-    m_tableSize = m_sharedMemory->size() / sizeof(LinkHash);
-    ASSERT(isPowerOf2(m_tableSize));
-    
-    m_tableSizeMask = m_tableSize - 1;
+void VisitedLinkTable::appendSegment(Ref<SharedMemory>&& sharedMemory)
+{
+    ASSERT(!(sharedMemory->size() % sizeof(LinkHash)));
+
+    unsigned tableSize = sharedMemory->size() / sizeof(LinkHash);
+    ASSERT(isPowerOf2(tableSize));
+
+    auto* table = static_cast<LinkHash*>(sharedMemory->data());
+    m_segments.append({ WTFMove(sharedMemory), tableSize - 1, table });
 }
 
 static inline unsigned doubleHash(unsigned key)
@@ -78,11 +78,17 @@ static inline unsigned doubleHash(unsigned key)
     
 bool VisitedLinkTable::addLinkHash(LinkHash linkHash)
 {
-    ASSERT(m_sharedMemory);
+    ASSERT(!m_segments.isEmpty());
+
+    // Earlier segments are full, only check them for the link hash.
+    for (unsigned i = 0; i + 1 < m_segments.size(); ++i) {
+        if (segmentContains(m_segments[i], linkHash))
+            return false;
+    }
 
     int k = 0;
-    LinkHash* table = m_table;
-    int sizeMask = m_tableSizeMask;
+    LinkHash* table = m_segments.last().table;
+    int sizeMask = m_segments.last().tableSizeMask;
     unsigned h = static_cast<unsigned>(linkHash);
     int i = h & sizeMask;
   
@@ -107,14 +113,11 @@ bool VisitedLinkTable::addLinkHash(LinkHash linkHash)
     return true;
 }
 
-bool VisitedLinkTable::isLinkVisited(LinkHash linkHash) const
+bool VisitedLinkTable::segmentContains(const Segment& segment, LinkHash linkHash)
 {
-    if (!m_sharedMemory)
-        return false;
-
     int k = 0;
-    LinkHash* table = m_table;
-    int sizeMask = m_tableSizeMask;
+    LinkHash* table = segment.table;
+    int sizeMask = segment.tableSizeMask;
     unsigned h = static_cast<unsigned>(linkHash);
     int i = h & sizeMask;
     
@@ -137,11 +140,19 @@ bool VisitedLinkTable::isLinkVisited(LinkHash linkHash) const
     return false;
 }
 
+bool VisitedLinkTable::isLinkVisited(LinkHash linkHash) const
+{
+    // The last segment is the largest one, look there first.
+    for (unsigned i = m_segments.size(); i--; ) {
+        if (segmentContains(m_segments[i], linkHash))
+            return true;
+    }
+    return false;
+}
+
 void VisitedLinkTable::clear()
 {
-    m_tableSize = 0;
-    m_tableSizeMask = 0;
-    m_sharedMemory = nullptr;
+    m_segments.clear();
 }
 
 } // namespace WebKit
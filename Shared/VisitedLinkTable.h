@@ -28,32 +28,41 @@
 
 #include <WebCore/LinkHash.h>
 #include <wtf/RefPtr.h>
+#include <wtf/Vector.h>
 
 namespace WebKit {
 
 class SharedMemory;
 
+// The table is made of open addressed segments in shared memory. Growing appends a segment
+// so existing segments never move and only the new one needs to be sent to web processes.
 class VisitedLinkTable {
 public:
     VisitedLinkTable();
     ~VisitedLinkTable();
 
+    // Replaces all segments with the given one.
     void setSharedMemory(Ref<SharedMemory>&&);
+    void appendSegment(Ref<SharedMemory>&&);
 
-    // This should only be called from the UI process.
+    // This should only be called from the UI process. New link hashes go to the last segment.
     bool addLinkHash(WebCore::LinkHash);
 
     bool isLinkVisited(WebCore::LinkHash) const;
 
-    SharedMemory* sharedMemory() const { return m_sharedMemory.get(); }
+    unsigned segmentCount() const { return m_segments.size(); }
+    SharedMemory& segmentSharedMemory(unsigned index) const { return *m_segments[index].sharedMemory; }
     void clear();
 
 private:
-    RefPtr<SharedMemory> m_sharedMemory;
+    struct Segment {
+        RefPtr<SharedMemory> sharedMemory;
+        unsigned tableSizeMask;
+        WebCore::LinkHash* table;
+    };
+    static bool segmentContains(const Segment&, WebCore::LinkHash);
 
-    unsigned m_tableSize;
-    unsigned m_tableSizeMask;
-    WebCore::LinkHash* m_table;
+    Vector<Segment, 4> m_segments;
 };
 
 }
@@ -281,6 +281,13 @@ template<> struct ArgumentCoder<WebCore::IntSize> {
     static bool decode(Decoder&, WebCore::IntSize&);
 };
 
+template<> struct IsTriviallyEncodable<WebCore::FloatPoint> : std::true_type { };
+template<> struct IsTriviallyEncodable<WebCore::FloatRect> : std::true_type { };
+template<> struct IsTriviallyEncodable<WebCore::FloatSize> : std::true_type { };
+template<> struct IsTriviallyEncodable<WebCore::IntPoint> : std::true_type { };
+template<> struct IsTriviallyEncodable<WebCore::IntRect> : std::true_type { };
+template<> struct IsTriviallyEncodable<WebCore::IntSize> : std::true_type { };
+
 template<> struct ArgumentCoder<WebCore::LayoutSize> {
     static void encode(Encoder&, const WebCore::LayoutSize&);
     static bool decode(Decoder&, WebCore::LayoutSize&);
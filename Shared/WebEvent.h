@@ -220,6 +220,10 @@ public:
     const WebCore::FloatSize& unacceleratedScrollingDelta() const { return m_unacceleratedScrollingDelta; }
 #endif
 
+    // Events can be coalesced when they only differ by their deltas, so that phase changes are never merged away.
+    bool canCoalesceWith(const WebWheelEvent&) const;
+    WebWheelEvent coalescedWith(const WebWheelEvent&) const;
+
     void encode(IPC::Encoder&) const;
     static bool decode(IPC::Decoder&, WebWheelEvent&);
 
@@ -41,6 +41,27 @@ FOR_EACH_WEBKIT_EXPERIMENTAL_FEATURE_PREFERENCE(DECLARE_KEY_GETTERS)
 #undef DECLARE_KEY_GETTERS
 
 } // namespace WebPreferencesKey
+
+// Dense index of every preference, in the order of the definitions, used to store preference values in arrays.
+enum class WebPreferencesKeyIndex : uint16_t {
+#define DEFINE_KEY_INDEX(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) KeyUpper,
+
+    FOR_EACH_WEBKIT_PREFERENCE(DEFINE_KEY_INDEX)
+    FOR_EACH_WEBKIT_DEBUG_PREFERENCE(DEFINE_KEY_INDEX)
+    FOR_EACH_WEBKIT_EXPERIMENTAL_FEATURE_PREFERENCE(DEFINE_KEY_INDEX)
+
+#undef DEFINE_KEY_INDEX
+};
+
+#define COUNT_KEY(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) + 1
+
+static const size_t webPreferencesKeyCount = 0
+    FOR_EACH_WEBKIT_PREFERENCE(COUNT_KEY)
+    FOR_EACH_WEBKIT_DEBUG_PREFERENCE(COUNT_KEY)
+    FOR_EACH_WEBKIT_EXPERIMENTAL_FEATURE_PREFERENCE(COUNT_KEY);
+
+#undef COUNT_KEY
+
 } // namespace WebKit
 
 #endif // WebPreferencesKeys_h
@@ -38,7 +38,7 @@ using namespace WebCore;
 
 namespace WebKit {
 
-typedef HashMap<String, bool> BoolOverridesMap;
+typedef HashMap<unsigned, bool, WTF::IntHash<unsigned>, WTF::UnsignedWithZeroKeyHashTraits<unsigned>> BoolOverridesMap;
 
 static BoolOverridesMap& boolTestRunnerOverridesMap()
 {
@@ -46,6 +46,28 @@ static BoolOverridesMap& boolTestRunnerOverridesMap()
     return map;
 }
 
+// Test runner overrides of keys that have no definition, which only the String-keyed getter can see.
+static HashMap<String, bool>& boolTestRunnerOverridesForUndefinedKeysMap()
+{
+    static NeverDestroyed<HashMap<String, bool>> map;
+    return map;
+}
+
+static const HashMap<String, unsigned>& keyIndexes()
+{
+    static NeverDestroyed<HashMap<String, unsigned>> keyIndexes([] {
+        HashMap<String, unsigned> indexes;
+#define DEFINE_KEY_INDEX(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) indexes.add(WebPreferencesKey::KeyLower##Key(), static_cast<unsigned>(WebPreferencesKeyIndex::KeyUpper));
+        FOR_EACH_WEBKIT_PREFERENCE(DEFINE_KEY_INDEX)
+        FOR_EACH_WEBKIT_DEBUG_PREFERENCE(DEFINE_KEY_INDEX)
+        FOR_EACH_WEBKIT_EXPERIMENTAL_FEATURE_PREFERENCE(DEFINE_KEY_INDEX)
+#undef DEFINE_KEY_INDEX
+        return indexes;
+    }());
+
+    return keyIndexes;
+}
+
 void WebPreferencesStore::Value::encode(IPC::Encoder& encoder) const
 {
     encoder.encodeEnum(m_type);
@@ -116,29 +138,140 @@ WebPreferencesStore::WebPreferencesStore()
 {
 }
 
+void WebPreferencesStore::encodeValues(IPC::Encoder& encoder, const ValueArray& values)
+{
+    uint32_t count = 0;
+    for (auto& value : values) {
+        if (value.type() != Value::Type::None)
+            ++count;
+    }
+
+    encoder << count;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (values[i].type() == Value::Type::None)
+            continue;
+        encoder << static_cast<uint16_t>(i);
+        encoder << values[i];
+    }
+}
+
+bool WebPreferencesStore::decodeValues(IPC::Decoder& decoder, ValueArray& values)
+{
+    uint32_t count;
+    if (!decoder.decode(count))
+        return false;
+    if (count > webPreferencesKeyCount)
+        return false;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint16_t index;
+        if (!decoder.decode(index))
+            return false;
+        if (index >= webPreferencesKeyCount)
+            return false;
+        if (!decoder.decode(values[index]))
+            return false;
+    }
+    return true;
+}
+
 void WebPreferencesStore::encode(IPC::Encoder& encoder) const
 {
-    encoder << m_values;
-    encoder << m_overridenDefaults;
+    encodeValues(encoder, m_values);
+    encodeValues(encoder, m_overridenDefaults);
 }
 
 bool WebPreferencesStore::decode(IPC::Decoder& decoder, WebPreferencesStore& result)
 {
-    if (!decoder.decode(result.m_values))
+    if (!decodeValues(decoder, result.m_values))
+        return false;
+    if (!decodeValues(decoder, result.m_overridenDefaults))
+        return false;
+    return true;
+}
+
+void WebPreferencesStore::Changes::encode(IPC::Encoder& encoder) const
+{
+    encoder << static_cast<uint32_t>(entries.size());
+    for (auto& entry : entries) {
+        encoder << static_cast<uint16_t>(entry.key);
+        encoder << entry.value;
+        encoder << entry.overridenDefault;
+    }
+}
+
+bool WebPreferencesStore::Changes::decode(IPC::Decoder& decoder, Changes& result)
+{
+    uint32_t size;
+    if (!decoder.decode(size))
         return false;
-    if (!decoder.decode(result.m_overridenDefaults))
+    if (size > webPreferencesKeyCount)
         return false;
+
+    result.entries.reserveInitialCapacity(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint16_t key;
+        if (!decoder.decode(key))
+            return false;
+        if (key >= webPreferencesKeyCount)
+            return false;
+
+        Entry entry { static_cast<WebPreferencesKeyIndex>(key), Value(), Value() };
+        if (!decoder.decode(entry.value))
+            return false;
+        if (!decoder.decode(entry.overridenDefault))
+            return false;
+        result.entries.uncheckedAppend(WTFMove(entry));
+    }
     return true;
 }
 
+WebPreferencesStore::Changes WebPreferencesStore::takeChanges()
+{
+    Changes changes;
+    if (m_changedKeys.none())
+        return changes;
+
+    changes.entries.reserveInitialCapacity(m_changedKeys.count());
+    for (size_t i = 0; i < webPreferencesKeyCount; ++i) {
+        if (m_changedKeys[i])
+            changes.entries.uncheckedAppend({ static_cast<WebPreferencesKeyIndex>(i), m_values[i], m_overridenDefaults[i] });
+    }
+    m_changedKeys.reset();
+    return changes;
+}
+
+void WebPreferencesStore::applyChanges(const Changes& changes)
+{
+    for (auto& entry : changes.entries) {
+        size_t index = static_cast<size_t>(entry.key);
+        m_values[index] = entry.value;
+        m_overridenDefaults[index] = entry.overridenDefault;
+        m_changedKeys.set(index);
+    }
+}
+
+std::optional<WebPreferencesKeyIndex> WebPreferencesStore::indexForKey(const String& key)
+{
+    auto& indexes = keyIndexes();
+    auto it = indexes.find(key);
+    if (it == indexes.end())
+        return std::nullopt;
+    return static_cast<WebPreferencesKeyIndex>(it->value);
+}
+
 void WebPreferencesStore::overrideBoolValueForKey(const String& key, bool value)
 {
-    boolTestRunnerOverridesMap().set(key, value);
+    if (auto index = indexForKey(key))
+        boolTestRunnerOverridesMap().set(static_cast<unsigned>(*index), value);
+    else
+        boolTestRunnerOverridesForUndefinedKeysMap().set(key, value);
 }
 
 void WebPreferencesStore::removeTestRunnerOverrides()
 {
     boolTestRunnerOverridesMap().clear();
+    boolTestRunnerOverridesForUndefinedKeysMap().clear();
 }
 
 template <typename T> struct ToType { };
@@ -157,115 +290,194 @@ template<> uint32_t as<uint32_t>(const WebPreferencesStore::Value& value) { retu
 template<> double as<double>(const WebPreferencesStore::Value& value) { return value.asDouble(); }
 
 
-static WebPreferencesStore::ValueMap& defaults()
+static const std::array<WebPreferencesStore::Value, webPreferencesKeyCount>& defaults()
 {
-    static NeverDestroyed<WebPreferencesStore::ValueMap> defaults;
-    if (defaults.get().isEmpty()) {
-#define DEFINE_DEFAULTS(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) defaults.get().set(WebPreferencesKey::KeyLower##Key(), WebPreferencesStore::Value((Type)DefaultValue));
+    static NeverDestroyed<std::array<WebPreferencesStore::Value, webPreferencesKeyCount>> defaults([] {
+        std::array<WebPreferencesStore::Value, webPreferencesKeyCount> values;
+#define DEFINE_DEFAULTS(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) values[static_cast<size_t>(WebPreferencesKeyIndex::KeyUpper)] = WebPreferencesStore::Value((Type)DefaultValue);
         FOR_EACH_WEBKIT_PREFERENCE(DEFINE_DEFAULTS)
         FOR_EACH_WEBKIT_DEBUG_PREFERENCE(DEFINE_DEFAULTS)
         FOR_EACH_WEBKIT_EXPERIMENTAL_FEATURE_PREFERENCE(DEFINE_DEFAULTS)
 #undef DEFINE_DEFAULTS
-    }
+        return values;
+    }());
 
     return defaults;
 }
 
 template<typename MappedType>
-static MappedType valueForKey(const WebPreferencesStore::ValueMap& values, const WebPreferencesStore::ValueMap& overridenDefaults, const String& key)
+MappedType WebPreferencesStore::valueForKey(WebPreferencesKeyIndex key) const
 {
-    auto valuesIt = values.find(key);
-    if (valuesIt != values.end() && valuesIt->value.type() == ToType<MappedType>::value)
-        return as<MappedType>(valuesIt->value);
+    size_t index = static_cast<size_t>(key);
+
+    auto& value = m_values[index];
+    if (value.type() == ToType<MappedType>::value)
+        return as<MappedType>(value);
 
-    auto overridenDefaultsIt = overridenDefaults.find(key);
-    if (overridenDefaultsIt != overridenDefaults.end() && overridenDefaultsIt->value.type() == ToType<MappedType>::value)
-        return as<MappedType>(overridenDefaultsIt->value);
+    auto& overridenDefault = m_overridenDefaults[index];
+    if (overridenDefault.type() == ToType<MappedType>::value)
+        return as<MappedType>(overridenDefault);
 
-    auto& defaultsMap = defaults();
-    auto defaultsIt = defaultsMap.find(key);
-    if (defaultsIt != defaultsMap.end() && defaultsIt->value.type() == ToType<MappedType>::value)
-        return as<MappedType>(defaultsIt->value);
+    auto& defaultValue = defaults()[index];
+    if (defaultValue.type() == ToType<MappedType>::value)
+        return as<MappedType>(defaultValue);
 
     return MappedType();
 }
 
 template<typename MappedType>
-static bool setValueForKey(WebPreferencesStore::ValueMap& map, const WebPreferencesStore::ValueMap& overridenDefaults, const String& key, const MappedType& value)
+bool WebPreferencesStore::setValueForKey(WebPreferencesKeyIndex key, const MappedType& value)
 {
-    MappedType existingValue = valueForKey<MappedType>(map, overridenDefaults, key);
+    MappedType existingValue = valueForKey<MappedType>(key);
     if (existingValue == value)
         return false;
 
-    map.set(key, WebPreferencesStore::Value(value));
+    size_t index = static_cast<size_t>(key);
+    m_values[index] = Value(value);
+    m_changedKeys.set(index);
     return true;
 }
 
+void WebPreferencesStore::setValueForKey(const String& key, const Value& value)
+{
+    auto index = indexForKey(key);
+    if (!index)
+        return;
+
+    m_values[static_cast<size_t>(*index)] = value;
+    m_changedKeys.set(static_cast<size_t>(*index));
+}
+
+bool WebPreferencesStore::setStringValueForKey(WebPreferencesKeyIndex key, const String& value)
+{
+    return setValueForKey<String>(key, value);
+}
+
+String WebPreferencesStore::getStringValueForKey(WebPreferencesKeyIndex key) const
+{
+    return valueForKey<String>(key);
+}
+
+bool WebPreferencesStore::setBoolValueForKey(WebPreferencesKeyIndex key, bool value)
+{
+    return setValueForKey<bool>(key, value);
+}
+
+bool WebPreferencesStore::getBoolValueForKey(WebPreferencesKeyIndex key) const
+{
+    // FIXME: Extend overriding to other key types used from TestRunner.
+    auto& overrides = boolTestRunnerOverridesMap();
+    if (!overrides.isEmpty()) {
+        auto it = overrides.find(static_cast<unsigned>(key));
+        if (it != overrides.end())
+            return it->value;
+    }
+
+    return valueForKey<bool>(key);
+}
+
+bool WebPreferencesStore::setUInt32ValueForKey(WebPreferencesKeyIndex key, uint32_t value)
+{
+    return setValueForKey<uint32_t>(key, value);
+}
+
+uint32_t WebPreferencesStore::getUInt32ValueForKey(WebPreferencesKeyIndex key) const
+{
+    return valueForKey<uint32_t>(key);
+}
+
+bool WebPreferencesStore::setDoubleValueForKey(WebPreferencesKeyIndex key, double value)
+{
+    return setValueForKey<double>(key, value);
+}
+
+double WebPreferencesStore::getDoubleValueForKey(WebPreferencesKeyIndex key) const
+{
+    return valueForKey<double>(key);
+}
+
 bool WebPreferencesStore::setStringValueForKey(const String& key, const String& value)
 {
-    return setValueForKey<String>(m_values, m_overridenDefaults, key, value);
+    auto index = indexForKey(key);
+    return index && setStringValueForKey(*index, value);
 }
 
 String WebPreferencesStore::getStringValueForKey(const String& key) const
 {
-    return valueForKey<String>(m_values, m_overridenDefaults, key);
+    auto index = indexForKey(key);
+    return index ? getStringValueForKey(*index) : String();
 }
 
 bool WebPreferencesStore::setBoolValueForKey(const String& key, bool value)
 {
-    return setValueForKey<bool>(m_values, m_overridenDefaults, key, value);
+    auto index = indexForKey(key);
+    return index && setBoolValueForKey(*index, value);
 }
 
 bool WebPreferencesStore::getBoolValueForKey(const String& key) const
 {
-    // FIXME: Extend overriding to other key types used from TestRunner.
-    auto it = boolTestRunnerOverridesMap().find(key);
-    if (it != boolTestRunnerOverridesMap().end())
-        return it->value;
+    if (auto index = indexForKey(key))
+        return getBoolValueForKey(*index);
 
-    return valueForKey<bool>(m_values, m_overridenDefaults, key);
+    auto& overrides = boolTestRunnerOverridesForUndefinedKeysMap();
+    auto it = overrides.find(key);
+    return it != overrides.end() && it->value;
 }
 
-bool WebPreferencesStore::setUInt32ValueForKey(const String& key, uint32_t value) 
+bool WebPreferencesStore::setUInt32ValueForKey(const String& key, uint32_t value)
 {
-    return setValueForKey<uint32_t>(m_values, m_overridenDefaults, key, value);
+    auto index = indexForKey(key);
+    return index && setUInt32ValueForKey(*index, value);
 }
 
 uint32_t WebPreferencesStore::getUInt32ValueForKey(const String& key) const
 {
-    return valueForKey<uint32_t>(m_values, m_overridenDefaults, key);
+    auto index = indexForKey(key);
+    return index ? getUInt32ValueForKey(*index) : 0;
 }
 
-bool WebPreferencesStore::setDoubleValueForKey(const String& key, double value) 
+bool WebPreferencesStore::setDoubleValueForKey(const String& key, double value)
 {
-    return setValueForKey<double>(m_values, m_overridenDefaults, key, value);
+    auto index = indexForKey(key);
+    return index && setDoubleValueForKey(*index, value);
 }
 
 double WebPreferencesStore::getDoubleValueForKey(const String& key) const
 {
-    return valueForKey<double>(m_values, m_overridenDefaults, key);
+    auto index = indexForKey(key);
+    return index ? getDoubleValueForKey(*index) : 0;
 }
 
 // Overriden Defaults
 
+void WebPreferencesStore::setOverrideDefaultsValueForKey(const String& key, Value&& value)
+{
+    auto index = indexForKey(key);
+    if (!index)
+        return;
+
+    m_overridenDefaults[static_cast<size_t>(*index)] = WTFMove(value);
+    m_changedKeys.set(static_cast<size_t>(*index));
+}
+
 void WebPreferencesStore::setOverrideDefaultsStringValueForKey(const String& key, String value)
 {
-    m_overridenDefaults.set(key, Value(value));
+    setOverrideDefaultsValueForKey(key, Value(value));
 }
 
 void WebPreferencesStore::setOverrideDefaultsBoolValueForKey(const String& key, bool value)
 {
-    m_overridenDefaults.set(key, Value(value));
+    setOverrideDefaultsValueForKey(key, Value(value));
 }
 
 void WebPreferencesStore::setOverrideDefaultsUInt32ValueForKey(const String& key, uint32_t value)
 {
-    m_overridenDefaults.set(key, Value(value));
+    setOverrideDefaultsValueForKey(key, Value(value));
 }
 
 void WebPreferencesStore::setOverrideDefaultsDoubleValueForKey(const String& key, double value)
 {
-    m_overridenDefaults.set(key, Value(value));
+    setOverrideDefaultsValueForKey(key, Value(value));
 }
 
 } // namespace WebKit
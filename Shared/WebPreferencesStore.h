@@ -27,6 +27,9 @@
 
 #include "Decoder.h"
 #include "Encoder.h"
+#include "WebPreferencesKeys.h"
+#include <array>
+#include <bitset>
 #include <wtf/HashMap.h>
 #include <wtf/text/StringHash.h>
 #include <wtf/text/WTFString.h>
@@ -53,6 +56,21 @@ struct WebPreferencesStore {
     bool setDoubleValueForKey(const String& key, double value);
     double getDoubleValueForKey(const String& key) const;
 
+    // Same as above, without looking up the key by name.
+    bool setStringValueForKey(WebPreferencesKeyIndex, const String& value);
+    String getStringValueForKey(WebPreferencesKeyIndex) const;
+
+    bool setBoolValueForKey(WebPreferencesKeyIndex, bool value);
+    bool getBoolValueForKey(WebPreferencesKeyIndex) const;
+
+    bool setUInt32ValueForKey(WebPreferencesKeyIndex, uint32_t value);
+    uint32_t getUInt32ValueForKey(WebPreferencesKeyIndex) const;
+
+    bool setDoubleValueForKey(WebPreferencesKeyIndex, double value);
+    double getDoubleValueForKey(WebPreferencesKeyIndex) const;
+
+    static std::optional<WebPreferencesKeyIndex> indexForKey(const String& key);
+
     void setOverrideDefaultsStringValueForKey(const String& key, String value);
     void setOverrideDefaultsBoolValueForKey(const String& key, bool value);
     void setOverrideDefaultsUInt32ValueForKey(const String& key, uint32_t value);
@@ -75,6 +93,11 @@ struct WebPreferencesStore {
         static bool decode(IPC::Decoder&, Value&);
 
         explicit Value() : m_type(Type::None) { }
+        Value(const Value& value)
+            : m_type(Type::None)
+        {
+            *this = value;
+        }
         explicit Value(const String& value) : m_type(Type::String), m_string(value) { }
         explicit Value(bool value) : m_type(Type::Bool), m_bool(value) { }
         explicit Value(uint32_t value) : m_type(Type::UInt32), m_uint32(value) { }
@@ -177,8 +200,45 @@ struct WebPreferencesStore {
     };
 
     typedef HashMap<String, Value> ValueMap;
-    ValueMap m_values;
-    ValueMap m_overridenDefaults;
+
+    // For values coming from a ValueMap, like the preference values of a page configuration.
+    void setValueForKey(const String& key, const Value&);
+
+    // Keys whose value or overriden default changed since the changes were last taken or cleared.
+    bool hasChanged(WebPreferencesKeyIndex key) const { return m_changedKeys[static_cast<size_t>(key)]; }
+    void markAllKeysChanged() { m_changedKeys.set(); }
+    void clearChangedKeys() { m_changedKeys.reset(); }
+
+    // The state of the changed keys, so that copies of the store can be updated without sending all of it.
+    struct Changes {
+        struct Entry {
+            WebPreferencesKeyIndex key;
+            Value value;
+            Value overridenDefault;
+        };
+
+        void encode(IPC::Encoder&) const;
+        static bool decode(IPC::Decoder&, Changes&);
+
+        Vector<Entry> entries;
+    };
+
+    Changes takeChanges();
+    void applyChanges(const Changes&);
+
+private:
+    typedef std::array<Value, webPreferencesKeyCount> ValueArray;
+
+    template<typename MappedType> MappedType valueForKey(WebPreferencesKeyIndex) const;
+    template<typename MappedType> bool setValueForKey(WebPreferencesKeyIndex, const MappedType&);
+    void setOverrideDefaultsValueForKey(const String& key, Value&&);
+
+    static void encodeValues(IPC::Encoder&, const ValueArray&);
+    static bool decodeValues(IPC::Decoder&, ValueArray&);
+
+    ValueArray m_values;
+    ValueArray m_overridenDefaults;
+    std::bitset<webPreferencesKeyCount> m_changedKeys;
 };
 
 } // namespace WebKit
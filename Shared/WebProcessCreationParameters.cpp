@@ -99,6 +99,7 @@ void WebProcessCreationParameters::encode(IPC::Encoder& encoder) const
     encoder << uiProcessBundleIdentifier;
 #endif
     encoder << presentingApplicationPID;
+    encoder << usesPackedIPCEncoding;
 #if PLATFORM(COCOA)
     encoder << accessibilityEnhancedUserInterfaceEnabled;
     encoder << acceleratedCompositingPort;
@@ -250,6 +251,8 @@ bool WebProcessCreationParameters::decode(IPC::Decoder& decoder, WebProcessCreat
 #endif
     if (!decoder.decode(parameters.presentingApplicationPID))
         return false;
+    if (!decoder.decode(parameters.usesPackedIPCEncoding))
+        return false;
 #if PLATFORM(COCOA)
     if (!decoder.decode(parameters.accessibilityEnhancedUserInterfaceEnabled))
         return false;
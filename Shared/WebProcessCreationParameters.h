@@ -136,6 +136,7 @@ struct WebProcessCreationParameters {
 #endif
 
     pid_t presentingApplicationPID { 0 };
+    bool usesPackedIPCEncoding { false };
 
 #if PLATFORM(COCOA)
     WebCore::MachSendRight acceleratedCompositingPort;
@@ -82,6 +82,48 @@ WebWheelEvent::WebWheelEvent(Type type, const IntPoint& position, const IntPoint
 }
 #endif
 
+bool WebWheelEvent::canCoalesceWith(const WebWheelEvent& other) const
+{
+    if (m_position != other.m_position)
+        return false;
+    if (m_globalPosition != other.m_globalPosition)
+        return false;
+    if (modifiers() != other.modifiers())
+        return false;
+    if (m_granularity != other.m_granularity)
+        return false;
+#if PLATFORM(COCOA) || PLATFORM(GTK)
+    if (m_phase != other.m_phase)
+        return false;
+    if (m_momentumPhase != other.m_momentumPhase)
+        return false;
+#endif
+#if PLATFORM(COCOA)
+    if (m_hasPreciseScrollingDeltas != other.m_hasPreciseScrollingDeltas)
+        return false;
+#endif
+
+    return true;
+}
+
+WebWheelEvent WebWheelEvent::coalescedWith(const WebWheelEvent& other) const
+{
+    ASSERT(canCoalesceWith(other));
+
+    FloatSize mergedDelta = m_delta + other.m_delta;
+    FloatSize mergedWheelTicks = m_wheelTicks + other.m_wheelTicks;
+
+#if PLATFORM(COCOA)
+    FloatSize mergedUnacceleratedScrollingDelta = m_unacceleratedScrollingDelta + other.m_unacceleratedScrollingDelta;
+
+    return WebWheelEvent(Wheel, other.position(), other.globalPosition(), mergedDelta, mergedWheelTicks, other.granularity(), other.directionInvertedFromDevice(), other.phase(), other.momentumPhase(), other.hasPreciseScrollingDeltas(), other.scrollCount(), mergedUnacceleratedScrollingDelta, other.modifiers(), other.timestamp());
+#elif PLATFORM(GTK)
+    return WebWheelEvent(Wheel, other.position(), other.globalPosition(), mergedDelta, mergedWheelTicks, other.phase(), other.momentumPhase(), other.granularity(), other.modifiers(), other.timestamp());
+#else
+    return WebWheelEvent(Wheel, other.position(), other.globalPosition(), mergedDelta, mergedWheelTicks, other.granularity(), other.modifiers(), other.timestamp());
+#endif
+}
+
 void WebWheelEvent::encode(IPC::Encoder& encoder) const
 {
     WebEvent::encode(encoder);
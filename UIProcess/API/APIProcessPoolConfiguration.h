@@ -28,6 +28,7 @@
 
 #include "APIObject.h"
 #include "CacheModel.h"
+#include "DiskCacheEvictionPolicy.h"
 #include "WebsiteDataStore.h"
 #include <wtf/ProcessID.h>
 #include <wtf/Ref.h>
@@ -57,6 +58,12 @@ public:
     bool diskCacheSpeculativeValidationEnabled() const { return m_diskCacheSpeculativeValidationEnabled; }
     void setDiskCacheSpeculativeValidationEnabled(bool enabled) { m_diskCacheSpeculativeValidationEnabled = enabled; }
 
+    bool diskCachePackedStorageEnabled() const { return m_diskCachePackedStorageEnabled; }
+    void setDiskCachePackedStorageEnabled(bool enabled) { m_diskCachePackedStorageEnabled = enabled; }
+
+    WebKit::DiskCacheEvictionPolicy diskCacheEvictionPolicy() const { return m_diskCacheEvictionPolicy; }
+    void setDiskCacheEvictionPolicy(WebKit::DiskCacheEvictionPolicy policy) { m_diskCacheEvictionPolicy = policy; }
+
     WebKit::CacheModel cacheModel() const { return m_cacheModel; }
     void setCacheModel(WebKit::CacheModel cacheModel) { m_cacheModel = cacheModel; }
 
@@ -139,11 +146,16 @@ public:
     pid_t presentingApplicationPID() const { return m_presentingApplicationPID; }
     void setPresentingApplicationPID(pid_t pid) { m_presentingApplicationPID = pid; }
 
+    bool usesPackedIPCEncoding() const { return m_usesPackedIPCEncoding; }
+    void setUsesPackedIPCEncoding(bool usesPackedIPCEncoding) { m_usesPackedIPCEncoding = usesPackedIPCEncoding; }
+
 private:
     bool m_shouldHaveLegacyDataStore { false };
 
     unsigned m_maximumProcessCount { 0 };
     bool m_diskCacheSpeculativeValidationEnabled { false };
+    bool m_diskCachePackedStorageEnabled { false };
+    WebKit::DiskCacheEvictionPolicy m_diskCacheEvictionPolicy { WebKit::DiskCacheEvictionPolicy::Random };
     WebKit::CacheModel m_cacheModel { WebKit::CacheModelPrimaryWebBrowser };
     int64_t m_diskCacheSizeOverride { -1 };
 
@@ -171,6 +183,7 @@ private:
     bool m_shouldTakeUIBackgroundAssertion { true };
     bool m_shouldCaptureAudioInUIProcess { false };
     pid_t m_presentingApplicationPID { getCurrentProcessID() };
+    bool m_usesPackedIPCEncoding { false };
 #if PLATFORM(IOS)
     WTF::String m_ctDataConnectionServiceType;
 #endif
@@ -28,13 +28,17 @@
 
 #include "APIArray.h"
 #include "APIClient.h"
+#include "APIDictionary.h"
 #include "APIDownloadClient.h"
 #include "APILegacyContextHistoryClient.h"
 #include "APINavigationData.h"
+#include "APINumber.h"
 #include "APIProcessPoolConfiguration.h"
+#include "APIString.h"
 #include "APIURLRequest.h"
 #include "AuthenticationChallengeProxy.h"
 #include "DownloadProxy.h"
+#include "MessageStatistics.h"
 #include "WKAPICast.h"
 #include "WKContextConfigurationRef.h"
 #include "WKRetainPtr.h"
@@ -594,3 +598,40 @@ pid_t WKContextGetDatabaseProcessIdentifier(WKContextRef contextRef)
 {
     return toImpl(contextRef)->databaseProcessIdentifier();
 }
+
+void WKContextSetIPCStatisticsEnabled(WKContextRef, bool enabled)
+{
+    IPC::MessageStatistics::setEnabled(enabled);
+}
+
+void WKContextResetIPCStatistics(WKContextRef)
+{
+    IPC::MessageStatistics::reset();
+}
+
+void WKContextDumpIPCStatistics(WKContextRef)
+{
+    IPC::MessageStatistics::dump();
+}
+
+WKArrayRef WKContextCopyIPCStatistics(WKContextRef)
+{
+    auto entries = IPC::MessageStatistics::snapshot();
+
+    Vector<RefPtr<API::Object>> statistics;
+    statistics.reserveInitialCapacity(entries.size());
+    for (auto& entry : entries) {
+        API::Dictionary::MapType map;
+        map.set(ASCIILiteral("MessageReceiverName"), API::String::create(entry.messageReceiverName));
+        map.set(ASCIILiteral("MessageName"), API::String::create(entry.messageName));
+        map.set(ASCIILiteral("Count"), API::UInt64::create(entry.count));
+        map.set(ASCIILiteral("Bytes"), API::UInt64::create(entry.bytes));
+        map.set(ASCIILiteral("QueueingDelay"), API::Double::create(entry.queueingDelay.seconds()));
+        map.set(ASCIILiteral("DispatchTime"), API::Double::create(entry.dispatchTime.seconds()));
+        map.set(ASCIILiteral("SyncSendCount"), API::UInt64::create(entry.syncSendCount));
+        map.set(ASCIILiteral("SyncWaitTime"), API::Double::create(entry.syncWaitTime.seconds()));
+        statistics.uncheckedAppend(API::Dictionary::create(WTFMove(map)));
+    }
+
+    return toAPI(&API::Array::create(WTFMove(statistics)).leakRef());
+}
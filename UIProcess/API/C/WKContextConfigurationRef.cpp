@@ -157,3 +157,13 @@ void WKContextConfigurationSetShouldCaptureAudioInUIProcess(WKContextConfigurati
 {
     toImpl(configuration)->setShouldCaptureAudioInUIProcess(should);
 }
+
+bool WKContextConfigurationUsesPackedIPCEncoding(WKContextConfigurationRef configuration)
+{
+    return toImpl(configuration)->usesPackedIPCEncoding();
+}
+
+void WKContextConfigurationSetUsesPackedIPCEncoding(WKContextConfigurationRef configuration, bool usesPackedIPCEncoding)
+{
+    toImpl(configuration)->setUsesPackedIPCEncoding(usesPackedIPCEncoding);
+}
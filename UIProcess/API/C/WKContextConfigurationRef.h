@@ -68,6 +68,9 @@ WK_EXPORT void WKContextConfigurationSetOverrideLanguages(WKContextConfiguration
 WK_EXPORT bool WKContextConfigurationShouldCaptureAudioInUIProcess(WKContextConfigurationRef configuration);
 WK_EXPORT void WKContextConfigurationSetShouldCaptureAudioInUIProcess(WKContextConfigurationRef configuration, bool allowed);
 
+WK_EXPORT bool WKContextConfigurationUsesPackedIPCEncoding(WKContextConfigurationRef configuration);
+WK_EXPORT void WKContextConfigurationSetUsesPackedIPCEncoding(WKContextConfigurationRef configuration, bool usesPackedIPCEncoding);
+
 #ifdef __cplusplus
 }
 #endif
@@ -103,6 +103,16 @@ WK_EXPORT void WKContextSetFontWhitelist(WKContextRef, WKArrayRef);
 WK_EXPORT pid_t WKContextGetNetworkProcessIdentifier(WKContextRef context);
 WK_EXPORT pid_t WKContextGetDatabaseProcessIdentifier(WKContextRef context);
 
+// Statistics about the IPC messages dispatched and sync messages sent by the UI process. Setting the
+// WEBKIT_IPC_STATISTICS environment variable enables them at launch and makes SIGUSR2 log them.
+WK_EXPORT void WKContextSetIPCStatisticsEnabled(WKContextRef context, bool enabled);
+WK_EXPORT void WKContextResetIPCStatistics(WKContextRef context);
+WK_EXPORT void WKContextDumpIPCStatistics(WKContextRef context);
+// Returns an array with a dictionary per message, with the keys "MessageReceiverName" and "MessageName"
+// (WKString), "Count", "Bytes" and "SyncSendCount" (WKUInt64), and "QueueingDelay", "DispatchTime"
+// and "SyncWaitTime" (WKDouble, total seconds).
+WK_EXPORT WKArrayRef WKContextCopyIPCStatistics(WKContextRef context);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2397,6 +2397,13 @@ void WKPageIsWebProcessResponsive(WKPageRef pageRef, void* context, WKPageIsWebP
     });
 }
 
+void WKPageTakeTiledSnapshot(WKPageRef pageRef, WKRect snapshotRect, uint32_t tileHeight, WKSnapshotOptions options, void* context, WKPageTakeTiledSnapshotFunction callback)
+{
+    toImpl(pageRef)->takeTiledSnapshot(toIntRect(snapshotRect), tileHeight, toSnapshotOptions(options), [context, callback](API::Data* data, const WebCore::IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, WebKit::CallbackBase::Error error) {
+        callback(toAPI(data), toAPI(tileRect), tileIndex, tileCount, error != WebKit::CallbackBase::Error::None ? toAPI(API::Error::create().ptr()) : 0, context);
+    });
+}
+
 void WKPageGetSelectionAsWebArchiveData(WKPageRef pageRef, void* context, WKPageGetSelectionAsWebArchiveDataFunction callback)
 {
     toImpl(pageRef)->getSelectionAsWebArchiveData(toGenericCallbackFunction(context, callback));
@@ -27,6 +27,7 @@
 #define WKPagePrivate_h
 
 #include <WebKit/WKBase.h>
+#include <WebKit/WKImage.h>
 #include <WebKit/WKPage.h>
 
 #include <unistd.h>
@@ -100,6 +101,13 @@ WK_EXPORT void WKPageGetSamplingProfilerOutput(WKPageRef page, void* context, WK
 
 typedef void (*WKPageIsWebProcessResponsiveFunction)(bool isWebProcessResponsive, void* context);
 WK_EXPORT void WKPageIsWebProcessResponsive(WKPageRef page, void* context, WKPageIsWebProcessResponsiveFunction function);
+
+// The function is called with the PNG data of each tile, in no particular order, or once with an error.
+// The tile rect is in pixels of the whole snapshot. An empty snapshot rect snapshots the whole document.
+// The page keeps running while the tiles are painted, so later tiles can show changes made in the meantime, and the
+// snapshot fails if the size of the document changes before all the tiles are painted.
+typedef void (*WKPageTakeTiledSnapshotFunction)(WKDataRef pngData, WKRect tileRect, uint32_t tileIndex, uint32_t tileCount, WKErrorRef error, void* functionContext);
+WK_EXPORT void WKPageTakeTiledSnapshot(WKPageRef page, WKRect snapshotRect, uint32_t tileHeight, WKSnapshotOptions options, void* context, WKPageTakeTiledSnapshotFunction function);
     
 WK_EXPORT WKArrayRef WKPageCopyRelatedPages(WKPageRef page);
 
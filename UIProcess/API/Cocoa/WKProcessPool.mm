@@ -32,6 +32,7 @@
 #import "CacheModel.h"
 #import "DownloadClient.h"
 #import "Logging.h"
+#import "MessageStatistics.h"
 #import "SandboxUtilities.h"
 #import "UIGamepadProvider.h"
 #import "WKObject.h"
@@ -416,6 +417,29 @@ static NSDictionary *policiesHashMapToDictionary(const HashMap<String, HashMap<S
 #endif
 }
 
++ (void)_setIPCMessageCountingEnabled:(BOOL)enabled
+{
+    IPC::MessageStatistics::setEnabled(enabled);
+}
+
++ (NSDictionary<NSString *, NSNumber *> *)_ipcMessageCountsByReceiver
+{
+    HashMap<String, uint64_t> counts;
+    for (auto& entry : IPC::MessageStatistics::snapshot())
+        counts.add(entry.messageReceiverName, 0).iterator->value += entry.count;
+
+    auto dictionary = adoptNS([[NSMutableDictionary alloc] initWithCapacity:counts.size()]);
+    for (auto& receiverAndCount : counts)
+        [dictionary setObject:@(receiverAndCount.value) forKey:(NSString *)receiverAndCount.key];
+
+    return dictionary.autorelease();
+}
+
++ (void)_resetIPCMessageCounts
+{
+    IPC::MessageStatistics::reset();
+}
+
 - (BOOL)_isCookieStoragePartitioningEnabled
 {
     return _processPool->cookieStoragePartitioningEnabled();
@@ -223,6 +223,16 @@
     _processPoolConfiguration->setPresentingApplicationPID(presentingApplicationPID);
 }
 
+- (BOOL)usesPackedIPCEncoding
+{
+    return _processPoolConfiguration->usesPackedIPCEncoding();
+}
+
+- (void)setUsesPackedIPCEncoding:(BOOL)usesPackedIPCEncoding
+{
+    _processPoolConfiguration->setUsesPackedIPCEncoding(usesPackedIPCEncoding);
+}
+
 - (pid_t)presentingApplicationPID
 {
     return _processPoolConfiguration->presentingApplicationPID();
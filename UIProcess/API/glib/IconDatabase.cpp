@@ -29,11 +29,13 @@
 
 #include "Logging.h"
 #include <WebCore/BitmapImage.h>
+#include <WebCore/CairoUtilities.h>
 #include <WebCore/FileSystem.h>
 #include <WebCore/Image.h>
 #include <WebCore/SQLiteStatement.h>
 #include <WebCore/SQLiteTransaction.h>
 #include <WebCore/SharedBuffer.h>
+#include <WebCore/RefPtrCairo.h>
 #include <WebCore/URL.h>
 #include <wtf/AutodrainedPool.h>
 #include <wtf/MainThread.h>
@@ -70,6 +72,12 @@ static bool checkIntegrityOnOpen = false;
 // 30 days, delete them even if they have not been explicitly released.
 static const int notUsedIconExpirationTime = 60*60*24*30;
 
+// Page URL records are read from the database on demand, keep this many of the ones that nobody retains.
+static const unsigned maximumUnretainedPageURLRecords = 256;
+
+// Number of scaled versions of an icon kept in memory.
+static const unsigned maximumScaledImagesPerIcon = 4;
+
 #if !LOG_DISABLED || !ERROR_DISABLED
 static String urlForLogging(const String& url)
 {
@@ -107,26 +115,83 @@ IconDatabase::IconRecord::~IconRecord()
     LOG(IconDatabase, "Destroying IconRecord for icon url %s", m_iconURL.ascii().data());
 }
 
-Image* IconDatabase::IconRecord::image(const IntSize&)
+static NativeImagePtr decodeIconImage(RefPtr<SharedBuffer>&& data)
+{
+    if (!data)
+        return nullptr;
+
+    auto image = BitmapImage::create();
+    if (image->setData(WTFMove(data), true) < EncodedDataStatus::SizeAvailable)
+        return nullptr;
+
+    return image->nativeImageForCurrentFrame();
+}
+
+static NativeImagePtr scaleIconImage(const NativeImagePtr& image, const IntSize& size)
+{
+    IntSize imageSize = cairoSurfaceSize(image.get());
+    if (imageSize.isEmpty())
+        return nullptr;
+
+    RefPtr<cairo_surface_t> surface = adoptRef(cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size.width(), size.height()));
+    RefPtr<cairo_t> cr = adoptRef(cairo_create(surface.get()));
+    cairo_scale(cr.get(), static_cast<double>(size.width()) / imageSize.width(), static_cast<double>(size.height()) / imageSize.height());
+    cairo_set_source_surface(cr.get(), image.get(), 0, 0);
+    cairo_pattern_set_filter(cairo_get_source(cr.get()), CAIRO_FILTER_GOOD);
+    cairo_paint(cr.get());
+    return surface;
+}
+
+NativeImagePtr IconDatabase::IconRecord::image(const IntSize& size)
 {
-    // FIXME rdar://4680377 - For size right now, we are returning our one and only image and the Bridge
-    // is resizing it in place. We need to actually store all the original representations here and return a native
-    // one, or resize the best one to the requested size and cache that result.
-    return m_image.get();
+    if (!m_image || size.isEmpty() || size == cairoSurfaceSize(m_image.get()))
+        return m_image;
+
+    for (size_t i = 0; i < m_scaledImages.size(); ++i) {
+        if (m_scaledImages[i].size != size)
+            continue;
+
+        auto scaledImage = m_scaledImages[i];
+        m_scaledImages.remove(i);
+        m_scaledImages.append(scaledImage);
+        return scaledImage.image;
+    }
+
+    // Sizes not requested while the icon was being read are scaled on the calling thread.
+    auto scaledImage = scaleIconImage(m_image, size);
+    if (!scaledImage)
+        return m_image;
+
+    if (m_scaledImages.size() == maximumScaledImagesPerIcon)
+        m_scaledImages.remove(0);
+    m_scaledImages.append({ size, scaledImage });
+    return scaledImage;
+}
+
+void IconDatabase::IconRecord::addRequestedSize(const IntSize& size)
+{
+    if (size.isEmpty() || m_requestedSizes.contains(size) || m_requestedSizes.size() == maximumScaledImagesPerIcon)
+        return;
+
+    m_requestedSizes.append(size);
 }
 
 void IconDatabase::IconRecord::setImageData(RefPtr<SharedBuffer>&& data)
 {
-    // It's okay to delete the raw image here. Any existing clients using this icon will be
-    // managing an image that was created with a copy of this raw image data.
-    m_image = BitmapImage::create();
+    auto image = decodeIconImage(data.copyRef());
+    setImageData(WTFMove(data), WTFMove(image), { });
+}
 
-    // Copy the provided data into the buffer of the new Image object.
-    if (m_image->setData(WTFMove(data), true) < EncodedDataStatus::SizeAvailable) {
+void IconDatabase::IconRecord::setImageData(RefPtr<SharedBuffer>&& data, NativeImagePtr&& image, Vector<ScaledImage>&& scaledImages)
+{
+    // It's okay to delete the previous image here. Any existing clients using this icon hold
+    // their own reference to the surface.
+    if (data && !image)
         LOG(IconDatabase, "Manual image data for iconURL '%s' FAILED - it was probably invalid image data", m_iconURL.ascii().data());
-        m_image = nullptr;
-    }
 
+    m_data = image ? WTFMove(data) : nullptr;
+    m_image = WTFMove(image);
+    m_scaledImages = WTFMove(scaledImages);
     m_dataSet = true;
 }
 
@@ -135,7 +200,10 @@ void IconDatabase::IconRecord::loadImageFromResource(const char* resource)
     if (!resource)
         return;
 
-    m_image = Image::loadPlatformResource(resource);
+    auto image = Image::loadPlatformResource(resource);
+    m_data = image->data();
+    m_image = image->nativeImageForCurrentFrame();
+    m_scaledImages.clear();
     m_dataSet = true;
 }
 
@@ -153,7 +221,7 @@ IconDatabase::IconSnapshot IconDatabase::IconRecord::snapshot(bool forDeletion)
     if (forDeletion)
         return IconSnapshot(m_iconURL, 0, 0);
 
-    return IconSnapshot(m_iconURL, m_stamp, m_image ? m_image->data() : 0);
+    return IconSnapshot(m_iconURL, m_stamp, m_data.get());
 }
 
 IconDatabase::PageURLRecord::PageURLRecord(const String& pageURL)
@@ -173,6 +241,7 @@ void IconDatabase::PageURLRecord::setIconRecord(RefPtr<IconRecord>&& icon)
         m_iconRecord->retainingPageURLs().remove(m_pageURL);
 
     m_iconRecord = WTFMove(icon);
+    m_needsIconURLImport = false;
 
     if (m_iconRecord)
         m_iconRecord->retainingPageURLs().add(m_pageURL);
@@ -277,6 +346,7 @@ void IconDatabase::removeAllIcons()
 
         // Clear the iconURL -> IconRecord map
         m_iconURLToRecordMap.clear();
+        m_iconURLToTimestampMap.clear();
 
         // Clear all in-memory records of things that need to be synced out to disk
         {
@@ -303,7 +373,7 @@ static bool documentCanHaveIcon(const String& documentURL)
     return !documentURL.isEmpty() && !protocolIs(documentURL, "about");
 }
 
-Image* IconDatabase::synchronousIconForPageURL(const String& pageURLOriginal, const IntSize& size)
+NativeImagePtr IconDatabase::synchronousIconForPageURL(const String& pageURLOriginal, const IntSize& size)
 {
     ASSERT_NOT_SYNC_THREAD();
 
@@ -320,42 +390,27 @@ Image* IconDatabase::synchronousIconForPageURL(const String& pageURLOriginal, co
     String pageURLCopy; // Creates a null string for easy testing
 
     PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURLOriginal);
-    if (!pageRecord) {
+    if (!pageRecord || pageRecord->needsIconURLImport()) {
         pageURLCopy = pageURLOriginal.isolatedCopy();
         pageRecord = getOrCreatePageURLRecord(pageURLCopy);
-    }
 
-    // If pageRecord is nullptr, one of two things is true -
-    // 1 - The initial url import is incomplete and this pageURL was marked to be notified once it is complete if an iconURL exists
-    // 2 - The initial url import IS complete and this pageURL has no icon
-    if (!pageRecord) {
-        LockHolder locker(m_pendingReadingLock);
-
-        // Import is ongoing, there might be an icon. In this case, register to be notified when the icon comes in
-        // If we ever reach this condition, we know we've already made the pageURL copy
-        if (!m_iconURLImportComplete)
+        // If pageRecord is nullptr, the icon URL of this page is being read from the database.
+        // Register to be notified when the icon comes in.
+        if (!pageRecord) {
+            LockHolder locker(m_pendingReadingLock);
             m_pageURLsInterestedInIcons.add(pageURLCopy);
+            return nullptr;
+        }
+    } else if (!pageRecord->retainCount())
+        didUseUnretainedPageURLRecord(pageRecord->url());
 
-        return nullptr;
-    }
-
+    // The page is known not to have an icon, or it's retained but has no icon yet.
     IconRecord* iconRecord = pageRecord->iconRecord();
-
-    // If the initial URL import isn't complete, it's possible to have a PageURL record without an associated icon
-    // In this case, the pageURL is already in the set to alert the client when the iconURL mapping is complete so
-    // we can just bail now
-    if (!m_iconURLImportComplete && !iconRecord)
-        return nullptr;
-
-    // Assuming we're done initializing and cleanup is allowed,
-    // the only way we should *not* have an icon record is if this pageURL is retained but has no icon yet.
-    ASSERT(iconRecord || databaseCleanupCounter || m_retainedPageURLs.contains(pageURLOriginal));
-
     if (!iconRecord)
         return nullptr;
 
     // If it's a new IconRecord object that doesn't have its imageData set yet,
-    // mark it to be read by the background thread
+    // mark it to be read by the background thread, which will also scale it to the requested size.
     if (iconRecord->imageDataStatus() == IconRecord::ImageDataStatus::Unknown) {
         if (pageURLCopy.isNull())
             pageURLCopy = pageURLOriginal.isolatedCopy();
@@ -363,25 +418,15 @@ Image* IconDatabase::synchronousIconForPageURL(const String& pageURLOriginal, co
         LockHolder locker(m_pendingReadingLock);
         m_pageURLsInterestedInIcons.add(pageURLCopy);
         m_iconsPendingReading.add(iconRecord);
+        iconRecord->addRequestedSize(size);
         wakeSyncThread();
         return nullptr;
     }
 
-    // If the size parameter was (0, 0) that means the caller of this method just wanted the read from disk to be kicked off
-    // and isn't actually interested in the image return value
-    if (size == IntSize(0, 0))
-        return nullptr;
-
-    // PARANOID DISCUSSION: This method makes some assumptions. It returns a WebCore::image which the icon database might dispose of at anytime in the future,
-    // and Images aren't ref counted. So there is no way for the client to guarantee continued existence of the image.
-    // This has *always* been the case, but in practice clients would always create some other platform specific representation of the image
-    // and drop the raw Image*. On Mac an NSImage, and on windows drawing into an HBITMAP.
-    // The async aspect adds a huge question - what if the image is deleted before the platform specific API has a chance to create its own
-    // representation out of it?
+    // The returned surface is reference counted, so it stays valid for the caller even if the icon database
+    // replaces or disposes of the IconRecord afterwards.
     // If an image is read in from the icondatabase, we do *not* overwrite any image data that exists in the in-memory cache.
     // This is because we make the assumption that anything in memory is newer than whatever is in the database.
-    // So the only time the data will be set from the second thread is when it is INITIALLY being read in from the database, but we would never
-    // delete the image on the secondary thread if the image already exists.
     return iconRecord->image(size);
 }
 
@@ -398,12 +443,13 @@ String IconDatabase::synchronousIconURLForPageURL(const String& pageURLOriginal)
     LockHolder locker(m_urlAndIconLock);
 
     PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURLOriginal);
-    if (!pageRecord)
+    if (!pageRecord || pageRecord->needsIconURLImport())
         pageRecord = getOrCreatePageURLRecord(pageURLOriginal.isolatedCopy());
+    else if (!pageRecord->retainCount())
+        didUseUnretainedPageURLRecord(pageRecord->url());
 
-    // If pageRecord is nullptr, one of two things is true -
-    // 1 - The initial url import is incomplete and this pageURL has already been marked to be notified once it is complete if an iconURL exists
-    // 2 - The initial url import IS complete and this pageURL has no icon
+    // If pageRecord is nullptr, the icon URL of this page is being read from the database and
+    // the client will be notified once it's known
     if (!pageRecord)
         return String();
 
@@ -411,6 +457,18 @@ String IconDatabase::synchronousIconURLForPageURL(const String& pageURLOriginal)
     return pageRecord->iconRecord() ? pageRecord->iconRecord()->iconURL().isolatedCopy() : String();
 }
 
+bool IconDatabase::isIconURLImportPendingForPageURL(const String& pageURL)
+{
+    ASSERT_NOT_SYNC_THREAD();
+
+    if (!isOpen() || !documentCanHaveIcon(pageURL))
+        return false;
+
+    LockHolder locker(m_urlAndIconLock);
+    PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURL);
+    return pageRecord && pageRecord->needsIconURLImport();
+}
+
 void IconDatabase::retainIconForPageURL(const String& pageURL)
 {
     ASSERT_NOT_SYNC_THREAD();
@@ -446,6 +504,7 @@ void IconDatabase::performRetainIconForPageURL(const String& pageURLOriginal, in
 
         // This page just had its retain count bumped from 0 to 1 - Record that fact
         m_retainedPageURLs.add(pageURL);
+        m_unretainedPageURLs.remove(pageURL);
 
         // If we read the iconURLs yet, we want to avoid any pageURL->iconURL lookups and the pageURLsPendingDeletion is moot,
         // so we bail here and skip those steps
@@ -511,8 +570,7 @@ void IconDatabase::performReleaseIconForPageURL(const String& pageURLOriginal, i
         LockHolder locker(m_pendingReadingLock);
 
         // Since this pageURL is going away, there's no reason anyone would ever be interested in its read results
-        if (!m_iconURLImportComplete)
-            m_pageURLsPendingImport.remove(pageURLOriginal);
+        m_pageURLsPendingImport.remove(pageURLOriginal);
         m_pageURLsInterestedInIcons.remove(pageURLOriginal);
 
         // If this icon is down to it's last retainer, we don't care about reading it in from disk anymore
@@ -561,6 +619,7 @@ void IconDatabase::setIconDataForIconURL(RefPtr<SharedBuffer>&& data, const Stri
         // Update the data and set the time stamp
         icon->setImageData(WTFMove(data));
         icon->setTimestamp((int)currentTime());
+        m_iconURLToTimestampMap.set(iconURL, icon->getTimestamp());
 
         // Copy the current retaining pageURLs - if any - to notify them of the change
         pageURLs.appendRange(icon->retainingPageURLs().begin(), icon->retainingPageURLs().end());
@@ -624,6 +683,9 @@ void IconDatabase::setIconURLForPageURL(const String& iconURLOriginal, const Str
             m_pageURLToRecordMap.set(pageURL, pageRecord);
         }
 
+        if (!pageRecord->retainCount())
+            didUseUnretainedPageURLRecord(pageRecord->url());
+
         RefPtr<IconRecord> iconRecord = pageRecord->iconRecord();
 
         // Otherwise, set the new icon record for this page
@@ -678,12 +740,16 @@ IconDatabase::IconLoadDecision IconDatabase::synchronousLoadDecisionForIconURL(c
             LOG(IconDatabase, "Found expiration time on a present icon based on existing IconRecord");
             return static_cast<int>(currentTime()) - static_cast<int>(icon->getTimestamp()) > iconExpirationTime ? IconLoadDecision::Yes : IconLoadDecision::No;
         }
-    }
 
-    // If we don't have a record for it, but we *have* imported all iconURLs from disk, then we should load it now
-    LockHolder readingLocker(m_pendingReadingLock);
-    if (m_iconURLImportComplete)
-        return IconLoadDecision::Yes;
+        // If we don't have a record for it, but we *have* imported all iconURLs from disk, the timestamp on disk decides
+        LockHolder readingLocker(m_pendingReadingLock);
+        if (m_iconURLImportComplete) {
+            auto it = m_iconURLToTimestampMap.find(iconURL);
+            if (it == m_iconURLToTimestampMap.end())
+                return IconLoadDecision::Yes;
+            return static_cast<int>(currentTime()) - it->value > iconExpirationTime ? IconLoadDecision::Yes : IconLoadDecision::No;
+        }
+    }
 
     // Otherwise - since we refuse to perform I/O on the main thread to find out for sure - we return the answer that says
     // "You might be asked to load this later, so flag that"
@@ -826,6 +892,8 @@ Ref<IconDatabase::IconRecord> IconDatabase::getOrCreateIconRecord(const String&
         return *icon;
 
     auto newIcon = IconRecord::create(iconURL);
+    // Until we read this icon from disk we don't know when it was loaded, use the timestamp imported at startup if any.
+    newIcon->setTimestamp(m_iconURLToTimestampMap.get(iconURL));
     m_iconURLToRecordMap.set(iconURL, newIcon.ptr());
     return newIcon;
 }
@@ -840,28 +908,67 @@ IconDatabase::PageURLRecord* IconDatabase::getOrCreatePageURLRecord(const String
         return nullptr;
 
     PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURL);
+    if (!pageRecord) {
+        LOG(IconDatabase, "Creating new PageURLRecord for pageURL %s", urlForLogging(pageURL).ascii().data());
+        pageRecord = new PageURLRecord(pageURL);
+        m_pageURLToRecordMap.set(pageURL, pageRecord);
+    }
 
-    LockHolder locker(m_pendingReadingLock);
-    if (!m_iconURLImportComplete) {
-        // If the initial import of all URLs hasn't completed and we have no page record, we assume we *might* know about this later and create a record for it
-        if (!pageRecord) {
-            LOG(IconDatabase, "Creating new PageURLRecord for pageURL %s", urlForLogging(pageURL).ascii().data());
-            pageRecord = new PageURLRecord(pageURL);
-            m_pageURLToRecordMap.set(pageURL, pageRecord);
-        }
+    if (!pageRecord->retainCount())
+        didUseUnretainedPageURLRecord(pageRecord->url());
 
-        // If the pageRecord for this page does not have an iconRecord attached to it, then it is a new pageRecord still awaiting the initial import
-        // Mark the URL as "interested in the result of the import" then bail
-        if (!pageRecord->iconRecord()) {
-            m_pageURLsPendingImport.add(pageURL);
-            return nullptr;
-        }
+    // If the icon URL of this page hasn't been read from the database yet, ask the sync thread to look it up.
+    // Mark the URL as "interested in the result of the import" then bail
+    if (pageRecord->needsIconURLImport()) {
+        LockHolder locker(m_pendingReadingLock);
+        m_pageURLsPendingImport.add(pageRecord->url());
+        wakeSyncThread();
+        return nullptr;
     }
 
-    // We've done the initial import of all URLs known in the database. If this record doesn't exist now, it never will
     return pageRecord;
 }
 
+void IconDatabase::didUseUnretainedPageURLRecord(const String& pageURL)
+{
+    // Clients of didUseUnretainedPageURLRecord() are required to acquire the m_urlAndIconLock before calling this method
+    ASSERT(!m_urlAndIconLock.tryLock());
+
+    m_unretainedPageURLs.appendOrMoveToLast(pageURL);
+    if (m_unretainedPageURLs.size() <= maximumUnretainedPageURLRecords)
+        return;
+
+    deletePageURLRecordIfUnretained(m_unretainedPageURLs.takeFirst());
+}
+
+// Unlike performReleaseIconForPageURL(), this only drops the in-memory record, the mapping stays in the database and will be read again on demand.
+void IconDatabase::deletePageURLRecordIfUnretained(const String& pageURL)
+{
+    ASSERT(!m_urlAndIconLock.tryLock());
+
+    PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURL);
+    if (!pageRecord || pageRecord->retainCount())
+        return;
+
+    LOG(IconDatabase, "Dropping unretained PageURLRecord for pageURL %s", urlForLogging(pageURL).ascii().data());
+    m_pageURLToRecordMap.remove(pageURL);
+
+    IconRecord* iconRecord = pageRecord->iconRecord();
+    {
+        LockHolder locker(m_pendingReadingLock);
+        m_pageURLsPendingImport.remove(pageURL);
+        m_pageURLsInterestedInIcons.remove(pageURL);
+
+        // If this page is the only remaining retainer of its icon, don't bother reading it in from disk
+        if (iconRecord && iconRecord->hasOneRef()) {
+            m_iconURLToRecordMap.remove(iconRecord->iconURL());
+            m_iconsPendingReading.remove(iconRecord);
+        }
+    }
+
+    delete pageRecord;
+}
+
 
 // ************************
 // *** Sync Thread Only ***
@@ -1102,11 +1209,30 @@ void IconDatabase::performURLImport()
 {
     ASSERT_ICON_SYNC_THREAD();
 
+    // Page URL to icon URL mappings are read on demand by importPendingPageURLs(), only the icon URLs and their
+    // timestamps are needed up front to make load decisions.
+    importIconURLTimestamps();
+    if (shouldStopThreadActivity())
+        return;
+
+    {
+        LockHolder locker(m_pendingReadingLock);
+        m_iconURLImportComplete = true;
+    }
+
+    // Notify the client that the URL import is complete in case it's managing its own pending notifications.
+    dispatchDidFinishURLImportOnMainThread();
+}
+
+void IconDatabase::importIconURLTimestamps()
+{
+    ASSERT_ICON_SYNC_THREAD();
+
     // Do not import icons not used in the last 30 days. They will be automatically pruned later if nobody retains them.
     // Note that IconInfo.stamp is only set when the icon data is retrieved from the server (and thus is not updated whether
     // we use it or not). This code works anyway because the IconDatabase downloads icons again if they are older than 4 days,
     // so if the timestamp goes back in time more than those 30 days we can be sure that the icon was not used at all.
-    String importQuery = String::format("SELECT PageURL.url, IconInfo.url, IconInfo.stamp FROM PageURL INNER JOIN IconInfo ON PageURL.iconID=IconInfo.iconID WHERE IconInfo.stamp > %.0f;", floor(currentTime() - notUsedIconExpirationTime));
+    String importQuery = String::format("SELECT url, stamp FROM IconInfo WHERE stamp > %.0f;", floor(currentTime() - notUsedIconExpirationTime));
 
     SQLiteStatement query(m_syncDB, importQuery);
 
@@ -1115,129 +1241,23 @@ void IconDatabase::performURLImport()
         return;
     }
 
-    int result = query.step();
-    while (result == SQLITE_ROW) {
-        AutodrainedPool pool;
-        String pageURL = query.getColumnText(0);
-        String iconURL = query.getColumnText(1);
-
-        {
-            LockHolder locker(m_urlAndIconLock);
-
-            PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURL);
-
-            // If the pageRecord doesn't exist in this map, then no one has retained this pageURL
-            // If the s_databaseCleanupCounter count is non-zero, then we're not supposed to be pruning the database in any manner,
-            // so actually create a pageURLRecord for this url even though it's not retained.
-            // If database cleanup *is* allowed, we don't want to bother pulling in a page url from disk that noone is actually interested
-            // in - we'll prune it later instead!
-            if (!pageRecord && databaseCleanupCounter && documentCanHaveIcon(pageURL)) {
-                pageRecord = new PageURLRecord(pageURL);
-                m_pageURLToRecordMap.set(pageURL, pageRecord);
-            }
-
-            if (pageRecord) {
-                IconRecord* currentIcon = pageRecord->iconRecord();
-
-                if (!currentIcon || currentIcon->iconURL() != iconURL) {
-                    pageRecord->setIconRecord(getOrCreateIconRecord(iconURL));
-                    currentIcon = pageRecord->iconRecord();
-                }
-
-                // Regardless, the time stamp from disk still takes precedence. Until we read this icon from disk, we didn't think we'd seen it before
-                // so we marked the timestamp as "now", but it's really much older
-                currentIcon->setTimestamp(query.getColumnInt(2));
-            }
-        }
-
-        // FIXME: Currently the WebKit API supports 1 type of notification that is sent whenever we get an Icon URL for a Page URL. We might want to re-purpose it to work for
-        // getting the actually icon itself also (so each pageurl would get this notification twice) or we might want to add a second type of notification -
-        // one for the URL and one for the Image itself
-        // Note that WebIconDatabase is not neccessarily API so we might be able to make this change
-        {
-            LockHolder locker(m_pendingReadingLock);
-            if (m_pageURLsPendingImport.contains(pageURL)) {
-                dispatchDidImportIconURLForPageURLOnMainThread(pageURL);
-                m_pageURLsPendingImport.remove(pageURL);
-            }
-        }
+    HashMap<String, int> iconURLToTimestampMap;
+    int result;
+    while ((result = query.step()) == SQLITE_ROW) {
+        iconURLToTimestampMap.set(query.getColumnText(0), query.getColumnInt(1));
 
         // Stop the import at any time of the thread has been asked to shutdown
         if (shouldStopThreadActivity()) {
-            LOG(IconDatabase, "IconDatabase asked to terminate during performURLImport()");
+            LOG(IconDatabase, "IconDatabase asked to terminate during importIconURLTimestamps()");
             return;
         }
-
-        result = query.step();
     }
 
     if (result != SQLITE_DONE)
-        LOG(IconDatabase, "Error reading page->icon url mappings from database");
-
-    // Clear the m_pageURLsPendingImport set - either the page URLs ended up with an iconURL (that we'll notify about) or not,
-    // but after m_iconURLImportComplete is set to true, we don't care about this set anymore
-    Vector<String> urls;
-    {
-        LockHolder locker(m_pendingReadingLock);
-
-        urls.appendRange(m_pageURLsPendingImport.begin(), m_pageURLsPendingImport.end());
-        m_pageURLsPendingImport.clear();
-        m_iconURLImportComplete = true;
-    }
-
-    Vector<String> urlsToNotify;
-
-    // Loop through the urls pending import
-    // Remove unretained ones if database cleanup is allowed
-    // Keep a set of ones that are retained and pending notification
-    {
-        LockHolder locker(m_urlAndIconLock);
-
-        performPendingRetainAndReleaseOperations();
-
-        for (auto& url : urls) {
-            if (!m_retainedPageURLs.contains(url)) {
-                PageURLRecord* record = m_pageURLToRecordMap.get(url);
-                if (record && !databaseCleanupCounter) {
-                    m_pageURLToRecordMap.remove(url);
-                    IconRecord* iconRecord = record->iconRecord();
-
-                    // If this page is the only remaining retainer of its icon, mark that icon for deletion and don't bother
-                    // reading anything related to it
-                    if (iconRecord && iconRecord->hasOneRef()) {
-                        m_iconURLToRecordMap.remove(iconRecord->iconURL());
-
-                        {
-                            LockHolder locker(m_pendingReadingLock);
-                            m_pageURLsInterestedInIcons.remove(url);
-                            m_iconsPendingReading.remove(iconRecord);
-                        }
-                        {
-                            LockHolder locker(m_pendingSyncLock);
-                            m_iconsPendingSync.set(iconRecord->iconURL(), iconRecord->snapshot(true));
-                        }
-                    }
-
-                    delete record;
-                }
-            } else
-                urlsToNotify.append(url);
-        }
-    }
-
-    LOG(IconDatabase, "Notifying %lu interested page URLs that their icon URL is known due to the import", static_cast<unsigned long>(urlsToNotify.size()));
-    // Now that we don't hold any locks, perform the actual notifications
-    for (auto& url : urlsToNotify) {
-        AutodrainedPool pool;
-
-        LOG(IconDatabase, "Notifying icon info known for pageURL %s", url.ascii().data());
-        dispatchDidImportIconURLForPageURLOnMainThread(url);
-        if (shouldStopThreadActivity())
-            return;
-    }
+        LOG(IconDatabase, "Error reading icon urls from database");
 
-    // Notify the client that the URL import is complete in case it's managing its own pending notifications.
-    dispatchDidFinishURLImportOnMainThread();
+    LockHolder locker(m_urlAndIconLock);
+    m_iconURLToTimestampMap = WTFMove(iconURLToTimestampMap);
 }
 
 void IconDatabase::syncThreadMainLoop()
@@ -1282,7 +1302,11 @@ void IconDatabase::syncThreadMainLoop()
             if (shouldStopThreadActivity())
                 break;
 
-            didAnyWork = readFromDatabase();
+            bool didImport = importPendingPageURLs();
+            if (shouldStopThreadActivity())
+                break;
+
+            didAnyWork = readFromDatabase() || didImport;
             if (shouldStopThreadActivity())
                 break;
 
@@ -1370,6 +1394,70 @@ void IconDatabase::performPendingRetainAndReleaseOperations()
     }
 }
 
+bool IconDatabase::importPendingPageURLs()
+{
+    ASSERT_ICON_SYNC_THREAD();
+
+    Vector<String> pageURLs;
+    {
+        LockHolder locker(m_pendingReadingLock);
+        pageURLs.appendRange(m_pageURLsPendingImport.begin(), m_pageURLsPendingImport.end());
+    }
+
+    for (auto& pageURL : pageURLs) {
+        AutodrainedPool pool;
+
+        int timestamp = 0;
+        String iconURL = getIconURLForPageURLFromSQLDatabase(pageURL, timestamp);
+
+        bool didImportIconURL = false;
+        bool iconDataKnown = false;
+        {
+            LockHolder urlLocker(m_urlAndIconLock);
+            LockHolder readLocker(m_pendingReadingLock);
+
+            // Verify this page still wants its icon URL, the record might have been released, dropped from
+            // the unretained records or given a new icon in the meantime
+            PageURLRecord* pageRecord = m_pageURLToRecordMap.get(pageURL);
+            if (m_pageURLsPendingImport.remove(pageURL) && pageRecord && pageRecord->needsIconURLImport()) {
+                if (iconURL.isEmpty())
+                    pageRecord->didImportIconURL();
+                else {
+                    bool isNewIcon = !m_iconURLToRecordMap.contains(iconURL);
+                    pageRecord->setIconRecord(getOrCreateIconRecord(iconURL));
+
+                    // The time stamp from disk takes precedence over the one of the startup import, but not over in-memory changes
+                    IconRecord* iconRecord = pageRecord->iconRecord();
+                    if (isNewIcon)
+                        iconRecord->setTimestamp(timestamp);
+
+                    if (m_pageURLsInterestedInIcons.contains(pageURL)) {
+                        if (iconRecord->imageDataStatus() == IconRecord::ImageDataStatus::Unknown)
+                            m_iconsPendingReading.add(iconRecord);
+                        else {
+                            m_pageURLsInterestedInIcons.remove(pageURL);
+                            iconDataKnown = true;
+                        }
+                    }
+                }
+                didImportIconURL = true;
+            }
+        }
+
+        if (didImportIconURL) {
+            LOG(IconDatabase, "Notifying icon url known for pageURL %s", urlForLogging(pageURL).ascii().data());
+            dispatchDidImportIconURLForPageURLOnMainThread(pageURL);
+            if (iconDataKnown)
+                dispatchDidImportIconDataForPageURLOnMainThread(pageURL);
+        }
+
+        if (shouldStopThreadActivity())
+            break;
+    }
+
+    return !pageURLs.isEmpty();
+}
+
 bool IconDatabase::readFromDatabase()
 {
     ASSERT_ICON_SYNC_THREAD();
@@ -1393,7 +1481,27 @@ bool IconDatabase::readFromDatabase()
 
     for (unsigned i = 0; i < icons.size(); ++i) {
         didAnyWork = true;
-        auto imageData = getImageDataForIconURLFromSQLDatabase(icons[i]->iconURL());
+
+        String iconURL;
+        Vector<IntSize> requestedSizes;
+        {
+            LockHolder locker(m_pendingReadingLock);
+            if (!m_iconsPendingReading.contains(icons[i]))
+                continue;
+            iconURL = icons[i]->iconURL().isolatedCopy();
+            requestedSizes = icons[i]->takeRequestedSizes();
+        }
+
+        // Decode the icon and scale it to the sizes asked for while it was pending, without holding any lock
+        auto imageData = getImageDataForIconURLFromSQLDatabase(iconURL);
+        auto image = decodeIconImage(imageData.copyRef());
+        Vector<IconRecord::ScaledImage> scaledImages;
+        if (image) {
+            for (auto& size : requestedSizes) {
+                if (auto scaledImage = scaleIconImage(image, size))
+                    scaledImages.append({ size, WTFMove(scaledImage) });
+            }
+        }
 
         // Verify this icon still wants to be read from disk
         {
@@ -1403,7 +1511,7 @@ bool IconDatabase::readFromDatabase()
 
                 if (m_iconsPendingReading.contains(icons[i])) {
                     // Set the new data
-                    icons[i]->setImageData(WTFMove(imageData));
+                    icons[i]->setImageData(WTFMove(imageData), WTFMove(image), WTFMove(scaledImages));
 
                     // Remove this icon from the set that needs to be read
                     m_iconsPendingReading.remove(icons[i]);
@@ -1603,6 +1711,9 @@ void IconDatabase::pruneUnretainedIcons()
 
     checkForDanglingPageURLs(true);
 
+    // Forget the timestamps of the icons we just deleted
+    importIconURLTimestamps();
+
     m_initialPruningComplete = true;
 }
 
@@ -1653,6 +1764,7 @@ void IconDatabase::deleteAllPreparedStatements()
     m_setIconIDForPageURLStatement = nullptr;
     m_removePageURLStatement = nullptr;
     m_getIconIDForIconURLStatement = nullptr;
+    m_getIconURLForPageURLStatement = nullptr;
     m_getImageDataForIconURLStatement = nullptr;
     m_addIconToIconInfoStatement = nullptr;
     m_addIconToIconDataStatement = nullptr;
@@ -1785,6 +1897,27 @@ int64_t IconDatabase::getIconIDForIconURLFromSQLDatabase(const String& iconURL)
     return result;
 }
 
+String IconDatabase::getIconURLForPageURLFromSQLDatabase(const String& pageURL, int& timestamp)
+{
+    ASSERT_ICON_SYNC_THREAD();
+
+    // Like the startup import, ignore icons not used in the last 30 days.
+    readySQLiteStatement(m_getIconURLForPageURLStatement, m_syncDB, "SELECT IconInfo.url, IconInfo.stamp FROM PageURL INNER JOIN IconInfo ON PageURL.iconID=IconInfo.iconID WHERE PageURL.url = (?) AND IconInfo.stamp > (?);");
+    m_getIconURLForPageURLStatement->bindText(1, pageURL);
+    m_getIconURLForPageURLStatement->bindInt64(2, static_cast<int64_t>(floor(currentTime() - notUsedIconExpirationTime)));
+
+    String iconURL;
+    int result = m_getIconURLForPageURLStatement->step();
+    if (result == SQLITE_ROW) {
+        iconURL = m_getIconURLForPageURLStatement->getColumnText(0);
+        timestamp = m_getIconURLForPageURLStatement->getColumnInt(1);
+    } else if (result != SQLITE_DONE)
+        LOG_ERROR("getIconURLForPageURLFromSQLDatabase failed for url %s", urlForLogging(pageURL).ascii().data());
+
+    m_getIconURLForPageURLStatement->reset();
+    return iconURL;
+}
+
 int64_t IconDatabase::addIconURLToSQLDatabase(const String& iconURL)
 {
     ASSERT_ICON_SYNC_THREAD();
@@ -1889,9 +2022,13 @@ void IconDatabase::writeIconSnapshotToSQLDatabase(const IconSnapshot& snapshot)
     if (!snapshot.timestamp() && !snapshot.data()) {
         LOG(IconDatabase, "Removing %s from on-disk database", urlForLogging(snapshot.iconURL()).ascii().data());
         removeIconFromSQLDatabase(snapshot.iconURL());
+        m_iconURLToTimestampMap.remove(snapshot.iconURL());
         return;
     }
 
+    // The caller holds m_urlAndIconLock, keep the timestamps used for load decisions in sync with the disk
+    m_iconURLToTimestampMap.set(snapshot.iconURL().isolatedCopy(), snapshot.timestamp());
+
     // There would be a transaction here to make sure these removals are atomic
     // In practice the only caller of this method is always wrapped in a transaction itself so placing another here is unnecessary
 
@@ -26,18 +26,19 @@
 
 #pragma once
 
+#include <WebCore/IntSize.h>
 #include <WebCore/NativeImage.h>
 #include <WebCore/SQLiteDatabase.h>
 #include <wtf/Condition.h>
 #include <wtf/HashCountedSet.h>
 #include <wtf/HashMap.h>
 #include <wtf/HashSet.h>
+#include <wtf/ListHashSet.h>
 #include <wtf/RunLoop.h>
 #include <wtf/text/StringHash.h>
 #include <wtf/text/WTFString.h>
 
 namespace WebCore {
-class Image;
 class SharedBuffer;
 }
 
@@ -94,8 +95,18 @@ private:
         time_t getTimestamp() { return m_stamp; }
         void setTimestamp(time_t stamp) { m_stamp = stamp; }
 
+        struct ScaledImage {
+            WebCore::IntSize size;
+            WebCore::NativeImagePtr image;
+        };
+
         void setImageData(RefPtr<WebCore::SharedBuffer>&&);
-        WebCore::Image* image(const WebCore::IntSize&);
+        void setImageData(RefPtr<WebCore::SharedBuffer>&&, WebCore::NativeImagePtr&&, Vector<ScaledImage>&&);
+        WebCore::NativeImagePtr image(const WebCore::IntSize&);
+
+        // Sizes requested while the image data is pending to be read, so that the sync thread scales it too. Protected by m_pendingReadingLock.
+        void addRequestedSize(const WebCore::IntSize&);
+        Vector<WebCore::IntSize> takeRequestedSizes() { return WTFMove(m_requestedSizes); }
 
         String iconURL() { return m_iconURL; }
 
@@ -113,7 +124,10 @@ private:
 
         String m_iconURL;
         time_t m_stamp { 0 };
-        RefPtr<WebCore::Image> m_image;
+        RefPtr<WebCore::SharedBuffer> m_data;
+        WebCore::NativeImagePtr m_image;
+        Vector<ScaledImage> m_scaledImages; // Most recently used last.
+        Vector<WebCore::IntSize> m_requestedSizes;
 
         HashSet<String> m_retainingPageURLs;
 
@@ -152,6 +166,10 @@ private:
         void setIconRecord(RefPtr<IconRecord>&&);
         IconRecord* iconRecord() { return m_iconRecord.get(); }
 
+        // Whether the icon URL of this page still has to be read from the database.
+        bool needsIconURLImport() const { return m_needsIconURLImport; }
+        void didImportIconURL() { m_needsIconURLImport = false; }
+
         PageURLSnapshot snapshot(bool forDeletion = false) const;
 
         // Returns false if the page wasn't retained beforehand, true if the retain count was already 1 or higher.
@@ -176,6 +194,7 @@ private:
         String m_pageURL;
         RefPtr<IconRecord> m_iconRecord;
         int m_retainCount { 0 };
+        bool m_needsIconURLImport { true };
     };
 
 // *** Main Thread Only ***
@@ -197,8 +216,10 @@ public:
     void setIconDataForIconURL(RefPtr<WebCore::SharedBuffer>&&, const String& iconURL);
     void setIconURLForPageURL(const String& iconURL, const String& pageURL);
 
-    WebCore::Image* synchronousIconForPageURL(const String&, const WebCore::IntSize&);
+    // An empty size returns the icon at its natural size.
+    WebCore::NativeImagePtr synchronousIconForPageURL(const String&, const WebCore::IntSize& = { });
     String synchronousIconURLForPageURL(const String&);
+    bool isIconURLImportPendingForPageURL(const String&);
     bool synchronousIconDataKnownForIconURL(const String&);
     IconLoadDecision synchronousLoadDecisionForIconURL(const String&);
 
@@ -231,6 +252,8 @@ public:
 private:
     Ref<IconRecord> getOrCreateIconRecord(const String& iconURL);
     PageURLRecord* getOrCreatePageURLRecord(const String& pageURL);
+    void didUseUnretainedPageURLRecord(const String& pageURL);
+    void deletePageURLRecordIfUnretained(const String& pageURL);
 
     bool m_isEnabled {false };
     bool m_privateBrowsingEnabled { false };
@@ -251,6 +274,10 @@ private:
     HashMap<String, IconRecord*> m_iconURLToRecordMap;
     HashMap<String, PageURLRecord*> m_pageURLToRecordMap;
     HashSet<String> m_retainedPageURLs;
+    // Page URLs are imported from the database on demand, the records of the ones nobody retains are kept in a bounded LRU.
+    ListHashSet<String> m_unretainedPageURLs;
+    // Icon URLs on disk and their timestamps, to make load decisions for icons that don't have an IconRecord.
+    HashMap<String, int> m_iconURLToTimestampMap;
 
     Lock m_pendingSyncLock;
     // Holding m_pendingSyncLock is required when accessing any of the following data structures
@@ -281,7 +308,9 @@ private:
     void performOpenInitialization();
     bool checkIntegrity();
     void performURLImport();
+    void importIconURLTimestamps();
     void syncThreadMainLoop();
+    bool importPendingPageURLs();
     bool readFromDatabase();
     bool writeToDatabase();
     void pruneUnretainedIcons();
@@ -301,6 +330,7 @@ private:
     void setIconIDForPageURLInSQLDatabase(int64_t, const String&);
     void removePageURLFromSQLDatabase(const String& pageURL);
     int64_t getIconIDForIconURLFromSQLDatabase(const String& iconURL);
+    String getIconURLForPageURLFromSQLDatabase(const String& pageURL, int& timestamp);
     int64_t addIconURLToSQLDatabase(const String&);
     RefPtr<WebCore::SharedBuffer> getImageDataForIconURLFromSQLDatabase(const String& iconURL);
     void removeIconFromSQLDatabase(const String& iconURL);
@@ -323,6 +353,7 @@ private:
     std::unique_ptr<WebCore::SQLiteStatement> m_setIconIDForPageURLStatement;
     std::unique_ptr<WebCore::SQLiteStatement> m_removePageURLStatement;
     std::unique_ptr<WebCore::SQLiteStatement> m_getIconIDForIconURLStatement;
+    std::unique_ptr<WebCore::SQLiteStatement> m_getIconURLForPageURLStatement;
     std::unique_ptr<WebCore::SQLiteStatement> m_getImageDataForIconURLStatement;
     std::unique_ptr<WebCore::SQLiteStatement> m_addIconToIconInfoStatement;
     std::unique_ptr<WebCore::SQLiteStatement> m_addIconToIconDataStatement;
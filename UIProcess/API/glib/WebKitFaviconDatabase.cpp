@@ -24,8 +24,6 @@
 #include "WebKitFaviconDatabasePrivate.h"
 #include "WebPreferences.h"
 #include <WebCore/FileSystem.h>
-#include <WebCore/Image.h>
-#include <WebCore/IntSize.h>
 #include <WebCore/RefPtrCairo.h>
 #include <glib/gi18n-lib.h>
 #include <wtf/RunLoop.h>
@@ -142,17 +140,10 @@ static RefPtr<cairo_surface_t> getIconSurfaceSynchronously(WebKitFaviconDatabase
 {
     ASSERT(RunLoop::isMain());
 
-    // The exact size we pass is irrelevant to the iconDatabase code.
-    // We must pass something greater than 0x0 to get an icon.
-    WebCore::Image* iconImage = database->priv->iconDatabase->synchronousIconForPageURL(pageURL, WebCore::IntSize(1, 1));
-    if (!iconImage) {
-        g_set_error(error, WEBKIT_FAVICON_DATABASE_ERROR, WEBKIT_FAVICON_DATABASE_ERROR_FAVICON_UNKNOWN, _("Unknown favicon for page %s"), pageURL.utf8().data());
-        return nullptr;
-    }
-
-    RefPtr<cairo_surface_t> surface = iconImage->nativeImageForCurrentFrame();
+    // The icon is decoded by the database, we get it at its natural size.
+    RefPtr<cairo_surface_t> surface = database->priv->iconDatabase->synchronousIconForPageURL(pageURL);
     if (!surface) {
-        g_set_error(error, WEBKIT_FAVICON_DATABASE_ERROR, WEBKIT_FAVICON_DATABASE_ERROR_FAVICON_NOT_FOUND, _("Page %s does not have a favicon"), pageURL.utf8().data());
+        g_set_error(error, WEBKIT_FAVICON_DATABASE_ERROR, WEBKIT_FAVICON_DATABASE_ERROR_FAVICON_UNKNOWN, _("Unknown favicon for page %s"), pageURL.utf8().data());
         return nullptr;
     }
 
@@ -212,8 +203,15 @@ public:
 private:
     void didImportIconURLForPageURL(const String& pageURL) override
     {
+        // The icon URL was read from the database on demand, so it didn't change. Just record it.
         String iconURL = m_database->priv->iconDatabase->synchronousIconURLForPageURL(pageURL);
-        webkitFaviconDatabaseSetIconURLForPageURL(m_database, iconURL, pageURL);
+        if (!iconURL.isEmpty()) {
+            m_database->priv->pageURLToIconURLMap.set(pageURL, iconURL);
+            return;
+        }
+
+        // There's no icon for this page, the pending requests can fail now.
+        processPendingIconsForPageURL(m_database, pageURL);
     }
 
     void didChangeIconForPageURL(const String& pageURL) override
@@ -396,17 +394,11 @@ void webkit_favicon_database_get_favicon(WebKitFaviconDatabase* database, const
     // At this point we still don't know whether we will get a valid icon for pageURL.
     data->shouldReleaseIconForPageURL = true;
 
-    if (g_error_matches(error.get(), WEBKIT_FAVICON_DATABASE_ERROR, WEBKIT_FAVICON_DATABASE_ERROR_FAVICON_NOT_FOUND)) {
-        g_task_return_error(task.get(), error.release().release());
-        return;
-    }
-
     // If there's not a valid icon, but there's an iconURL registered,
-    // or it's still not registered but the import process hasn't
-    // finished yet, we need to wait for iconDataReadyForPage to be
-    // called before making and informed decision.
+    // or it's still being read from the database, we need to wait for
+    // the database to notify us before making and informed decision.
     String iconURLForPageURL = priv->iconDatabase->synchronousIconURLForPageURL(data->pageURL);
-    if (!iconURLForPageURL.isEmpty() || !priv->isURLImportCompleted) {
+    if (!iconURLForPageURL.isEmpty() || !priv->isURLImportCompleted || priv->iconDatabase->isIconURLImportPendingForPageURL(data->pageURL)) {
         PendingIconRequestVector* iconRequests = getOrCreatePendingIconRequests(database, data->pageURL);
         ASSERT(iconRequests);
         iconRequests->append(task);
@@ -67,6 +67,7 @@
 #include <WebCore/RefPtrCairo.h>
 #include <glib/gi18n-lib.h>
 #include <wtf/glib/GRefPtr.h>
+#include <wtf/RunLoop.h>
 #include <wtf/glib/WTFGType.h>
 #include <wtf/text/CString.h>
 #include <wtf/text/StringBuilder.h>
@@ -3659,6 +3660,123 @@ cairo_surface_t* webkit_web_view_get_snapshot_finish(WebKitWebView* webView, GAs
     return static_cast<cairo_surface_t*>(g_task_propagate_pointer(G_TASK(result), error));
 }
 
+struct TiledSnapshotAsyncData {
+    ~TiledSnapshotAsyncData()
+    {
+        if (tileUserDataDestroyFunc)
+            tileUserDataDestroyFunc(tileUserData);
+    }
+
+    WebKitSnapshotTileCallback tileCallback;
+    gpointer tileUserData;
+    GDestroyNotify tileUserDataDestroyFunc;
+    uint64_t snapshotID;
+    unsigned deliveredTileCount;
+    bool isFinished;
+};
+WEBKIT_DEFINE_ASYNC_DATA_STRUCT(TiledSnapshotAsyncData)
+
+static void didGetSnapshotTile(GTask* task, API::Data* data, const IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, WebKit::CallbackBase::Error error)
+{
+    TiledSnapshotAsyncData* asyncData = static_cast<TiledSnapshotAsyncData*>(g_task_get_task_data(task));
+    if (asyncData->isFinished)
+        return;
+
+    WebKitWebView* webView = WEBKIT_WEB_VIEW(g_task_get_source_object(task));
+    if (g_task_return_error_if_cancelled(task)) {
+        asyncData->isFinished = true;
+        // The snapshot can't be cancelled while one of its tiles is being delivered.
+        RunLoop::main().dispatch([webView = GRefPtr<WebKitWebView>(webView), snapshotID = asyncData->snapshotID] {
+            getPage(webView.get()).cancelTiledSnapshot(snapshotID);
+        });
+        return;
+    }
+
+    if (error != WebKit::CallbackBase::Error::None) {
+        asyncData->isFinished = true;
+        g_task_return_new_error(task, WEBKIT_SNAPSHOT_ERROR, WEBKIT_SNAPSHOT_ERROR_FAILED_TO_CREATE,
+            _("There was an error creating the snapshot"));
+        return;
+    }
+
+    GRefPtr<GBytes> bytes = adoptGRef(g_bytes_new(data->bytes(), data->size()));
+    cairo_rectangle_int_t rect = tileRect;
+    asyncData->tileCallback(webView, bytes.get(), &rect, tileIndex, tileCount, asyncData->tileUserData);
+
+    if (++asyncData->deliveredTileCount == tileCount) {
+        asyncData->isFinished = true;
+        g_task_return_boolean(task, TRUE);
+    }
+}
+
+/**
+ * webkit_web_view_get_tiled_snapshot:
+ * @web_view: a #WebKitWebView
+ * @options: #WebKitSnapshotOptions for the snapshot
+ * @tile_height: the height of the tiles, in CSS pixels
+ * @tile_callback: (scope notified): a #WebKitSnapshotTileCallback
+ * @tile_user_data: (closure tile_callback): user data for @tile_callback
+ * @tile_user_data_destroy_func: (allow-none): destroy notifier for @tile_user_data
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): a #GAsyncReadyCallback
+ * @user_data: (closure): user data
+ *
+ * Asynchronously retrieves a snapshot of the entire document of @web_view,
+ * split in tiles of @tile_height. Every tile is encoded as PNG and passed to
+ * @tile_callback as soon as it is ready, so tiles are not necessarily received
+ * in order. Unlike webkit_web_view_get_snapshot(), the memory used doesn't
+ * depend on the height of the document.
+ * %WEBKIT_SNAPSHOT_OPTIONS_TRANSPARENT_BACKGROUND is not supported.
+ *
+ * The page keeps running while the tiles are painted, so the snapshot is not
+ * atomic: tiles painted later can show changes made to the page in the meantime.
+ * The operation fails if the size of the document changes before all the tiles
+ * have been painted.
+ *
+ * When all the tiles have been received, or the operation failed, @callback
+ * will be called. You must call webkit_web_view_get_tiled_snapshot_finish()
+ * to get the result of the operation.
+ *
+ * Since: 2.20
+ */
+void webkit_web_view_get_tiled_snapshot(WebKitWebView* webView, WebKitSnapshotOptions options, guint tileHeight, WebKitSnapshotTileCallback tileCallback, gpointer tileUserData, GDestroyNotify tileUserDataDestroyFunc, GCancellable* cancellable, GAsyncReadyCallback callback, gpointer userData)
+{
+    g_return_if_fail(WEBKIT_IS_WEB_VIEW(webView));
+    g_return_if_fail(tileHeight);
+    g_return_if_fail(tileCallback);
+
+    GRefPtr<GTask> task = adoptGRef(g_task_new(webView, cancellable, callback, userData));
+    TiledSnapshotAsyncData* data = createTiledSnapshotAsyncData();
+    data->tileCallback = tileCallback;
+    data->tileUserData = tileUserData;
+    data->tileUserDataDestroyFunc = tileUserDataDestroyFunc;
+    g_task_set_task_data(task.get(), data, reinterpret_cast<GDestroyNotify>(destroyTiledSnapshotAsyncData));
+
+    data->snapshotID = getPage(webView).takeTiledSnapshot(IntRect(), tileHeight, webKitSnapshotOptionsToSnapshotOptions(options), [task](API::Data* data, const IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, WebKit::CallbackBase::Error error) {
+        didGetSnapshotTile(task.get(), data, tileRect, tileIndex, tileCount, error);
+    });
+}
+
+/**
+ * webkit_web_view_get_tiled_snapshot_finish:
+ * @web_view: a #WebKitWebView
+ * @result: a #GAsyncResult
+ * @error: return location for error or %NULL to ignore
+ *
+ * Finishes an asynchronous operation started with webkit_web_view_get_tiled_snapshot().
+ *
+ * Returns: %TRUE if all the tiles of the snapshot were received or %FALSE in case of error.
+ *
+ * Since: 2.20
+ */
+gboolean webkit_web_view_get_tiled_snapshot_finish(WebKitWebView* webView, GAsyncResult* result, GError** error)
+{
+    g_return_val_if_fail(WEBKIT_IS_WEB_VIEW(webView), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, webView), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), error);
+}
+
 void webkitWebViewWebProcessCrashed(WebKitWebView* webView)
 {
     gboolean returnValue;
@@ -186,6 +186,27 @@ typedef enum {
   WEBKIT_SNAPSHOT_REGION_FULL_DOCUMENT,
 } WebKitSnapshotRegion;
 
+/**
+ * WebKitSnapshotTileCallback:
+ * @web_view: the #WebKitWebView
+ * @data: a #GBytes with the PNG data of the tile
+ * @tile_rect: the area of the snapshot covered by the tile, in pixels
+ * @tile_index: the index of the tile
+ * @n_tiles: the number of tiles of the snapshot
+ * @user_data: user data passed to the callback
+ *
+ * Type definition for a function that will be called back with each tile
+ * of a snapshot requested with webkit_web_view_get_tiled_snapshot().
+ *
+ * Since: 2.20
+ */
+typedef void (* WebKitSnapshotTileCallback) (WebKitWebView               *web_view,
+                                             GBytes                      *data,
+                                             const cairo_rectangle_int_t *tile_rect,
+                                             guint                        tile_index,
+                                             guint                        n_tiles,
+                                             gpointer                     user_data);
+
 struct _WebKitWebView {
     WebKitWebViewBase parent;
 
@@ -497,6 +518,22 @@ webkit_web_view_get_snapshot_finish                  (WebKitWebView
                                                       GAsyncResult              *result,
                                                       GError                   **error);
 
+WEBKIT_API void
+webkit_web_view_get_tiled_snapshot                   (WebKitWebView             *web_view,
+                                                      WebKitSnapshotOptions      options,
+                                                      guint                      tile_height,
+                                                      WebKitSnapshotTileCallback tile_callback,
+                                                      gpointer                   tile_user_data,
+                                                      GDestroyNotify             tile_user_data_destroy_func,
+                                                      GCancellable              *cancellable,
+                                                      GAsyncReadyCallback        callback,
+                                                      gpointer                   user_data);
+
+WEBKIT_API gboolean
+webkit_web_view_get_tiled_snapshot_finish            (WebKitWebView             *web_view,
+                                                      GAsyncResult              *result,
+                                                      GError                   **error);
+
 WEBKIT_API WebKitUserContentManager *
 webkit_web_view_get_user_content_manager             (WebKitWebView             *web_view);
 
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// PageLoadBenchmark loads a corpus of URLs from a network capture in replay
+// mode and reports how long each phase of the load took, along with the number
+// of IPC messages the UI process received per message receiver. Nothing is
+// fetched from the network: requests missing from the capture fail.
+//
+// Usage: PageLoadBenchmark --capture-directory <directory> [--iterations <count>]
+//            [--timeout <seconds>] [--recorded-timing] [--output <file>]
+//            <URL or file of URLs>...
+//
+// The capture directory is the WebKitRecordReplayCacheLocation that the corpus
+// was recorded into. Results are written as JSON so they can be compared
+// across builds.
+
+#import <Cocoa/Cocoa.h>
+#import <WebKit/WKNavigationDelegate.h>
+#import <WebKit/WKProcessPoolPrivate.h>
+#import <WebKit/WKWebViewConfiguration.h>
+#import <WebKit/WKWebViewPrivate.h>
+#import <WebKit/WKWebsiteDataStore.h>
+#import <WebKit/_WKProcessPoolConfiguration.h>
+
+static const NSTimeInterval defaultTimeout = 60;
+static const NSRect viewRect = { { 0, 0 }, { 1024, 768 } };
+
+@interface PageLoadBenchmarkLoad : NSObject <WKNavigationDelegate>
+@property (nonatomic, readonly) NSTimeInterval navigationStart;
+@property (nonatomic, readonly) NSMutableDictionary<NSString *, NSNumber *> *phases;
+@property (nonatomic, readonly) NSString *error;
+@property (nonatomic, readonly, getter=isComplete) BOOL complete;
+- (void)startWithWebView:(WKWebView *)webView URL:(NSURL *)url;
+@end
+
+@implementation PageLoadBenchmarkLoad {
+    BOOL _didFinishLoad;
+    BOOL _didFlushLayers;
+}
+
+- (void)startWithWebView:(WKWebView *)webView URL:(NSURL *)url
+{
+    _phases = [NSMutableDictionary dictionary];
+    webView.navigationDelegate = self;
+    _navigationStart = [NSProcessInfo processInfo].systemUptime;
+    [webView loadRequest:[NSURLRequest requestWithURL:url]];
+}
+
+- (void)recordPhase:(NSString *)phase
+{
+    // Only the first occurrence counts; redirects and subframes can repeat phases.
+    if (_phases[phase])
+        return;
+
+    NSTimeInterval elapsed = [NSProcessInfo processInfo].systemUptime - _navigationStart;
+    _phases[phase] = @(elapsed * 1000);
+}
+
+- (void)failWithError:(NSError *)error
+{
+    _error = error.localizedDescription ?: @"Unknown error";
+    _complete = YES;
+}
+
+- (void)webView:(WKWebView *)webView didStartProvisionalNavigation:(WKNavigation *)navigation
+{
+    [self recordPhase:@"didStartProvisionalLoadForFrame"];
+}
+
+- (void)webView:(WKWebView *)webView decidePolicyForNavigationResponse:(WKNavigationResponse *)navigationResponse decisionHandler:(void (^)(WKNavigationResponsePolicy))decisionHandler
+{
+    if (navigationResponse.isForMainFrame)
+        [self recordPhase:@"responseReceived"];
+    decisionHandler(WKNavigationResponsePolicyAllow);
+}
+
+- (void)webView:(WKWebView *)webView didCommitNavigation:(WKNavigation *)navigation
+{
+    [self recordPhase:@"didCommitLoadForFrame"];
+
+    [webView _doAfterNextPresentationUpdate:^{
+        [self recordPhase:@"firstLayerFlush"];
+        _didFlushLayers = YES;
+        _complete = _didFinishLoad;
+    }];
+}
+
+- (void)webView:(WKWebView *)webView didFinishNavigation:(WKNavigation *)navigation
+{
+    [self recordPhase:@"loadComplete"];
+    _didFinishLoad = YES;
+    _complete = _didFlushLayers;
+}
+
+- (void)webView:(WKWebView *)webView didFailProvisionalNavigation:(WKNavigation *)navigation withError:(NSError *)error
+{
+    [self failWithError:error];
+}
+
+- (void)webView:(WKWebView *)webView didFailNavigation:(WKNavigation *)navigation withError:(NSError *)error
+{
+    [self failWithError:error];
+}
+
+- (void)webViewWebContentProcessDidTerminate:(WKWebView *)webView
+{
+    _error = @"Web content process terminated";
+    _complete = YES;
+}
+
+@end
+
+static void printUsageAndExit()
+{
+    fprintf(stderr, "Usage: PageLoadBenchmark --capture-directory <directory> [--iterations <count>] [--timeout <seconds>] [--recorded-timing] [--output <file>] <URL or file of URLs>...\n");
+    exit(EXIT_FAILURE);
+}
+
+static void addURLsFromArgument(NSString *argument, NSMutableArray<NSURL *> *urls)
+{
+    BOOL isDirectory = NO;
+    if (![[NSFileManager defaultManager] fileExistsAtPath:argument isDirectory:&isDirectory] || isDirectory) {
+        NSURL *url = [NSURL URLWithString:argument];
+        if (!url.scheme) {
+            fprintf(stderr, "Not a URL or a corpus file: %s\n", argument.UTF8String);
+            exit(EXIT_FAILURE);
+        }
+        [urls addObject:url];
+        return;
+    }
+
+    NSError *error = nil;
+    NSString *corpus = [NSString stringWithContentsOfFile:argument encoding:NSUTF8StringEncoding error:&error];
+    if (!corpus) {
+        fprintf(stderr, "Could not read corpus %s: %s\n", argument.UTF8String, error.localizedDescription.UTF8String);
+        exit(EXIT_FAILURE);
+    }
+
+    for (NSString *line in [corpus componentsSeparatedByCharactersInSet:[NSCharacterSet newlineCharacterSet]]) {
+        NSString *trimmedLine = [line stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+        if (!trimmedLine.length || [trimmedLine hasPrefix:@"#"])
+            continue;
+        if (NSURL *url = [NSURL URLWithString:trimmedLine])
+            [urls addObject:url];
+    }
+}
+
+static void setNetworkCaptureReplayDefaults(NSString *captureDirectory, BOOL usesRecordedTiming)
+{
+    // The network process is configured from the UI process's defaults, so
+    // override them for this process only through the argument domain.
+    NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *argumentDomain = [[defaults volatileDomainForName:NSArgumentDomain] mutableCopy] ?: [NSMutableDictionary dictionary];
+    argumentDomain[@"WebKitRecordReplayMode"] = @"replay";
+    argumentDomain[@"WebKitRecordReplayCacheLocation"] = captureDirectory;
+    argumentDomain[@"WebKitRecordReplayUsesRecordedTiming"] = @(usesRecordedTiming);
+
+    [defaults removeVolatileDomainForName:NSArgumentDomain];
+    [defaults setVolatileDomain:argumentDomain forName:NSArgumentDomain];
+}
+
+static NSDictionary *runLoad(WKWebViewConfiguration *configuration, NSWindow *window, NSURL *url, NSUInteger iteration, NSTimeInterval timeout)
+{
+    WKWebView *webView = [[WKWebView alloc] initWithFrame:viewRect configuration:configuration];
+    [window.contentView addSubview:webView];
+
+    [WKProcessPool _resetIPCMessageCounts];
+
+    PageLoadBenchmarkLoad *load = [[PageLoadBenchmarkLoad alloc] init];
+    [load startWithWebView:webView URL:url];
+
+    NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:timeout];
+    while (!load.complete && [deadline timeIntervalSinceNow] > 0)
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+
+    NSMutableDictionary *result = [NSMutableDictionary dictionary];
+    result[@"url"] = url.absoluteString;
+    result[@"iteration"] = @(iteration);
+    result[@"phases"] = load.phases;
+    result[@"ipcMessageCountsByReceiver"] = [WKProcessPool _ipcMessageCountsByReceiver];
+    if (!load.complete)
+        result[@"error"] = @"Timed out";
+    else if (load.error)
+        result[@"error"] = load.error;
+
+    webView.navigationDelegate = nil;
+    [webView removeFromSuperview];
+    [webView _close];
+
+    return result;
+}
+
+int main(int argc, const char* argv[])
+{
+    @autoreleasepool {
+        NSString *captureDirectory = nil;
+        NSString *outputPath = nil;
+        NSUInteger iterations = 1;
+        NSTimeInterval timeout = defaultTimeout;
+        BOOL usesRecordedTiming = NO;
+        NSMutableArray<NSURL *> *urls = [NSMutableArray array];
+
+        for (int i = 1; i < argc; ++i) {
+            NSString *argument = @(argv[i]);
+            BOOL hasValue = i + 1 < argc;
+            if ([argument isEqualToString:@"--capture-directory"] && hasValue)
+                captureDirectory = [@(argv[++i]) stringByStandardizingPath];
+            else if ([argument isEqualToString:@"--output"] && hasValue)
+                outputPath = @(argv[++i]);
+            else if ([argument isEqualToString:@"--iterations"] && hasValue)
+                iterations = MAX(atoi(argv[++i]), 1);
+            else if ([argument isEqualToString:@"--timeout"] && hasValue)
+                timeout = MAX(atof(argv[++i]), 1.0);
+            else if ([argument isEqualToString:@"--recorded-timing"])
+                usesRecordedTiming = YES;
+            else if ([argument hasPrefix:@"--"])
+                printUsageAndExit();
+            else
+                addURLsFromArgument(argument, urls);
+        }
+
+        if (!captureDirectory || !urls.count)
+            printUsageAndExit();
+
+        setNetworkCaptureReplayDefaults(captureDirectory, usesRecordedTiming);
+
+        [NSApplication sharedApplication];
+        [NSApp setActivationPolicy:NSApplicationActivationPolicyProhibited];
+
+        // Views must be in a window to paint, but the window never needs to be on screen.
+        NSWindow *window = [[NSWindow alloc] initWithContentRect:NSOffsetRect(viewRect, -10000, -10000) styleMask:NSWindowStyleMaskBorderless backing:NSBackingStoreBuffered defer:NO];
+        window.releasedWhenClosed = NO;
+        [window orderBack:nil];
+
+        WKWebViewConfiguration *configuration = [[WKWebViewConfiguration alloc] init];
+        configuration.processPool = [[WKProcessPool alloc] _initWithConfiguration:[[_WKProcessPoolConfiguration alloc] init]];
+        configuration.websiteDataStore = [WKWebsiteDataStore nonPersistentDataStore];
+
+        [WKProcessPool _setIPCMessageCountingEnabled:YES];
+
+        NSMutableArray *results = [NSMutableArray array];
+        for (NSUInteger iteration = 0; iteration < iterations; ++iteration) {
+            for (NSURL *url in urls)
+                [results addObject:runLoad(configuration, window, url, iteration, timeout)];
+        }
+
+        [window close];
+
+        NSDictionary *report = @{
+            @"captureDirectory": captureDirectory,
+            @"iterations": @(iterations),
+            @"usesRecordedTiming": @(usesRecordedTiming),
+            @"results": results,
+        };
+
+        NSError *error = nil;
+        NSData *json = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:&error];
+        if (!json) {
+            fprintf(stderr, "Could not serialize results: %s\n", error.localizedDescription.UTF8String);
+            return EXIT_FAILURE;
+        }
+
+        if (!outputPath) {
+            fwrite(json.bytes, 1, json.length, stdout);
+            fputc('\n', stdout);
+        } else if (![json writeToFile:outputPath options:NSDataWritingAtomic error:&error]) {
+            fprintf(stderr, "Could not write %s: %s\n", outputPath.UTF8String, error.localizedDescription.UTF8String);
+            return EXIT_FAILURE;
+        }
+
+        BOOL allLoadsSucceeded = YES;
+        for (NSDictionary *result in results)
+            allLoadsSucceeded &= !result[@"error"];
+        return allLoadsSucceeded ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+}
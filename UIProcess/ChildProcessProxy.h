@@ -104,7 +104,7 @@ bool ChildProcessProxy::send(T&& message, uint64_t destinationID, OptionSet<IPC:
 {
     COMPILE_ASSERT(!T::isSync, AsyncMessageExpected);
 
-    auto encoder = std::make_unique<IPC::Encoder>(T::receiverName(), T::name(), destinationID);
+    auto encoder = m_connection ? m_connection->createEncoder(T::receiverName(), T::name(), destinationID) : std::make_unique<IPC::Encoder>(T::receiverName(), T::name(), destinationID);
     encoder->encode(message.arguments());
 
     return sendMessage(WTFMove(encoder), sendOptions);
@@ -90,6 +90,7 @@ static NSString * const WebKitNetworkLoadThrottleLatencyMillisecondsDefaultsKey
 #if ENABLE(NETWORK_CAPTURE)
 static NSString * const WebKitRecordReplayModeDefaultsKey = @"WebKitRecordReplayMode";
 static NSString * const WebKitRecordReplayCacheLocationDefaultsKey = @"WebKitRecordReplayCacheLocation";
+static NSString * const WebKitRecordReplayUsesRecordedTimingDefaultsKey = @"WebKitRecordReplayUsesRecordedTiming";
 #endif
 
 namespace WebKit {
@@ -304,6 +305,7 @@ void WebProcessPool::platformInitializeNetworkProcess(NetworkProcessCreationPara
     parameters.recordReplayCacheLocation = [defaults stringForKey:WebKitRecordReplayCacheLocationDefaultsKey];
     if (parameters.recordReplayCacheLocation.isEmpty())
         parameters.recordReplayCacheLocation = parameters.diskCacheDirectory;
+    parameters.recordReplayUsesRecordedTiming = [defaults boolForKey:WebKitRecordReplayUsesRecordedTimingDefaultsKey];
 #endif
 }
 
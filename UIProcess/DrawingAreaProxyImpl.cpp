@@ -119,8 +119,12 @@ void DrawingAreaProxyImpl::setBackingStoreIsDiscardable(bool isBackingStoreDisca
 void DrawingAreaProxyImpl::update(uint64_t backingStoreStateID, const UpdateInfo& updateInfo)
 {
     ASSERT_ARG(backingStoreStateID, backingStoreStateID <= m_currentBackingStoreStateID);
-    if (backingStoreStateID < m_currentBackingStoreStateID)
+    if (backingStoreStateID < m_currentBackingStoreStateID) {
+        // Keep the mapping of a new pooled buffer, later updates only refer to it by index.
+        updateBitmap(updateInfo);
+        returnUpdateBitmap(updateInfo);
         return;
+    }
 
     // FIXME: Handle the case where the view is hidden.
 
@@ -133,6 +137,8 @@ void DrawingAreaProxyImpl::didUpdateBackingStoreState(uint64_t backingStoreState
     AcceleratedDrawingAreaProxy::didUpdateBackingStoreState(backingStoreStateID, updateInfo, layerTreeContext);
     if (isInAcceleratedCompositingMode()) {
         ASSERT(!m_backingStore);
+        updateBitmap(updateInfo);
+        returnUpdateBitmap(updateInfo);
         return;
     }
 
@@ -145,8 +151,11 @@ void DrawingAreaProxyImpl::didUpdateBackingStoreState(uint64_t backingStoreState
 void DrawingAreaProxyImpl::exitAcceleratedCompositingMode(uint64_t backingStoreStateID, const UpdateInfo& updateInfo)
 {
     ASSERT_ARG(backingStoreStateID, backingStoreStateID <= m_currentBackingStoreStateID);
-    if (backingStoreStateID < m_currentBackingStoreStateID)
+    if (backingStoreStateID < m_currentBackingStoreStateID) {
+        updateBitmap(updateInfo);
+        returnUpdateBitmap(updateInfo);
         return;
+    }
 
     AcceleratedDrawingAreaProxy::exitAcceleratedCompositingMode();
 
@@ -157,13 +166,17 @@ void DrawingAreaProxyImpl::incorporateUpdate(const UpdateInfo& updateInfo)
 {
     ASSERT(!isInAcceleratedCompositingMode());
 
-    if (updateInfo.updateRectBounds.isEmpty())
+    auto bitmap = updateBitmap(updateInfo);
+    if (updateInfo.updateRectBounds.isEmpty() || !bitmap) {
+        returnUpdateBitmap(updateInfo);
         return;
+    }
 
     if (!m_backingStore)
         m_backingStore = std::make_unique<BackingStore>(updateInfo.viewSize, updateInfo.deviceScaleFactor, m_webPageProxy);
 
-    m_backingStore->incorporateUpdate(updateInfo);
+    m_backingStore->incorporateUpdate(bitmap.get(), updateInfo);
+    returnUpdateBitmap(updateInfo);
 
     Region damageRegion;
     if (updateInfo.scrollRect.isEmpty()) {
@@ -174,6 +187,39 @@ void DrawingAreaProxyImpl::incorporateUpdate(const UpdateInfo& updateInfo)
     m_webPageProxy.setViewNeedsDisplay(damageRegion);
 }
 
+RefPtr<ShareableBitmap> DrawingAreaProxyImpl::updateBitmap(const UpdateInfo& updateInfo)
+{
+    if (!updateInfo.bitmapPoolIndex)
+        return updateInfo.bitmapHandle.isNull() ? nullptr : ShareableBitmap::create(updateInfo.bitmapHandle);
+
+    unsigned index = *updateInfo.bitmapPoolIndex;
+    if (!updateInfo.bitmapHandle.isNull()) {
+        // First use of this buffer, or the web process reallocated it.
+        auto bitmap = ShareableBitmap::create(updateInfo.bitmapHandle);
+        if (!bitmap)
+            return nullptr;
+        if (index >= m_updateBitmapPool.size())
+            m_updateBitmapPool.grow(index + 1);
+        m_updateBitmapPool[index] = bitmap->sharedMemory();
+        return bitmap;
+    }
+
+    if (index >= m_updateBitmapPool.size() || !m_updateBitmapPool[index])
+        return nullptr;
+
+    IntSize bitmapSize = updateInfo.updateRectBounds.size();
+    bitmapSize.scale(updateInfo.deviceScaleFactor);
+    return ShareableBitmap::create(bitmapSize, ShareableBitmap::SupportsAlpha, m_updateBitmapPool[index]);
+}
+
+void DrawingAreaProxyImpl::returnUpdateBitmap(const UpdateInfo& updateInfo)
+{
+    if (!updateInfo.bitmapPoolIndex)
+        return;
+
+    m_webPageProxy.process().send(Messages::DrawingArea::ReturnUpdateBitmap(*updateInfo.bitmapPoolIndex), m_webPageProxy.pageID());
+}
+
 void DrawingAreaProxyImpl::enterAcceleratedCompositingMode(const LayerTreeContext& layerTreeContext)
 {
     m_backingStore = nullptr;
@@ -37,6 +37,9 @@ class Region;
 
 namespace WebKit {
 
+class ShareableBitmap;
+class SharedMemory;
+
 class DrawingAreaProxyImpl final : public AcceleratedDrawingAreaProxy {
 public:
     explicit DrawingAreaProxyImpl(WebPageProxy&);
@@ -54,6 +57,8 @@ private:
     void exitAcceleratedCompositingMode(uint64_t backingStoreStateID, const UpdateInfo&) override;
 
     void incorporateUpdate(const UpdateInfo&);
+    RefPtr<ShareableBitmap> updateBitmap(const UpdateInfo&);
+    void returnUpdateBitmap(const UpdateInfo&);
 
     void enterAcceleratedCompositingMode(const LayerTreeContext&) override;
 
@@ -84,6 +89,9 @@ private:
 
     bool m_isBackingStoreDiscardable { true };
     std::unique_ptr<BackingStore> m_backingStore;
+
+    // Mappings of the web process update bitmap buffers, indexed by UpdateInfo::bitmapPoolIndex.
+    Vector<RefPtr<SharedMemory>> m_updateBitmapPool;
     RunLoop::Timer<DrawingAreaProxyImpl> m_discardBackingStoreTimer;
     std::unique_ptr<DrawingMonitor> m_drawingMonitor;
 };
@@ -31,6 +31,7 @@
 #include <WebCore/SQLiteStatement.h>
 #include <WebCore/SQLiteTransaction.h>
 #include <WebCore/SecurityOrigin.h>
+#include <WebCore/SharedBuffer.h>
 #include <WebCore/StorageMap.h>
 #include <WebCore/SuddenTermination.h>
 #include <wtf/RefPtr.h>
@@ -38,20 +39,36 @@
 #include <wtf/text/StringHash.h>
 #include <wtf/text/WTFString.h>
 
+#if OS(UNIX)
+#include <unistd.h>
+#endif
+
 using namespace WebCore;
 
-static const auto databaseUpdateInterval = 1_s;
+// With LocalStorageDurability::Interval, changes reach the change log at most this long after they are made.
+static const auto changeLogFlushInterval = 1_s;
+
+// The change log is folded into the database this long after the first change that is not in the database yet,
+// or as soon as it grows past maximumChangeLogSize.
+static const auto changeLogCompactionInterval = 10_s;
+static const uint64_t maximumChangeLogSize = 1024 * 1024;
 
-static const int maximumItemsToUpdate = 100;
+static const uint32_t changeLogVersion = 1;
+static const uint32_t is8BitStringFlag = 1u << 31;
 
 namespace WebKit {
 
-Ref<LocalStorageDatabase> LocalStorageDatabase::create(Ref<WorkQueue>&& queue, Ref<LocalStorageDatabaseTracker>&& tracker, const SecurityOriginData& securityOrigin)
+Ref<LocalStorageDatabase> LocalStorageDatabase::create(Ref<WorkQueue>&& queue, Ref<LocalStorageDatabaseTracker>&& tracker, const SecurityOriginData& securityOrigin, LocalStorageDurability durability)
+{
+    return adoptRef(*new LocalStorageDatabase(WTFMove(queue), WTFMove(tracker), securityOrigin, durability));
+}
+
+String LocalStorageDatabase::changeLogPath(const String& databasePath)
 {
-    return adoptRef(*new LocalStorageDatabase(WTFMove(queue), WTFMove(tracker), securityOrigin));
+    return databasePath + "-log";
 }
 
-LocalStorageDatabase::LocalStorageDatabase(Ref<WorkQueue>&& queue, Ref<LocalStorageDatabaseTracker>&& tracker, const SecurityOriginData& securityOrigin)
+LocalStorageDatabase::LocalStorageDatabase(Ref<WorkQueue>&& queue, Ref<LocalStorageDatabaseTracker>&& tracker, const SecurityOriginData& securityOrigin, LocalStorageDurability durability)
     : m_queue(WTFMove(queue))
     , m_tracker(WTFMove(tracker))
     , m_securityOrigin(securityOrigin)
@@ -61,6 +78,8 @@ LocalStorageDatabase::LocalStorageDatabase(Ref<WorkQueue>&& queue, Ref<LocalStor
     , m_isClosed(false)
     , m_didScheduleDatabaseUpdate(false)
     , m_shouldClearItems(false)
+    , m_durability(durability)
+    , m_changeLogPath(changeLogPath(m_databasePath))
 {
 }
 
@@ -167,30 +186,57 @@ void LocalStorageDatabase::importItems(StorageMap& storageMap)
     // there's really no good way to recover other than not importing anything.
     m_didImportItems = true;
 
+    HashMap<String, String> items;
+
     openDatabase(SkipIfNonExistent);
-    if (!m_database.isOpen())
-        return;
+    if (m_database.isOpen()) {
+        SQLiteStatement query(m_database, "SELECT key, value FROM ItemTable");
+        if (query.prepare() != SQLITE_OK) {
+            LOG_ERROR("Unable to select items from ItemTable for local storage");
+            return;
+        }
 
-    SQLiteStatement query(m_database, "SELECT key, value FROM ItemTable");
-    if (query.prepare() != SQLITE_OK) {
-        LOG_ERROR("Unable to select items from ItemTable for local storage");
-        return;
-    }
+        int result = query.step();
+        while (result == SQLITE_ROW) {
+            String key = query.getColumnText(0);
+            String value = query.getColumnBlobAsString(1);
+            if (!key.isNull() && !value.isNull())
+                items.set(key, value);
+            result = query.step();
+        }
 
-    HashMap<String, String> items;
+        if (result != SQLITE_DONE) {
+            LOG_ERROR("Error reading items from ItemTable for local storage");
+            return;
+        }
+    }
 
-    int result = query.step();
-    while (result == SQLITE_ROW) {
-        String key = query.getColumnText(0);
-        String value = query.getColumnBlobAsString(1);
-        if (!key.isNull() && !value.isNull())
-            items.set(key, value);
-        result = query.step();
+    // A change log is left behind when we did not get to close the database, for instance because the process crashed.
+    // Fold it into the database before logging anything new, and keep it around if that fails so that nothing is lost.
+    bool shouldRelogReplayedChanges = false;
+    if (replayChangeLog(items)) {
+        if (writeChangedItemsToDatabase())
+            deleteFile(m_changeLogPath);
+        else {
+            LOG_ERROR("Failed to write the local storage change log %s to the database, keeping it to replay next time", m_changeLogPath.utf8().data());
+            shouldRelogReplayedChanges = true;
+        }
     }
 
-    if (result != SQLITE_DONE) {
-        LOG_ERROR("Error reading items from ItemTable for local storage");
-        return;
+    m_canUseChangeLog = m_durability != LocalStorageDurability::OnClose;
+
+    if (shouldRelogReplayedChanges) {
+        // The log is rewritten from the start when it is next opened, so the replayed changes that are
+        // still waiting in m_changedItems go back into it ahead of any new ones.
+        if (m_shouldClearItems)
+            appendToChangeLog(ChangeLogRecordType::Clear);
+        for (auto& item : m_changedItems) {
+            if (item.value.isNull())
+                appendToChangeLog(ChangeLogRecordType::RemoveItem, item.key);
+            else
+                appendToChangeLog(ChangeLogRecordType::SetItem, item.key, item.value);
+        }
+        scheduleDatabaseUpdate();
     }
 
     storageMap.importItems(items);
@@ -211,6 +257,7 @@ void LocalStorageDatabase::clear()
     m_changedItems.clear();
     m_shouldClearItems = true;
 
+    appendToChangeLog(ChangeLogRecordType::Clear);
     scheduleDatabaseUpdate();
 }
 
@@ -219,10 +266,19 @@ void LocalStorageDatabase::close()
     ASSERT(!m_isClosed);
     m_isClosed = true;
 
-    if (m_didScheduleDatabaseUpdate) {
-        updateDatabaseWithChangedItems(m_changedItems);
-        m_changedItems.clear();
-    }
+    // Get whatever has not been logged yet on disk first, in case writing to the database fails.
+    if (!m_pendingChangeLogRecords.isEmpty())
+        writeChangeLogRecords();
+
+    bool didWriteChangedItems = true;
+    if (!m_changedItems.isEmpty() || m_shouldClearItems)
+        didWriteChangedItems = writeChangedItemsToDatabase();
+
+    closeChangeLog();
+    if (didWriteChangedItems)
+        deleteFile(m_changeLogPath);
+
+    m_disableSuddenTerminationWhileWritingToLocalStorage = nullptr;
 
     bool isEmpty = databaseIsEmpty();
 
@@ -236,21 +292,244 @@ void LocalStorageDatabase::close()
 void LocalStorageDatabase::itemDidChange(const String& key, const String& value)
 {
     m_changedItems.set(key, value);
+
+    // A null value means that the key/value pair should be deleted.
+    if (value.isNull())
+        appendToChangeLog(ChangeLogRecordType::RemoveItem, key);
+    else
+        appendToChangeLog(ChangeLogRecordType::SetItem, key, value);
+
     scheduleDatabaseUpdate();
 }
 
-void LocalStorageDatabase::scheduleDatabaseUpdate()
+static void appendString(Vector<uint8_t>& buffer, const String& string)
 {
-    if (m_didScheduleDatabaseUpdate)
-        return;
+    uint32_t header = string.length();
+    if (string.is8Bit())
+        header |= is8BitStringFlag;
+    buffer.append(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+
+    if (string.is8Bit())
+        buffer.append(string.characters8(), string.length());
+    else
+        buffer.append(reinterpret_cast<const uint8_t*>(string.characters16()), string.length() * sizeof(UChar));
+}
+
+static bool readString(const uint8_t*& data, const uint8_t* end, String& string)
+{
+    uint32_t header;
+    if (static_cast<size_t>(end - data) < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    data += sizeof(header);
+
+    bool is8Bit = header & is8BitStringFlag;
+    size_t length = header & ~is8BitStringFlag;
+    size_t characterSize = is8Bit ? sizeof(LChar) : sizeof(UChar);
+    if (static_cast<size_t>(end - data) / characterSize < length)
+        return false;
+
+    if (is8Bit)
+        string = String(data, length);
+    else {
+        UChar* characters;
+        string = String::createUninitialized(length, characters);
+        memcpy(characters, data, length * sizeof(UChar));
+    }
+    data += length * characterSize;
+    return true;
+}
 
+void LocalStorageDatabase::appendToChangeLog(ChangeLogRecordType type, const String& key, const String& value)
+{
     if (!m_disableSuddenTerminationWhileWritingToLocalStorage)
         m_disableSuddenTerminationWhileWritingToLocalStorage = std::make_unique<SuddenTerminationDisabler>();
 
+    if (!m_canUseChangeLog)
+        return;
+
+    // Each record is preceded by its size so that a record that was only partially written can be detected when replaying.
+    size_t sizeOffset = m_pendingChangeLogRecords.size();
+    m_pendingChangeLogRecords.grow(sizeOffset + sizeof(uint32_t));
+    m_pendingChangeLogRecords.append(static_cast<uint8_t>(type));
+    if (type != ChangeLogRecordType::Clear)
+        appendString(m_pendingChangeLogRecords, key);
+    if (type == ChangeLogRecordType::SetItem)
+        appendString(m_pendingChangeLogRecords, value);
+
+    uint32_t recordSize = m_pendingChangeLogRecords.size() - sizeOffset - sizeof(uint32_t);
+    memcpy(m_pendingChangeLogRecords.data() + sizeOffset, &recordSize, sizeof(recordSize));
+
+    scheduleChangeLogFlush();
+}
+
+void LocalStorageDatabase::scheduleChangeLogFlush()
+{
+    if (m_didScheduleChangeLogFlush)
+        return;
+
+    m_didScheduleChangeLogFlush = true;
+
+    RefPtr<LocalStorageDatabase> localStorageDatabase(this);
+    auto flush = [localStorageDatabase] {
+        localStorageDatabase->flushChangeLog();
+    };
+
+    // Changes that are made before the flush gets to run are written and synced together.
+    if (m_durability == LocalStorageDurability::PerWrite)
+        m_queue->dispatch(WTFMove(flush));
+    else
+        m_queue->dispatchAfter(changeLogFlushInterval, WTFMove(flush));
+}
+
+void LocalStorageDatabase::flushChangeLog()
+{
+    if (m_isClosed)
+        return;
+
+    ASSERT(m_didScheduleChangeLogFlush);
+    m_didScheduleChangeLogFlush = false;
+
+    if (m_pendingChangeLogRecords.isEmpty())
+        return;
+
+    if (!writeChangeLogRecords())
+        return;
+
+    // Once everything is in the log there is nothing left to lose.
+    m_disableSuddenTerminationWhileWritingToLocalStorage = nullptr;
+
+    if (m_changeLogSize >= maximumChangeLogSize)
+        compactChangeLog();
+}
+
+bool LocalStorageDatabase::writeChangeLogRecords()
+{
+    ASSERT(m_canUseChangeLog);
+
+    if (m_changeLogHandle == invalidPlatformFileHandle) {
+        // The database is created along with the log so that the tracker knows about this origin, and deleting its data also deletes the log.
+        if (!m_database.isOpen() && !m_failedToOpenDatabase)
+            openDatabase(CreateIfNonExistent);
+        if (m_database.isOpen())
+            m_changeLogHandle = openFile(m_changeLogPath, OpenForWrite);
+
+        if (m_changeLogHandle == invalidPlatformFileHandle
+            || writeToFile(m_changeLogHandle, reinterpret_cast<const char*>(&changeLogVersion), sizeof(changeLogVersion)) != sizeof(changeLogVersion)) {
+            LOG_ERROR("Failed to create the local storage change log %s", m_changeLogPath.utf8().data());
+            // The changes are still written to the database when it is compacted or closed.
+            closeChangeLog();
+            m_canUseChangeLog = false;
+            m_pendingChangeLogRecords.clear();
+            return false;
+        }
+        m_changeLogSize = sizeof(changeLogVersion);
+    }
+
+    int64_t size = m_pendingChangeLogRecords.size();
+    bool didWriteRecords = writeToFile(m_changeLogHandle, reinterpret_cast<const char*>(m_pendingChangeLogRecords.data()), size) == size;
+#if OS(UNIX)
+    if (didWriteRecords)
+        didWriteRecords = !fsync(m_changeLogHandle);
+#endif
+    m_pendingChangeLogRecords.clear();
+
+    if (!didWriteRecords) {
+        LOG_ERROR("Failed to write to the local storage change log %s", m_changeLogPath.utf8().data());
+        closeChangeLog();
+        m_canUseChangeLog = false;
+        return false;
+    }
+
+    m_changeLogSize += size;
+    return true;
+}
+
+bool LocalStorageDatabase::replayChangeLog(HashMap<String, String>& items)
+{
+    if (!fileExists(m_changeLogPath))
+        return false;
+
+    auto buffer = SharedBuffer::createWithContentsOfFile(m_changeLogPath);
+    if (!buffer)
+        return false;
+
+    auto* data = reinterpret_cast<const uint8_t*>(buffer->data());
+    auto* end = data + buffer->size();
+
+    uint32_t version;
+    if (buffer->size() < sizeof(version))
+        return true;
+    memcpy(&version, data, sizeof(version));
+    if (version != changeLogVersion) {
+        LOG_ERROR("Ignoring local storage change log %s with unknown version %u", m_changeLogPath.utf8().data(), version);
+        return true;
+    }
+    data += sizeof(version);
+
+    while (static_cast<size_t>(end - data) >= sizeof(uint32_t)) {
+        uint32_t recordSize;
+        memcpy(&recordSize, data, sizeof(recordSize));
+        data += sizeof(recordSize);
+
+        // Anything after a record that was only partially written never made it to disk.
+        if (!recordSize || static_cast<size_t>(end - data) < recordSize)
+            break;
+
+        auto* recordEnd = data + recordSize;
+        if (*data > static_cast<uint8_t>(ChangeLogRecordType::Clear)) {
+            LOG_ERROR("Unknown record in local storage change log %s", m_changeLogPath.utf8().data());
+            return true;
+        }
+        auto type = static_cast<ChangeLogRecordType>(*data++);
+
+        String key;
+        String value;
+        switch (type) {
+        case ChangeLogRecordType::SetItem:
+            if (!readString(data, recordEnd, key) || !readString(data, recordEnd, value))
+                return true;
+            items.set(key, value);
+            m_changedItems.set(key, value);
+            break;
+        case ChangeLogRecordType::RemoveItem:
+            if (!readString(data, recordEnd, key))
+                return true;
+            items.remove(key);
+            m_changedItems.set(key, String());
+            break;
+        case ChangeLogRecordType::Clear:
+            items.clear();
+            m_changedItems.clear();
+            m_shouldClearItems = true;
+            break;
+        }
+        data = recordEnd;
+    }
+
+    return true;
+}
+
+void LocalStorageDatabase::closeChangeLog()
+{
+    if (m_changeLogHandle == invalidPlatformFileHandle)
+        return;
+
+    closeFile(m_changeLogHandle);
+    m_changeLogHandle = invalidPlatformFileHandle;
+    m_changeLogSize = 0;
+}
+
+void LocalStorageDatabase::scheduleDatabaseUpdate()
+{
+    // With LocalStorageDurability::OnClose, changes are only written when the database is closed.
+    if (m_didScheduleDatabaseUpdate || m_durability == LocalStorageDurability::OnClose)
+        return;
+
     m_didScheduleDatabaseUpdate = true;
 
     RefPtr<LocalStorageDatabase> localStorageDatabase(this);
-    m_queue->dispatchAfter(databaseUpdateInterval, [localStorageDatabase] {
+    m_queue->dispatchAfter(changeLogCompactionInterval, [localStorageDatabase] {
         localStorageDatabase->updateDatabase();
     });
 }
@@ -263,66 +542,74 @@ void LocalStorageDatabase::updateDatabase()
     ASSERT(m_didScheduleDatabaseUpdate);
     m_didScheduleDatabaseUpdate = false;
 
-    HashMap<String, String> changedItems;
-    if (m_changedItems.size() <= maximumItemsToUpdate) {
-        // There are few enough changed items that we can just always write all of them.
-        m_changedItems.swap(changedItems);
-        updateDatabaseWithChangedItems(changedItems);
-        m_disableSuddenTerminationWhileWritingToLocalStorage = nullptr;
-    } else {
-        for (int i = 0; i < maximumItemsToUpdate; ++i) {
-            auto it = m_changedItems.begin();
-            changedItems.add(it->key, it->value);
-
-            m_changedItems.remove(it);
-        }
+    if (!compactChangeLog())
+        scheduleDatabaseUpdate();
+}
 
-        ASSERT(changedItems.size() <= maximumItemsToUpdate);
+bool LocalStorageDatabase::compactChangeLog()
+{
+    // All changes since the log was last compacted are in m_changedItems, including the ones that have not been logged yet.
+    if (!writeChangedItemsToDatabase())
+        return false;
 
-        // Reschedule the update for the remaining items.
-        scheduleDatabaseUpdate();
-        updateDatabaseWithChangedItems(changedItems);
-    }
+    m_pendingChangeLogRecords.clear();
+    closeChangeLog();
+    deleteFile(m_changeLogPath);
+
+    m_disableSuddenTerminationWhileWritingToLocalStorage = nullptr;
+    return true;
 }
 
-void LocalStorageDatabase::updateDatabaseWithChangedItems(const HashMap<String, String>& changedItems)
+bool LocalStorageDatabase::writeChangedItemsToDatabase()
 {
-    if (!m_database.isOpen())
-        openDatabase(CreateIfNonExistent);
-    if (!m_database.isOpen())
-        return;
+    if (m_changedItems.isEmpty() && !m_shouldClearItems)
+        return true;
 
-    if (m_shouldClearItems) {
-        m_shouldClearItems = false;
+    if (!updateDatabaseWithChangedItems(m_changedItems))
+        return false;
 
-        SQLiteStatement clearStatement(m_database, "DELETE FROM ItemTable");
-        if (clearStatement.prepare() != SQLITE_OK) {
-            LOG_ERROR("Failed to prepare clear statement - cannot write to local storage database");
-            return;
-        }
+    m_changedItems.clear();
+    return true;
+}
 
-        int result = clearStatement.step();
-        if (result != SQLITE_DONE) {
-            LOG_ERROR("Failed to clear all items in the local storage database - %i", result);
-            return;
-        }
-    }
+bool LocalStorageDatabase::updateDatabaseWithChangedItems(const HashMap<String, String>& changedItems)
+{
+    if (!m_database.isOpen() && !m_failedToOpenDatabase)
+        openDatabase(CreateIfNonExistent);
+    if (!m_database.isOpen())
+        return false;
 
     SQLiteStatement insertStatement(m_database, "INSERT INTO ItemTable VALUES (?, ?)");
     if (insertStatement.prepare() != SQLITE_OK) {
         LOG_ERROR("Failed to prepare insert statement - cannot write to local storage database");
-        return;
+        return false;
     }
 
     SQLiteStatement deleteStatement(m_database, "DELETE FROM ItemTable WHERE key=?");
     if (deleteStatement.prepare() != SQLITE_OK) {
         LOG_ERROR("Failed to prepare delete statement - cannot write to local storage database");
-        return;
+        return false;
     }
 
     SQLiteTransaction transaction(m_database);
     transaction.begin();
 
+    if (m_shouldClearItems) {
+        SQLiteStatement clearStatement(m_database, "DELETE FROM ItemTable");
+        if (clearStatement.prepare() != SQLITE_OK) {
+            LOG_ERROR("Failed to prepare clear statement - cannot write to local storage database");
+            transaction.rollback();
+            return false;
+        }
+
+        int result = clearStatement.step();
+        if (result != SQLITE_DONE) {
+            LOG_ERROR("Failed to clear all items in the local storage database - %i", result);
+            transaction.rollback();
+            return false;
+        }
+    }
+
     for (auto it = changedItems.begin(), end = changedItems.end(); it != end; ++it) {
         // A null value means that the key/value pair should be deleted.
         SQLiteStatement& statement = it->value.isNull() ? deleteStatement : insertStatement;
@@ -336,13 +623,16 @@ void LocalStorageDatabase::updateDatabaseWithChangedItems(const HashMap<String,
         int result = statement.step();
         if (result != SQLITE_DONE) {
             LOG_ERROR("Failed to update item in the local storage database - %i", result);
-            break;
+            transaction.rollback();
+            return false;
         }
 
         statement.reset();
     }
 
     transaction.commit();
+    m_shouldClearItems = false;
+    return true;
 }
 
 bool LocalStorageDatabase::databaseIsEmpty()
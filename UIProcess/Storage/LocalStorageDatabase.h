@@ -25,12 +25,15 @@
 
 #pragma once
 
+#include "LocalStorageDurability.h"
+#include <WebCore/FileSystem.h>
 #include <WebCore/SQLiteDatabase.h>
 #include <WebCore/SecurityOriginData.h>
 #include <wtf/Forward.h>
 #include <wtf/HashMap.h>
 #include <wtf/RefPtr.h>
 #include <wtf/ThreadSafeRefCounted.h>
+#include <wtf/Vector.h>
 #include <wtf/WorkQueue.h>
 
 namespace WebCore {
@@ -45,9 +48,11 @@ class LocalStorageDatabaseTracker;
 
 class LocalStorageDatabase : public ThreadSafeRefCounted<LocalStorageDatabase> {
 public:
-    static Ref<LocalStorageDatabase> create(Ref<WorkQueue>&&, Ref<LocalStorageDatabaseTracker>&&, const WebCore::SecurityOriginData&);
+    static Ref<LocalStorageDatabase> create(Ref<WorkQueue>&&, Ref<LocalStorageDatabaseTracker>&&, const WebCore::SecurityOriginData&, LocalStorageDurability);
     ~LocalStorageDatabase();
 
+    static String changeLogPath(const String& databasePath);
+
     // Will block until the import is complete.
     void importItems(WebCore::StorageMap&);
 
@@ -59,7 +64,7 @@ public:
     void close();
 
 private:
-    LocalStorageDatabase(Ref<WorkQueue>&&, Ref<LocalStorageDatabaseTracker>&&, const WebCore::SecurityOriginData&);
+    LocalStorageDatabase(Ref<WorkQueue>&&, Ref<LocalStorageDatabaseTracker>&&, const WebCore::SecurityOriginData&, LocalStorageDurability);
 
     enum DatabaseOpeningStrategy {
         CreateIfNonExistent,
@@ -72,9 +77,23 @@ private:
 
     void itemDidChange(const String& key, const String& value);
 
+    enum class ChangeLogRecordType : uint8_t {
+        SetItem,
+        RemoveItem,
+        Clear
+    };
+    void appendToChangeLog(ChangeLogRecordType, const String& key = String(), const String& value = String());
+    void scheduleChangeLogFlush();
+    void flushChangeLog();
+    bool writeChangeLogRecords();
+    bool compactChangeLog();
+    bool replayChangeLog(HashMap<String, String>& items);
+    void closeChangeLog();
+
     void scheduleDatabaseUpdate();
     void updateDatabase();
-    void updateDatabaseWithChangedItems(const HashMap<String, String>&);
+    bool writeChangedItemsToDatabase();
+    bool updateDatabaseWithChangedItems(const HashMap<String, String>&);
 
     bool databaseIsEmpty();
 
@@ -92,6 +111,14 @@ private:
     bool m_shouldClearItems;
     HashMap<String, String> m_changedItems;
 
+    const LocalStorageDurability m_durability;
+    String m_changeLogPath;
+    WebCore::PlatformFileHandle m_changeLogHandle { WebCore::invalidPlatformFileHandle };
+    Vector<uint8_t> m_pendingChangeLogRecords;
+    uint64_t m_changeLogSize { 0 };
+    bool m_canUseChangeLog { false };
+    bool m_didScheduleChangeLogFlush { false };
+
     std::unique_ptr<WebCore::SuddenTerminationDisabler> m_disableSuddenTerminationWhileWritingToLocalStorage;
 };
 
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "LocalStorageDatabaseTracker.h"
 
+#include "LocalStorageDatabase.h"
 #include <WebCore/FileSystem.h>
 #include <WebCore/SQLiteFileSystem.h>
 #include <WebCore/SQLiteStatement.h>
@@ -95,7 +96,9 @@ void LocalStorageDatabaseTracker::deleteAllDatabases()
 
     int result;
     while ((result = statement.step()) == SQLITE_ROW) {
-        deleteFile(statement.getColumnText(1));
+        String path = statement.getColumnText(1);
+        deleteFile(path);
+        deleteFile(LocalStorageDatabase::changeLogPath(path));
 
         // FIXME: Call out to the client.
     }
@@ -155,6 +158,10 @@ Vector<SecurityOriginData> LocalStorageDatabaseTracker::deleteDatabasesModifiedS
         if (!modificationTime)
             continue;
 
+        // Recent changes may only have made it to the change log so far.
+        if (auto changeLogModificationTime = fileModificationTime(LocalStorageDatabase::changeLogPath(filePath)))
+            modificationTime = std::max(modificationTime.value(), changeLogModificationTime.value());
+
         if (modificationTime.value() >= std::chrono::system_clock::to_time_t(time))
             originIdentifiersToDelete.append(origin);
     }
@@ -354,6 +361,7 @@ void LocalStorageDatabaseTracker::removeDatabaseWithOriginIdentifier(const Strin
     }
 
     SQLiteFileSystem::deleteDatabaseFile(path);
+    deleteFile(LocalStorageDatabase::changeLogPath(path));
 
     m_origins.remove(originIdentifier);
     if (m_origins.isEmpty()) {
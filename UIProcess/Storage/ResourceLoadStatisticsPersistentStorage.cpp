@@ -31,15 +31,41 @@
 #include <WebCore/FileMonitor.h>
 #include <WebCore/FileSystem.h>
 #include <WebCore/KeyedCoding.h>
+#include <WebCore/ResourceLoadStatistics.h>
 #include <WebCore/SharedBuffer.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <wtf/RunLoop.h>
 #include <wtf/WorkQueue.h>
+#include <wtf/persistence/Decoder.h>
+#include <wtf/persistence/Encoder.h>
 #include <wtf/threads/BinarySemaphore.h>
 
 namespace WebKit {
 
 constexpr Seconds minimumWriteInterval { 5_min };
 
+// The statistics are persisted as an append-only log of records. Each write only appends
+// the entries that changed since the previous write, and the log gets rewritten from the
+// memory store once it holds too many superseded records. The rewritten log goes to a
+// temporary file that then replaces the old one, so a crash or a failed write during
+// compaction leaves the previous log intact.
+//
+// The log starts with a header record, every record is prefixed by its uint32_t size and
+// ends with a checksum. Reading stops at the first torn or corrupt record, and the log
+// gets compacted on the next write.
+constexpr uint32_t logMagic { 0x57524c53 };
+constexpr uint32_t logFormatVersion { 1 };
+constexpr size_t minimumLogRecordCountForCompaction { 1024 };
+constexpr size_t maximumLogRecordsPerLiveEntry { 2 };
+
+enum class LogRecordType : uint8_t {
+    Statistics,
+    Removal,
+    Metadata,
+};
+
 using namespace WebCore;
 
 static bool hasFileChangedSince(const String& path, WallTime since)
@@ -52,34 +78,267 @@ static bool hasFileChangedSince(const String& path, WallTime since)
     return WallTime::fromRawSeconds(modificationTime) > since;
 }
 
-static std::unique_ptr<KeyedDecoder> createDecoderForFile(const String& path)
+static bool readFileContents(const String& path, Vector<uint8_t>& contents)
 {
     ASSERT(!RunLoop::isMain());
     auto handle = openAndLockFile(path, OpenForRead);
     if (handle == invalidPlatformFileHandle)
-        return nullptr;
+        return false;
 
     long long fileSize = 0;
     if (!getFileSize(handle, fileSize)) {
         unlockAndCloseFile(handle);
-        return nullptr;
+        return false;
     }
 
     size_t bytesToRead;
     if (!WTF::convertSafely(fileSize, bytesToRead)) {
         unlockAndCloseFile(handle);
-        return nullptr;
+        return false;
     }
 
-    Vector<char> buffer(bytesToRead);
-    size_t totalBytesRead = readFromFile(handle, buffer.data(), buffer.size());
+    contents.resize(bytesToRead);
+    size_t totalBytesRead = readFromFile(handle, reinterpret_cast<char*>(contents.data()), contents.size());
 
     unlockAndCloseFile(handle);
 
-    if (totalBytesRead != bytesToRead)
+    return totalBytesRead == bytesToRead;
+}
+
+static std::unique_ptr<KeyedDecoder> createDecoderForFile(const String& path)
+{
+    Vector<uint8_t> contents;
+    if (!readFileContents(path, contents))
         return nullptr;
 
-    return KeyedDecoder::decoder(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size());
+    return KeyedDecoder::decoder(contents.data(), contents.size());
+}
+
+static PlatformFileHandle openAndLockFileForAppending(const String& path)
+{
+    ASSERT(!RunLoop::isMain());
+    // WebCore::openFile() truncates files opened for writing.
+    PlatformFileHandle handle = open(fileSystemRepresentation(path).data(), O_WRONLY | O_CREAT | O_APPEND, S_IRUSR | S_IWUSR);
+    if (handle == invalidPlatformFileHandle)
+        return invalidPlatformFileHandle;
+
+#if USE(FILE_LOCK)
+    if (!lockFile(handle, LockExclusive)) {
+        closeFile(handle);
+        return invalidPlatformFileHandle;
+    }
+#endif
+
+    return handle;
+}
+
+// Writes and syncs the data, then unlocks and closes the file.
+static bool writeLogData(PlatformFileHandle handle, const Vector<uint8_t>& data)
+{
+    int64_t writtenBytes = writeToFile(handle, reinterpret_cast<const char*>(data.data()), data.size());
+    bool didWrite = writtenBytes == static_cast<int64_t>(data.size());
+    if (didWrite)
+        didWrite = !fsync(handle);
+    unlockAndCloseFile(handle);
+
+    if (!didWrite) {
+        RELEASE_LOG_ERROR(ResourceLoadStatistics, "ResourceLoadStatisticsPersistentStorage: We only wrote %d out of %zu bytes to disk", static_cast<unsigned>(writtenBytes), data.size());
+        return false;
+    }
+    return true;
+}
+
+static bool replaceLogFile(const String& path, const Vector<uint8_t>& data)
+{
+    ASSERT(!RunLoop::isMain());
+    String temporaryPath = path + "-temp";
+    auto handle = openAndLockFile(temporaryPath, OpenForWrite);
+    if (handle == invalidPlatformFileHandle)
+        return false;
+
+    if (!writeLogData(handle, data)) {
+        deleteFile(temporaryPath);
+        return false;
+    }
+
+    if (!moveFile(temporaryPath, path)) {
+        RELEASE_LOG_ERROR(ResourceLoadStatistics, "ResourceLoadStatisticsPersistentStorage: Failed to replace statistics file: %s", path.utf8().data());
+        deleteFile(temporaryPath);
+        return false;
+    }
+    return true;
+}
+
+static void appendLogRecord(Vector<uint8_t>& log, WTF::Persistence::Encoder& record)
+{
+    record.encodeChecksum();
+
+    uint32_t recordSize = record.bufferSize();
+    log.append(reinterpret_cast<const uint8_t*>(&recordSize), sizeof(recordSize));
+    log.append(record.buffer(), record.bufferSize());
+}
+
+static void appendLogHeader(Vector<uint8_t>& log)
+{
+    WTF::Persistence::Encoder record;
+    record << logMagic;
+    record << logFormatVersion;
+    record << static_cast<uint32_t>(WebResourceLoadStatisticsStore::statisticsModelVersion);
+    appendLogRecord(log, record);
+}
+
+static bool appendStatisticsRecord(Vector<uint8_t>& log, const ResourceLoadStatistics& statistics)
+{
+    auto encoder = KeyedEncoder::encoder();
+    statistics.encode(*encoder);
+    auto encodedStatistics = encoder->finishEncoding();
+    if (!encodedStatistics)
+        return false;
+
+    WTF::Persistence::Encoder record;
+    record << static_cast<uint8_t>(LogRecordType::Statistics);
+    record << statistics.highLevelDomain;
+    record << Vector<uint8_t>(reinterpret_cast<const uint8_t*>(encodedStatistics->data()), encodedStatistics->size());
+    appendLogRecord(log, record);
+    return true;
+}
+
+static void appendRemovalRecord(Vector<uint8_t>& log, const String& primaryDomain)
+{
+    WTF::Persistence::Encoder record;
+    record << static_cast<uint8_t>(LogRecordType::Removal);
+    record << primaryDomain;
+    appendLogRecord(log, record);
+}
+
+static Vector<uint8_t> encodeMetadataRecord(const WebResourceLoadStatisticsStore& store)
+{
+    Vector<double> operatingDates;
+    for (auto date : store.operatingDates())
+        operatingDates.append(date.secondsSinceEpoch().value());
+
+    WTF::Persistence::Encoder record;
+    record << static_cast<uint8_t>(LogRecordType::Metadata);
+    record << store.endOfGrandfatheringTimestamp().secondsSinceEpoch().value();
+    record << operatingDates;
+
+    Vector<uint8_t> log;
+    appendLogRecord(log, record);
+    return log;
+}
+
+struct LogContents {
+    // Only the most recent record of each domain gets fully decoded.
+    HashMap<String, std::pair<const uint8_t*, size_t>> statisticsRecords;
+    std::pair<const uint8_t*, size_t> metadataRecord { nullptr, 0 };
+    size_t recordCount { 0 };
+    bool isComplete { false };
+};
+
+static bool readLog(const Vector<uint8_t>& log, LogContents& contents)
+{
+    const uint8_t* position = log.data();
+    const uint8_t* end = position + log.size();
+
+    auto nextRecord = [&] () -> std::pair<const uint8_t*, size_t> {
+        uint32_t recordSize;
+        if (static_cast<size_t>(end - position) < sizeof(recordSize))
+            return { nullptr, 0 };
+        memcpy(&recordSize, position, sizeof(recordSize));
+        position += sizeof(recordSize);
+        if (static_cast<size_t>(end - position) < recordSize)
+            return { nullptr, 0 };
+        auto record = std::make_pair(position, static_cast<size_t>(recordSize));
+        position += recordSize;
+        return record;
+    };
+
+    auto header = nextRecord();
+    if (!header.first)
+        return false;
+
+    WTF::Persistence::Decoder headerDecoder(header.first, header.second);
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint32_t modelVersion;
+    if (!headerDecoder.decode(magic) || !headerDecoder.decode(formatVersion) || !headerDecoder.decode(modelVersion) || !headerDecoder.verifyChecksum())
+        return false;
+    if (magic != logMagic || formatVersion != logFormatVersion || modelVersion != WebResourceLoadStatisticsStore::statisticsModelVersion)
+        return false;
+
+    while (position < end) {
+        auto record = nextRecord();
+        if (!record.first)
+            return true;
+
+        // A record only takes effect once its checksum checks out, so that a corrupt record
+        // never replaces a good earlier one. Anything after it is ignored.
+        WTF::Persistence::Decoder decoder(record.first, record.second);
+        uint8_t type;
+        if (!decoder.decode(type))
+            return true;
+
+        switch (static_cast<LogRecordType>(type)) {
+        case LogRecordType::Statistics: {
+            String primaryDomain;
+            Vector<uint8_t> encodedStatistics;
+            if (!decoder.decode(primaryDomain) || !decoder.decode(encodedStatistics) || !decoder.verifyChecksum())
+                return true;
+            contents.statisticsRecords.set(primaryDomain, record);
+            break;
+        }
+        case LogRecordType::Removal: {
+            String primaryDomain;
+            if (!decoder.decode(primaryDomain) || !decoder.verifyChecksum())
+                return true;
+            contents.statisticsRecords.remove(primaryDomain);
+            break;
+        }
+        case LogRecordType::Metadata: {
+            double timestamp;
+            Vector<double> dates;
+            if (!decoder.decode(timestamp) || !decoder.decode(dates) || !decoder.verifyChecksum())
+                return true;
+            contents.metadataRecord = record;
+            break;
+        }
+        default:
+            return true;
+        }
+
+        ++contents.recordCount;
+    }
+
+    contents.isComplete = true;
+    return true;
+}
+
+static bool decodeStatisticsRecord(std::pair<const uint8_t*, size_t> record, ResourceLoadStatistics& statistics)
+{
+    WTF::Persistence::Decoder decoder(record.first, record.second);
+    uint8_t type;
+    String primaryDomain;
+    Vector<uint8_t> encodedStatistics;
+    if (!decoder.decode(type) || !decoder.decode(primaryDomain) || !decoder.decode(encodedStatistics) || !decoder.verifyChecksum())
+        return false;
+
+    auto statisticsDecoder = KeyedDecoder::decoder(encodedStatistics.data(), encodedStatistics.size());
+    return statistics.decode(*statisticsDecoder) && statistics.highLevelDomain == primaryDomain;
+}
+
+static bool decodeMetadataRecord(std::pair<const uint8_t*, size_t> record, WallTime& endOfGrandfatheringTimestamp, Vector<WallTime>& operatingDates)
+{
+    WTF::Persistence::Decoder decoder(record.first, record.second);
+    uint8_t type;
+    double timestamp;
+    Vector<double> dates;
+    if (!decoder.decode(type) || !decoder.decode(timestamp) || !decoder.decode(dates) || !decoder.verifyChecksum())
+        return false;
+
+    endOfGrandfatheringTimestamp = WallTime::fromRawSeconds(timestamp);
+    for (auto date : dates)
+        operatingDates.append(WallTime::fromRawSeconds(date));
+    return true;
 }
 
 ResourceLoadStatisticsPersistentStorage::ResourceLoadStatisticsPersistentStorage(WebResourceLoadStatisticsStore& store, const String& storageDirectoryPath)
@@ -107,6 +366,15 @@ String ResourceLoadStatisticsPersistentStorage::storageDirectoryPath() const
 }
 
 String ResourceLoadStatisticsPersistentStorage::resourceLogFilePath() const
+{
+    String storagePath = storageDirectoryPath();
+    if (storagePath.isEmpty())
+        return emptyString();
+
+    return pathByAppendingComponent(storagePath, "full_browsing_session_resourceLog.log");
+}
+
+String ResourceLoadStatisticsPersistentStorage::legacyResourceLogFilePath() const
 {
     String storagePath = storageDirectoryPath();
     if (storagePath.isEmpty())
@@ -194,22 +462,83 @@ void ResourceLoadStatisticsPersistentStorage::refreshMemoryStoreFromDisk()
     if (!hasFileChangedSince(filePath, m_lastStatisticsFileSyncTime))
         return;
 
+    mergeMemoryStoreWithLog();
+}
+
+bool ResourceLoadStatisticsPersistentStorage::mergeMemoryStoreWithLog()
+{
+    ASSERT(!RunLoop::isMain());
+
     WallTime readTime = WallTime::now();
 
+    Vector<uint8_t> log;
+    if (!readFileContents(resourceLogFilePath(), log))
+        return false;
+
+    LogContents contents;
+    if (!readLog(log, contents)) {
+        RELEASE_LOG_ERROR(ResourceLoadStatistics, "ResourceLoadStatisticsPersistentStorage: Ignoring statistics log with an invalid header");
+        m_needsCompaction = true;
+        return false;
+    }
+
+    Vector<ResourceLoadStatistics> loadedStatistics;
+    loadedStatistics.reserveInitialCapacity(contents.statisticsRecords.size());
+    for (auto& record : contents.statisticsRecords.values()) {
+        ResourceLoadStatistics statistics;
+        if (!decodeStatisticsRecord(record, statistics)) {
+            m_needsCompaction = true;
+            continue;
+        }
+        loadedStatistics.uncheckedAppend(WTFMove(statistics));
+    }
+
+    WallTime endOfGrandfatheringTimestamp;
+    Vector<WallTime> operatingDates;
+    if (contents.metadataRecord.first && !decodeMetadataRecord(contents.metadataRecord, endOfGrandfatheringTimestamp, operatingDates))
+        m_needsCompaction = true;
+
+    m_memoryStore.mergeWithPersistedData(WTFMove(loadedStatistics), endOfGrandfatheringTimestamp, operatingDates);
+
+    m_logRecordCount = contents.recordCount;
+    if (!contents.isComplete)
+        m_needsCompaction = true;
+
+    m_lastStatisticsFileSyncTime = readTime;
+    return true;
+}
+
+bool ResourceLoadStatisticsPersistentStorage::populateMemoryStoreFromLegacyFile()
+{
+    ASSERT(!RunLoop::isMain());
+
+    String filePath = legacyResourceLogFilePath();
+    if (filePath.isEmpty() || !fileExists(filePath))
+        return false;
+
     auto decoder = createDecoderForFile(filePath);
     if (!decoder)
-        return;
+        return false;
 
     m_memoryStore.mergeWithDataFromDecoder(*decoder);
-    m_lastStatisticsFileSyncTime = readTime;
+
+    // The legacy file gets deleted once its contents have been written to the log.
+    m_needsCompaction = true;
+    return true;
 }
 
 void ResourceLoadStatisticsPersistentStorage::populateMemoryStoreFromDisk()
 {
     ASSERT(!RunLoop::isMain());
+    ASSERT_WITH_MESSAGE(m_memoryStore.isEmpty(), "This is the initial import so the store should be empty");
 
     String filePath = resourceLogFilePath();
     if (filePath.isEmpty() || !fileExists(filePath)) {
+        if (populateMemoryStoreFromLegacyFile()) {
+            writeMemoryStoreToDisk();
+            m_memoryStore.logTestingEvent(ASCIILiteral("PopulatedWithoutGrandfathering"));
+            return;
+        }
         m_memoryStore.grandfatherExistingWebsiteData();
         monitorDirectoryForNewStatistics();
         return;
@@ -220,18 +549,12 @@ void ResourceLoadStatisticsPersistentStorage::populateMemoryStoreFromDisk()
         return;
     }
 
-    WallTime readTime = WallTime::now();
-
-    auto decoder = createDecoderForFile(filePath);
-    if (!decoder) {
+    if (!mergeMemoryStoreWithLog()) {
         m_memoryStore.grandfatherExistingWebsiteData();
         return;
     }
 
-    ASSERT_WITH_MESSAGE(m_memoryStore.isEmpty(), "This is the initial import so the store should be empty");
-    m_memoryStore.mergeWithDataFromDecoder(*decoder);
-
-    m_lastStatisticsFileSyncTime = readTime;
+    m_lastWrittenMetadataRecord = encodeMetadataRecord(m_memoryStore);
 
     m_memoryStore.logTestingEvent(ASCIILiteral("PopulatedWithoutGrandfathering"));
 }
@@ -251,26 +574,21 @@ void ResourceLoadStatisticsPersistentStorage::writeMemoryStoreToDisk()
     m_hasPendingWrite = false;
     stopMonitoringDisk();
 
-    auto encoder = m_memoryStore.createEncoderFromData();
-    auto rawData = encoder->finishEncoding();
-    if (!rawData)
-        return;
-
     auto storagePath = storageDirectoryPath();
     if (!storagePath.isEmpty()) {
         makeAllDirectories(storagePath);
         excludeFromBackup();
     }
 
-    auto handle = openAndLockFile(resourceLogFilePath(), OpenForWrite);
-    if (handle == invalidPlatformFileHandle)
-        return;
-
-    int64_t writtenBytes = writeToFile(handle, rawData->data(), rawData->size());
-    unlockAndCloseFile(handle);
-
-    if (writtenBytes != static_cast<int64_t>(rawData->size()))
-        RELEASE_LOG_ERROR(ResourceLoadStatistics, "ResourceLoadStatisticsPersistentStorage: We only wrote %d out of %zu bytes to disk", static_cast<unsigned>(writtenBytes), rawData->size());
+    auto changedDomains = m_memoryStore.takeDomainsWithUnsavedChanges();
+    if (shouldCompactLog(changedDomains.size())) {
+        if (compactLog()) {
+            String legacyFilePath = legacyResourceLogFilePath();
+            if (!legacyFilePath.isEmpty() && fileExists(legacyFilePath))
+                deleteFile(legacyFilePath);
+        }
+    } else
+        appendChangesToLog(changedDomains);
 
     m_lastStatisticsFileSyncTime = WallTime::now();
     m_lastStatisticsWriteTime = MonotonicTime::now();
@@ -278,6 +596,85 @@ void ResourceLoadStatisticsPersistentStorage::writeMemoryStoreToDisk()
     startMonitoringDisk();
 }
 
+bool ResourceLoadStatisticsPersistentStorage::shouldCompactLog(size_t changedDomainCount) const
+{
+    if (m_needsCompaction || !fileExists(resourceLogFilePath()))
+        return true;
+
+    size_t recordCountAfterAppending = m_logRecordCount + changedDomainCount + 1;
+    if (recordCountAfterAppending < minimumLogRecordCountForCompaction)
+        return false;
+
+    return recordCountAfterAppending > maximumLogRecordsPerLiveEntry * (m_memoryStore.statisticsCount() + 1);
+}
+
+bool ResourceLoadStatisticsPersistentStorage::appendChangesToLog(const HashSet<String>& changedDomains)
+{
+    ASSERT(!RunLoop::isMain());
+
+    Vector<uint8_t> log;
+    size_t recordCount = 0;
+    for (auto& primaryDomain : changedDomains) {
+        if (auto* statistics = m_memoryStore.statisticsForPrimaryDomain(primaryDomain)) {
+            if (!appendStatisticsRecord(log, *statistics))
+                continue;
+        } else
+            appendRemovalRecord(log, primaryDomain);
+        ++recordCount;
+    }
+
+    auto metadataRecord = encodeMetadataRecord(m_memoryStore);
+    if (metadataRecord != m_lastWrittenMetadataRecord) {
+        log.appendVector(metadataRecord);
+        ++recordCount;
+    }
+
+    if (log.isEmpty())
+        return true;
+
+    auto handle = openAndLockFileForAppending(resourceLogFilePath());
+    if (handle == invalidPlatformFileHandle) {
+        m_needsCompaction = true;
+        return false;
+    }
+
+    if (!writeLogData(handle, log)) {
+        // Reading stops at a partially written record, so anything appended after it would be lost. Rewrite everything next time.
+        m_needsCompaction = true;
+        return false;
+    }
+
+    m_lastWrittenMetadataRecord = WTFMove(metadataRecord);
+    m_logRecordCount += recordCount;
+    return true;
+}
+
+bool ResourceLoadStatisticsPersistentStorage::compactLog()
+{
+    ASSERT(!RunLoop::isMain());
+
+    Vector<uint8_t> log;
+    appendLogHeader(log);
+
+    size_t recordCount = 0;
+    m_memoryStore.processStatistics([&log, &recordCount] (const ResourceLoadStatistics& statistics) {
+        if (appendStatisticsRecord(log, statistics))
+            ++recordCount;
+    });
+
+    auto metadataRecord = encodeMetadataRecord(m_memoryStore);
+    log.appendVector(metadataRecord);
+    ++recordCount;
+
+    if (!replaceLogFile(resourceLogFilePath(), log))
+        return false;
+
+    m_lastWrittenMetadataRecord = WTFMove(metadataRecord);
+    m_logRecordCount = recordCount;
+    m_needsCompaction = false;
+    return true;
+}
+
 void ResourceLoadStatisticsPersistentStorage::scheduleOrWriteMemoryStore(ForceImmediateWrite forceImmediateWrite)
 {
     ASSERT(!RunLoop::isMain());
@@ -308,6 +705,15 @@ void ResourceLoadStatisticsPersistentStorage::clear()
 
     if (!deleteFile(filePath))
         RELEASE_LOG_ERROR(ResourceLoadStatistics, "ResourceLoadStatisticsPersistentStorage: Unable to delete statistics file: %s", filePath.utf8().data());
+
+    String legacyFilePath = legacyResourceLogFilePath();
+    if (fileExists(legacyFilePath))
+        deleteFile(legacyFilePath);
+
+    m_memoryStore.takeDomainsWithUnsavedChanges();
+    m_lastWrittenMetadataRecord.clear();
+    m_logRecordCount = 0;
+    m_needsCompaction = false;
 }
 
 void ResourceLoadStatisticsPersistentStorage::finishAllPendingWorkSynchronously()
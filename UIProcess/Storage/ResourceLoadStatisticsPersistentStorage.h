@@ -26,6 +26,7 @@
 #pragma once
 
 #include <wtf/Forward.h>
+#include <wtf/HashSet.h>
 #include <wtf/MonotonicTime.h>
 #include <wtf/RunLoop.h>
 #include <wtf/WallTime.h>
@@ -61,13 +62,19 @@ public:
 private:
     String storageDirectoryPath() const;
     String resourceLogFilePath() const;
+    String legacyResourceLogFilePath() const;
 
     void startMonitoringDisk();
     void stopMonitoringDisk();
     void monitorDirectoryForNewStatistics();
 
     void writeMemoryStoreToDisk();
+    bool appendChangesToLog(const HashSet<String>& changedDomains);
+    bool compactLog();
+    bool shouldCompactLog(size_t changedDomainCount) const;
     void populateMemoryStoreFromDisk();
+    bool populateMemoryStoreFromLegacyFile();
+    bool mergeMemoryStoreWithLog();
     void excludeFromBackup() const;
     void refreshMemoryStoreFromDisk();
     void asyncWriteTimerFired();
@@ -78,7 +85,10 @@ private:
     std::unique_ptr<WebCore::FileMonitor> m_fileMonitor;
     WallTime m_lastStatisticsFileSyncTime;
     MonotonicTime m_lastStatisticsWriteTime;
+    Vector<uint8_t> m_lastWrittenMetadataRecord;
+    size_t m_logRecordCount { 0 };
     bool m_hasPendingWrite { false };
+    bool m_needsCompaction { false };
 };
 
 }
@@ -29,6 +29,7 @@
 #include "LocalStorageDatabase.h"
 #include "LocalStorageDatabaseTracker.h"
 #include "StorageAreaMapMessages.h"
+#include "StorageAreaSnapshot.h"
 #include "StorageManagerMessages.h"
 #include "WebProcessProxy.h"
 #include <WebCore/SecurityOriginData.h>
@@ -286,7 +287,7 @@ void StorageManager::StorageArea::openDatabaseAndImportItemsIfNeeded() const
 
     // We open the database here even if we've already imported our items to ensure that the database is open if we need to write to it.
     if (!m_localStorageDatabase)
-        m_localStorageDatabase = LocalStorageDatabase::create(m_localStorageNamespace->storageManager()->m_queue.copyRef(), m_localStorageNamespace->storageManager()->m_localStorageDatabaseTracker.copyRef(), m_securityOrigin);
+        m_localStorageDatabase = LocalStorageDatabase::create(m_localStorageNamespace->storageManager()->m_queue.copyRef(), m_localStorageNamespace->storageManager()->m_localStorageDatabaseTracker.copyRef(), m_securityOrigin, m_localStorageNamespace->storageManager()->m_localStorageDurability);
 
     if (m_didImportItemsFromDatabase)
         return;
@@ -446,14 +447,15 @@ void StorageManager::SessionStorageNamespace::cloneTo(SessionStorageNamespace& n
         newSessionStorageNamespace.m_storageAreaMap.add(pair.key, pair.value->clone());
 }
 
-Ref<StorageManager> StorageManager::create(const String& localStorageDirectory)
+Ref<StorageManager> StorageManager::create(const String& localStorageDirectory, LocalStorageDurability localStorageDurability)
 {
-    return adoptRef(*new StorageManager(localStorageDirectory));
+    return adoptRef(*new StorageManager(localStorageDirectory, localStorageDurability));
 }
 
-StorageManager::StorageManager(const String& localStorageDirectory)
+StorageManager::StorageManager(const String& localStorageDirectory, LocalStorageDurability localStorageDurability)
     : m_queue(WorkQueue::create("com.apple.WebKit.StorageManager"))
     , m_localStorageDatabaseTracker(LocalStorageDatabaseTracker::create(m_queue.copyRef(), localStorageDirectory))
+    , m_localStorageDurability(localStorageDurability)
 {
     // Make sure the encoding is initialized before we start dispatching things to the queue.
     UTF8Encoding();
@@ -767,6 +769,23 @@ void StorageManager::destroyStorageMap(IPC::Connection& connection, uint64_t sto
     m_storageAreasByConnection.remove(connectionAndStorageMapIDPair);
 }
 
+void StorageManager::preloadValues(IPC::Connection& connection, uint64_t storageMapID, uint64_t storageMapSeed)
+{
+    // Reading the items may require importing them from the database, which is why this is done here on the
+    // work queue rather than while the web process is blocked in a synchronous GetValues.
+    SharedMemory::Handle handle;
+    uint64_t encodedSize = 0;
+    if (StorageArea* storageArea = findStorageArea(connection, storageMapID)) {
+        if (auto sharedMemory = StorageAreaSnapshot::encode(storageArea->items(), encodedSize))
+            sharedMemory->createHandle(handle, SharedMemory::Protection::ReadOnly);
+    }
+
+    // DidGetValues marks where the snapshot sits in the stream of storage events, in case the web process
+    // dispatched DidPreloadValues ahead of the events that were sent before it.
+    connection.send(Messages::StorageAreaMap::DidPreloadValues(storageMapSeed, handle, encodedSize), storageMapID);
+    connection.send(Messages::StorageAreaMap::DidGetValues(storageMapSeed), storageMapID);
+}
+
 void StorageManager::getValues(IPC::Connection& connection, uint64_t storageMapID, uint64_t storageMapSeed, HashMap<String, String>& values)
 {
     StorageArea* storageArea = findStorageArea(connection, storageMapID);
@@ -27,6 +27,7 @@
 
 #include "Connection.h"
 #include "LocalStorageDatabaseTracker.h"
+#include "LocalStorageDurability.h"
 #include <WebCore/SecurityOriginData.h>
 #include <WebCore/SecurityOriginHash.h>
 #include <chrono>
@@ -47,7 +48,7 @@ class WebProcessProxy;
 
 class StorageManager : public IPC::Connection::WorkQueueMessageReceiver {
 public:
-    static Ref<StorageManager> create(const String& localStorageDirectory);
+    static Ref<StorageManager> create(const String& localStorageDirectory, LocalStorageDurability = LocalStorageDurability::Interval);
     ~StorageManager();
 
     void createSessionStorageNamespace(uint64_t storageNamespaceID, unsigned quotaInBytes);
@@ -72,7 +73,7 @@ public:
     void getLocalStorageOriginDetails(Function<void(Vector<LocalStorageDatabaseTracker::OriginDetails>)>&& completionHandler);
 
 private:
-    explicit StorageManager(const String& localStorageDirectory);
+    StorageManager(const String& localStorageDirectory, LocalStorageDurability);
 
     // IPC::Connection::WorkQueueMessageReceiver.
     void didReceiveMessage(IPC::Connection&, IPC::Decoder&) override;
@@ -84,6 +85,7 @@ private:
     void createSessionStorageMap(IPC::Connection&, uint64_t storageMapID, uint64_t storageNamespaceID, WebCore::SecurityOriginData&&);
     void destroyStorageMap(IPC::Connection&, uint64_t storageMapID);
 
+    void preloadValues(IPC::Connection&, uint64_t storageMapID, uint64_t storageMapSeed);
     void getValues(IPC::Connection&, uint64_t storageMapID, uint64_t storageMapSeed, HashMap<String, String>& values);
     void setItem(IPC::Connection&, uint64_t storageAreaID, uint64_t sourceStorageAreaID, uint64_t storageMapSeed, const String& key, const String& value, const String& urlString);
     void removeItem(IPC::Connection&, uint64_t storageMapID, uint64_t sourceStorageAreaID, uint64_t storageMapSeed, const String& key, const String& urlString);
@@ -101,6 +103,7 @@ private:
     Ref<WorkQueue> m_queue;
 
     Ref<LocalStorageDatabaseTracker> m_localStorageDatabaseTracker;
+    const LocalStorageDurability m_localStorageDurability;
     HashMap<uint64_t, RefPtr<LocalStorageNamespace>> m_localStorageNamespaces;
 
     HashMap<std::pair<uint64_t, WebCore::SecurityOriginData>, RefPtr<TransientLocalStorageNamespace>> m_transientLocalStorageNamespaces;
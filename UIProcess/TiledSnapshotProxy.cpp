@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "TiledSnapshotProxy.h"
+
+#include "APIData.h"
+#include <wtf/NeverDestroyed.h>
+#include <wtf/NumberOfCores.h>
+#include <wtf/RunLoop.h>
+#include <wtf/WorkQueue.h>
+
+#if USE(CG)
+#include <ImageIO/ImageIO.h>
+#elif USE(CAIRO)
+#include <WebCore/RefPtrCairo.h>
+#include <cairo.h>
+#endif
+
+using namespace WebCore;
+
+namespace WebKit {
+
+static const unsigned maximumEncodingQueueCount = 4;
+
+#if USE(CG)
+typedef RetainPtr<CGImageRef> PlatformTileImage;
+#elif USE(CAIRO)
+typedef RefPtr<cairo_surface_t> PlatformTileImage;
+#endif
+
+static WorkQueue& encodingQueue(uint32_t tileIndex)
+{
+    ASSERT(RunLoop::isMain());
+
+    static NeverDestroyed<Vector<Ref<WorkQueue>>> queues;
+    if (queues.get().isEmpty()) {
+        unsigned queueCount = std::max(1, std::min(static_cast<int>(maximumEncodingQueueCount), WTF::numberOfProcessorCores() - 1));
+        for (unsigned i = 0; i < queueCount; ++i)
+            queues.get().append(WorkQueue::create("com.apple.WebKit.TiledSnapshotEncoding"));
+    }
+
+    return queues.get()[tileIndex % queues.get().size()];
+}
+
+// The image references the shared bitmap, so it must be created and destroyed on the main thread.
+static PlatformTileImage createTileImage(ShareableBitmap& bitmap)
+{
+#if USE(CG)
+    return bitmap.makeCGImage();
+#elif USE(CAIRO)
+    return bitmap.createCairoSurface();
+#endif
+}
+
+static Vector<uint8_t> encodeTileImageAsPNG(const PlatformTileImage& image)
+{
+    Vector<uint8_t> encodedData;
+    if (!image)
+        return encodedData;
+
+#if USE(CG)
+    auto data = adoptCF(CFDataCreateMutable(kCFAllocatorDefault, 0));
+    auto destination = adoptCF(CGImageDestinationCreateWithData(data.get(), CFSTR("public.png"), 1, nullptr));
+    if (!destination)
+        return encodedData;
+
+    CGImageDestinationAddImage(destination.get(), image.get(), nullptr);
+    if (!CGImageDestinationFinalize(destination.get()))
+        return encodedData;
+
+    encodedData.append(CFDataGetBytePtr(data.get()), CFDataGetLength(data.get()));
+#elif USE(CAIRO)
+    auto writeFunction = [](void* closure, const unsigned char* data, unsigned length) -> cairo_status_t {
+        static_cast<Vector<uint8_t>*>(closure)->append(data, length);
+        return CAIRO_STATUS_SUCCESS;
+    };
+    if (cairo_surface_write_to_png_stream(image.get(), writeFunction, &encodedData) != CAIRO_STATUS_SUCCESS)
+        encodedData.clear();
+#endif
+
+    return encodedData;
+}
+
+static uint64_t generateTiledSnapshotID()
+{
+    static uint64_t uniqueTiledSnapshotID;
+    return ++uniqueTiledSnapshotID;
+}
+
+TiledSnapshotProxy::TiledSnapshotProxy(TileCallback&& callback, ProcessThrottler::BackgroundActivityToken activityToken)
+    : m_snapshotID(generateTiledSnapshotID())
+    , m_callback(WTFMove(callback))
+    , m_activityToken(activityToken)
+{
+}
+
+TiledSnapshotProxy::~TiledSnapshotProxy()
+{
+    didFail(CallbackBase::Error::OwnerWasInvalidated);
+}
+
+void TiledSnapshotProxy::encodeTile(Ref<ShareableBitmap>&& bitmap, const IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, WTF::Function<void ()>&& completionHandler)
+{
+    ASSERT(RunLoop::isMain());
+    ASSERT(tileIndex < tileCount);
+
+    m_tileCount = tileCount;
+
+    auto image = createTileImage(bitmap);
+    encodingQueue(tileIndex).dispatch([protectedThis = makeRef(*this), image = WTFMove(image), tileRect, tileIndex, tileCount, completionHandler = WTFMove(completionHandler)]() mutable {
+        auto encodedData = encodeTileImageAsPNG(image);
+
+        RunLoop::main().dispatch([protectedThis = WTFMove(protectedThis), image = WTFMove(image), encodedData = WTFMove(encodedData), tileRect, tileIndex, tileCount, completionHandler = WTFMove(completionHandler)]() mutable {
+            image = nullptr;
+            protectedThis->didEncodeTile(encodedData, tileRect, tileIndex, tileCount);
+            completionHandler();
+        });
+    });
+}
+
+void TiledSnapshotProxy::didEncodeTile(const Vector<uint8_t>& encodedData, const IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount)
+{
+    if (!m_callback)
+        return;
+
+    if (encodedData.isEmpty()) {
+        didFail(CallbackBase::Error::Unknown);
+        return;
+    }
+
+    ++m_deliveredTileCount;
+    m_callback(API::Data::create(encodedData).ptr(), tileRect, tileIndex, tileCount, CallbackBase::Error::None);
+
+    if (isComplete())
+        m_callback = nullptr;
+}
+
+void TiledSnapshotProxy::didFail(CallbackBase::Error error)
+{
+    if (!m_callback)
+        return;
+
+    auto callback = WTFMove(m_callback);
+    callback(nullptr, IntRect(), 0, 0, error);
+}
+
+void TiledSnapshotProxy::invalidate()
+{
+    m_callback = nullptr;
+}
+
+} // namespace WebKit
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "GenericCallback.h"
+#include "ProcessThrottler.h"
+#include "ShareableBitmap.h"
+#include <WebCore/IntRect.h>
+#include <wtf/Function.h>
+#include <wtf/RefCounted.h>
+
+namespace API {
+class Data;
+}
+
+namespace WebKit {
+
+// A snapshot that the web process paints and sends a tile at a time. Each tile is encoded as PNG on
+// one of a pool of encoding queues and handed to the tile callback as soon as it is encoded, so tiles
+// may arrive out of order.
+class TiledSnapshotProxy : public RefCounted<TiledSnapshotProxy> {
+public:
+    typedef WTF::Function<void (API::Data*, const WebCore::IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, CallbackBase::Error)> TileCallback;
+
+    static Ref<TiledSnapshotProxy> create(TileCallback&& callback, ProcessThrottler::BackgroundActivityToken activityToken)
+    {
+        return adoptRef(*new TiledSnapshotProxy(WTFMove(callback), activityToken));
+    }
+
+    ~TiledSnapshotProxy();
+
+    uint64_t snapshotID() const { return m_snapshotID; }
+
+    // Calls completionHandler on the main thread once the tile has been encoded and the bitmap isn't used anymore.
+    void encodeTile(Ref<ShareableBitmap>&&, const WebCore::IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount, WTF::Function<void ()>&& completionHandler);
+
+    void didFail(CallbackBase::Error);
+    void invalidate();
+
+    // A snapshot stops being valid once all its tiles were delivered, or it failed or was invalidated.
+    bool isValid() const { return !!m_callback; }
+    bool isComplete() const { return m_tileCount && m_deliveredTileCount == m_tileCount; }
+
+private:
+    TiledSnapshotProxy(TileCallback&&, ProcessThrottler::BackgroundActivityToken);
+
+    void didEncodeTile(const Vector<uint8_t>&, const WebCore::IntRect& tileRect, uint32_t tileIndex, uint32_t tileCount);
+
+    uint64_t m_snapshotID;
+    TileCallback m_callback;
+    ProcessThrottler::BackgroundActivityToken m_activityToken;
+    uint32_t m_tileCount { 0 };
+    uint32_t m_deliveredTileCount { 0 };
+};
+
+} // namespace WebKit
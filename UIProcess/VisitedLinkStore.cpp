@@ -63,7 +63,6 @@ VisitedLinkStore::~VisitedLinkStore()
 VisitedLinkStore::VisitedLinkStore()
     : m_identifier(generateIdentifier())
     , m_keyCount(0)
-    , m_tableSize(0)
     , m_pendingVisitedLinksTimer(RunLoop::main(), this, &VisitedLinkStore::pendingVisitedLinksTimerFired)
 {
 }
@@ -80,7 +79,7 @@ void VisitedLinkStore::addProcess(WebProcessProxy& process)
     if (!m_keyCount)
         return;
 
-    ASSERT(m_table.sharedMemory());
+    ASSERT(m_table.segmentCount());
 
     sendTable(process);
 }
@@ -106,7 +105,8 @@ void VisitedLinkStore::removeAll()
     m_pendingVisitedLinksTimer.stop();
     m_pendingVisitedLinks.clear();
     m_keyCount = 0;
-    m_tableSize = 0;
+    m_lastSegmentKeyCount = 0;
+    m_lastSegmentSize = 0;
     m_table.clear();
 
     for (WebProcessProxy* process : m_processes) {
@@ -166,14 +166,11 @@ static unsigned tableSizeForKeyCount(unsigned keyCount)
 
 void VisitedLinkStore::pendingVisitedLinksTimerFired()
 {
-    unsigned currentTableSize = m_tableSize;
-    unsigned newTableSize = tableSizeForKeyCount(m_keyCount + m_pendingVisitedLinks.size());
-
-    newTableSize = std::max(currentTableSize, newTableSize);
-
-    if (currentTableSize != newTableSize) {
-        resizeTable(newTableSize);
-        return;
+    // Existing segments are never rehashed. When the last one would get too full, a segment large
+    // enough for all the links is appended so the number of segments stays logarithmic.
+    if (m_lastSegmentKeyCount + m_pendingVisitedLinks.size() > m_lastSegmentSize / visitedLinkTableMaxLoad) {
+        if (!appendTableSegment(tableSizeForKeyCount(m_keyCount + m_pendingVisitedLinks.size())))
+            return;
     }
 
     Vector<WebCore::LinkHash> addedVisitedLinks;
@@ -182,6 +179,7 @@ void VisitedLinkStore::pendingVisitedLinksTimerFired()
         if (m_table.addLinkHash(linkHash)) {
             addedVisitedLinks.append(linkHash);
             ++m_keyCount;
+            ++m_lastSegmentKeyCount;
         }
     }
 
@@ -200,60 +198,55 @@ void VisitedLinkStore::pendingVisitedLinksTimerFired()
     }
 }
 
-void VisitedLinkStore::resizeTable(unsigned newTableSize)
+bool VisitedLinkStore::appendTableSegment(unsigned segmentSize)
 {
-    auto newTableMemory = SharedMemory::allocate(newTableSize * sizeof(LinkHash));
+    auto segmentMemory = SharedMemory::allocate(segmentSize * sizeof(LinkHash));
 
-    if (!newTableMemory) {
+    if (!segmentMemory) {
         LOG_ERROR("Could not allocate shared memory for visited link table");
-        return;
+        return false;
     }
 
-    memset(newTableMemory->data(), 0, newTableMemory->size());
+    memset(segmentMemory->data(), 0, segmentMemory->size());
 
-    RefPtr<SharedMemory> currentTableMemory = m_table.sharedMemory();
-    unsigned currentTableSize = m_tableSize;
+    bool isFirstSegment = !m_table.segmentCount();
+    auto& segment = *segmentMemory;
+    m_table.appendSegment(segmentMemory.releaseNonNull());
+    m_lastSegmentSize = segmentSize;
+    m_lastSegmentKeyCount = 0;
 
-    m_table.setSharedMemory(newTableMemory.releaseNonNull());
-    m_tableSize = newTableSize;
-
-    if (currentTableMemory) {
-        ASSERT_UNUSED(currentTableSize, currentTableMemory->size() == currentTableSize * sizeof(LinkHash));
-
-        // Go through the current hash table and re-add all entries to the new hash table.
-        const LinkHash* currentLinkHashes = static_cast<const LinkHash*>(currentTableMemory->data());
-        for (unsigned i = 0; i < currentTableSize; ++i) {
-            LinkHash linkHash = currentLinkHashes[i];
-
-            if (!linkHash)
-                continue;
-
-            bool didAddLinkHash = m_table.addLinkHash(linkHash);
+    // Processes only map the new segment, the links they know about don't change.
+    for (WebProcessProxy* process : m_processes) {
+        ASSERT(process->processPool().processes().contains(process));
 
-            // It should always be possible to add the link hash to a new table.
-            ASSERT_UNUSED(didAddLinkHash, didAddLinkHash);
-        }
-    }
+        // Encoding a handle consumes it, so each process needs its own.
+        SharedMemory::Handle handle;
+        if (!segment.createHandle(handle, SharedMemory::Protection::ReadOnly))
+            continue;
 
-    for (auto& linkHash : m_pendingVisitedLinks) {
-        if (m_table.addLinkHash(linkHash))
-            m_keyCount++;
+        if (isFirstSegment)
+            process->send(Messages::VisitedLinkTableController::SetVisitedLinkTable(handle), m_identifier);
+        else
+            process->send(Messages::VisitedLinkTableController::AppendVisitedLinkTableSegment(handle), m_identifier);
     }
-    m_pendingVisitedLinks.clear();
 
-    for (WebProcessProxy* process : m_processes)
-        sendTable(*process);
+    return true;
 }
 
 void VisitedLinkStore::sendTable(WebProcessProxy& process)
 {
     ASSERT(process.processPool().processes().contains(&process));
 
-    SharedMemory::Handle handle;
-    if (!m_table.sharedMemory()->createHandle(handle, SharedMemory::Protection::ReadOnly))
-        return;
+    for (unsigned i = 0; i < m_table.segmentCount(); ++i) {
+        SharedMemory::Handle handle;
+        if (!m_table.segmentSharedMemory(i).createHandle(handle, SharedMemory::Protection::ReadOnly))
+            return;
 
-    process.send(Messages::VisitedLinkTableController::SetVisitedLinkTable(handle), m_identifier);
+        if (!i)
+            process.send(Messages::VisitedLinkTableController::SetVisitedLinkTable(handle), m_identifier);
+        else
+            process.send(Messages::VisitedLinkTableController::AppendVisitedLinkTableSegment(handle), m_identifier);
+    }
 }
 
 } // namespace WebKit
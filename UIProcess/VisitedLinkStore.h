@@ -69,7 +69,7 @@ private:
 
     void pendingVisitedLinksTimerFired();
 
-    void resizeTable(unsigned newTableSize);
+    bool appendTableSegment(unsigned segmentSize);
     void sendTable(WebProcessProxy&);
 
     HashSet<WebProcessProxy*> m_processes;
@@ -77,7 +77,8 @@ private:
     uint64_t m_identifier;
 
     unsigned m_keyCount;
-    unsigned m_tableSize;
+    unsigned m_lastSegmentKeyCount { 0 };
+    unsigned m_lastSegmentSize { 0 };
     VisitedLinkTable m_table;
 
     HashSet<WebCore::LinkHash, WebCore::LinkHashHash> m_pendingVisitedLinks;
@@ -368,6 +368,11 @@ WebPageProxy::WebPageProxy(PageClient& pageClient, WebProcessProxy& process, uin
     , m_weakPtrFactory(this)
 {
     m_webProcessLifetimeTracker.addObserver(m_visitedLinkStore);
+
+    for (auto& key : m_configurationPreferenceValues.keys()) {
+        if (auto index = WebPreferencesStore::indexForKey(key))
+            m_configurationPreferenceKeys.set(static_cast<size_t>(*index));
+    }
     m_webProcessLifetimeTracker.addObserver(m_websiteDataStore);
 
     updateActivityState();
@@ -1826,46 +1831,6 @@ void WebPageProxy::handleMouseEvent(const NativeWebMouseEvent& event)
     m_process->send(Messages::WebPage::MouseEvent(event), m_pageID);
 }
 
-#if MERGE_WHEEL_EVENTS
-static bool canCoalesce(const WebWheelEvent& a, const WebWheelEvent& b)
-{
-    if (a.position() != b.position())
-        return false;
-    if (a.globalPosition() != b.globalPosition())
-        return false;
-    if (a.modifiers() != b.modifiers())
-        return false;
-    if (a.granularity() != b.granularity())
-        return false;
-#if PLATFORM(COCOA)
-    if (a.phase() != b.phase())
-        return false;
-    if (a.momentumPhase() != b.momentumPhase())
-        return false;
-    if (a.hasPreciseScrollingDeltas() != b.hasPreciseScrollingDeltas())
-        return false;
-#endif
-
-    return true;
-}
-
-static WebWheelEvent coalesce(const WebWheelEvent& a, const WebWheelEvent& b)
-{
-    ASSERT(canCoalesce(a, b));
-
-    FloatSize mergedDelta = a.delta() + b.delta();
-    FloatSize mergedWheelTicks = a.wheelTicks() + b.wheelTicks();
-
-#if PLATFORM(COCOA)
-    FloatSize mergedUnacceleratedScrollingDelta = a.unacceleratedScrollingDelta() + b.unacceleratedScrollingDelta();
-
-    return WebWheelEvent(WebEvent::Wheel, b.position(), b.globalPosition(), mergedDelta, mergedWheelTicks, b.granularity(), b.directionInvertedFromDevice(), b.phase(), b.momentumPhase(), b.hasPreciseScrollingDeltas(), b.scrollCount(), mergedUnacceleratedScrollingDelta, b.modifiers(), b.timestamp());
-#else
-    return WebWheelEvent(WebEvent::Wheel, b.position(), b.globalPosition(), mergedDelta, mergedWheelTicks, b.granularity(), b.modifiers(), b.timestamp());
-#endif
-}
-#endif // MERGE_WHEEL_EVENTS
-
 static WebWheelEvent coalescedWheelEvent(Deque<NativeWebWheelEvent>& queue, Vector<NativeWebWheelEvent>& coalescedEvents)
 {
     ASSERT(!queue.isEmpty());
@@ -1876,10 +1841,10 @@ static WebWheelEvent coalescedWheelEvent(Deque<NativeWebWheelEvent>& queue, Vect
     coalescedEvents.append(firstEvent);
 
     WebWheelEvent event = firstEvent;
-    while (!queue.isEmpty() && canCoalesce(event, queue.first())) {
+    while (!queue.isEmpty() && event.canCoalesceWith(queue.first())) {
         NativeWebWheelEvent firstEvent = queue.takeFirst();
         coalescedEvents.append(firstEvent);
-        event = coalesce(event, firstEvent);
+        event = event.coalescedWith(firstEvent);
     }
 
     return event;
@@ -1989,7 +1954,7 @@ WebPreferencesStore WebPageProxy::preferencesStore() const
 
     WebPreferencesStore store = m_preferences->store();
     for (const auto& preference : m_configurationPreferenceValues)
-        store.m_values.set(preference.key, preference.value);
+        store.setValueForKey(preference.key, preference.value);
 
     return store;
 }
@@ -3051,24 +3016,53 @@ static OptionSet<IPC::SendOption> printingSendOptions(bool isPerformingDOMPrintO
     return { };
 }
 
-void WebPageProxy::preferencesDidChange()
+void WebPageProxy::updatePreferencesDependentState()
 {
-    if (!isValid())
-        return;
-
     updateThrottleState();
     updateHiddenPageThrottlingAutoIncreases();
 
     m_pageClient.preferencesDidChange();
+}
 
-    // FIXME: It probably makes more sense to send individual preference changes.
-    // However, WebKitTestRunner depends on getting a preference change notification
+void WebPageProxy::preferencesDidChange()
+{
+    if (!isValid())
+        return;
+
+    updatePreferencesDependentState();
+
+    // WebKitTestRunner depends on getting a preference change notification
     // even if nothing changed in UI process, so that overrides get removed.
 
     // Preferences need to be updated during synchronous printing to make "print backgrounds" preference work when toggled from a print dialog checkbox.
     m_process->send(Messages::WebPage::PreferencesDidChange(preferencesStore()), m_pageID, printingSendOptions(m_isPerformingDOMPrintOperation));
 }
 
+void WebPageProxy::preferenceValuesDidChange(const WebPreferencesStore::Changes& changes)
+{
+    if (!isValid())
+        return;
+
+    updatePreferencesDependentState();
+
+    if (m_configurationPreferenceKeys.none()) {
+        m_process->send(Messages::WebPage::PreferenceValuesDidChange(changes), m_pageID, printingSendOptions(m_isPerformingDOMPrintOperation));
+        return;
+    }
+
+    // Values from the page configuration take precedence over the preferences, so changes to them don't need to be sent.
+    WebPreferencesStore::Changes filteredChanges;
+    for (auto& entry : changes.entries) {
+        if (!m_configurationPreferenceKeys[static_cast<size_t>(entry.key)])
+            filteredChanges.entries.append(entry);
+    }
+
+    if (filteredChanges.entries.isEmpty())
+        return;
+
+    m_process->send(Messages::WebPage::PreferenceValuesDidChange(filteredChanges), m_pageID, printingSendOptions(m_isPerformingDOMPrintOperation));
+}
+
 void WebPageProxy::didCreateMainFrame(uint64_t frameID)
 {
     PageClientProtector protector(m_pageClient);
@@ -5580,6 +5574,10 @@ void WebPageProxy::resetState(ResetStateReason resetStateReason)
     m_callbacks.invalidate(error);
     m_loadDependentStringCallbackIDs.clear();
 
+    auto tiledSnapshots = WTFMove(m_tiledSnapshots);
+    for (auto& snapshot : tiledSnapshots.values())
+        snapshot->didFail(error);
+
     Vector<WebEditCommandProxy*> editCommandVector;
     copyToVector(m_editCommandSet, editCommandVector);
     m_editCommandSet.clear();
@@ -6515,6 +6513,67 @@ void WebPageProxy::takeSnapshot(IntRect rect, IntSize bitmapSize, SnapshotOption
     m_process->send(Messages::WebPage::TakeSnapshot(rect, bitmapSize, options, callbackID), m_pageID);
 }
 
+uint64_t WebPageProxy::takeTiledSnapshot(IntRect rect, uint32_t tileHeight, SnapshotOptions options, TiledSnapshotProxy::TileCallback&& callback)
+{
+    if (!isValid()) {
+        callback(nullptr, IntRect(), 0, 0, CallbackBase::Error::Unknown);
+        return 0;
+    }
+
+    auto snapshot = TiledSnapshotProxy::create(WTFMove(callback), m_process->throttler().backgroundActivityToken());
+    uint64_t snapshotID = snapshot->snapshotID();
+    m_tiledSnapshots.set(snapshotID, WTFMove(snapshot));
+    m_process->send(Messages::WebPage::TakeTiledSnapshot(rect, tileHeight, options, snapshotID), m_pageID);
+    return snapshotID;
+}
+
+void WebPageProxy::cancelTiledSnapshot(uint64_t snapshotID)
+{
+    auto snapshot = m_tiledSnapshots.take(snapshotID);
+    if (!snapshot)
+        return;
+
+    snapshot->invalidate();
+    if (isValid())
+        m_process->send(Messages::WebPage::CancelTiledSnapshot(snapshotID), m_pageID);
+}
+
+void WebPageProxy::didPaintSnapshotTile(uint64_t snapshotID, uint32_t tileIndex, uint32_t tileCount, uint32_t bitmapIndex, const IntRect& tileRect, const ShareableBitmap::Handle& bitmapHandle)
+{
+    RefPtr<TiledSnapshotProxy> snapshot = m_tiledSnapshots.get(snapshotID);
+    if (!snapshot)
+        return;
+
+    RefPtr<ShareableBitmap> bitmap;
+    if (!bitmapHandle.isNull())
+        bitmap = ShareableBitmap::create(bitmapHandle, SharedMemory::Protection::ReadOnly);
+    if (!bitmap) {
+        m_tiledSnapshots.remove(snapshotID);
+        snapshot->didFail(CallbackBase::Error::Unknown);
+        return;
+    }
+
+    MESSAGE_CHECK(tileIndex < tileCount);
+
+    // Give the bitmap back to the web process once the tile is encoded, so that it paints the next tile in it.
+    snapshot->encodeTile(bitmap.releaseNonNull(), tileRect, tileIndex, tileCount, [this, protectedThis = makeRef(*this), snapshotID, bitmapIndex] {
+        auto* snapshot = m_tiledSnapshots.get(snapshotID);
+        if (!snapshot)
+            return;
+
+        if (snapshot->isValid()) {
+            if (isValid())
+                m_process->send(Messages::WebPage::ReleaseSnapshotTile(snapshotID, bitmapIndex), m_pageID);
+            return;
+        }
+
+        bool isComplete = snapshot->isComplete();
+        m_tiledSnapshots.remove(snapshotID);
+        if (!isComplete && isValid())
+            m_process->send(Messages::WebPage::CancelTiledSnapshot(snapshotID), m_pageID);
+    });
+}
+
 void WebPageProxy::navigationGestureDidBegin()
 {
     PageClientProtector protector(m_pageClient);
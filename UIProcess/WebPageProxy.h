@@ -44,6 +44,7 @@
 #include "ProcessThrottler.h"
 #include "SandboxExtension.h"
 #include "ShareableBitmap.h"
+#include "TiledSnapshotProxy.h"
 #include "UserMediaPermissionRequestManagerProxy.h"
 #include "VisibleContentRectUpdateInfo.h"
 #include "VisibleWebPageCounter.h"
@@ -893,6 +894,7 @@ public:
 #endif
 
     void preferencesDidChange();
+    void preferenceValuesDidChange(const WebPreferencesStore::Changes&);
 
 #if ENABLE(CONTEXT_MENUS)
     // Called by the WebContextMenuProxy.
@@ -1056,6 +1058,10 @@ public:
 
     void takeSnapshot(WebCore::IntRect, WebCore::IntSize bitmapSize, SnapshotOptions, WTF::Function<void (const ShareableBitmap::Handle&, CallbackBase::Error)>&&);
 
+    // Snapshots the rect, or the whole document if it's empty, in tiles of the given height that are encoded as PNG.
+    uint64_t takeTiledSnapshot(WebCore::IntRect, uint32_t tileHeight, SnapshotOptions, TiledSnapshotProxy::TileCallback&&);
+    void cancelTiledSnapshot(uint64_t snapshotID);
+
     void navigationGestureDidBegin();
     void navigationGestureWillEnd(bool willNavigate, WebBackForwardListItem&);
     void navigationGestureDidEnd(bool willNavigate, WebBackForwardListItem&);
@@ -1209,6 +1215,7 @@ private:
     void updateActivityState(WebCore::ActivityState::Flags flagsToUpdate = WebCore::ActivityState::AllFlags);
     void updateThrottleState();
     void updateHiddenPageThrottlingAutoIncreases();
+    void updatePreferencesDependentState();
 
     enum class ResetStateReason {
         PageInvalidated,
@@ -1462,6 +1469,7 @@ private:
     void voidCallback(CallbackID);
     void dataCallback(const IPC::DataReference&, CallbackID);
     void imageCallback(const ShareableBitmap::Handle&, CallbackID);
+    void didPaintSnapshotTile(uint64_t snapshotID, uint32_t tileIndex, uint32_t tileCount, uint32_t bitmapIndex, const WebCore::IntRect& tileRect, const ShareableBitmap::Handle&);
     void stringCallback(const String&, CallbackID);
     void invalidateStringCallback(CallbackID);
     void scriptValueCallback(const IPC::DataReference&, bool hadException, const WebCore::ExceptionDetails&, CallbackID);
@@ -1713,6 +1721,7 @@ private:
 
     CallbackMap m_callbacks;
     HashSet<CallbackID> m_loadDependentStringCallbackIDs;
+    HashMap<uint64_t, RefPtr<TiledSnapshotProxy>> m_tiledSnapshots;
 
     HashSet<WebEditCommandProxy*> m_editCommandSet;
 
@@ -1983,6 +1992,8 @@ private:
     uint64_t m_navigationID { 0 };
 
     WebPreferencesStore::ValueMap m_configurationPreferenceValues;
+    // The keys of m_configurationPreferenceValues, by index.
+    std::bitset<webPreferencesKeyCount> m_configurationPreferenceKeys;
     WebCore::ActivityState::Flags m_potentiallyChangedActivityStateFlags { WebCore::ActivityState::NoFlags };
     bool m_activityStateChangeWantsSynchronousReply { false };
     Vector<CallbackID> m_nextActivityStateChangeCallbacks;
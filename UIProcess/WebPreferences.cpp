@@ -109,6 +109,18 @@ void WebPreferences::removePage(WebPageProxy& webPageProxy)
 
 void WebPreferences::update()
 {
+    auto changes = m_store.takeChanges();
+    if (changes.entries.isEmpty())
+        return;
+
+    for (auto& webPageProxy : m_pages)
+        webPageProxy->preferenceValuesDidChange(changes);
+}
+
+void WebPreferences::forceUpdate()
+{
+    // Send the whole store even if nothing changed, the web process removes the test runner overrides when it gets it.
+    m_store.clearChangedKeys();
     for (auto& webPageProxy : m_pages)
         webPageProxy->preferencesDidChange();
 }
@@ -116,7 +128,7 @@ void WebPreferences::update()
 void WebPreferences::updateStringValueForKey(const String& key, const String& value)
 {
     platformUpdateStringValueForKey(key, value);
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updateBoolValueForKey(const String& key, bool value)
@@ -127,30 +139,30 @@ void WebPreferences::updateBoolValueForKey(const String& key, bool value)
     }
 
     platformUpdateBoolValueForKey(key, value);
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updateBoolValueForExperimentalFeatureKey(const String& key, bool value)
 {
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updateUInt32ValueForKey(const String& key, uint32_t value)
 {
     platformUpdateUInt32ValueForKey(key, value);
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updateDoubleValueForKey(const String& key, double value)
 {
     platformUpdateDoubleValueForKey(key, value);
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updateFloatValueForKey(const String& key, float value)
 {
     platformUpdateFloatValueForKey(key, value);
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 }
 
 void WebPreferences::updatePrivateBrowsingValue(bool value)
@@ -167,7 +179,7 @@ void WebPreferences::updatePrivateBrowsingValue(bool value)
         privateBrowsingPageCount += pagesChanged;
     }
 
-    update(); // FIXME: Only send over the changed key and value.
+    update();
 
     if (!value) {
         ASSERT(privateBrowsingPageCount >= pagesChanged);
@@ -68,7 +68,7 @@ public:
     void enableAllExperimentalFeatures();
 
     // Exposed for WebKitTestRunner use only.
-    void forceUpdate() { update(); }
+    void forceUpdate();
 
     static bool anyPagesAreUsingPrivateBrowsing();
 
@@ -445,6 +445,10 @@ NetworkProcessProxy& WebProcessPool::ensureNetworkProcess(WebsiteDataStore* with
 #if ENABLE(NETWORK_CACHE_SPECULATIVE_REVALIDATION)
     parameters.shouldEnableNetworkCacheSpeculativeRevalidation = m_configuration->diskCacheSpeculativeValidationEnabled();
 #endif
+#if ENABLE(NETWORK_CACHE)
+    parameters.shouldUseNetworkCachePackedStorage = m_configuration->diskCachePackedStorageEnabled();
+    parameters.networkCacheEvictionPolicy = m_configuration->diskCacheEvictionPolicy();
+#endif
 
 #if PLATFORM(IOS)
     String cookieStorageDirectory = this->cookieStorageDirectory();
@@ -775,6 +779,7 @@ WebProcessProxy& WebProcessPool::createNewWebProcess(WebsiteDataStore& websiteDa
 #endif
 
     parameters.presentingApplicationPID = m_configuration->presentingApplicationPID();
+    parameters.usesPackedIPCEncoding = m_configuration->usesPackedIPCEncoding();
 
     // Add any platform specific parameters
     platformInitializeWebProcess(parameters);
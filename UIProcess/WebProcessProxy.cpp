@@ -154,6 +154,9 @@ void WebProcessProxy::connectionWillOpen(IPC::Connection& connection)
 {
     ASSERT(this->connection() == &connection);
 
+    if (m_processPool->configuration().usesPackedIPCEncoding())
+        connection.setEncodingFormat(IPC::EncodingFormat::Packed);
+
 #if ENABLE(SEC_ITEM_SHIM)
     SecItemShimProxy::singleton().initializeConnection(connection);
 #endif
@@ -45,8 +45,8 @@ using namespace WebCore;
 namespace WebKit {
 
 constexpr unsigned operatingDatesWindow { 30 };
-constexpr unsigned statisticsModelVersion { 9 };
 constexpr unsigned maxImportance { 3 };
+constexpr size_t minimumPruningCandidatesForRebuild { 128 };
 
 template<typename T> static inline String isolatedPrimaryDomain(const T& value)
 {
@@ -206,10 +206,16 @@ void WebResourceLoadStatisticsStore::processStatisticsAndDataRecords()
 {
     m_statisticsQueue->dispatch([this, protectedThis = makeRef(*this)] () {
         if (m_parameters.shouldClassifyResourcesBeforeDataRecordsRemoval) {
-            for (auto& resourceStatistic : m_resourceStatisticsMap.values()) {
-                if (!resourceStatistic.isPrevalentResource && m_resourceLoadStatisticsClassifier.hasPrevalentResourceCharacteristics(resourceStatistic))
+            // Only entries that changed since they were last classified can have become prevalent.
+            updateIndexes();
+            for (auto& primaryDomain : m_domainsToClassify) {
+                auto& resourceStatistic = m_resourceStatisticsMap.find(primaryDomain)->value;
+                if (m_resourceLoadStatisticsClassifier.hasPrevalentResourceCharacteristics(resourceStatistic)) {
                     resourceStatistic.isPrevalentResource = true;
+                    markStatisticsAsModified(primaryDomain);
+                }
             }
+            m_domainsToClassify.clear();
         }
         removeDataRecords();
         
@@ -563,11 +569,30 @@ void WebResourceLoadStatisticsStore::setDataRecordsBeingRemoved(bool value)
 ResourceLoadStatistics& WebResourceLoadStatisticsStore::ensureResourceStatisticsForPrimaryDomain(const String& primaryDomain)
 {
     ASSERT(!RunLoop::isMain());
+    // Every caller is about to modify the returned statistics.
+    markStatisticsAsModified(primaryDomain);
     return m_resourceStatisticsMap.ensure(primaryDomain, [&primaryDomain] {
         return ResourceLoadStatistics(primaryDomain);
     }).iterator->value;
 }
 
+const ResourceLoadStatistics* WebResourceLoadStatisticsStore::statisticsForPrimaryDomain(const String& primaryDomain) const
+{
+    ASSERT(!RunLoop::isMain());
+    auto it = m_resourceStatisticsMap.find(primaryDomain);
+    return it == m_resourceStatisticsMap.end() ? nullptr : &it->value;
+}
+
+Vector<WallTime> WebResourceLoadStatisticsStore::operatingDates() const
+{
+    ASSERT(!RunLoop::isMain());
+    Vector<WallTime> dates;
+    dates.reserveInitialCapacity(m_operatingDates.size());
+    for (auto& date : m_operatingDates)
+        dates.uncheckedAppend(WallTime::fromRawSeconds(date.secondsSinceEpoch().value()));
+    return dates;
+}
+
 std::unique_ptr<KeyedEncoder> WebResourceLoadStatisticsStore::createEncoderFromData() const
 {
     ASSERT(!RunLoop::isMain());
@@ -598,10 +623,8 @@ void WebResourceLoadStatisticsStore::mergeWithDataFromDecoder(KeyedDecoder& deco
         return;
 
     double endOfGrandfatheringTimestamp;
-    if (decoder.decodeDouble("endOfGrandfatheringTimestamp", endOfGrandfatheringTimestamp))
-        m_endOfGrandfatheringTimestamp = WallTime::fromRawSeconds(endOfGrandfatheringTimestamp);
-    else
-        m_endOfGrandfatheringTimestamp = { };
+    if (!decoder.decodeDouble("endOfGrandfatheringTimestamp", endOfGrandfatheringTimestamp))
+        endOfGrandfatheringTimestamp = 0;
 
     Vector<ResourceLoadStatistics> loadedStatistics;
     bool succeeded = decoder.decodeObjects("browsingStatistics", loadedStatistics, [](KeyedDecoder& decoderInner, ResourceLoadStatistics& statistics) {
@@ -611,31 +634,62 @@ void WebResourceLoadStatisticsStore::mergeWithDataFromDecoder(KeyedDecoder& deco
     if (!succeeded)
         return;
 
-    mergeStatistics(WTFMove(loadedStatistics));
-    updateCookiePartitioning();
-
-    Vector<OperatingDate> operatingDates;
-    succeeded = decoder.decodeObjects("operatingDates", operatingDates, [](KeyedDecoder& decoder, OperatingDate& date) {
+    Vector<WallTime> operatingDates;
+    succeeded = decoder.decodeObjects("operatingDates", operatingDates, [](KeyedDecoder& decoder, WallTime& date) {
         double value;
         if (!decoder.decodeDouble("date", value))
             return false;
 
-        date = OperatingDate::fromWallTime(WallTime::fromRawSeconds(value));
+        date = WallTime::fromRawSeconds(value);
         return true;
     });
 
     if (!succeeded)
-        return;
+        operatingDates.clear();
+
+    mergeWithPersistedData(WTFMove(loadedStatistics), WallTime::fromRawSeconds(endOfGrandfatheringTimestamp), operatingDates);
+}
+
+void WebResourceLoadStatisticsStore::mergeWithPersistedData(Vector<ResourceLoadStatistics>&& statistics, WallTime endOfGrandfatheringTimestamp, const Vector<WallTime>& operatingDates)
+{
+    ASSERT(!RunLoop::isMain());
+
+    m_endOfGrandfatheringTimestamp = endOfGrandfatheringTimestamp;
 
-    m_operatingDates = mergeOperatingDates(m_operatingDates, WTFMove(operatingDates));
+    // Entries that are new to the memory store match what is on disk, only merged ones need to be written out again.
+    auto domainsWithUnsavedChanges = WTFMove(m_domainsWithUnsavedChanges);
+    for (auto& statistic : statistics) {
+        if (m_resourceStatisticsMap.contains(statistic.highLevelDomain))
+            domainsWithUnsavedChanges.add(statistic.highLevelDomain);
+    }
+    mergeStatistics(WTFMove(statistics));
+    m_domainsWithUnsavedChanges = WTFMove(domainsWithUnsavedChanges);
+
+    updateCookiePartitioning();
+
+    Vector<OperatingDate> newOperatingDates;
+    newOperatingDates.reserveInitialCapacity(operatingDates.size());
+    for (auto date : operatingDates)
+        newOperatingDates.uncheckedAppend(OperatingDate::fromWallTime(date));
+
+    m_operatingDates = mergeOperatingDates(m_operatingDates, WTFMove(newOperatingDates));
 }
 
 void WebResourceLoadStatisticsStore::clearInMemory()
 {
     ASSERT(!RunLoop::isMain());
+    for (auto& primaryDomain : m_resourceStatisticsMap.keys())
+        m_domainsWithUnsavedChanges.add(primaryDomain);
     m_resourceStatisticsMap.clear();
     m_operatingDates.clear();
 
+    m_domainsWithStaleIndexes.clear();
+    m_prevalentResourceDomains.clear();
+    m_domainsMarkedForCookiePartitioning.clear();
+    m_grandfatheredDomains.clear();
+    m_domainsToClassify.clear();
+    m_pruningCandidates.clear();
+
     updateCookiePartitioningForDomains({ }, { }, ShouldClearFirst::Yes);
 }
 
@@ -648,6 +702,7 @@ void WebResourceLoadStatisticsStore::mergeStatistics(Vector<ResourceLoadStatisti
         });
         if (!result.isNewEntry)
             result.iterator->value.merge(statistic);
+        markStatisticsAsModified(result.iterator->key);
     }
 }
 
@@ -660,16 +715,26 @@ void WebResourceLoadStatisticsStore::updateCookiePartitioning()
 {
     ASSERT(!RunLoop::isMain());
 
+    updateIndexes();
+
+    // Only prevalent resources can get their cookies partitioned.
     Vector<String> domainsToRemove;
-    Vector<String> domainsToAdd;
-    for (auto& resourceStatistic : m_resourceStatisticsMap.values()) {
-        bool shouldPartition = shouldPartitionCookies(resourceStatistic);
-        if (resourceStatistic.isMarkedForCookiePartitioning && !shouldPartition) {
+    for (auto& primaryDomain : m_domainsMarkedForCookiePartitioning) {
+        auto& resourceStatistic = m_resourceStatisticsMap.find(primaryDomain)->value;
+        if (!shouldPartitionCookies(resourceStatistic)) {
             resourceStatistic.isMarkedForCookiePartitioning = false;
-            domainsToRemove.append(resourceStatistic.highLevelDomain);
-        } else if (!resourceStatistic.isMarkedForCookiePartitioning && shouldPartition) {
+            domainsToRemove.append(primaryDomain);
+            markStatisticsAsModified(primaryDomain);
+        }
+    }
+
+    Vector<String> domainsToAdd;
+    for (auto& primaryDomain : m_prevalentResourceDomains) {
+        auto& resourceStatistic = m_resourceStatisticsMap.find(primaryDomain)->value;
+        if (!resourceStatistic.isMarkedForCookiePartitioning && shouldPartitionCookies(resourceStatistic)) {
             resourceStatistic.isMarkedForCookiePartitioning = true;
-            domainsToAdd.append(resourceStatistic.highLevelDomain);
+            domainsToAdd.append(primaryDomain);
+            markStatisticsAsModified(primaryDomain);
         }
     }
 
@@ -705,8 +770,11 @@ void WebResourceLoadStatisticsStore::updateCookiePartitioningForDomains(const Ve
 void WebResourceLoadStatisticsStore::resetCookiePartitioningState()
 {
     ASSERT(!RunLoop::isMain());
-    for (auto& resourceStatistic : m_resourceStatisticsMap.values())
-        resourceStatistic.isMarkedForCookiePartitioning = false;
+    updateIndexes();
+    for (auto& primaryDomain : m_domainsMarkedForCookiePartitioning) {
+        m_resourceStatisticsMap.find(primaryDomain)->value.isMarkedForCookiePartitioning = false;
+        markStatisticsAsModified(primaryDomain);
+    }
 }
 
 void WebResourceLoadStatisticsStore::processStatistics(const WTF::Function<void (const ResourceLoadStatistics&)>& processFunction) const
@@ -716,7 +784,7 @@ void WebResourceLoadStatisticsStore::processStatistics(const WTF::Function<void
         processFunction(resourceStatistic);
 }
 
-bool WebResourceLoadStatisticsStore::hasHadUnexpiredRecentUserInteraction(ResourceLoadStatistics& resourceStatistic) const
+bool WebResourceLoadStatisticsStore::hasHadUnexpiredRecentUserInteraction(ResourceLoadStatistics& resourceStatistic)
 {
     if (resourceStatistic.hadUserInteraction && hasStatisticsExpired(resourceStatistic)) {
         // Drop privacy sensitive data because we no longer need it.
@@ -724,6 +792,7 @@ bool WebResourceLoadStatisticsStore::hasHadUnexpiredRecentUserInteraction(Resour
         // it has been reset as opposed to its default -1.
         resourceStatistic.mostRecentUserInteractionTime = { };
         resourceStatistic.hadUserInteraction = false;
+        markStatisticsAsModified(resourceStatistic.highLevelDomain);
     }
 
     return resourceStatistic.hadUserInteraction;
@@ -739,13 +808,20 @@ Vector<String> WebResourceLoadStatisticsStore::topPrivatelyControlledDomainsToRe
     if (shouldClearGrandfathering)
         m_endOfGrandfatheringTimestamp = { };
 
+    updateIndexes();
+
     Vector<String> prevalentResources;
-    for (auto& statistic : m_resourceStatisticsMap.values()) {
-        if (statistic.isPrevalentResource && !hasHadUnexpiredRecentUserInteraction(statistic) && (!shouldCheckForGrandfathering || !statistic.grandfathered))
-            prevalentResources.append(statistic.highLevelDomain);
+    for (auto& primaryDomain : m_prevalentResourceDomains) {
+        auto& statistic = m_resourceStatisticsMap.find(primaryDomain)->value;
+        if (!hasHadUnexpiredRecentUserInteraction(statistic) && (!shouldCheckForGrandfathering || !statistic.grandfathered))
+            prevalentResources.append(primaryDomain);
+    }
 
-        if (shouldClearGrandfathering && statistic.grandfathered)
-            statistic.grandfathered = false;
+    if (shouldClearGrandfathering) {
+        for (auto& primaryDomain : m_grandfatheredDomains) {
+            m_resourceStatisticsMap.find(primaryDomain)->value.grandfathered = false;
+            markStatisticsAsModified(primaryDomain);
+        }
     }
 
     return prevalentResources;
@@ -791,23 +867,6 @@ void WebResourceLoadStatisticsStore::setPruneEntriesDownTo(size_t pruneTargetCou
     m_parameters.pruneEntriesDownTo = pruneTargetCount;
 }
     
-struct StatisticsLastSeen {
-    String topPrivatelyOwnedDomain;
-    WallTime lastSeen;
-};
-    
-static void pruneResources(HashMap<String, WebCore::ResourceLoadStatistics>& statisticsMap, Vector<StatisticsLastSeen>& statisticsToPrune, size_t& numberOfEntriesToPrune)
-{
-    if (statisticsToPrune.size() > numberOfEntriesToPrune) {
-        std::sort(statisticsToPrune.begin(), statisticsToPrune.end(), [](const StatisticsLastSeen& a, const StatisticsLastSeen& b) {
-            return a.lastSeen < b.lastSeen;
-        });
-    }
-
-    for (size_t i = 0, end = std::min(numberOfEntriesToPrune, statisticsToPrune.size()); i != end; ++i, --numberOfEntriesToPrune)
-        statisticsMap.remove(statisticsToPrune[i].topPrivatelyOwnedDomain);
-}
-    
 static unsigned computeImportance(const ResourceLoadStatistics& resourceStatistic)
 {
     unsigned importance = maxImportance;
@@ -817,7 +876,65 @@ static unsigned computeImportance(const ResourceLoadStatistics& resourceStatisti
         importance -= 2;
     return importance;
 }
-    
+
+bool WebResourceLoadStatisticsStore::shouldBePrunedAfter(const PruningCandidate& a, const PruningCandidate& b)
+{
+    // Less important entries are pruned first, least recently seen first within the same importance.
+    if (a.importance != b.importance)
+        return a.importance > b.importance;
+    return a.lastSeen > b.lastSeen;
+}
+
+static void updateSetMembership(HashSet<String>& set, const String& primaryDomain, bool isMember)
+{
+    if (isMember)
+        set.add(primaryDomain);
+    else
+        set.remove(primaryDomain);
+}
+
+void WebResourceLoadStatisticsStore::updateIndexes()
+{
+    ASSERT(!RunLoop::isMain());
+
+    for (auto& primaryDomain : m_domainsWithStaleIndexes) {
+        auto it = m_resourceStatisticsMap.find(primaryDomain);
+        if (it == m_resourceStatisticsMap.end()) {
+            m_prevalentResourceDomains.remove(primaryDomain);
+            m_domainsMarkedForCookiePartitioning.remove(primaryDomain);
+            m_grandfatheredDomains.remove(primaryDomain);
+            m_domainsToClassify.remove(primaryDomain);
+            continue;
+        }
+
+        auto& resourceStatistic = it->value;
+        updateSetMembership(m_prevalentResourceDomains, primaryDomain, resourceStatistic.isPrevalentResource);
+        updateSetMembership(m_domainsMarkedForCookiePartitioning, primaryDomain, resourceStatistic.isMarkedForCookiePartitioning);
+        updateSetMembership(m_grandfatheredDomains, primaryDomain, resourceStatistic.grandfathered);
+        updateSetMembership(m_domainsToClassify, primaryDomain, !resourceStatistic.isPrevalentResource);
+
+        // The entry previously pushed for this domain becomes outdated and gets skipped when popped.
+        m_pruningCandidates.append({ computeImportance(resourceStatistic), resourceStatistic.lastSeen, primaryDomain });
+        std::push_heap(m_pruningCandidates.begin(), m_pruningCandidates.end(), shouldBePrunedAfter);
+    }
+    m_domainsWithStaleIndexes.clear();
+
+    if (m_pruningCandidates.size() > std::max(2 * m_resourceStatisticsMap.size(), minimumPruningCandidatesForRebuild))
+        rebuildPruningCandidates();
+}
+
+void WebResourceLoadStatisticsStore::rebuildPruningCandidates()
+{
+    ASSERT(!RunLoop::isMain());
+    ASSERT(m_domainsWithStaleIndexes.isEmpty());
+
+    m_pruningCandidates.clear();
+    m_pruningCandidates.reserveInitialCapacity(m_resourceStatisticsMap.size());
+    for (auto& resourceStatistic : m_resourceStatisticsMap.values())
+        m_pruningCandidates.uncheckedAppend({ computeImportance(resourceStatistic), resourceStatistic.lastSeen, resourceStatistic.highLevelDomain });
+    std::make_heap(m_pruningCandidates.begin(), m_pruningCandidates.end(), shouldBePrunedAfter);
+}
+
 void WebResourceLoadStatisticsStore::pruneStatisticsIfNeeded()
 {
     ASSERT(!RunLoop::isMain());
@@ -828,13 +945,21 @@ void WebResourceLoadStatisticsStore::pruneStatisticsIfNeeded()
 
     size_t numberOfEntriesLeftToPrune = m_resourceStatisticsMap.size() - m_parameters.pruneEntriesDownTo;
     ASSERT(numberOfEntriesLeftToPrune);
-    
-    Vector<StatisticsLastSeen> resourcesToPrunePerImportance[maxImportance + 1];
-    for (auto& resourceStatistic : m_resourceStatisticsMap.values())
-        resourcesToPrunePerImportance[computeImportance(resourceStatistic)].append({ resourceStatistic.highLevelDomain, resourceStatistic.lastSeen });
-    
-    for (unsigned importance = 0; numberOfEntriesLeftToPrune && importance <= maxImportance; ++importance)
-        pruneResources(m_resourceStatisticsMap, resourcesToPrunePerImportance[importance], numberOfEntriesLeftToPrune);
+
+    updateIndexes();
+
+    while (numberOfEntriesLeftToPrune && !m_pruningCandidates.isEmpty()) {
+        std::pop_heap(m_pruningCandidates.begin(), m_pruningCandidates.end(), shouldBePrunedAfter);
+        auto candidate = m_pruningCandidates.takeLast();
+
+        auto it = m_resourceStatisticsMap.find(candidate.primaryDomain);
+        if (it == m_resourceStatisticsMap.end() || computeImportance(it->value) != candidate.importance || it->value.lastSeen != candidate.lastSeen)
+            continue;
+
+        m_resourceStatisticsMap.remove(it);
+        markStatisticsAsModified(candidate.primaryDomain);
+        --numberOfEntriesLeftToPrune;
+    }
 
     ASSERT(!numberOfEntriesLeftToPrune);
 }
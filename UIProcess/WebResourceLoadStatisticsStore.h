@@ -29,6 +29,7 @@
 #include "ResourceLoadStatisticsClassifier.h"
 #include "ResourceLoadStatisticsPersistentStorage.h"
 #include "WebsiteDataType.h"
+#include <wtf/HashSet.h>
 #include <wtf/MonotonicTime.h>
 #include <wtf/RunLoop.h>
 #include <wtf/Vector.h>
@@ -68,8 +69,10 @@ public:
     ~WebResourceLoadStatisticsStore();
 
     static const OptionSet<WebsiteDataType>& monitoredDataTypes();
+    static constexpr unsigned statisticsModelVersion { 9 };
 
     bool isEmpty() const { return m_resourceStatisticsMap.isEmpty(); }
+    size_t statisticsCount() const { return m_resourceStatisticsMap.size(); }
     WorkQueue& statisticsQueue() { return m_statisticsQueue.get(); }
 
     void setNotifyPagesWhenDataRecordsWereScanned(bool value) { m_parameters.shouldNotifyPagesWhenDataRecordsWereScanned = value; }
@@ -125,6 +128,14 @@ public:
 
     std::unique_ptr<WebCore::KeyedEncoder> createEncoderFromData() const;
     void mergeWithDataFromDecoder(WebCore::KeyedDecoder&);
+    void mergeWithPersistedData(Vector<WebCore::ResourceLoadStatistics>&&, WallTime endOfGrandfatheringTimestamp, const Vector<WallTime>& operatingDates);
+
+    // Used by ResourceLoadStatisticsPersistentStorage to only write out the entries that changed since the last write.
+    const WebCore::ResourceLoadStatistics* statisticsForPrimaryDomain(const String&) const;
+    HashSet<String> takeDomainsWithUnsavedChanges() { return WTFMove(m_domainsWithUnsavedChanges); }
+    WallTime endOfGrandfatheringTimestamp() const { return m_endOfGrandfatheringTimestamp; }
+    Vector<WallTime> operatingDates() const;
+
     void clearInMemory();
     void grandfatherExistingWebsiteData();
 
@@ -145,13 +156,20 @@ private:
 
     bool shouldPartitionCookies(const WebCore::ResourceLoadStatistics&) const;
     bool hasStatisticsExpired(const WebCore::ResourceLoadStatistics&) const;
-    bool hasHadUnexpiredRecentUserInteraction(WebCore::ResourceLoadStatistics&) const;
+    bool hasHadUnexpiredRecentUserInteraction(WebCore::ResourceLoadStatistics&);
     void includeTodayAsOperatingDateIfNecessary();
     Vector<String> topPrivatelyControlledDomainsToRemoveWebsiteDataFor();
     void updateCookiePartitioning();
     void updateCookiePartitioningForDomains(const Vector<String>& domainsToRemove, const Vector<String>& domainsToAdd, ShouldClearFirst);
     void mergeStatistics(Vector<WebCore::ResourceLoadStatistics>&&);
     WebCore::ResourceLoadStatistics& ensureResourceStatisticsForPrimaryDomain(const String&);
+    void markStatisticsAsModified(const String& primaryDomain)
+    {
+        m_domainsWithUnsavedChanges.add(primaryDomain);
+        m_domainsWithStaleIndexes.add(primaryDomain);
+    }
+    void updateIndexes();
+    void rebuildPruningCandidates();
 
     void resetCookiePartitioningState();
 
@@ -171,7 +189,23 @@ private:
         bool shouldSubmitTelemetry { true };
     };
 
+    struct PruningCandidate {
+        unsigned importance;
+        WallTime lastSeen;
+        String primaryDomain;
+    };
+    static bool shouldBePrunedAfter(const PruningCandidate&, const PruningCandidate&);
+
     HashMap<String, WebCore::ResourceLoadStatistics> m_resourceStatisticsMap;
+    HashSet<String> m_domainsWithUnsavedChanges;
+
+    // Secondary indexes over m_resourceStatisticsMap, brought up to date by updateIndexes().
+    HashSet<String> m_domainsWithStaleIndexes;
+    HashSet<String> m_prevalentResourceDomains;
+    HashSet<String> m_domainsMarkedForCookiePartitioning;
+    HashSet<String> m_grandfatheredDomains;
+    HashSet<String> m_domainsToClassify;
+    Vector<PruningCandidate> m_pruningCandidates; // Binary heap, may contain outdated entries.
 #if HAVE(CORE_PREDICTION)
     ResourceLoadStatisticsClassifierCocoa m_resourceLoadStatisticsClassifier;
 #else
@@ -75,7 +75,7 @@ WebsiteDataStore::WebsiteDataStore(Configuration configuration, WebCore::Session
     : m_identifier(generateIdentifier())
     , m_sessionID(sessionID)
     , m_configuration(WTFMove(configuration))
-    , m_storageManager(StorageManager::create(m_configuration.localStorageDirectory))
+    , m_storageManager(StorageManager::create(m_configuration.localStorageDirectory, m_configuration.localStorageDurability))
     , m_queue(WorkQueue::create("com.apple.WebKit.WebsiteDataStore"))
 {
     platformInitialize();
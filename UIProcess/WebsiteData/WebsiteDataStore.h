@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include "LocalStorageDurability.h"
 #include "WebProcessLifetimeObserver.h"
 #include <WebCore/Cookie.h>
 #include <WebCore/SecurityOriginData.h>
@@ -75,6 +76,7 @@ public:
         String indexedDBDatabaseDirectory;
         String webSQLDatabaseDirectory;
         String localStorageDirectory;
+        LocalStorageDurability localStorageDurability { LocalStorageDurability::Interval };
         String mediaKeysStorageDirectory;
         String resourceLoadStatisticsDirectory;
         String javaScriptConfigurationDirectory;
@@ -133,27 +133,77 @@ void WebCookieManager::notifyCookiesDidChange(SessionID sessionID)
 {
     ASSERT(RunLoop::isMain());
     m_process->send(Messages::WebCookieManagerProxy::CookiesDidChange(sessionID), 0);
+
+    if (m_cookiesDidChangeHandler)
+        m_cookiesDidChangeHandler(sessionID);
+}
+
+void WebCookieManager::cookiesDidChange(SessionID sessionID)
+{
+    ASSERT(RunLoop::isMain());
+    if (m_sessionsObservedByUIProcess.contains(sessionID))
+        m_process->send(Messages::WebCookieManagerProxy::CookiesDidChange(sessionID), 0);
+
+    if (m_cookiesDidChangeHandler)
+        m_cookiesDidChangeHandler(sessionID);
+}
+
+bool WebCookieManager::ensureObservingCookieChanges(SessionID sessionID)
+{
+    if (m_observedSessions.contains(sessionID))
+        return true;
+
+    auto* storageSession = NetworkStorageSession::storageSession(sessionID);
+    if (!storageSession)
+        return false;
+
+    // WebCore only supports a single observer per storage session, so changes are fanned out from here
+    // to both the UI process and the web processes.
+    WebCore::startObservingCookieChanges(*storageSession, [this, sessionID] {
+        cookiesDidChange(sessionID);
+    });
+    m_observedSessions.add(sessionID);
+    return true;
 }
 
 void WebCookieManager::startObservingCookieChanges(SessionID sessionID)
 {
-    if (auto* storageSession = NetworkStorageSession::storageSession(sessionID)) {
-        WebCore::startObservingCookieChanges(*storageSession, [this, sessionID] {
-            notifyCookiesDidChange(sessionID);
-        });
-    }
+    if (ensureObservingCookieChanges(sessionID))
+        m_sessionsObservedByUIProcess.add(sessionID);
 }
 
 void WebCookieManager::stopObservingCookieChanges(SessionID sessionID)
 {
+    m_sessionsObservedByUIProcess.remove(sessionID);
+
+    // Keep observing on behalf of the web processes, whose cookie caches rely on change notifications.
+    if (m_cookiesDidChangeHandler || !m_observedSessions.remove(sessionID))
+        return;
+
     if (auto* storageSession = NetworkStorageSession::storageSession(sessionID))
         WebCore::stopObservingCookieChanges(*storageSession);
 }
 
+bool WebCookieManager::observeCookieChangesForWebProcesses(SessionID sessionID)
+{
+    return m_cookiesDidChangeHandler && ensureObservingCookieChanges(sessionID);
+}
+
+void WebCookieManager::setCookiesDidChangeHandler(Function<void (SessionID)>&& handler)
+{
+    m_cookiesDidChangeHandler = WTFMove(handler);
+}
+
 void WebCookieManager::setHTTPCookieAcceptPolicy(HTTPCookieAcceptPolicy policy, OptionalCallbackID callbackID)
 {
     platformSetHTTPCookieAcceptPolicy(policy);
 
+    // The accept policy affects what document.cookie returns, so cached results must be dropped.
+    if (m_cookiesDidChangeHandler) {
+        for (auto& sessionID : m_observedSessions)
+            m_cookiesDidChangeHandler(sessionID);
+    }
+
     if (callbackID)
         m_process->send(Messages::WebCookieManagerProxy::DidSetHTTPCookieAcceptPolicy(callbackID.callbackID()), 0);
 }
@@ -35,6 +35,8 @@
 #include <chrono>
 #include <stdint.h>
 #include <wtf/Forward.h>
+#include <wtf/Function.h>
+#include <wtf/HashSet.h>
 #include <wtf/Noncopyable.h>
 #include <wtf/Vector.h>
 
@@ -66,6 +68,11 @@ public:
 
     void notifyCookiesDidChange(WebCore::SessionID);
 
+    // Web processes cache document.cookie results only for sessions whose cookie storage is
+    // being observed, so that any change can be pushed to them as an invalidation.
+    bool observeCookieChangesForWebProcesses(WebCore::SessionID);
+    void setCookiesDidChangeHandler(Function<void (WebCore::SessionID)>&&);
+
 private:
     // IPC::MessageReceiver
     void didReceiveMessage(IPC::Connection&, IPC::Decoder&) override;
@@ -88,8 +95,13 @@ private:
 
     void startObservingCookieChanges(WebCore::SessionID);
     void stopObservingCookieChanges(WebCore::SessionID);
+    bool ensureObservingCookieChanges(WebCore::SessionID);
+    void cookiesDidChange(WebCore::SessionID);
 
     ChildProcess* m_process;
+    HashSet<WebCore::SessionID> m_observedSessions;
+    HashSet<WebCore::SessionID> m_sessionsObservedByUIProcess;
+    Function<void (WebCore::SessionID)> m_cookiesDidChangeHandler;
 };
 
 } // namespace WebKit
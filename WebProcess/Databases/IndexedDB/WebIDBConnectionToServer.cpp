@@ -35,6 +35,7 @@
 #include "WebCoreArgumentCoders.h"
 #include "WebIDBConnectionToClientMessages.h"
 #include "WebIDBResult.h"
+#include "WebIDBValue.h"
 #include "WebProcess.h"
 #include "WebToDatabaseProcessConnection.h"
 #include <WebCore/IDBConnectionToServer.h>
@@ -51,11 +52,15 @@
 #include <WebCore/IDBResultData.h>
 #include <WebCore/IDBTransactionInfo.h>
 #include <WebCore/IDBValue.h>
+#include <wtf/RunLoop.h>
 
 using namespace WebCore;
 
 namespace WebKit {
 
+static const uint32_t initialPrefetchCount = 4;
+static const uint32_t maximumPrefetchCount = 128;
+
 Ref<WebIDBConnectionToServer> WebIDBConnectionToServer::create(SessionID sessionID)
 {
     return adoptRef(*new WebIDBConnectionToServer(sessionID));
@@ -98,6 +103,7 @@ void WebIDBConnectionToServer::openDatabase(const IDBRequestData& requestData)
 
 void WebIDBConnectionToServer::abortTransaction(const IDBResourceIdentifier& transactionIdentifier)
 {
+    forgetReadOnlyTransaction(transactionIdentifier);
     send(Messages::WebIDBConnectionToClient::AbortTransaction(transactionIdentifier));
 }
 
@@ -153,16 +159,19 @@ void WebIDBConnectionToServer::putOrAdd(const IDBRequestData& requestData, const
 
 void WebIDBConnectionToServer::getRecord(const IDBRequestData& requestData, const IDBGetRecordData& getRecordData)
 {
+    didSendReadOnlyRequest(requestData);
     send(Messages::WebIDBConnectionToClient::GetRecord(requestData, getRecordData));
 }
 
 void WebIDBConnectionToServer::getAllRecords(const IDBRequestData& requestData, const IDBGetAllRecordsData& getAllRecordsData)
 {
+    didSendReadOnlyRequest(requestData);
     send(Messages::WebIDBConnectionToClient::GetAllRecords(requestData, getAllRecordsData));
 }
 
 void WebIDBConnectionToServer::getCount(const IDBRequestData& requestData, const IDBKeyRangeData& range)
 {
+    didSendReadOnlyRequest(requestData);
     send(Messages::WebIDBConnectionToClient::GetCount(requestData, range));
 }
 
@@ -173,16 +182,76 @@ void WebIDBConnectionToServer::deleteRecord(const IDBRequestData& requestData, c
 
 void WebIDBConnectionToServer::openCursor(const IDBRequestData& requestData, const IDBCursorInfo& info)
 {
+    if (m_readOnlyTransactions.contains(requestData.transactionIdentifier())) {
+        m_prefetchedCursors.set(info.identifier(), PrefetchedCursor { requestData.transactionIdentifier(), info.cursorDirection() });
+        didSendReadOnlyRequest(requestData);
+    }
     send(Messages::WebIDBConnectionToClient::OpenCursor(requestData, info));
 }
 
+static bool recordReachesIterateTarget(const IDBGetResult& record, const IDBIterateCursorData& data, IndexedDB::CursorDirection direction)
+{
+    bool isForward = direction == IndexedDB::CursorDirection::Next || direction == IndexedDB::CursorDirection::NextNoDuplicate;
+    int keyComparison = record.keyData().compare(data.keyData);
+    if (keyComparison)
+        return isForward ? keyComparison > 0 : keyComparison < 0;
+    if (data.primaryKeyData.isNull())
+        return true;
+
+    int primaryKeyComparison = record.primaryKeyData().compare(data.primaryKeyData);
+    return isForward ? primaryKeyComparison >= 0 : primaryKeyComparison <= 0;
+}
+
+// Consumes prefetched records up to the one the iteration lands on. If the batch runs out first,
+// data is adjusted to continue from the last prefetched record, which is where the cursor in the
+// DatabaseProcess stopped.
+static std::optional<IDBGetResult> takePrefetchedRecord(Deque<IDBGetResult>& records, IDBIterateCursorData& data, IndexedDB::CursorDirection direction)
+{
+    while (!records.isEmpty()) {
+        auto record = records.takeFirst();
+        if (record.keyData().isNull())
+            return record;
+
+        if (!data.keyData.isNull()) {
+            if (recordReachesIterateTarget(record, data, direction))
+                return record;
+            continue;
+        }
+
+        if (data.count <= 1)
+            return record;
+        --data.count;
+    }
+    return std::nullopt;
+}
+
 void WebIDBConnectionToServer::iterateCursor(const IDBRequestData& requestData, const IDBIterateCursorData& data)
 {
-    send(Messages::WebIDBConnectionToClient::IterateCursor(requestData, data));
+    auto iterator = m_prefetchedCursors.find(requestData.cursorIdentifier());
+    if (iterator == m_prefetchedCursors.end()) {
+        send(Messages::WebIDBConnectionToClient::IterateCursor(requestData, data, 0));
+        return;
+    }
+
+    auto& cursor = iterator->value;
+    auto remainingData = data;
+    if (auto record = takePrefetchedRecord(cursor.records, remainingData, cursor.direction)) {
+        enqueuePrefetchedResult(cursor.transactionIdentifier, IDBResultData::iterateCursorSuccess(requestData.requestIdentifier(), *record));
+        return;
+    }
+
+    // Every trip to the DatabaseProcess asks for a longer batch. The DatabaseProcess cuts a batch
+    // short once its records get large.
+    cursor.prefetchCount = cursor.prefetchCount ? std::min(cursor.prefetchCount * 2, maximumPrefetchCount) : initialPrefetchCount;
+    m_pendingCursorPrefetches.set(requestData.requestIdentifier(), requestData.cursorIdentifier());
+    didSendReadOnlyRequest(requestData);
+    send(Messages::WebIDBConnectionToClient::IterateCursor(requestData, remainingData, cursor.prefetchCount));
 }
 
 void WebIDBConnectionToServer::establishTransaction(uint64_t databaseConnectionIdentifier, const IDBTransactionInfo& info)
 {
+    if (info.mode() == IDBTransactionMode::Readonly)
+        m_readOnlyTransactions.add(info.identifier(), Deque<PendingReadOnlyRequest> { });
     send(Messages::WebIDBConnectionToClient::EstablishTransaction(databaseConnectionIdentifier, info));
 }
 
@@ -233,11 +302,15 @@ void WebIDBConnectionToServer::didOpenDatabase(const IDBResultData& result)
 
 void WebIDBConnectionToServer::didAbortTransaction(const IDBResourceIdentifier& transactionIdentifier, const IDBError& error)
 {
+    deliverPrefetchedResults(transactionIdentifier);
+    forgetReadOnlyTransaction(transactionIdentifier);
     m_connectionToServer->didAbortTransaction(transactionIdentifier, error);
 }
 
 void WebIDBConnectionToServer::didCommitTransaction(const IDBResourceIdentifier& transactionIdentifier, const IDBError& error)
 {
+    deliverPrefetchedResults(transactionIdentifier);
+    forgetReadOnlyTransaction(transactionIdentifier);
     m_connectionToServer->didCommitTransaction(transactionIdentifier, error);
 }
 
@@ -289,7 +362,7 @@ static void preregisterSandboxExtensionsIfNecessary(const WebIDBResult& result)
         return;
     }
 
-    const auto filePaths = resultType == IDBResultType::GetAllRecordsSuccess ? result.resultData().getAllResult().allBlobFilePaths() : result.resultData().getResult().value().blobFilePaths();
+    auto filePaths = result.blobFilePaths();
 
 #if ENABLE(SANDBOX_EXTENSIONS)
     ASSERT(filePaths.size() == result.handles().size());
@@ -299,22 +372,98 @@ static void preregisterSandboxExtensionsIfNecessary(const WebIDBResult& result)
         WebProcess::singleton().networkConnection().connection().send(Messages::NetworkConnectionToWebProcess::PreregisterSandboxExtensionsForOptionallyFileBackedBlob(filePaths, result.handles()), 0);
 }
 
+void WebIDBConnectionToServer::didSendReadOnlyRequest(const IDBRequestData& requestData)
+{
+    auto iterator = m_readOnlyTransactions.find(requestData.transactionIdentifier());
+    if (iterator == m_readOnlyTransactions.end())
+        return;
+
+    iterator->value.append({ requestData.requestIdentifier(), std::nullopt });
+    m_readOnlyRequestTransactions.set(requestData.requestIdentifier(), requestData.transactionIdentifier());
+}
+
+template<typename DeliverFunction> void WebIDBConnectionToServer::deliverResultInOrder(const IDBResultData& result, DeliverFunction&& deliver)
+{
+    auto requestIterator = m_readOnlyRequestTransactions.find(result.requestIdentifier());
+    if (requestIterator == m_readOnlyRequestTransactions.end()) {
+        deliver();
+        return;
+    }
+
+    auto transactionIdentifier = requestIterator->value;
+    m_readOnlyRequestTransactions.remove(requestIterator);
+
+    deliverPrefetchedResults(transactionIdentifier);
+    auto iterator = m_readOnlyTransactions.find(transactionIdentifier);
+    if (iterator != m_readOnlyTransactions.end() && !iterator->value.isEmpty()) {
+        ASSERT(iterator->value.first().requestIdentifier == result.requestIdentifier());
+        iterator->value.removeFirst();
+    }
+
+    deliver();
+    deliverPrefetchedResults(transactionIdentifier);
+}
+
+void WebIDBConnectionToServer::enqueuePrefetchedResult(const IDBResourceIdentifier& transactionIdentifier, IDBResultData&& result)
+{
+    auto iterator = m_readOnlyTransactions.find(transactionIdentifier);
+    ASSERT(iterator != m_readOnlyTransactions.end());
+    if (iterator == m_readOnlyTransactions.end())
+        return;
+
+    auto requestIdentifier = result.requestIdentifier();
+    iterator->value.append({ requestIdentifier, WTFMove(result) });
+
+    // WebCore does not expect the result while it is still issuing the request.
+    RunLoop::main().dispatch([this, protectedThis = makeRef(*this), transactionIdentifier] {
+        deliverPrefetchedResults(transactionIdentifier);
+    });
+}
+
+void WebIDBConnectionToServer::deliverPrefetchedResults(const IDBResourceIdentifier& transactionIdentifier)
+{
+    while (true) {
+        auto iterator = m_readOnlyTransactions.find(transactionIdentifier);
+        if (iterator == m_readOnlyTransactions.end() || iterator->value.isEmpty() || !iterator->value.first().prefetchedResult)
+            return;
+
+        auto result = *iterator->value.takeFirst().prefetchedResult;
+        m_connectionToServer->didIterateCursor(result);
+    }
+}
+
+void WebIDBConnectionToServer::forgetReadOnlyTransaction(const IDBResourceIdentifier& transactionIdentifier)
+{
+    if (!m_readOnlyTransactions.remove(transactionIdentifier))
+        return;
+
+    m_prefetchedCursors.removeIf([&](auto& entry) {
+        return entry.value.transactionIdentifier == transactionIdentifier;
+    });
+}
+
 void WebIDBConnectionToServer::didGetRecord(const WebIDBResult& result)
 {
     preregisterSandboxExtensionsIfNecessary(result);
-    m_connectionToServer->didGetRecord(result.resultData());
+    deliverResultInOrder(result.resultData(), [&] {
+        m_connectionToServer->didGetRecord(result.resultData());
+    });
 }
 
 void WebIDBConnectionToServer::didGetAllRecords(const WebIDBResult& result)
 {
     if (result.resultData().getAllResult().type() == IndexedDB::GetAllType::Values)
         preregisterSandboxExtensionsIfNecessary(result);
-    m_connectionToServer->didGetAllRecords(result.resultData());
+    deliverResultInOrder(result.resultData(), [&] {
+        m_connectionToServer->didGetAllRecords(result.resultData());
+    });
 }
 
 void WebIDBConnectionToServer::didGetCount(const IDBResultData& result)
 {
-    m_connectionToServer->didGetCount(result);
+    deliverResultInOrder(result, [&] {
+        m_connectionToServer->didGetCount(result);
+    });
 }
 
 void WebIDBConnectionToServer::didDeleteRecord(const IDBResultData& result)
@@ -325,13 +474,29 @@ void WebIDBConnectionToServer::didDeleteRecord(const IDBResultData& result)
 void WebIDBConnectionToServer::didOpenCursor(const WebIDBResult& result)
 {
     preregisterSandboxExtensionsIfNecessary(result);
-    m_connectionToServer->didOpenCursor(result.resultData());
+    deliverResultInOrder(result.resultData(), [&] {
+        m_connectionToServer->didOpenCursor(result.resultData());
+    });
 }
 
 void WebIDBConnectionToServer::didIterateCursor(const WebIDBResult& result)
 {
     preregisterSandboxExtensionsIfNecessary(result);
-    m_connectionToServer->didIterateCursor(result.resultData());
+
+    auto prefetchIterator = m_pendingCursorPrefetches.find(result.resultData().requestIdentifier());
+    if (prefetchIterator != m_pendingCursorPrefetches.end()) {
+        auto cursorIterator = m_prefetchedCursors.find(prefetchIterator->value);
+        m_pendingCursorPrefetches.remove(prefetchIterator);
+        if (cursorIterator != m_prefetchedCursors.end()) {
+            ASSERT(cursorIterator->value.records.isEmpty());
+            for (auto& prefetchedResult : result.prefetchedResults())
+                cursorIterator->value.records.append(prefetchedResult.getResult());
+        }
+    }
+
+    deliverResultInOrder(result.resultData(), [&] {
+        m_connectionToServer->didIterateCursor(result.resultData());
+    });
 }
 
 void WebIDBConnectionToServer::fireVersionChangeEvent(uint64_t uniqueDatabaseConnectionIdentifier, const IDBResourceIdentifier& requestIdentifier, uint64_t requestedVersion)
@@ -361,6 +526,11 @@ void WebIDBConnectionToServer::didGetAllDatabaseNames(uint64_t callbackID, const
 
 void WebIDBConnectionToServer::connectionToServerLost()
 {
+    m_prefetchedCursors.clear();
+    m_pendingCursorPrefetches.clear();
+    m_readOnlyTransactions.clear();
+    m_readOnlyRequestTransactions.clear();
+
     m_connectionToServer->connectionToServerLost({ WebCore::IDBDatabaseException::UnknownError, ASCIILiteral("An internal error was encountered in the Indexed Database server") });
 }
 
@@ -30,7 +30,13 @@
 #include "MessageSender.h"
 #include "SandboxExtension.h"
 #include <WebCore/IDBConnectionToServer.h>
+#include <WebCore/IDBGetResult.h>
+#include <WebCore/IDBResourceIdentifier.h>
+#include <WebCore/IDBResultData.h>
+#include <WebCore/IndexedDB.h>
 #include <WebCore/SessionID.h>
+#include <wtf/Deque.h>
+#include <wtf/HashMap.h>
 
 namespace WebKit {
 
@@ -113,10 +119,38 @@ private:
 
     IPC::Connection* messageSenderConnection() final;
 
+    void didSendReadOnlyRequest(const WebCore::IDBRequestData&);
+    template<typename DeliverFunction> void deliverResultInOrder(const WebCore::IDBResultData&, DeliverFunction&&);
+    void enqueuePrefetchedResult(const WebCore::IDBResourceIdentifier& transactionIdentifier, WebCore::IDBResultData&&);
+    void deliverPrefetchedResults(const WebCore::IDBResourceIdentifier& transactionIdentifier);
+    void forgetReadOnlyTransaction(const WebCore::IDBResourceIdentifier& transactionIdentifier);
+
     uint64_t m_identifier { 0 };
     bool m_isOpenInServer { false };
     RefPtr<WebCore::IDBClient::IDBConnectionToServer> m_connectionToServer;
     WebCore::SessionID m_sessionID;
+
+    // Cursors in read-only transactions are iterated in batches: the DatabaseProcess answers an
+    // iteration with the requested record plus the ones after it, and later iterations are served
+    // from those. Nothing can write to the object store while a read-only transaction is running,
+    // so the batch stays valid until the transaction finishes.
+    struct PrefetchedCursor {
+        WebCore::IDBResourceIdentifier transactionIdentifier;
+        WebCore::IndexedDB::CursorDirection direction { WebCore::IndexedDB::CursorDirection::Next };
+        Deque<WebCore::IDBGetResult> records;
+        uint32_t prefetchCount { 0 };
+    };
+    HashMap<WebCore::IDBResourceIdentifier, PrefetchedCursor> m_prefetchedCursors;
+    HashMap<WebCore::IDBResourceIdentifier, WebCore::IDBResourceIdentifier> m_pendingCursorPrefetches;
+
+    // Results must reach WebCore in request order, so results served from a prefetched batch wait
+    // behind any request of the same transaction that is still in flight to the DatabaseProcess.
+    struct PendingReadOnlyRequest {
+        WebCore::IDBResourceIdentifier requestIdentifier;
+        std::optional<WebCore::IDBResultData> prefetchedResult;
+    };
+    HashMap<WebCore::IDBResourceIdentifier, Deque<PendingReadOnlyRequest>> m_readOnlyTransactions;
+    HashMap<WebCore::IDBResourceIdentifier, WebCore::IDBResourceIdentifier> m_readOnlyRequestTransactions;
 };
 
 } // namespace WebKit
@@ -105,6 +105,7 @@ void NetworkProcessConnection::didClose(IPC::Connection&)
         handler(dummyFilenames);
 
     m_writeBlobToFileCompletionHandlers.clear();
+    m_cookieCache.clear();
 }
 
 void NetworkProcessConnection::didReceiveInvalidMessage(IPC::Connection&, IPC::StringReference, IPC::StringReference)
@@ -128,6 +129,21 @@ void NetworkProcessConnection::didWriteBlobsToTemporaryFiles(uint64_t requestIde
         handler(filenames);
 }
 
+void NetworkProcessConnection::cookiesDidChange(SessionID sessionID)
+{
+    m_cookieCache.clear(sessionID);
+}
+
+void NetworkProcessConnection::cookiesDidChangeForHost(SessionID sessionID, const String& host)
+{
+    m_cookieCache.clear(sessionID, host);
+}
+
+void NetworkProcessConnection::allCookiesDidChange()
+{
+    m_cookieCache.clear();
+}
+
 #if ENABLE(SHAREABLE_RESOURCE)
 void NetworkProcessConnection::didCacheResource(const ResourceRequest& request, const ShareableResource::Handle& handle, SessionID sessionID)
 {
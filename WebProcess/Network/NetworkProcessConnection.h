@@ -28,6 +28,7 @@
 
 #include "Connection.h"
 #include "ShareableResource.h"
+#include "WebCookieCache.h"
 #include <wtf/RefCounted.h>
 #include <wtf/text/WTFString.h>
 
@@ -60,6 +61,8 @@ public:
 
     void writeBlobsToTemporaryFiles(const Vector<String>& blobURLs, Function<void (const Vector<String>& filePaths)>&& completionHandler);
 
+    WebCookieCache& cookieCache() { return m_cookieCache; }
+
 private:
     NetworkProcessConnection(IPC::Connection::Identifier);
 
@@ -70,6 +73,9 @@ private:
     void didReceiveInvalidMessage(IPC::Connection&, IPC::StringReference messageReceiverName, IPC::StringReference messageName) override;
 
     void didWriteBlobsToTemporaryFiles(uint64_t requestIdentifier, const Vector<String>& filenames);
+    void cookiesDidChange(WebCore::SessionID);
+    void cookiesDidChangeForHost(WebCore::SessionID, const String& host);
+    void allCookiesDidChange();
 
 #if ENABLE(SHAREABLE_RESOURCE)
     // Message handlers.
@@ -80,6 +86,8 @@ private:
     Ref<IPC::Connection> m_connection;
 
     HashMap<uint64_t, Function<void (const Vector<String>&)>> m_writeBlobToFileCompletionHandlers;
+
+    WebCookieCache m_cookieCache;
 };
 
 } // namespace WebKit
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "WebCookieCache.h"
+
+#include <WebCore/URL.h>
+#include <wtf/text/StringConcatenate.h>
+
+using namespace WebCore;
+
+namespace WebKit {
+
+// Bounds memory use for pages that touch cookies for many distinct URLs.
+static const unsigned maximumEntriesPerMap = 256;
+
+static String cacheKey(const URL& firstParty, const URL& url)
+{
+    // Cookies are matched on scheme, host and path, so the query and fragment do not need to be part of the key.
+    URL cookieURL = url;
+    cookieURL.setQuery({ });
+    cookieURL.removeFragmentIdentifier();
+    return makeString(firstParty.string(), '\n', cookieURL.string());
+}
+
+WebCookieCache::SessionCache& WebCookieCache::ensureSessionCache(SessionID sessionID)
+{
+    return *m_sessionCaches.ensure(sessionID, [] {
+        return std::make_unique<SessionCache>();
+    }).iterator->value;
+}
+
+std::optional<String> WebCookieCache::lookup(CookiesMap& map, const String& key)
+{
+    auto iterator = map.find(key);
+    if (iterator == map.end())
+        return std::nullopt;
+
+    if (iterator->value.expirationTime <= WallTime::now()) {
+        map.remove(iterator);
+        return std::nullopt;
+    }
+    return iterator->value.value;
+}
+
+void WebCookieCache::add(CookiesMap& map, const String& key, const String& value, const String& host, double expirationTime)
+{
+    auto cookiesExpirationTime = WallTime::fromRawSeconds(expirationTime / 1000);
+    if (cookiesExpirationTime <= WallTime::now())
+        return;
+
+    if (map.size() >= maximumEntriesPerMap)
+        map.clear();
+    map.set(key, CachedCookies { value, host, cookiesExpirationTime });
+}
+
+std::optional<String> WebCookieCache::cookiesForDOM(SessionID sessionID, const URL& firstParty, const URL& url)
+{
+    auto iterator = m_sessionCaches.find(sessionID);
+    if (iterator == m_sessionCaches.end())
+        return std::nullopt;
+    return lookup(iterator->value->cookiesForDOM, cacheKey(firstParty, url));
+}
+
+void WebCookieCache::setCookiesForDOM(SessionID sessionID, const URL& firstParty, const URL& url, const String& cookies, double expirationTime)
+{
+    add(ensureSessionCache(sessionID).cookiesForDOM, cacheKey(firstParty, url), cookies, url.host(), expirationTime);
+}
+
+std::optional<String> WebCookieCache::cookieRequestHeaderFieldValue(SessionID sessionID, const URL& firstParty, const URL& url)
+{
+    auto iterator = m_sessionCaches.find(sessionID);
+    if (iterator == m_sessionCaches.end())
+        return std::nullopt;
+    return lookup(iterator->value->requestHeaderFieldValues, cacheKey(firstParty, url));
+}
+
+void WebCookieCache::setCookieRequestHeaderFieldValue(SessionID sessionID, const URL& firstParty, const URL& url, const String& headerFieldValue, double expirationTime)
+{
+    add(ensureSessionCache(sessionID).requestHeaderFieldValues, cacheKey(firstParty, url), headerFieldValue, url.host(), expirationTime);
+}
+
+std::optional<bool> WebCookieCache::cookiesEnabled(SessionID sessionID, const URL& firstParty, const URL& url)
+{
+    auto sessionIterator = m_sessionCaches.find(sessionID);
+    if (sessionIterator == m_sessionCaches.end())
+        return std::nullopt;
+
+    auto& cookiesEnabled = sessionIterator->value->cookiesEnabled;
+    auto iterator = cookiesEnabled.find(cacheKey(firstParty, url));
+    if (iterator == cookiesEnabled.end())
+        return std::nullopt;
+    return iterator->value;
+}
+
+void WebCookieCache::setCookiesEnabled(SessionID sessionID, const URL& firstParty, const URL& url, bool enabled)
+{
+    auto& cookiesEnabled = ensureSessionCache(sessionID).cookiesEnabled;
+    if (cookiesEnabled.size() >= maximumEntriesPerMap)
+        cookiesEnabled.clear();
+    cookiesEnabled.set(cacheKey(firstParty, url), enabled);
+}
+
+void WebCookieCache::clear(SessionID sessionID)
+{
+    m_sessionCaches.remove(sessionID);
+}
+
+// A response can set cookies for its host or any parent domain that isn't a public suffix, which always includes the
+// last two labels of the host. Matching on those drops more than needed, but never misses an affected host.
+static String cookieDomainForHost(const String& host)
+{
+    size_t lastDot = host.reverseFind('.');
+    if (lastDot == notFound || !lastDot)
+        return host;
+    size_t secondToLastDot = host.reverseFind('.', lastDot - 1);
+    if (secondToLastDot == notFound)
+        return host;
+    return host.substring(secondToLastDot + 1);
+}
+
+static bool hostIsInDomain(const String& host, const String& domain)
+{
+    if (!host.endsWith(domain))
+        return false;
+    return host.length() == domain.length() || host[host.length() - domain.length() - 1] == '.';
+}
+
+void WebCookieCache::removeEntriesForDomain(CookiesMap& map, const String& domain)
+{
+    map.removeIf([&domain](auto& entry) {
+        return hostIsInDomain(entry.value.host, domain);
+    });
+}
+
+void WebCookieCache::clear(SessionID sessionID, const String& host)
+{
+    auto iterator = m_sessionCaches.find(sessionID);
+    if (iterator == m_sessionCaches.end())
+        return;
+
+    auto domain = cookieDomainForHost(host);
+    removeEntriesForDomain(iterator->value->cookiesForDOM, domain);
+    removeEntriesForDomain(iterator->value->requestHeaderFieldValues, domain);
+}
+
+void WebCookieCache::clear()
+{
+    m_sessionCaches.clear();
+}
+
+} // namespace WebKit
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 Apple Inc. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY APPLE INC. AND ITS CONTRIBUTORS ``AS IS''
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL APPLE INC. OR ITS CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF
+ * THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <WebCore/SessionID.h>
+#include <wtf/HashMap.h>
+#include <wtf/Noncopyable.h>
+#include <wtf/Optional.h>
+#include <wtf/WallTime.h>
+#include <wtf/text/StringHash.h>
+#include <wtf/text/WTFString.h>
+
+namespace WebCore {
+class URL;
+}
+
+namespace WebKit {
+
+// Caches the results of cookie queries made on behalf of the DOM so that repeated document.cookie reads
+// do not each require a synchronous round trip to the network process. The network process only allows
+// results to be cached for sessions it is observing, and sends an invalidation whenever their cookies change.
+class WebCookieCache {
+    WTF_MAKE_NONCOPYABLE(WebCookieCache); WTF_MAKE_FAST_ALLOCATED;
+public:
+    WebCookieCache() = default;
+
+    std::optional<String> cookiesForDOM(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&);
+    void setCookiesForDOM(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&, const String&, double expirationTime);
+
+    std::optional<String> cookieRequestHeaderFieldValue(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&);
+    void setCookieRequestHeaderFieldValue(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&, const String&, double expirationTime);
+
+    std::optional<bool> cookiesEnabled(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&);
+    void setCookiesEnabled(WebCore::SessionID, const WebCore::URL& firstParty, const WebCore::URL&, bool);
+
+    void clear(WebCore::SessionID);
+    // Drops the cached cookies of every host that a response from this host may have set cookies for.
+    void clear(WebCore::SessionID, const String& host);
+    void clear();
+
+private:
+    struct CachedCookies {
+        String value;
+        String host;
+        WallTime expirationTime;
+    };
+    using CookiesMap = HashMap<String, CachedCookies>;
+
+    struct SessionCache {
+        CookiesMap cookiesForDOM;
+        CookiesMap requestHeaderFieldValues;
+        HashMap<String, bool> cookiesEnabled;
+    };
+
+    SessionCache& ensureSessionCache(WebCore::SessionID);
+    static std::optional<String> lookup(CookiesMap&, const String& key);
+    static void add(CookiesMap&, const String& key, const String& value, const String& host, double expirationTime);
+    static void removeEntriesForDomain(CookiesMap&, const String& domain);
+
+    HashMap<WebCore::SessionID, std::unique_ptr<SessionCache>> m_sessionCaches;
+};
+
+} // namespace WebKit
@@ -135,6 +135,40 @@ void WebResourceLoader::didReceiveData(const IPC::DataReference& data, int64_t e
     m_coreLoader->didReceiveData(reinterpret_cast<const char*>(data.data()), data.size(), encodedDataLength, DataPayloadBytes);
 }
 
+void WebResourceLoader::didReceiveDataChunk(uint64_t chunkIdentifier, const SharedMemory::Handle& handle, uint64_t offset, uint64_t size, int64_t encodedDataLength)
+{
+    LOG(Network, "(WebProcess) WebResourceLoader::didReceiveDataChunk of size %" PRIu64 " for '%s'", size, m_coreLoader->url().string().latin1().data());
+
+    if (!chunkIdentifier || !HashMap<uint64_t, RefPtr<SharedMemory>>::isValidKey(chunkIdentifier)) {
+        m_coreLoader->didFail(internalError(m_coreLoader->request().url()));
+        return;
+    }
+
+    auto& chunk = m_dataChunks.add(chunkIdentifier, nullptr).iterator->value;
+    if (!handle.isNull())
+        chunk = SharedMemory::map(handle, SharedMemory::Protection::ReadOnly);
+
+    if (!chunk || offset > chunk->size() || size > chunk->size() - offset) {
+        LOG_ERROR("Unable to map data chunk sent from the network process.");
+        m_coreLoader->didFail(internalError(m_coreLoader->request().url()));
+        return;
+    }
+
+    if (!m_numBytesReceived) {
+        RELEASE_LOG_IF_ALLOWED("didReceiveDataChunk: Started receiving data (pageID = %" PRIu64 ", frameID = %" PRIu64 ", resourceID = %" PRIu64 ")", m_trackingParameters.pageID, m_trackingParameters.frameID, m_trackingParameters.resourceID);
+    }
+    m_numBytesReceived += size;
+
+    Ref<WebResourceLoader> protect(*this);
+    RefPtr<SharedMemory> protectedChunk = chunk;
+
+    // ResourceLoader copies what it needs, so the chunk can be handed back once its last byte was consumed.
+    m_coreLoader->didReceiveData(static_cast<const char*>(protectedChunk->data()) + offset, size, encodedDataLength, DataPayloadBytes);
+
+    if (m_coreLoader && offset + size == protectedChunk->size())
+        send(Messages::NetworkResourceLoader::DidConsumeDataChunk(chunkIdentifier));
+}
+
 void WebResourceLoader::didRetrieveDerivedData(const String& type, const IPC::DataReference& data)
 {
     LOG(Network, "(WebProcess) WebResourceLoader::didRetrieveDerivedData of size %lu for '%s'", data.size(), m_coreLoader->url().string().latin1().data());
@@ -28,6 +28,8 @@
 #include "Connection.h"
 #include "MessageSender.h"
 #include "ShareableResource.h"
+#include "SharedMemory.h"
+#include <wtf/HashMap.h>
 #include <wtf/RefCounted.h>
 #include <wtf/RefPtr.h>
 
@@ -78,6 +80,7 @@ private:
     void didSendData(uint64_t bytesSent, uint64_t totalBytesToBeSent);
     void didReceiveResponse(const WebCore::ResourceResponse&, bool needsContinueDidReceiveResponseMessage);
     void didReceiveData(const IPC::DataReference&, int64_t encodedDataLength);
+    void didReceiveDataChunk(uint64_t chunkIdentifier, const SharedMemory::Handle&, uint64_t offset, uint64_t size, int64_t encodedDataLength);
     void didRetrieveDerivedData(const String& type, const IPC::DataReference&);
     void didFinishResourceLoad(const WebCore::NetworkLoadMetrics&);
     void didFailResourceLoad(const WebCore::ResourceError&);
@@ -88,6 +91,9 @@ private:
     RefPtr<WebCore::ResourceLoader> m_coreLoader;
     TrackingParameters m_trackingParameters;
     size_t m_numBytesReceived { 0 };
+
+    // Chunks of the NetworkResourceBodyStream of this load, mapped until the load is done.
+    HashMap<uint64_t, RefPtr<SharedMemory>> m_dataChunks;
 };
 
 } // namespace WebKit
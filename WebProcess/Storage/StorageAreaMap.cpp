@@ -28,6 +28,7 @@
 
 #include "StorageAreaImpl.h"
 #include "StorageAreaMapMessages.h"
+#include "StorageAreaSnapshot.h"
 #include "StorageManagerMessages.h"
 #include "StorageNamespaceImpl.h"
 #include "WebPage.h"
@@ -48,6 +49,10 @@ using namespace WebCore;
 
 namespace WebKit {
 
+// JavaScript is blocked while waiting for preloaded values, so only wait about as long as a GetValues round trip would
+// take. If they are slower than that, GetValues is no worse.
+static const Seconds preloadValuesTimeout { 100_ms };
+
 static uint64_t generateStorageMapID()
 {
     static uint64_t storageMapID;
@@ -90,6 +95,8 @@ StorageAreaMap::StorageAreaMap(StorageNamespaceImpl* storageNamespace, Ref<WebCo
     }
 
     WebProcess::singleton().addMessageReceiver(Messages::StorageAreaMap::messageReceiverName(), m_storageMapID, *this);
+
+    preloadValues();
 }
 
 StorageAreaMap::~StorageAreaMap()
@@ -182,14 +189,35 @@ void StorageAreaMap::resetValues()
     m_pendingValueChanges.clear();
     m_hasPendingClear = false;
     m_hasPendingGetValues = false;
+    m_hasPendingPreload = false;
     m_currentSeed++;
 }
 
+void StorageAreaMap::preloadValues()
+{
+    ASSERT(m_storageType != StorageType::EphemeralLocal);
+    ASSERT(!m_storageMap);
+
+    m_hasPendingPreload = true;
+    WebProcess::singleton().parentProcessConnection()->send(Messages::StorageManager::PreloadValues(m_storageMapID, m_currentSeed), 0);
+}
+
 void StorageAreaMap::loadValuesIfNeeded()
 {
     if (m_storageMap)
         return;
 
+    // Only wait for values that are already on their way. This does not dispatch any other incoming messages, which
+    // matters because we may be called from within JavaScript code.
+    if (m_hasPendingPreload) {
+        WebProcess::singleton().parentProcessConnection()->waitForAndDispatchImmediately<Messages::StorageAreaMap::DidPreloadValues>(m_storageMapID, preloadValuesTimeout);
+        if (m_storageMap)
+            return;
+
+        // Ignore the preloaded values if they do arrive later, the ones we get here are more recent.
+        m_hasPendingPreload = false;
+    }
+
     HashMap<String, String> values;
     // FIXME: This should use a special sendSync flag to indicate that we don't want to process incoming messages while waiting for a reply.
     // (This flag does not yet exist). Since loadValuesIfNeeded() ends up being called from within JavaScript code, processing incoming synchronous messages
@@ -203,12 +231,37 @@ void StorageAreaMap::loadValuesIfNeeded()
     m_hasPendingGetValues = true;
 }
 
+void StorageAreaMap::didPreloadValues(uint64_t storageMapSeed, const SharedMemory::Handle& handle, uint64_t encodedSize)
+{
+    if (m_currentSeed != storageMapSeed || !m_hasPendingPreload)
+        return;
+
+    m_hasPendingPreload = false;
+
+    HashMap<String, String> values;
+    if (!handle.isNull()) {
+        auto sharedMemory = SharedMemory::map(handle, SharedMemory::Protection::ReadOnly);
+        if (!sharedMemory || !StorageAreaSnapshot::decode(*sharedMemory, encodedSize, values)) {
+            // Leave m_storageMap null so that loadValuesIfNeeded() falls back to GetValues.
+            return;
+        }
+    }
+
+    // Whatever was received before this snapshot is already reflected in it. If this message was dispatched ahead of
+    // storage events that were sent earlier, they must be ignored until the DidGetValues message that follows it.
+    m_storageMap = StorageMap::create(m_quotaInBytes);
+    m_storageMap->importItems(values);
+    m_hasPendingGetValues = true;
+}
+
 void StorageAreaMap::didGetValues(uint64_t storageMapSeed)
 {
     if (m_currentSeed != storageMapSeed)
         return;
 
-    ASSERT(m_hasPendingGetValues);
+    // If the preloaded values did not arrive in time there can be two of these for the same seed. The events
+    // between them are already reflected in the values we got from GetValues, and replaying them in order
+    // ends up in the same state.
     m_hasPendingGetValues = false;
 }
 
@@ -27,6 +27,7 @@
 #define StorageAreaMap_h
 
 #include "MessageReceiver.h"
+#include "SharedMemory.h"
 #include <WebCore/SecurityOrigin.h>
 #include <WebCore/StorageArea.h>
 #include <wtf/Forward.h>
@@ -67,6 +68,7 @@ private:
     // IPC::MessageReceiver
     void didReceiveMessage(IPC::Connection&, IPC::Decoder&) override;
 
+    void didPreloadValues(uint64_t storageMapSeed, const SharedMemory::Handle&, uint64_t encodedSize);
     void didGetValues(uint64_t storageMapSeed);
     void didSetItem(uint64_t storageMapSeed, const String& key, bool quotaError);
     void didRemoveItem(uint64_t storageMapSeed, const String& key);
@@ -76,6 +78,7 @@ private:
     void clearCache();
 
     void resetValues();
+    void preloadValues();
     void loadValuesIfNeeded();
 
     bool shouldApplyChangeForKey(const String& key) const;
@@ -98,6 +101,7 @@ private:
     uint64_t m_currentSeed;
     bool m_hasPendingClear;
     bool m_hasPendingGetValues;
+    bool m_hasPendingPreload { false };
     HashCountedSet<String> m_pendingValueChanges;
 };
 
@@ -111,22 +111,41 @@ BlobRegistry* WebPlatformStrategies::createBlobRegistry()
 
 String WebPlatformStrategies::cookiesForDOM(const NetworkStorageSession& session, const URL& firstParty, const URL& url)
 {
+    auto& networkConnection = WebProcess::singleton().networkConnection();
+    if (auto cachedCookies = networkConnection.cookieCache().cookiesForDOM(session.sessionID(), firstParty, url))
+        return WTFMove(*cachedCookies);
+
     String result;
-    if (!WebProcess::singleton().networkConnection().connection().sendSync(Messages::NetworkConnectionToWebProcess::CookiesForDOM(session.sessionID(), firstParty, url), Messages::NetworkConnectionToWebProcess::CookiesForDOM::Reply(result), 0))
+    std::optional<double> cacheExpirationTime;
+    if (!networkConnection.connection().sendSync(Messages::NetworkConnectionToWebProcess::CookiesForDOM(session.sessionID(), firstParty, url), Messages::NetworkConnectionToWebProcess::CookiesForDOM::Reply(result, cacheExpirationTime), 0))
         return String();
+
+    if (cacheExpirationTime)
+        networkConnection.cookieCache().setCookiesForDOM(session.sessionID(), firstParty, url, result, *cacheExpirationTime);
     return result;
 }
 
 void WebPlatformStrategies::setCookiesFromDOM(const NetworkStorageSession& session, const URL& firstParty, const URL& url, const String& cookieString)
 {
-    WebProcess::singleton().networkConnection().connection().send(Messages::NetworkConnectionToWebProcess::SetCookiesFromDOM(session.sessionID(), firstParty, url, cookieString), 0);
+    // The next read has to reflect this write, so don't wait for the network process to report the change.
+    auto& networkConnection = WebProcess::singleton().networkConnection();
+    networkConnection.cookieCache().clear(session.sessionID());
+    networkConnection.connection().send(Messages::NetworkConnectionToWebProcess::SetCookiesFromDOM(session.sessionID(), firstParty, url, cookieString), 0);
 }
 
 bool WebPlatformStrategies::cookiesEnabled(const NetworkStorageSession& session, const URL& firstParty, const URL& url)
 {
+    auto& networkConnection = WebProcess::singleton().networkConnection();
+    if (auto cachedResult = networkConnection.cookieCache().cookiesEnabled(session.sessionID(), firstParty, url))
+        return *cachedResult;
+
     bool result;
-    if (!WebProcess::singleton().networkConnection().connection().sendSync(Messages::NetworkConnectionToWebProcess::CookiesEnabled(session.sessionID(), firstParty, url), Messages::NetworkConnectionToWebProcess::CookiesEnabled::Reply(result), 0))
+    bool isCacheable;
+    if (!networkConnection.connection().sendSync(Messages::NetworkConnectionToWebProcess::CookiesEnabled(session.sessionID(), firstParty, url), Messages::NetworkConnectionToWebProcess::CookiesEnabled::Reply(result, isCacheable), 0))
         return false;
+
+    if (isCacheable)
+        networkConnection.cookieCache().setCookiesEnabled(session.sessionID(), firstParty, url, result);
     return result;
 }
 
@@ -137,9 +156,17 @@ String WebPlatformStrategies::cookieRequestHeaderFieldValue(const NetworkStorage
 
 String WebPlatformStrategies::cookieRequestHeaderFieldValue(SessionID sessionID, const URL& firstParty, const URL& url)
 {
+    auto& networkConnection = WebProcess::singleton().networkConnection();
+    if (auto cachedValue = networkConnection.cookieCache().cookieRequestHeaderFieldValue(sessionID, firstParty, url))
+        return WTFMove(*cachedValue);
+
     String result;
-    if (!WebProcess::singleton().networkConnection().connection().sendSync(Messages::NetworkConnectionToWebProcess::CookieRequestHeaderFieldValue(sessionID, firstParty, url), Messages::NetworkConnectionToWebProcess::CookieRequestHeaderFieldValue::Reply(result), 0))
+    std::optional<double> cacheExpirationTime;
+    if (!networkConnection.connection().sendSync(Messages::NetworkConnectionToWebProcess::CookieRequestHeaderFieldValue(sessionID, firstParty, url), Messages::NetworkConnectionToWebProcess::CookieRequestHeaderFieldValue::Reply(result, cacheExpirationTime), 0))
         return String();
+
+    if (cacheExpirationTime)
+        networkConnection.cookieCache().setCookieRequestHeaderFieldValue(sessionID, firstParty, url, result, *cacheExpirationTime);
     return result;
 }
 
@@ -152,7 +179,9 @@ bool WebPlatformStrategies::getRawCookies(const NetworkStorageSession& session,
 
 void WebPlatformStrategies::deleteCookie(const NetworkStorageSession& session, const URL& url, const String& cookieName)
 {
-    WebProcess::singleton().networkConnection().connection().send(Messages::NetworkConnectionToWebProcess::DeleteCookie(session.sessionID(), url, cookieName), 0);
+    auto& networkConnection = WebProcess::singleton().networkConnection();
+    networkConnection.cookieCache().clear(session.sessionID());
+    networkConnection.connection().send(Messages::NetworkConnectionToWebProcess::DeleteCookie(session.sessionID(), url, cookieName), 0);
 }
 
 #if PLATFORM(COCOA)
@@ -166,6 +166,7 @@ private:
     virtual void updateBackingStoreState(uint64_t /*backingStoreStateID*/, bool /*respondImmediately*/, float /*deviceScaleFactor*/, const WebCore::IntSize& /*size*/, 
                                          const WebCore::IntSize& /*scrollOffset*/) { }
     virtual void didUpdate() { }
+    virtual void returnUpdateBitmap(uint32_t /*bitmapPoolIndex*/) { }
 
 #if PLATFORM(COCOA)
     // Used by TiledCoreAnimationDrawingArea.
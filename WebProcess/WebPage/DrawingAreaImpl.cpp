@@ -265,6 +265,14 @@ void DrawingAreaImpl::didUpdate()
     displayTimerFired();
 }
 
+void DrawingAreaImpl::returnUpdateBitmap(uint32_t bitmapPoolIndex)
+{
+    if (bitmapPoolIndex >= updateBitmapPoolSize)
+        return;
+
+    m_updateBitmapPool[bitmapPoolIndex].isInUse = false;
+}
+
 void DrawingAreaImpl::suspendPainting()
 {
     AcceleratedDrawingArea::suspendPainting();
@@ -281,6 +289,12 @@ void DrawingAreaImpl::enterAcceleratedCompositingMode(GraphicsLayer* graphicsLay
     m_scrollOffset = IntSize();
     m_displayTimer.stop();
     m_isWaitingForDidUpdate = false;
+
+    // Buffers still used by the UI process are released when they are returned.
+    for (auto& buffer : m_updateBitmapPool) {
+        if (!buffer.isInUse)
+            buffer = { };
+    }
 }
 
 void DrawingAreaImpl::exitAcceleratedCompositingMode()
@@ -416,13 +430,10 @@ void DrawingAreaImpl::display(UpdateInfo& updateInfo)
     IntSize bitmapSize = bounds.size();
     float deviceScaleFactor = m_webPage.corePage()->deviceScaleFactor();
     bitmapSize.scale(deviceScaleFactor);
-    RefPtr<ShareableBitmap> bitmap = ShareableBitmap::createShareable(bitmapSize, ShareableBitmap::SupportsAlpha);
+    RefPtr<ShareableBitmap> bitmap = createUpdateBitmap(bitmapSize, deviceScaleFactor, updateInfo);
     if (!bitmap)
         return;
 
-    if (!bitmap->createHandle(updateInfo.bitmapHandle))
-        return;
-
     Vector<IntRect> rects;
     if (m_webPage.drawsBackground()) {
         rects = m_dirtyRegion.rects();
@@ -449,6 +460,9 @@ void DrawingAreaImpl::display(UpdateInfo& updateInfo)
     graphicsContext->translate(-bounds.x(), -bounds.y());
 
     for (const auto& rect : rects) {
+        // Pooled buffers contain the previous update.
+        if (updateInfo.bitmapPoolIndex)
+            graphicsContext->clearRect(rect);
         m_webPage.drawRect(*graphicsContext, rect);
         updateInfo.updateRects.append(rect);
     }
@@ -458,4 +472,45 @@ void DrawingAreaImpl::display(UpdateInfo& updateInfo)
     m_displayTimer.stop();
 }
 
+RefPtr<ShareableBitmap> DrawingAreaImpl::createUpdateBitmap(const IntSize& bitmapSize, float deviceScaleFactor, UpdateInfo& updateInfo)
+{
+    // Buffers are sized for the whole view so that any update fits.
+    IntSize viewBitmapSize = m_webPage.size();
+    viewBitmapSize.scale(deviceScaleFactor);
+
+    for (unsigned i = 0; i < updateBitmapPoolSize; ++i) {
+        auto& buffer = m_updateBitmapPool[i];
+        if (buffer.isInUse)
+            continue;
+
+        if (!buffer.sharedMemory || buffer.size != viewBitmapSize) {
+            auto viewBitmap = ShareableBitmap::createShareable(viewBitmapSize, ShareableBitmap::SupportsAlpha);
+            if (!viewBitmap)
+                break;
+            buffer.sharedMemory = viewBitmap->sharedMemory();
+            buffer.size = viewBitmapSize;
+            buffer.wasSent = false;
+        }
+
+        auto bitmap = ShareableBitmap::create(bitmapSize, ShareableBitmap::SupportsAlpha, buffer.sharedMemory);
+        if (!bitmap)
+            break;
+        if (!buffer.wasSent) {
+            if (!bitmap->createHandle(updateInfo.bitmapHandle))
+                break;
+            buffer.wasSent = true;
+        }
+
+        buffer.isInUse = true;
+        updateInfo.bitmapPoolIndex = i;
+        return bitmap;
+    }
+
+    // All the buffers are used by the UI process, fall back to a bitmap for this update only.
+    auto bitmap = ShareableBitmap::createShareable(bitmapSize, ShareableBitmap::SupportsAlpha);
+    if (!bitmap || !bitmap->createHandle(updateInfo.bitmapHandle))
+        return nullptr;
+    return bitmap;
+}
+
 } // namespace WebKit
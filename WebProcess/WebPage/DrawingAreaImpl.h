@@ -27,6 +27,7 @@
 
 #include "AcceleratedDrawingArea.h"
 #include <WebCore/Region.h>
+#include <array>
 
 namespace WebCore {
 class GraphicsContext;
@@ -35,6 +36,7 @@ class GraphicsContext;
 namespace WebKit {
 
 class ShareableBitmap;
+class SharedMemory;
 class UpdateInfo;
 
 class DrawingAreaImpl final : public AcceleratedDrawingArea {
@@ -56,6 +58,7 @@ private:
     // IPC message handlers.
     void updateBackingStoreState(uint64_t backingStoreStateID, bool respondImmediately, float deviceScaleFactor, const WebCore::IntSize&, const WebCore::IntSize& scrollOffset) override;
     void didUpdate() override;
+    void returnUpdateBitmap(uint32_t bitmapPoolIndex) override;
 
     // AcceleratedDrawingArea
     void suspendPainting() override;
@@ -69,6 +72,7 @@ private:
     void displayTimerFired();
     void display();
     void display(UpdateInfo&);
+    RefPtr<ShareableBitmap> createUpdateBitmap(const WebCore::IntSize&, float deviceScaleFactor, UpdateInfo&);
 
     WebCore::Region m_dirtyRegion;
     WebCore::IntRect m_scrollRect;
@@ -82,6 +86,17 @@ private:
     bool m_forceRepaintAfterBackingStoreStateUpdate { false };
 
     RunLoop::Timer<DrawingAreaImpl> m_displayTimer;
+
+    // Update bitmaps are painted into a few buffers sized for the whole view that the UI process
+    // gives back once it has incorporated the update, so displaying doesn't allocate shared memory.
+    struct UpdateBitmapBuffer {
+        RefPtr<SharedMemory> sharedMemory;
+        WebCore::IntSize size;
+        bool isInUse { false };
+        bool wasSent { false };
+    };
+    static const unsigned updateBitmapPoolSize = 2;
+    std::array<UpdateBitmapBuffer, updateBitmapPoolSize> m_updateBitmapPool;
 };
 
 } // namespace WebKit
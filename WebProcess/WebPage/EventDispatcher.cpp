@@ -138,9 +138,30 @@ void EventDispatcher::wheelEvent(uint64_t pageID, const WebWheelEvent& wheelEven
     UNUSED_PARAM(canRubberBandAtBottom);
 #endif
 
-    RunLoop::main().dispatch([protectedThis = makeRef(*this), pageID, wheelEvent]() mutable {
-        protectedThis->dispatchWheelEvent(pageID, wheelEvent);
-    }); 
+    bool shouldDispatch;
+    {
+        LockHolder locker(m_wheelEventsLock);
+        auto& queuedEvents = m_wheelEvents.add(pageID, Deque<QueuedWheelEvent>()).iterator->value;
+
+        // Every queued event has a main thread dispatch of its own, so that it keeps its place among the
+        // other work the main thread does in between. Only the last one, which has not been dispatched
+        // yet, takes in the deltas of following events in the same phase.
+        shouldDispatch = queuedEvents.isEmpty() || !queuedEvents.last().event.canCoalesceWith(wheelEvent);
+        if (shouldDispatch)
+            queuedEvents.append(QueuedWheelEvent { wheelEvent, 0 });
+        else {
+            auto& lastQueuedEvent = queuedEvents.last();
+            lastQueuedEvent.event = lastQueuedEvent.event.coalescedWith(wheelEvent);
+            ++lastQueuedEvent.coalescedEventCount;
+            m_coalescedWheelEventCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (shouldDispatch) {
+        RunLoop::main().dispatch([protectedThis = makeRef(*this), pageID]() mutable {
+            protectedThis->dispatchWheelEvent(pageID);
+        });
+    }
 }
 
 #if ENABLE(MAC_GESTURE_EVENTS)
@@ -180,9 +201,10 @@ void EventDispatcher::touchEvent(uint64_t pageID, const WebKit::WebTouchEvent& t
             const WebTouchEvent& lastTouchEvent = queuedEvents.last();
 
             // Coalesce touch move events.
-            if (touchEvent.type() == WebEvent::TouchMove && lastTouchEvent.type() == WebEvent::TouchMove)
+            if (touchEvent.type() == WebEvent::TouchMove && lastTouchEvent.type() == WebEvent::TouchMove) {
                 queuedEvents.last() = touchEvent;
-            else
+                m_coalescedTouchEventCount.fetch_add(1, std::memory_order_relaxed);
+            } else
                 queuedEvents.append(touchEvent);
         }
     }
@@ -209,15 +231,29 @@ void EventDispatcher::dispatchTouchEvents()
 }
 #endif
 
-void EventDispatcher::dispatchWheelEvent(uint64_t pageID, const WebWheelEvent& wheelEvent)
+void EventDispatcher::dispatchWheelEvent(uint64_t pageID)
 {
     ASSERT(RunLoop::isMain());
 
+    QueuedWheelEvent queuedEvent;
+    {
+        LockHolder locker(m_wheelEventsLock);
+        auto it = m_wheelEvents.find(pageID);
+        ASSERT(it != m_wheelEvents.end() && !it->value.isEmpty());
+        if (it == m_wheelEvents.end())
+            return;
+
+        // Each dispatch handles the event that was queued along with it, later events have dispatches of their own.
+        queuedEvent = it->value.takeFirst();
+        if (it->value.isEmpty())
+            m_wheelEvents.remove(it);
+    }
+
     WebPage* webPage = WebProcess::singleton().webPage(pageID);
     if (!webPage)
         return;
 
-    webPage->wheelEvent(wheelEvent);
+    webPage->wheelEvent(queuedEvent.event, queuedEvent.coalescedEventCount);
 }
 
 #if ENABLE(MAC_GESTURE_EVENTS)
@@ -30,7 +30,9 @@
 
 #include "WebEvent.h"
 #include <WebCore/WheelEventDeltaFilter.h>
+#include <atomic>
 #include <memory>
+#include <wtf/Deque.h>
 #include <wtf/HashMap.h>
 #include <wtf/Lock.h>
 #include <wtf/Noncopyable.h>
@@ -70,6 +72,12 @@ public:
 
     void initializeConnection(IPC::Connection*);
 
+    // Number of events that were merged into an earlier queued event instead of being dispatched on their own.
+    uint64_t coalescedWheelEventCount() const { return m_coalescedWheelEventCount.load(std::memory_order_relaxed); }
+#if ENABLE(IOS_TOUCH_EVENTS)
+    uint64_t coalescedTouchEventCount() const { return m_coalescedTouchEventCount.load(std::memory_order_relaxed); }
+#endif
+
 private:
     EventDispatcher();
 
@@ -87,7 +95,7 @@ private:
 
 
     // This is called on the main thread.
-    void dispatchWheelEvent(uint64_t pageID, const WebWheelEvent&);
+    void dispatchWheelEvent(uint64_t pageID);
 #if ENABLE(IOS_TOUCH_EVENTS)
     void dispatchTouchEvents();
 #endif
@@ -106,9 +114,19 @@ private:
     HashMap<uint64_t, RefPtr<WebCore::ThreadedScrollingTree>> m_scrollingTrees;
 #endif
     std::unique_ptr<WebCore::WheelEventDeltaFilter> m_recentWheelEventDeltaFilter;
+
+    struct QueuedWheelEvent {
+        WebWheelEvent event;
+        unsigned coalescedEventCount { 0 };
+    };
+    Lock m_wheelEventsLock;
+    HashMap<uint64_t, Deque<QueuedWheelEvent>> m_wheelEvents;
+    std::atomic<uint64_t> m_coalescedWheelEventCount { 0 };
+
 #if ENABLE(IOS_TOUCH_EVENTS)
     Lock m_touchEventsLock;
     HashMap<uint64_t, TouchEventQueue> m_touchEvents;
+    std::atomic<uint64_t> m_coalescedTouchEventCount { 0 };
 #endif
 };
 
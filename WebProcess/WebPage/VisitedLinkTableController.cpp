@@ -99,6 +99,16 @@ void VisitedLinkTableController::setVisitedLinkTable(const SharedMemory::Handle&
     invalidateStylesForAllLinks();
 }
 
+void VisitedLinkTableController::appendVisitedLinkTableSegment(const SharedMemory::Handle& handle)
+{
+    auto sharedMemory = SharedMemory::map(handle, SharedMemory::Protection::ReadOnly);
+    if (!sharedMemory)
+        return;
+
+    // The new segment is empty, styles are invalidated when links are added to it.
+    m_visitedLinkTable.appendSegment(sharedMemory.releaseNonNull());
+}
+
 void VisitedLinkTableController::visitedLinkStateChanged(const Vector<WebCore::LinkHash>& linkHashes)
 {
     for (auto linkHash : linkHashes)
@@ -48,6 +48,7 @@ private:
     void didReceiveMessage(IPC::Connection&, IPC::Decoder&) override;
 
     void setVisitedLinkTable(const SharedMemory::Handle&);
+    void appendVisitedLinkTableSegment(const SharedMemory::Handle&);
     void visitedLinkStateChanged(const Vector<WebCore::LinkHash>&);
     void allVisitedLinkStateChanged();
     void removeAllVisitedLinks();
@@ -180,6 +180,8 @@
 #include <WebCore/Settings.h>
 #include <WebCore/ShadowRoot.h>
 #include <WebCore/SharedBuffer.h>
+#include <WebCore/StorageArea.h>
+#include <WebCore/StorageNamespaceProvider.h>
 #include <WebCore/StyleProperties.h>
 #include <WebCore/SubframeLoader.h>
 #include <WebCore/SubstituteData.h>
@@ -412,14 +414,17 @@ WebPage::WebPage(uint64_t pageID, WebPageCreationParameters&& parameters)
 #endif
 
     m_page = std::make_unique<Page>(WTFMove(pageConfiguration));
-    updatePreferences(parameters.store);
+
+    m_preferencesStore = parameters.store;
+    m_preferencesStore.markAllKeysChanged();
+    updatePreferences();
 
     m_drawingArea = DrawingArea::create(*this, parameters);
     m_drawingArea->setPaintingEnabled(false);
     m_drawingArea->setShouldScaleViewToFitDocument(parameters.shouldScaleViewToFitDocument);
 
 #if ENABLE(ASYNC_SCROLLING)
-    m_useAsyncScrolling = parameters.store.getBoolValueForKey(WebPreferencesKey::threadedScrollingEnabledKey());
+    m_useAsyncScrolling = m_preferencesStore.getBoolValueForKey(WebPreferencesKeyIndex::ThreadedScrollingEnabled);
     if (!m_drawingArea->supportsAsyncScrolling())
         m_useAsyncScrolling = false;
     m_page->settings().setScrollingCoordinatorEnabled(m_useAsyncScrolling);
@@ -2009,6 +2014,106 @@ RefPtr<WebImage> WebPage::snapshotAtSize(const IntRect& rect, const IntSize& bit
     return snapshot;
 }
 
+// The number of tiles of a tiled snapshot that are painted ahead of the UI process, which bounds its memory use.
+static const uint32_t maximumSnapshotTilesInFlight = 4;
+
+void WebPage::takeTiledSnapshot(IntRect snapshotRect, uint32_t tileHeight, uint32_t options, uint64_t snapshotID)
+{
+    FrameView* frameView = mainFrameView();
+    if (frameView && snapshotRect.isEmpty())
+        snapshotRect = IntRect(IntPoint(), frameView->contentsSize());
+
+    if (!frameView || snapshotRect.isEmpty() || !tileHeight) {
+        send(Messages::WebPageProxy::DidPaintSnapshotTile(snapshotID, 0, 0, 0, IntRect(), ShareableBitmap::Handle()));
+        return;
+    }
+
+    auto snapshot = std::make_unique<TiledSnapshot>();
+    snapshot->rect = snapshotRect;
+    snapshot->tileHeight = tileHeight;
+    // Printing lays out the whole document in pages, so it can't be painted a tile at a time.
+    snapshot->options = (static_cast<SnapshotOptions>(options) | SnapshotOptionsShareable) & ~SnapshotOptionsPrinting;
+    snapshot->contentsSize = frameView->contentsSize();
+    snapshot->tileCount = snapshotRect.height() / tileHeight + (snapshotRect.height() % tileHeight ? 1 : 0);
+
+    uint32_t bitmapCount = std::min(snapshot->tileCount, maximumSnapshotTilesInFlight);
+    snapshot->images.resize(bitmapCount);
+    m_tiledSnapshots.set(snapshotID, WTFMove(snapshot));
+
+    for (uint32_t bitmapIndex = 0; bitmapIndex < bitmapCount; ++bitmapIndex)
+        paintNextSnapshotTile(snapshotID, bitmapIndex);
+}
+
+void WebPage::releaseSnapshotTile(uint64_t snapshotID, uint32_t bitmapIndex)
+{
+    auto* snapshot = m_tiledSnapshots.get(snapshotID);
+    if (!snapshot || bitmapIndex >= snapshot->images.size())
+        return;
+
+    paintNextSnapshotTile(snapshotID, bitmapIndex);
+}
+
+void WebPage::cancelTiledSnapshot(uint64_t snapshotID)
+{
+    m_tiledSnapshots.remove(snapshotID);
+}
+
+void WebPage::paintNextSnapshotTile(uint64_t snapshotID, uint32_t bitmapIndex)
+{
+    auto* snapshot = m_tiledSnapshots.get(snapshotID);
+    ASSERT(snapshot);
+    ASSERT(snapshot->nextTileIndex < snapshot->tileCount);
+
+    Frame* coreFrame = m_mainFrame->coreFrame();
+    FrameView* frameView = coreFrame ? coreFrame->view() : nullptr;
+    if (frameView)
+        frameView->updateLayoutAndStyleIfNeededRecursive();
+
+    // Tiles after the first few are painted in later run loop iterations, after script and layout had a chance to run.
+    // Changes that keep the contents size end up in the tiles painted after them, but tiles of a page whose size
+    // changed no longer line up, so the snapshot fails instead.
+    if (!frameView || frameView->contentsSize() != snapshot->contentsSize) {
+        m_tiledSnapshots.remove(snapshotID);
+        send(Messages::WebPageProxy::DidPaintSnapshotTile(snapshotID, 0, 0, 0, IntRect(), ShareableBitmap::Handle()));
+        return;
+    }
+
+    uint32_t tileIndex = snapshot->nextTileIndex++;
+    IntRect tileRect = snapshot->rect;
+    tileRect.move(0, tileIndex * snapshot->tileHeight);
+    tileRect.setHeight(std::min<int>(snapshot->tileHeight, snapshot->rect.maxY() - tileRect.y()));
+
+    float scaleFactor = 1;
+    if (!(snapshot->options & SnapshotOptionsExcludeDeviceScaleFactor))
+        scaleFactor = corePage()->deviceScaleFactor();
+
+    IntSize bitmapSize = tileRect.size();
+    bitmapSize.scale(scaleFactor);
+    IntSize tileBitmapSize(tileRect.width(), snapshot->tileHeight);
+    tileBitmapSize.scale(scaleFactor);
+    IntRect tileBitmapRect(IntPoint(0, tileIndex * tileBitmapSize.height()), bitmapSize);
+
+    // All the tiles but the last one have the same size, so the bitmaps are only allocated once.
+    auto& image = snapshot->images[bitmapIndex];
+    if (!image || image->size() != bitmapSize)
+        image = WebImage::create(bitmapSize, snapshotOptionsToImageOptions(snapshot->options));
+
+    ShareableBitmap::Handle handle;
+    if (image) {
+        auto graphicsContext = image->bitmap().createGraphicsContext();
+        paintSnapshotAtSize(tileRect, bitmapSize, snapshot->options, *coreFrame, *frameView, *graphicsContext);
+        graphicsContext = nullptr;
+
+        image->bitmap().createHandle(handle, SharedMemory::Protection::ReadOnly);
+    }
+
+    uint32_t tileCount = snapshot->tileCount;
+    if (handle.isNull() || snapshot->nextTileIndex == tileCount)
+        m_tiledSnapshots.remove(snapshotID);
+
+    send(Messages::WebPageProxy::DidPaintSnapshotTile(snapshotID, tileIndex, tileCount, bitmapIndex, tileBitmapRect, handle));
+}
+
 #if USE(CF)
 RetainPtr<CFDataRef> WebPage::pdfSnapshotAtSize(const IntRect& rect, const IntSize& bitmapSize, SnapshotOptions options)
 {
@@ -2379,7 +2484,7 @@ static bool handleWheelEvent(const WebWheelEvent& wheelEvent, Page* page)
     return page->userInputBridge().handleWheelEvent(platformWheelEvent);
 }
 
-void WebPage::wheelEvent(const WebWheelEvent& wheelEvent)
+void WebPage::wheelEvent(const WebWheelEvent& wheelEvent, unsigned coalescedEventCount)
 {
     m_userActivityHysteresis.impulse();
 
@@ -2387,7 +2492,9 @@ void WebPage::wheelEvent(const WebWheelEvent& wheelEvent)
 
     bool handled = handleWheelEvent(wheelEvent, m_page.get());
 
-    send(Messages::WebPageProxy::DidReceiveEvent(static_cast<uint32_t>(wheelEvent.type()), handled));
+    // The UI process expects an answer for every event it sent, including the ones the EventDispatcher merged into this one.
+    for (unsigned i = 0; i <= coalescedEventCount; ++i)
+        send(Messages::WebPageProxy::DidReceiveEvent(static_cast<uint32_t>(wheelEvent.type()), handled));
 }
 
 static bool handleKeyEvent(const WebKeyboardEvent& keyboardEvent, Page* page)
@@ -3018,154 +3125,263 @@ void WebPage::forceRepaint(CallbackID callbackID)
 void WebPage::preferencesDidChange(const WebPreferencesStore& store)
 {
     WebPreferencesStore::removeTestRunnerOverrides();
-    updatePreferences(store);
+
+    m_preferencesStore = store;
+    m_preferencesStore.markAllKeysChanged();
+    updatePreferences();
+}
+
+void WebPage::preferenceValuesDidChange(const WebPreferencesStore::Changes& changes)
+{
+    m_preferencesStore.applyChanges(changes);
+    updatePreferences();
 }
 
-void WebPage::updatePreferences(const WebPreferencesStore& store)
+void WebPage::updatePreferences()
 {
     Settings& settings = m_page->settings();
+    auto& store = m_preferencesStore;
 
-    m_tabToLinks = store.getBoolValueForKey(WebPreferencesKey::tabsToLinksKey());
-    m_asynchronousPluginInitializationEnabled = store.getBoolValueForKey(WebPreferencesKey::asynchronousPluginInitializationEnabledKey());
-    m_asynchronousPluginInitializationEnabledForAllPlugins = store.getBoolValueForKey(WebPreferencesKey::asynchronousPluginInitializationEnabledForAllPluginsKey());
-    m_artificialPluginInitializationDelayEnabled = store.getBoolValueForKey(WebPreferencesKey::artificialPluginInitializationDelayEnabledKey());
+    if (store.hasChanged(WebPreferencesKeyIndex::TabsToLinks))
+        m_tabToLinks = store.getBoolValueForKey(WebPreferencesKeyIndex::TabsToLinks);
+    if (store.hasChanged(WebPreferencesKeyIndex::AsynchronousPluginInitializationEnabled))
+        m_asynchronousPluginInitializationEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::AsynchronousPluginInitializationEnabled);
+    if (store.hasChanged(WebPreferencesKeyIndex::AsynchronousPluginInitializationEnabledForAllPlugins))
+        m_asynchronousPluginInitializationEnabledForAllPlugins = store.getBoolValueForKey(WebPreferencesKeyIndex::AsynchronousPluginInitializationEnabledForAllPlugins);
+    if (store.hasChanged(WebPreferencesKeyIndex::ArtificialPluginInitializationDelayEnabled))
+        m_artificialPluginInitializationDelayEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::ArtificialPluginInitializationDelayEnabled);
 
-    m_scrollingPerformanceLoggingEnabled = store.getBoolValueForKey(WebPreferencesKey::scrollingPerformanceLoggingEnabledKey());
+    if (store.hasChanged(WebPreferencesKeyIndex::ScrollingPerformanceLoggingEnabled))
+        m_scrollingPerformanceLoggingEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::ScrollingPerformanceLoggingEnabled);
 
 #if PLATFORM(COCOA)
-    m_pdfPluginEnabled = store.getBoolValueForKey(WebPreferencesKey::pdfPluginEnabledKey());
+    if (store.hasChanged(WebPreferencesKeyIndex::PDFPluginEnabled))
+        m_pdfPluginEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::PDFPluginEnabled);
 #endif
 
     // FIXME: This should be generated from macro expansion for all preferences,
     // but we currently don't match the naming of WebCore exactly so we are
     // handrolling the boolean and integer preferences until that is fixed.
 
-#define INITIALIZE_SETTINGS(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) settings.set##KeyUpper(store.get##TypeName##ValueForKey(WebPreferencesKey::KeyLower##Key()));
+#define INITIALIZE_SETTINGS(KeyUpper, KeyLower, TypeName, Type, DefaultValue, HumanReadableName, HumanReadableDescription) \
+    if (store.hasChanged(WebPreferencesKeyIndex::KeyUpper)) \
+        settings.set##KeyUpper(store.get##TypeName##ValueForKey(WebPreferencesKeyIndex::KeyUpper));
 
     FOR_EACH_WEBKIT_STRING_PREFERENCE(INITIALIZE_SETTINGS)
 
 #undef INITIALIZE_SETTINGS
 
-    settings.setScriptEnabled(store.getBoolValueForKey(WebPreferencesKey::javaScriptEnabledKey()));
-    settings.setScriptMarkupEnabled(store.getBoolValueForKey(WebPreferencesKey::javaScriptMarkupEnabledKey()));
-    settings.setLoadsImagesAutomatically(store.getBoolValueForKey(WebPreferencesKey::loadsImagesAutomaticallyKey()));
-    settings.setLoadsSiteIconsIgnoringImageLoadingSetting(store.getBoolValueForKey(WebPreferencesKey::loadsSiteIconsIgnoringImageLoadingPreferenceKey()));
-    settings.setPluginsEnabled(store.getBoolValueForKey(WebPreferencesKey::pluginsEnabledKey()));
-    settings.setJavaEnabled(store.getBoolValueForKey(WebPreferencesKey::javaEnabledKey()));
-    settings.setJavaEnabledForLocalFiles(store.getBoolValueForKey(WebPreferencesKey::javaEnabledForLocalFilesKey()));    
-    settings.setOfflineWebApplicationCacheEnabled(store.getBoolValueForKey(WebPreferencesKey::offlineWebApplicationCacheEnabledKey()));
-    settings.setLocalStorageEnabled(store.getBoolValueForKey(WebPreferencesKey::localStorageEnabledKey()));
-    settings.setXSSAuditorEnabled(store.getBoolValueForKey(WebPreferencesKey::xssAuditorEnabledKey()));
-    settings.setFrameFlattening(static_cast<WebCore::FrameFlattening>(store.getUInt32ValueForKey(WebPreferencesKey::frameFlatteningKey())));
-    settings.setAsyncFrameScrollingEnabled(store.getBoolValueForKey(WebPreferencesKey::asyncFrameScrollingEnabledKey()));
-    if (store.getBoolValueForKey(WebPreferencesKey::privateBrowsingEnabledKey()) && !usesEphemeralSession())
-        setSessionID(SessionID::legacyPrivateSessionID());
-    else if (!store.getBoolValueForKey(WebPreferencesKey::privateBrowsingEnabledKey()) && sessionID() == SessionID::legacyPrivateSessionID())
-        setSessionID(SessionID::defaultSessionID());
-    settings.setDeveloperExtrasEnabled(store.getBoolValueForKey(WebPreferencesKey::developerExtrasEnabledKey()));
-    settings.setJavaScriptRuntimeFlags(RuntimeFlags(store.getUInt32ValueForKey(WebPreferencesKey::javaScriptRuntimeFlagsKey())));
-    settings.setTextAreasAreResizable(store.getBoolValueForKey(WebPreferencesKey::textAreasAreResizableKey()));
-    settings.setNeedsSiteSpecificQuirks(store.getBoolValueForKey(WebPreferencesKey::needsSiteSpecificQuirksKey()));
-    settings.setJavaScriptCanOpenWindowsAutomatically(store.getBoolValueForKey(WebPreferencesKey::javaScriptCanOpenWindowsAutomaticallyKey()));
-    settings.setForceFTPDirectoryListings(store.getBoolValueForKey(WebPreferencesKey::forceFTPDirectoryListingsKey()));
-    settings.setDNSPrefetchingEnabled(store.getBoolValueForKey(WebPreferencesKey::dnsPrefetchingEnabledKey()));
-    settings.setDOMTimersThrottlingEnabled(store.getBoolValueForKey(WebPreferencesKey::domTimersThrottlingEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaScriptEnabled))
+        settings.setScriptEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaScriptEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaScriptMarkupEnabled))
+        settings.setScriptMarkupEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaScriptMarkupEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::LoadsImagesAutomatically))
+        settings.setLoadsImagesAutomatically(store.getBoolValueForKey(WebPreferencesKeyIndex::LoadsImagesAutomatically));
+    if (store.hasChanged(WebPreferencesKeyIndex::LoadsSiteIconsIgnoringImageLoadingPreference))
+        settings.setLoadsSiteIconsIgnoringImageLoadingSetting(store.getBoolValueForKey(WebPreferencesKeyIndex::LoadsSiteIconsIgnoringImageLoadingPreference));
+    if (store.hasChanged(WebPreferencesKeyIndex::PluginsEnabled))
+        settings.setPluginsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PluginsEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaEnabled))
+        settings.setJavaEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaEnabledForLocalFiles))
+        settings.setJavaEnabledForLocalFiles(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaEnabledForLocalFiles));    
+    if (store.hasChanged(WebPreferencesKeyIndex::OfflineWebApplicationCacheEnabled))
+        settings.setOfflineWebApplicationCacheEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::OfflineWebApplicationCacheEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::LocalStorageEnabled))
+        settings.setLocalStorageEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LocalStorageEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::XSSAuditorEnabled))
+        settings.setXSSAuditorEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::XSSAuditorEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::FrameFlattening))
+        settings.setFrameFlattening(static_cast<WebCore::FrameFlattening>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::FrameFlattening)));
+    if (store.hasChanged(WebPreferencesKeyIndex::AsyncFrameScrollingEnabled))
+        settings.setAsyncFrameScrollingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AsyncFrameScrollingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::PrivateBrowsingEnabled)) {
+        bool privateBrowsingEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::PrivateBrowsingEnabled);
+        if (privateBrowsingEnabled && !usesEphemeralSession())
+            setSessionID(SessionID::legacyPrivateSessionID());
+        else if (!privateBrowsingEnabled && sessionID() == SessionID::legacyPrivateSessionID())
+            setSessionID(SessionID::defaultSessionID());
+    }
+    if (store.hasChanged(WebPreferencesKeyIndex::DeveloperExtrasEnabled))
+        settings.setDeveloperExtrasEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DeveloperExtrasEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaScriptRuntimeFlags))
+        settings.setJavaScriptRuntimeFlags(RuntimeFlags(store.getUInt32ValueForKey(WebPreferencesKeyIndex::JavaScriptRuntimeFlags)));
+    if (store.hasChanged(WebPreferencesKeyIndex::TextAreasAreResizable))
+        settings.setTextAreasAreResizable(store.getBoolValueForKey(WebPreferencesKeyIndex::TextAreasAreResizable));
+    if (store.hasChanged(WebPreferencesKeyIndex::NeedsSiteSpecificQuirks))
+        settings.setNeedsSiteSpecificQuirks(store.getBoolValueForKey(WebPreferencesKeyIndex::NeedsSiteSpecificQuirks));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaScriptCanOpenWindowsAutomatically))
+        settings.setJavaScriptCanOpenWindowsAutomatically(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaScriptCanOpenWindowsAutomatically));
+    if (store.hasChanged(WebPreferencesKeyIndex::ForceFTPDirectoryListings))
+        settings.setForceFTPDirectoryListings(store.getBoolValueForKey(WebPreferencesKeyIndex::ForceFTPDirectoryListings));
+    if (store.hasChanged(WebPreferencesKeyIndex::DNSPrefetchingEnabled))
+        settings.setDNSPrefetchingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DNSPrefetchingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::DOMTimersThrottlingEnabled))
+        settings.setDOMTimersThrottlingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DOMTimersThrottlingEnabled));
 #if ENABLE(WEB_ARCHIVE)
-    settings.setWebArchiveDebugModeEnabled(store.getBoolValueForKey(WebPreferencesKey::webArchiveDebugModeEnabledKey()));
-#endif
-    settings.setLocalFileContentSniffingEnabled(store.getBoolValueForKey(WebPreferencesKey::localFileContentSniffingEnabledKey()));
-    settings.setUsesPageCache(store.getBoolValueForKey(WebPreferencesKey::usesPageCacheKey()));
-    settings.setPageCacheSupportsPlugins(store.getBoolValueForKey(WebPreferencesKey::pageCacheSupportsPluginsKey()));
-    settings.setAuthorAndUserStylesEnabled(store.getBoolValueForKey(WebPreferencesKey::authorAndUserStylesEnabledKey()));
-    settings.setPaginateDuringLayoutEnabled(store.getBoolValueForKey(WebPreferencesKey::paginateDuringLayoutEnabledKey()));
-    settings.setDOMPasteAllowed(store.getBoolValueForKey(WebPreferencesKey::domPasteAllowedKey()));
-    settings.setJavaScriptCanAccessClipboard(store.getBoolValueForKey(WebPreferencesKey::javaScriptCanAccessClipboardKey()));
-    settings.setShouldPrintBackgrounds(store.getBoolValueForKey(WebPreferencesKey::shouldPrintBackgroundsKey()));
-    settings.setWebSecurityEnabled(store.getBoolValueForKey(WebPreferencesKey::webSecurityEnabledKey()));
-    settings.setAllowUniversalAccessFromFileURLs(store.getBoolValueForKey(WebPreferencesKey::allowUniversalAccessFromFileURLsKey()));
-    settings.setAllowFileAccessFromFileURLs(store.getBoolValueForKey(WebPreferencesKey::allowFileAccessFromFileURLsKey()));
-    settings.setNeedsStorageAccessFromFileURLsQuirk(store.getBoolValueForKey(WebPreferencesKey::needsStorageAccessFromFileURLsQuirkKey()));
-
-    settings.setMinimumFontSize(store.getDoubleValueForKey(WebPreferencesKey::minimumFontSizeKey()));
-    settings.setMinimumLogicalFontSize(store.getDoubleValueForKey(WebPreferencesKey::minimumLogicalFontSizeKey()));
-    settings.setDefaultFontSize(store.getDoubleValueForKey(WebPreferencesKey::defaultFontSizeKey()));
-    settings.setDefaultFixedFontSize(store.getDoubleValueForKey(WebPreferencesKey::defaultFixedFontSizeKey()));
-    settings.setLayoutFallbackWidth(store.getUInt32ValueForKey(WebPreferencesKey::layoutFallbackWidthKey()));
-    settings.setDeviceWidth(store.getUInt32ValueForKey(WebPreferencesKey::deviceWidthKey()));
-    settings.setDeviceHeight(store.getUInt32ValueForKey(WebPreferencesKey::deviceHeightKey()));
-    settings.setEditableLinkBehavior(static_cast<WebCore::EditableLinkBehavior>(store.getUInt32ValueForKey(WebPreferencesKey::editableLinkBehaviorKey())));
-    settings.setShowsToolTipOverTruncatedText(store.getBoolValueForKey(WebPreferencesKey::showsToolTipOverTruncatedTextKey()));
-
-    settings.setAcceleratedCompositingForOverflowScrollEnabled(store.getBoolValueForKey(WebPreferencesKey::acceleratedCompositingForOverflowScrollEnabledKey()));
-    settings.setAcceleratedCompositingEnabled(store.getBoolValueForKey(WebPreferencesKey::acceleratedCompositingEnabledKey()));
-    settings.setAcceleratedDrawingEnabled(store.getBoolValueForKey(WebPreferencesKey::acceleratedDrawingEnabledKey()));
-    settings.setDisplayListDrawingEnabled(store.getBoolValueForKey(WebPreferencesKey::displayListDrawingEnabledKey()));
-    settings.setCanvasUsesAcceleratedDrawing(store.getBoolValueForKey(WebPreferencesKey::canvasUsesAcceleratedDrawingKey()));
-    settings.setShowDebugBorders(store.getBoolValueForKey(WebPreferencesKey::compositingBordersVisibleKey()));
-    settings.setShowRepaintCounter(store.getBoolValueForKey(WebPreferencesKey::compositingRepaintCountersVisibleKey()));
-    settings.setShowTiledScrollingIndicator(store.getBoolValueForKey(WebPreferencesKey::tiledScrollingIndicatorVisibleKey()));
-    settings.setVisibleDebugOverlayRegions(store.getUInt32ValueForKey(WebPreferencesKey::visibleDebugOverlayRegionsKey()));
-    settings.setUseGiantTiles(store.getBoolValueForKey(WebPreferencesKey::useGiantTilesKey()));
-    settings.setSubpixelAntialiasedLayerTextEnabled(store.getBoolValueForKey(WebPreferencesKey::subpixelAntialiasedLayerTextEnabledKey()));
-
-    settings.setAggressiveTileRetentionEnabled(store.getBoolValueForKey(WebPreferencesKey::aggressiveTileRetentionEnabledKey()));
-    settings.setTemporaryTileCohortRetentionEnabled(store.getBoolValueForKey(WebPreferencesKey::temporaryTileCohortRetentionEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebArchiveDebugModeEnabled))
+        settings.setWebArchiveDebugModeEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebArchiveDebugModeEnabled));
+#endif
+    if (store.hasChanged(WebPreferencesKeyIndex::LocalFileContentSniffingEnabled))
+        settings.setLocalFileContentSniffingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LocalFileContentSniffingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::UsesPageCache))
+        settings.setUsesPageCache(store.getBoolValueForKey(WebPreferencesKeyIndex::UsesPageCache));
+    if (store.hasChanged(WebPreferencesKeyIndex::PageCacheSupportsPlugins))
+        settings.setPageCacheSupportsPlugins(store.getBoolValueForKey(WebPreferencesKeyIndex::PageCacheSupportsPlugins));
+    if (store.hasChanged(WebPreferencesKeyIndex::AuthorAndUserStylesEnabled))
+        settings.setAuthorAndUserStylesEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AuthorAndUserStylesEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::PaginateDuringLayoutEnabled))
+        settings.setPaginateDuringLayoutEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PaginateDuringLayoutEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::DOMPasteAllowed))
+        settings.setDOMPasteAllowed(store.getBoolValueForKey(WebPreferencesKeyIndex::DOMPasteAllowed));
+    if (store.hasChanged(WebPreferencesKeyIndex::JavaScriptCanAccessClipboard))
+        settings.setJavaScriptCanAccessClipboard(store.getBoolValueForKey(WebPreferencesKeyIndex::JavaScriptCanAccessClipboard));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldPrintBackgrounds))
+        settings.setShouldPrintBackgrounds(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldPrintBackgrounds));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebSecurityEnabled))
+        settings.setWebSecurityEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebSecurityEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowUniversalAccessFromFileURLs))
+        settings.setAllowUniversalAccessFromFileURLs(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowUniversalAccessFromFileURLs));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowFileAccessFromFileURLs))
+        settings.setAllowFileAccessFromFileURLs(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowFileAccessFromFileURLs));
+    if (store.hasChanged(WebPreferencesKeyIndex::NeedsStorageAccessFromFileURLsQuirk))
+        settings.setNeedsStorageAccessFromFileURLsQuirk(store.getBoolValueForKey(WebPreferencesKeyIndex::NeedsStorageAccessFromFileURLsQuirk));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::MinimumFontSize))
+        settings.setMinimumFontSize(store.getDoubleValueForKey(WebPreferencesKeyIndex::MinimumFontSize));
+    if (store.hasChanged(WebPreferencesKeyIndex::MinimumLogicalFontSize))
+        settings.setMinimumLogicalFontSize(store.getDoubleValueForKey(WebPreferencesKeyIndex::MinimumLogicalFontSize));
+    if (store.hasChanged(WebPreferencesKeyIndex::DefaultFontSize))
+        settings.setDefaultFontSize(store.getDoubleValueForKey(WebPreferencesKeyIndex::DefaultFontSize));
+    if (store.hasChanged(WebPreferencesKeyIndex::DefaultFixedFontSize))
+        settings.setDefaultFixedFontSize(store.getDoubleValueForKey(WebPreferencesKeyIndex::DefaultFixedFontSize));
+    if (store.hasChanged(WebPreferencesKeyIndex::LayoutFallbackWidth))
+        settings.setLayoutFallbackWidth(store.getUInt32ValueForKey(WebPreferencesKeyIndex::LayoutFallbackWidth));
+    if (store.hasChanged(WebPreferencesKeyIndex::DeviceWidth))
+        settings.setDeviceWidth(store.getUInt32ValueForKey(WebPreferencesKeyIndex::DeviceWidth));
+    if (store.hasChanged(WebPreferencesKeyIndex::DeviceHeight))
+        settings.setDeviceHeight(store.getUInt32ValueForKey(WebPreferencesKeyIndex::DeviceHeight));
+    if (store.hasChanged(WebPreferencesKeyIndex::EditableLinkBehavior))
+        settings.setEditableLinkBehavior(static_cast<WebCore::EditableLinkBehavior>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::EditableLinkBehavior)));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShowsToolTipOverTruncatedText))
+        settings.setShowsToolTipOverTruncatedText(store.getBoolValueForKey(WebPreferencesKeyIndex::ShowsToolTipOverTruncatedText));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::AcceleratedCompositingForOverflowScrollEnabled))
+        settings.setAcceleratedCompositingForOverflowScrollEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AcceleratedCompositingForOverflowScrollEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AcceleratedCompositingEnabled))
+        settings.setAcceleratedCompositingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AcceleratedCompositingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AcceleratedDrawingEnabled))
+        settings.setAcceleratedDrawingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AcceleratedDrawingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::DisplayListDrawingEnabled))
+        settings.setDisplayListDrawingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DisplayListDrawingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::CanvasUsesAcceleratedDrawing))
+        settings.setCanvasUsesAcceleratedDrawing(store.getBoolValueForKey(WebPreferencesKeyIndex::CanvasUsesAcceleratedDrawing));
+    if (store.hasChanged(WebPreferencesKeyIndex::CompositingBordersVisible))
+        settings.setShowDebugBorders(store.getBoolValueForKey(WebPreferencesKeyIndex::CompositingBordersVisible));
+    if (store.hasChanged(WebPreferencesKeyIndex::CompositingRepaintCountersVisible))
+        settings.setShowRepaintCounter(store.getBoolValueForKey(WebPreferencesKeyIndex::CompositingRepaintCountersVisible));
+    if (store.hasChanged(WebPreferencesKeyIndex::TiledScrollingIndicatorVisible))
+        settings.setShowTiledScrollingIndicator(store.getBoolValueForKey(WebPreferencesKeyIndex::TiledScrollingIndicatorVisible));
+    if (store.hasChanged(WebPreferencesKeyIndex::VisibleDebugOverlayRegions))
+        settings.setVisibleDebugOverlayRegions(store.getUInt32ValueForKey(WebPreferencesKeyIndex::VisibleDebugOverlayRegions));
+    if (store.hasChanged(WebPreferencesKeyIndex::UseGiantTiles))
+        settings.setUseGiantTiles(store.getBoolValueForKey(WebPreferencesKeyIndex::UseGiantTiles));
+    if (store.hasChanged(WebPreferencesKeyIndex::SubpixelAntialiasedLayerTextEnabled))
+        settings.setSubpixelAntialiasedLayerTextEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SubpixelAntialiasedLayerTextEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::AggressiveTileRetentionEnabled))
+        settings.setAggressiveTileRetentionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AggressiveTileRetentionEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::TemporaryTileCohortRetentionEnabled))
+        settings.setTemporaryTileCohortRetentionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::TemporaryTileCohortRetentionEnabled));
 #if ENABLE(CSS_ANIMATIONS_LEVEL_2)
-    RuntimeEnabledFeatures::sharedFeatures().setAnimationTriggersEnabled(store.getBoolValueForKey(WebPreferencesKey::cssAnimationTriggersEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::CSSAnimationTriggersEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setAnimationTriggersEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CSSAnimationTriggersEnabled));
 #endif
 #if ENABLE(WEB_ANIMATIONS)
-    RuntimeEnabledFeatures::sharedFeatures().setWebAnimationsEnabled(store.getBoolValueForKey(WebPreferencesKey::webAnimationsEnabledKey()));
-#endif
-    settings.setWebGLEnabled(store.getBoolValueForKey(WebPreferencesKey::webGLEnabledKey()));
-    settings.setForceSoftwareWebGLRendering(store.getBoolValueForKey(WebPreferencesKey::forceSoftwareWebGLRenderingKey()));
-    settings.setAccelerated2dCanvasEnabled(store.getBoolValueForKey(WebPreferencesKey::accelerated2dCanvasEnabledKey()));
-    bool requiresUserGestureForMedia = store.getBoolValueForKey(WebPreferencesKey::requiresUserGestureForMediaPlaybackKey());
-    settings.setVideoPlaybackRequiresUserGesture(requiresUserGestureForMedia || store.getBoolValueForKey(WebPreferencesKey::requiresUserGestureForVideoPlaybackKey()));
-    settings.setAudioPlaybackRequiresUserGesture(requiresUserGestureForMedia || store.getBoolValueForKey(WebPreferencesKey::requiresUserGestureForAudioPlaybackKey()));
-    settings.setRequiresUserGestureToLoadVideo(store.getBoolValueForKey(WebPreferencesKey::requiresUserGestureToLoadVideoKey()));
-    settings.setMainContentUserGestureOverrideEnabled(store.getBoolValueForKey(WebPreferencesKey::mainContentUserGestureOverrideEnabledKey()));
-    settings.setMediaUserGestureInheritsFromDocument(store.getBoolValueForKey(WebPreferencesKey::mediaUserGestureInheritsFromDocumentKey()));
-    settings.setAllowsInlineMediaPlayback(store.getBoolValueForKey(WebPreferencesKey::allowsInlineMediaPlaybackKey()));
-    settings.setAllowsInlineMediaPlaybackAfterFullscreen(store.getBoolValueForKey(WebPreferencesKey::allowsInlineMediaPlaybackAfterFullscreenKey()));
-    settings.setInlineMediaPlaybackRequiresPlaysInlineAttribute(store.getBoolValueForKey(WebPreferencesKey::inlineMediaPlaybackRequiresPlaysInlineAttributeKey()));
-    settings.setInvisibleAutoplayNotPermitted(store.getBoolValueForKey(WebPreferencesKey::invisibleAutoplayNotPermittedKey()));
-    settings.setMediaDataLoadsAutomatically(store.getBoolValueForKey(WebPreferencesKey::mediaDataLoadsAutomaticallyKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebAnimationsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setWebAnimationsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebAnimationsEnabled));
+#endif
+    if (store.hasChanged(WebPreferencesKeyIndex::WebGLEnabled))
+        settings.setWebGLEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebGLEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::ForceSoftwareWebGLRendering))
+        settings.setForceSoftwareWebGLRendering(store.getBoolValueForKey(WebPreferencesKeyIndex::ForceSoftwareWebGLRendering));
+    if (store.hasChanged(WebPreferencesKeyIndex::Accelerated2dCanvasEnabled))
+        settings.setAccelerated2dCanvasEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::Accelerated2dCanvasEnabled));
+    bool requiresUserGestureForMedia = store.getBoolValueForKey(WebPreferencesKeyIndex::RequiresUserGestureForMediaPlayback);
+    if (store.hasChanged(WebPreferencesKeyIndex::RequiresUserGestureForMediaPlayback) || store.hasChanged(WebPreferencesKeyIndex::RequiresUserGestureForVideoPlayback))
+        settings.setVideoPlaybackRequiresUserGesture(requiresUserGestureForMedia || store.getBoolValueForKey(WebPreferencesKeyIndex::RequiresUserGestureForVideoPlayback));
+    if (store.hasChanged(WebPreferencesKeyIndex::RequiresUserGestureForMediaPlayback) || store.hasChanged(WebPreferencesKeyIndex::RequiresUserGestureForAudioPlayback))
+        settings.setAudioPlaybackRequiresUserGesture(requiresUserGestureForMedia || store.getBoolValueForKey(WebPreferencesKeyIndex::RequiresUserGestureForAudioPlayback));
+    if (store.hasChanged(WebPreferencesKeyIndex::RequiresUserGestureToLoadVideo))
+        settings.setRequiresUserGestureToLoadVideo(store.getBoolValueForKey(WebPreferencesKeyIndex::RequiresUserGestureToLoadVideo));
+    if (store.hasChanged(WebPreferencesKeyIndex::MainContentUserGestureOverrideEnabled))
+        settings.setMainContentUserGestureOverrideEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MainContentUserGestureOverrideEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaUserGestureInheritsFromDocument))
+        settings.setMediaUserGestureInheritsFromDocument(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaUserGestureInheritsFromDocument));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowsInlineMediaPlayback))
+        settings.setAllowsInlineMediaPlayback(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowsInlineMediaPlayback));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowsInlineMediaPlaybackAfterFullscreen))
+        settings.setAllowsInlineMediaPlaybackAfterFullscreen(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowsInlineMediaPlaybackAfterFullscreen));
+    if (store.hasChanged(WebPreferencesKeyIndex::InlineMediaPlaybackRequiresPlaysInlineAttribute))
+        settings.setInlineMediaPlaybackRequiresPlaysInlineAttribute(store.getBoolValueForKey(WebPreferencesKeyIndex::InlineMediaPlaybackRequiresPlaysInlineAttribute));
+    if (store.hasChanged(WebPreferencesKeyIndex::InvisibleAutoplayNotPermitted))
+        settings.setInvisibleAutoplayNotPermitted(store.getBoolValueForKey(WebPreferencesKeyIndex::InvisibleAutoplayNotPermitted));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaDataLoadsAutomatically))
+        settings.setMediaDataLoadsAutomatically(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaDataLoadsAutomatically));
 #if ENABLE(ATTACHMENT_ELEMENT)
-    settings.setAttachmentElementEnabled(store.getBoolValueForKey(WebPreferencesKey::attachmentElementEnabledKey()));
-#endif
-    settings.setAllowsPictureInPictureMediaPlayback(store.getBoolValueForKey(WebPreferencesKey::allowsPictureInPictureMediaPlaybackKey()));
-    settings.setMediaControlsScaleWithPageZoom(store.getBoolValueForKey(WebPreferencesKey::mediaControlsScaleWithPageZoomKey()));
-    settings.setMockScrollbarsEnabled(store.getBoolValueForKey(WebPreferencesKey::mockScrollbarsEnabledKey()));
-    settings.setHyperlinkAuditingEnabled(store.getBoolValueForKey(WebPreferencesKey::hyperlinkAuditingEnabledKey()));
-    settings.setRequestAnimationFrameEnabled(store.getBoolValueForKey(WebPreferencesKey::requestAnimationFrameEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::AttachmentElementEnabled))
+        settings.setAttachmentElementEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AttachmentElementEnabled));
+#endif
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowsPictureInPictureMediaPlayback))
+        settings.setAllowsPictureInPictureMediaPlayback(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowsPictureInPictureMediaPlayback));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaControlsScaleWithPageZoom))
+        settings.setMediaControlsScaleWithPageZoom(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaControlsScaleWithPageZoom));
+    if (store.hasChanged(WebPreferencesKeyIndex::MockScrollbarsEnabled))
+        settings.setMockScrollbarsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MockScrollbarsEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::HyperlinkAuditingEnabled))
+        settings.setHyperlinkAuditingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::HyperlinkAuditingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::RequestAnimationFrameEnabled))
+        settings.setRequestAnimationFrameEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::RequestAnimationFrameEnabled));
 #if ENABLE(SMOOTH_SCROLLING)
-    settings.setScrollAnimatorEnabled(store.getBoolValueForKey(WebPreferencesKey::scrollAnimatorEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ScrollAnimatorEnabled))
+        settings.setScrollAnimatorEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ScrollAnimatorEnabled));
 #endif
-    settings.setForceUpdateScrollbarsOnMainThreadForPerformanceTesting(store.getBoolValueForKey(WebPreferencesKey::forceUpdateScrollbarsOnMainThreadForPerformanceTestingKey()));
-    settings.setInteractiveFormValidationEnabled(store.getBoolValueForKey(WebPreferencesKey::interactiveFormValidationEnabledKey()));
-    settings.setSpatialNavigationEnabled(store.getBoolValueForKey(WebPreferencesKey::spatialNavigationEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ForceUpdateScrollbarsOnMainThreadForPerformanceTesting))
+        settings.setForceUpdateScrollbarsOnMainThreadForPerformanceTesting(store.getBoolValueForKey(WebPreferencesKeyIndex::ForceUpdateScrollbarsOnMainThreadForPerformanceTesting));
+    if (store.hasChanged(WebPreferencesKeyIndex::InteractiveFormValidationEnabled))
+        settings.setInteractiveFormValidationEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::InteractiveFormValidationEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::SpatialNavigationEnabled))
+        settings.setSpatialNavigationEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SpatialNavigationEnabled));
 
-    settings.setHttpEquivEnabled(store.getBoolValueForKey(WebPreferencesKey::httpEquivEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::HTTPEquivEnabled))
+        settings.setHttpEquivEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::HTTPEquivEnabled));
 
-    settings.setSelectionPaintingWithoutSelectionGapsEnabled(store.getBoolValueForKey(WebPreferencesKey::selectionPaintingWithoutSelectionGapsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::SelectionPaintingWithoutSelectionGapsEnabled))
+        settings.setSelectionPaintingWithoutSelectionGapsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SelectionPaintingWithoutSelectionGapsEnabled));
 
-    DatabaseManager::singleton().setIsAvailable(store.getBoolValueForKey(WebPreferencesKey::databasesEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::DatabasesEnabled))
+        DatabaseManager::singleton().setIsAvailable(store.getBoolValueForKey(WebPreferencesKeyIndex::DatabasesEnabled));
 
 #if ENABLE(FULLSCREEN_API)
-    settings.setFullScreenEnabled(store.getBoolValueForKey(WebPreferencesKey::fullScreenEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::FullScreenEnabled))
+        settings.setFullScreenEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::FullScreenEnabled));
 #endif
 
 #if USE(AVFOUNDATION)
-    settings.setAVFoundationEnabled(store.getBoolValueForKey(WebPreferencesKey::isAVFoundationEnabledKey()));
-    settings.setAVFoundationNSURLSessionEnabled(store.getBoolValueForKey(WebPreferencesKey::isAVFoundationNSURLSessionEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::AVFoundationEnabled))
+        settings.setAVFoundationEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AVFoundationEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AVFoundationNSURLSessionEnabled))
+        settings.setAVFoundationNSURLSessionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AVFoundationNSURLSessionEnabled));
 #endif
 
 #if USE(GSTREAMER)
-    settings.setGStreamerEnabled(store.getBoolValueForKey(WebPreferencesKey::isGStreamerEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::GStreamerEnabled))
+        settings.setGStreamerEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::GStreamerEnabled));
 #endif
 
 #if PLATFORM(COCOA)
-    settings.setQTKitEnabled(store.getBoolValueForKey(WebPreferencesKey::isQTKitEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::QTKitEnabled))
+        settings.setQTKitEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::QTKitEnabled));
 #endif
 
 #if PLATFORM(IOS) && HAVE(AVKIT)
@@ -3173,122 +3389,185 @@ void WebPage::updatePreferences(const WebPreferencesStore& store)
 #endif
 
 #if ENABLE(WEB_AUDIO)
-    settings.setWebAudioEnabled(store.getBoolValueForKey(WebPreferencesKey::webAudioEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebAudioEnabled))
+        settings.setWebAudioEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebAudioEnabled));
 #endif
 
 #if ENABLE(MEDIA_STREAM)
-    RuntimeEnabledFeatures::sharedFeatures().setMediaDevicesEnabled(store.getBoolValueForKey(WebPreferencesKey::mediaDevicesEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setMediaStreamEnabled(store.getBoolValueForKey(WebPreferencesKey::mediaStreamEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaDevicesEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setMediaDevicesEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaDevicesEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaStreamEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setMediaStreamEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaStreamEnabled));
 #endif
 
 #if ENABLE(WEB_RTC)
-    RuntimeEnabledFeatures::sharedFeatures().setPeerConnectionEnabled(store.getBoolValueForKey(WebPreferencesKey::peerConnectionEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setWebRTCLegacyAPIEnabled(!store.getBoolValueForKey(WebPreferencesKey::webRTCLegacyAPIDisabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::PeerConnectionEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setPeerConnectionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PeerConnectionEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebRTCLegacyAPIDisabled))
+        RuntimeEnabledFeatures::sharedFeatures().setWebRTCLegacyAPIEnabled(!store.getBoolValueForKey(WebPreferencesKeyIndex::WebRTCLegacyAPIDisabled));
 #endif
 
 #if ENABLE(SERVICE_CONTROLS)
-    settings.setImageControlsEnabled(store.getBoolValueForKey(WebPreferencesKey::imageControlsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ImageControlsEnabled))
+        settings.setImageControlsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ImageControlsEnabled));
 #endif
 
 #if ENABLE(WIRELESS_PLAYBACK_TARGET)
-    settings.setAllowsAirPlayForMediaPlayback(store.getBoolValueForKey(WebPreferencesKey::allowsAirPlayForMediaPlaybackKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowsAirPlayForMediaPlayback))
+        settings.setAllowsAirPlayForMediaPlayback(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowsAirPlayForMediaPlayback));
 #endif
 
 #if ENABLE(RESOURCE_USAGE)
-    settings.setResourceUsageOverlayVisible(store.getBoolValueForKey(WebPreferencesKey::resourceUsageOverlayVisibleKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ResourceUsageOverlayVisible))
+        settings.setResourceUsageOverlayVisible(store.getBoolValueForKey(WebPreferencesKeyIndex::ResourceUsageOverlayVisible));
 #endif
 
-    settings.setSuppressesIncrementalRendering(store.getBoolValueForKey(WebPreferencesKey::suppressesIncrementalRenderingKey()));
-    settings.setIncrementalRenderingSuppressionTimeoutInSeconds(store.getDoubleValueForKey(WebPreferencesKey::incrementalRenderingSuppressionTimeoutKey()));
-    settings.setBackspaceKeyNavigationEnabled(store.getBoolValueForKey(WebPreferencesKey::backspaceKeyNavigationEnabledKey()));
-    settings.setWantsBalancedSetDefersLoadingBehavior(store.getBoolValueForKey(WebPreferencesKey::wantsBalancedSetDefersLoadingBehaviorKey()));
-    settings.setCaretBrowsingEnabled(store.getBoolValueForKey(WebPreferencesKey::caretBrowsingEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::SuppressesIncrementalRendering))
+        settings.setSuppressesIncrementalRendering(store.getBoolValueForKey(WebPreferencesKeyIndex::SuppressesIncrementalRendering));
+    if (store.hasChanged(WebPreferencesKeyIndex::IncrementalRenderingSuppressionTimeout))
+        settings.setIncrementalRenderingSuppressionTimeoutInSeconds(store.getDoubleValueForKey(WebPreferencesKeyIndex::IncrementalRenderingSuppressionTimeout));
+    if (store.hasChanged(WebPreferencesKeyIndex::BackspaceKeyNavigationEnabled))
+        settings.setBackspaceKeyNavigationEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::BackspaceKeyNavigationEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::WantsBalancedSetDefersLoadingBehavior))
+        settings.setWantsBalancedSetDefersLoadingBehavior(store.getBoolValueForKey(WebPreferencesKeyIndex::WantsBalancedSetDefersLoadingBehavior));
+    if (store.hasChanged(WebPreferencesKeyIndex::CaretBrowsingEnabled))
+        settings.setCaretBrowsingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CaretBrowsingEnabled));
 
 #if ENABLE(VIDEO_TRACK)
-    settings.setShouldDisplaySubtitles(store.getBoolValueForKey(WebPreferencesKey::shouldDisplaySubtitlesKey()));
-    settings.setShouldDisplayCaptions(store.getBoolValueForKey(WebPreferencesKey::shouldDisplayCaptionsKey()));
-    settings.setShouldDisplayTextDescriptions(store.getBoolValueForKey(WebPreferencesKey::shouldDisplayTextDescriptionsKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldDisplaySubtitles))
+        settings.setShouldDisplaySubtitles(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldDisplaySubtitles));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldDisplayCaptions))
+        settings.setShouldDisplayCaptions(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldDisplayCaptions));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldDisplayTextDescriptions))
+        settings.setShouldDisplayTextDescriptions(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldDisplayTextDescriptions));
 #endif
 
 #if ENABLE(NOTIFICATIONS)
-    settings.setNotificationsEnabled(store.getBoolValueForKey(WebPreferencesKey::notificationsEnabledKey()));
-#endif
-
-    settings.setShouldRespectImageOrientation(store.getBoolValueForKey(WebPreferencesKey::shouldRespectImageOrientationKey()));
-    settings.setStorageBlockingPolicy(static_cast<SecurityOrigin::StorageBlockingPolicy>(store.getUInt32ValueForKey(WebPreferencesKey::storageBlockingPolicyKey())));
-    settings.setCookieEnabled(store.getBoolValueForKey(WebPreferencesKey::cookieEnabledKey()));
-
-    settings.setDiagnosticLoggingEnabled(store.getBoolValueForKey(WebPreferencesKey::diagnosticLoggingEnabledKey()));
-
-    settings.setScrollingPerformanceLoggingEnabled(m_scrollingPerformanceLoggingEnabled);
-
-    settings.setPlugInSnapshottingEnabled(store.getBoolValueForKey(WebPreferencesKey::plugInSnapshottingEnabledKey()));
-    settings.setSnapshotAllPlugIns(store.getBoolValueForKey(WebPreferencesKey::snapshotAllPlugInsKey()));
-    settings.setAutostartOriginPlugInSnapshottingEnabled(store.getBoolValueForKey(WebPreferencesKey::autostartOriginPlugInSnapshottingEnabledKey()));
-    settings.setPrimaryPlugInSnapshotDetectionEnabled(store.getBoolValueForKey(WebPreferencesKey::primaryPlugInSnapshotDetectionEnabledKey()));
-    settings.setUsesEncodingDetector(store.getBoolValueForKey(WebPreferencesKey::usesEncodingDetectorKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::NotificationsEnabled))
+        settings.setNotificationsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::NotificationsEnabled));
+#endif
+
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldRespectImageOrientation))
+        settings.setShouldRespectImageOrientation(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldRespectImageOrientation));
+    if (store.hasChanged(WebPreferencesKeyIndex::StorageBlockingPolicy))
+        settings.setStorageBlockingPolicy(static_cast<SecurityOrigin::StorageBlockingPolicy>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::StorageBlockingPolicy)));
+    if (store.hasChanged(WebPreferencesKeyIndex::CookieEnabled))
+        settings.setCookieEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CookieEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::DiagnosticLoggingEnabled))
+        settings.setDiagnosticLoggingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DiagnosticLoggingEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::ScrollingPerformanceLoggingEnabled))
+        settings.setScrollingPerformanceLoggingEnabled(m_scrollingPerformanceLoggingEnabled);
+
+    if (store.hasChanged(WebPreferencesKeyIndex::PlugInSnapshottingEnabled))
+        settings.setPlugInSnapshottingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PlugInSnapshottingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::SnapshotAllPlugIns))
+        settings.setSnapshotAllPlugIns(store.getBoolValueForKey(WebPreferencesKeyIndex::SnapshotAllPlugIns));
+    if (store.hasChanged(WebPreferencesKeyIndex::AutostartOriginPlugInSnapshottingEnabled))
+        settings.setAutostartOriginPlugInSnapshottingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AutostartOriginPlugInSnapshottingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::PrimaryPlugInSnapshotDetectionEnabled))
+        settings.setPrimaryPlugInSnapshotDetectionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PrimaryPlugInSnapshotDetectionEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::UsesEncodingDetector))
+        settings.setUsesEncodingDetector(store.getBoolValueForKey(WebPreferencesKeyIndex::UsesEncodingDetector));
 
 #if ENABLE(TEXT_AUTOSIZING)
-    settings.setTextAutosizingEnabled(store.getBoolValueForKey(WebPreferencesKey::textAutosizingEnabledKey()));
-    settings.setMinimumZoomFontSize(store.getDoubleValueForKey(WebPreferencesKey::minimumZoomFontSizeKey()));
-#endif
-
-    settings.setLogsPageMessagesToSystemConsoleEnabled(store.getBoolValueForKey(WebPreferencesKey::logsPageMessagesToSystemConsoleEnabledKey()));
-    settings.setAsynchronousSpellCheckingEnabled(store.getBoolValueForKey(WebPreferencesKey::asynchronousSpellCheckingEnabledKey()));
-
-    settings.setSmartInsertDeleteEnabled(store.getBoolValueForKey(WebPreferencesKey::smartInsertDeleteEnabledKey()));
-    settings.setSelectTrailingWhitespaceEnabled(store.getBoolValueForKey(WebPreferencesKey::selectTrailingWhitespaceEnabledKey()));
-    settings.setShowsURLsInToolTips(store.getBoolValueForKey(WebPreferencesKey::showsURLsInToolTipsEnabledKey()));
-
-    settings.setHiddenPageDOMTimerThrottlingEnabled(store.getBoolValueForKey(WebPreferencesKey::hiddenPageDOMTimerThrottlingEnabledKey()));
-    settings.setHiddenPageDOMTimerThrottlingAutoIncreases(store.getBoolValueForKey(WebPreferencesKey::hiddenPageDOMTimerThrottlingAutoIncreasesKey()));
-
-    settings.setHiddenPageCSSAnimationSuspensionEnabled(store.getBoolValueForKey(WebPreferencesKey::hiddenPageCSSAnimationSuspensionEnabledKey()));
-    settings.setLowPowerVideoAudioBufferSizeEnabled(store.getBoolValueForKey(WebPreferencesKey::lowPowerVideoAudioBufferSizeEnabledKey()));
-    settings.setSimpleLineLayoutEnabled(store.getBoolValueForKey(WebPreferencesKey::simpleLineLayoutEnabledKey()));
-    settings.setSimpleLineLayoutDebugBordersEnabled(store.getBoolValueForKey(WebPreferencesKey::simpleLineLayoutDebugBordersEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::TextAutosizingEnabled))
+        settings.setTextAutosizingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::TextAutosizingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::MinimumZoomFontSize))
+        settings.setMinimumZoomFontSize(store.getDoubleValueForKey(WebPreferencesKeyIndex::MinimumZoomFontSize));
+#endif
+
+    if (store.hasChanged(WebPreferencesKeyIndex::LogsPageMessagesToSystemConsoleEnabled))
+        settings.setLogsPageMessagesToSystemConsoleEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LogsPageMessagesToSystemConsoleEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AsynchronousSpellCheckingEnabled))
+        settings.setAsynchronousSpellCheckingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AsynchronousSpellCheckingEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::SmartInsertDeleteEnabled))
+        settings.setSmartInsertDeleteEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SmartInsertDeleteEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::SelectTrailingWhitespaceEnabled))
+        settings.setSelectTrailingWhitespaceEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SelectTrailingWhitespaceEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShowsURLsInToolTipsEnabled))
+        settings.setShowsURLsInToolTips(store.getBoolValueForKey(WebPreferencesKeyIndex::ShowsURLsInToolTipsEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::HiddenPageDOMTimerThrottlingEnabled))
+        settings.setHiddenPageDOMTimerThrottlingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::HiddenPageDOMTimerThrottlingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::HiddenPageDOMTimerThrottlingAutoIncreases))
+        settings.setHiddenPageDOMTimerThrottlingAutoIncreases(store.getBoolValueForKey(WebPreferencesKeyIndex::HiddenPageDOMTimerThrottlingAutoIncreases));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::HiddenPageCSSAnimationSuspensionEnabled))
+        settings.setHiddenPageCSSAnimationSuspensionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::HiddenPageCSSAnimationSuspensionEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::LowPowerVideoAudioBufferSizeEnabled))
+        settings.setLowPowerVideoAudioBufferSizeEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LowPowerVideoAudioBufferSizeEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::SimpleLineLayoutEnabled))
+        settings.setSimpleLineLayoutEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SimpleLineLayoutEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::SimpleLineLayoutDebugBordersEnabled))
+        settings.setSimpleLineLayoutDebugBordersEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SimpleLineLayoutDebugBordersEnabled));
     
-    settings.setNewBlockInsideInlineModelEnabled(store.getBoolValueForKey(WebPreferencesKey::newBlockInsideInlineModelEnabledKey()));
-    settings.setDeferredCSSParserEnabled(store.getBoolValueForKey(WebPreferencesKey::deferredCSSParserEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::NewBlockInsideInlineModelEnabled))
+        settings.setNewBlockInsideInlineModelEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::NewBlockInsideInlineModelEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::DeferredCSSParserEnabled))
+        settings.setDeferredCSSParserEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DeferredCSSParserEnabled));
 
-    settings.setSubpixelCSSOMElementMetricsEnabled(store.getBoolValueForKey(WebPreferencesKey::subpixelCSSOMElementMetricsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::SubpixelCSSOMElementMetricsEnabled))
+        settings.setSubpixelCSSOMElementMetricsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SubpixelCSSOMElementMetricsEnabled));
 
-    settings.setUseLegacyTextAlignPositionedElementBehavior(store.getBoolValueForKey(WebPreferencesKey::useLegacyTextAlignPositionedElementBehaviorKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::UseLegacyTextAlignPositionedElementBehavior))
+        settings.setUseLegacyTextAlignPositionedElementBehavior(store.getBoolValueForKey(WebPreferencesKeyIndex::UseLegacyTextAlignPositionedElementBehavior));
 
 #if ENABLE(MEDIA_SOURCE)
-    settings.setMediaSourceEnabled(store.getBoolValueForKey(WebPreferencesKey::mediaSourceEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaSourceEnabled))
+        settings.setMediaSourceEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaSourceEnabled));
 #endif
 
 #if ENABLE(MEDIA_STREAM)
-    settings.setMockCaptureDevicesEnabled(store.getBoolValueForKey(WebPreferencesKey::mockCaptureDevicesEnabledKey()));
-    settings.setMediaCaptureRequiresSecureConnection(store.getBoolValueForKey(WebPreferencesKey::mediaCaptureRequiresSecureConnectionKey()));
-#endif
-
-    settings.setShouldConvertPositionStyleOnCopy(store.getBoolValueForKey(WebPreferencesKey::shouldConvertPositionStyleOnCopyKey()));
-
-    settings.setStandalone(store.getBoolValueForKey(WebPreferencesKey::standaloneKey()));
-    settings.setTelephoneNumberParsingEnabled(store.getBoolValueForKey(WebPreferencesKey::telephoneNumberParsingEnabledKey()));
-    settings.setAllowMultiElementImplicitSubmission(store.getBoolValueForKey(WebPreferencesKey::allowMultiElementImplicitSubmissionKey()));
-    settings.setAlwaysUseAcceleratedOverflowScroll(store.getBoolValueForKey(WebPreferencesKey::alwaysUseAcceleratedOverflowScrollKey()));
-
-    settings.setPasswordEchoEnabled(store.getBoolValueForKey(WebPreferencesKey::passwordEchoEnabledKey()));
-    settings.setPasswordEchoDurationInSeconds(store.getDoubleValueForKey(WebPreferencesKey::passwordEchoDurationKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::MockCaptureDevicesEnabled))
+        settings.setMockCaptureDevicesEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MockCaptureDevicesEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaCaptureRequiresSecureConnection))
+        settings.setMediaCaptureRequiresSecureConnection(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaCaptureRequiresSecureConnection));
+#endif
+
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldConvertPositionStyleOnCopy))
+        settings.setShouldConvertPositionStyleOnCopy(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldConvertPositionStyleOnCopy));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::Standalone))
+        settings.setStandalone(store.getBoolValueForKey(WebPreferencesKeyIndex::Standalone));
+    if (store.hasChanged(WebPreferencesKeyIndex::TelephoneNumberParsingEnabled))
+        settings.setTelephoneNumberParsingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::TelephoneNumberParsingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowMultiElementImplicitSubmission))
+        settings.setAllowMultiElementImplicitSubmission(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowMultiElementImplicitSubmission));
+    if (store.hasChanged(WebPreferencesKeyIndex::AlwaysUseAcceleratedOverflowScroll))
+        settings.setAlwaysUseAcceleratedOverflowScroll(store.getBoolValueForKey(WebPreferencesKeyIndex::AlwaysUseAcceleratedOverflowScroll));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::PasswordEchoEnabled))
+        settings.setPasswordEchoEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::PasswordEchoEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::PasswordEchoDuration))
+        settings.setPasswordEchoDurationInSeconds(store.getDoubleValueForKey(WebPreferencesKeyIndex::PasswordEchoDuration));
     
-    settings.setLayoutInterval(Seconds(store.getDoubleValueForKey(WebPreferencesKey::layoutIntervalKey())));
-    settings.setMaxParseDuration(store.getDoubleValueForKey(WebPreferencesKey::maxParseDurationKey()));
-
-    settings.setEnableInheritURIQueryComponent(store.getBoolValueForKey(WebPreferencesKey::enableInheritURIQueryComponentKey()));
-
-    auto userInterfaceDirectionPolicyCandidate = static_cast<WebCore::UserInterfaceDirectionPolicy>(store.getUInt32ValueForKey(WebPreferencesKey::userInterfaceDirectionPolicyKey()));
-    if (userInterfaceDirectionPolicyCandidate == WebCore::UserInterfaceDirectionPolicy::Content || userInterfaceDirectionPolicyCandidate == WebCore::UserInterfaceDirectionPolicy::System)
-        settings.setUserInterfaceDirectionPolicy(userInterfaceDirectionPolicyCandidate);
-    TextDirection systemLayoutDirectionCandidate = static_cast<TextDirection>(store.getUInt32ValueForKey(WebPreferencesKey::systemLayoutDirectionKey()));
-    if (systemLayoutDirectionCandidate == WebCore::LTR || systemLayoutDirectionCandidate == WebCore::RTL)
-        settings.setSystemLayoutDirection(systemLayoutDirectionCandidate);
+    if (store.hasChanged(WebPreferencesKeyIndex::LayoutInterval))
+        settings.setLayoutInterval(Seconds(store.getDoubleValueForKey(WebPreferencesKeyIndex::LayoutInterval)));
+    if (store.hasChanged(WebPreferencesKeyIndex::MaxParseDuration))
+        settings.setMaxParseDuration(store.getDoubleValueForKey(WebPreferencesKeyIndex::MaxParseDuration));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::EnableInheritURIQueryComponent))
+        settings.setEnableInheritURIQueryComponent(store.getBoolValueForKey(WebPreferencesKeyIndex::EnableInheritURIQueryComponent));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::UserInterfaceDirectionPolicy)) {
+        auto userInterfaceDirectionPolicyCandidate = static_cast<WebCore::UserInterfaceDirectionPolicy>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::UserInterfaceDirectionPolicy));
+        if (userInterfaceDirectionPolicyCandidate == WebCore::UserInterfaceDirectionPolicy::Content || userInterfaceDirectionPolicyCandidate == WebCore::UserInterfaceDirectionPolicy::System)
+            settings.setUserInterfaceDirectionPolicy(userInterfaceDirectionPolicyCandidate);
+    }
+    if (store.hasChanged(WebPreferencesKeyIndex::SystemLayoutDirection)) {
+        TextDirection systemLayoutDirectionCandidate = static_cast<TextDirection>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::SystemLayoutDirection));
+        if (systemLayoutDirectionCandidate == WebCore::LTR || systemLayoutDirectionCandidate == WebCore::RTL)
+            settings.setSystemLayoutDirection(systemLayoutDirectionCandidate);
+    }
 
 #if ENABLE(APPLE_PAY)
-    settings.setApplePayEnabled(store.getBoolValueForKey(WebPreferencesKey::applePayEnabledKey()));
-    settings.setApplePayCapabilityDisclosureAllowed(store.getBoolValueForKey(WebPreferencesKey::applePayCapabilityDisclosureAllowedKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ApplePayEnabled))
+        settings.setApplePayEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ApplePayEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::ApplePayCapabilityDisclosureAllowed))
+        settings.setApplePayCapabilityDisclosureAllowed(store.getBoolValueForKey(WebPreferencesKeyIndex::ApplePayCapabilityDisclosureAllowed));
 #endif
 
 #if PLATFORM(IOS)
@@ -3296,78 +3575,108 @@ void WebPage::updatePreferences(const WebPreferencesStore& store)
 #endif
 
 #if ENABLE(DATA_DETECTION)
-    settings.setDataDetectorTypes(static_cast<DataDetectorTypes>(store.getUInt32ValueForKey(WebPreferencesKey::dataDetectorTypesKey())));
+    if (store.hasChanged(WebPreferencesKeyIndex::DataDetectorTypes))
+        settings.setDataDetectorTypes(static_cast<DataDetectorTypes>(store.getUInt32ValueForKey(WebPreferencesKeyIndex::DataDetectorTypes)));
 #endif
 #if ENABLE(GAMEPAD)
-    RuntimeEnabledFeatures::sharedFeatures().setGamepadsEnabled(store.getBoolValueForKey(WebPreferencesKey::gamepadsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::GamepadsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setGamepadsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::GamepadsEnabled));
 #endif
 
 #if ENABLE(SERVICE_CONTROLS)
-    settings.setServiceControlsEnabled(store.getBoolValueForKey(WebPreferencesKey::serviceControlsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ServiceControlsEnabled))
+        settings.setServiceControlsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ServiceControlsEnabled));
 #endif
 
 #if ENABLE(FETCH_API)
-    RuntimeEnabledFeatures::sharedFeatures().setFetchAPIEnabled(store.getBoolValueForKey(WebPreferencesKey::fetchAPIEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::FetchAPIEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setFetchAPIEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::FetchAPIEnabled));
 #endif
 
 #if ENABLE(DOWNLOAD_ATTRIBUTE)
-    RuntimeEnabledFeatures::sharedFeatures().setDownloadAttributeEnabled(store.getBoolValueForKey(WebPreferencesKey::downloadAttributeEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::DownloadAttributeEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setDownloadAttributeEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DownloadAttributeEnabled));
 #endif
 
-    RuntimeEnabledFeatures::sharedFeatures().setShadowDOMEnabled(store.getBoolValueForKey(WebPreferencesKey::shadowDOMEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShadowDOMEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setShadowDOMEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ShadowDOMEnabled));
 
-    RuntimeEnabledFeatures::sharedFeatures().setInteractiveFormValidationEnabled(store.getBoolValueForKey(WebPreferencesKey::interactiveFormValidationEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::InteractiveFormValidationEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setInteractiveFormValidationEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::InteractiveFormValidationEnabled));
 
     // Experimental Features.
 
-    RuntimeEnabledFeatures::sharedFeatures().setCSSGridLayoutEnabled(store.getBoolValueForKey(WebPreferencesKey::cssGridLayoutEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::CSSGridLayoutEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setCSSGridLayoutEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CSSGridLayoutEnabled));
 
-    RuntimeEnabledFeatures::sharedFeatures().setCustomElementsEnabled(store.getBoolValueForKey(WebPreferencesKey::customElementsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::CustomElementsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setCustomElementsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CustomElementsEnabled));
 
 #if ENABLE(WEBGL2)
-    RuntimeEnabledFeatures::sharedFeatures().setWebGL2Enabled(store.getBoolValueForKey(WebPreferencesKey::webGL2EnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebGL2Enabled))
+        RuntimeEnabledFeatures::sharedFeatures().setWebGL2Enabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebGL2Enabled));
 #endif
 
 #if ENABLE(WEBGPU)
-    RuntimeEnabledFeatures::sharedFeatures().setWebGPUEnabled(store.getBoolValueForKey(WebPreferencesKey::webGPUEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::WebGPUEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setWebGPUEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::WebGPUEnabled));
 #endif
 
-    settings.setSpringTimingFunctionEnabled(store.getBoolValueForKey(WebPreferencesKey::springTimingFunctionEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::SpringTimingFunctionEnabled))
+        settings.setSpringTimingFunctionEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SpringTimingFunctionEnabled));
 
-    settings.setConstantPropertiesEnabled(store.getBoolValueForKey(WebPreferencesKey::constantPropertiesEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ConstantPropertiesEnabled))
+        settings.setConstantPropertiesEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ConstantPropertiesEnabled));
 
-    settings.setViewportFitEnabled(store.getBoolValueForKey(WebPreferencesKey::viewportFitEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ViewportFitEnabled))
+        settings.setViewportFitEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ViewportFitEnabled));
 
-    settings.setVisualViewportEnabled(store.getBoolValueForKey(WebPreferencesKey::visualViewportEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::VisualViewportEnabled))
+        settings.setVisualViewportEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::VisualViewportEnabled));
 
-    settings.setInputEventsEnabled(store.getBoolValueForKey(WebPreferencesKey::inputEventsEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setInputEventsEnabled(store.getBoolValueForKey(WebPreferencesKey::inputEventsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::InputEventsEnabled))
+        settings.setInputEventsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::InputEventsEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::InputEventsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setInputEventsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::InputEventsEnabled));
 
-    RuntimeEnabledFeatures::sharedFeatures().setModernMediaControlsEnabled(store.getBoolValueForKey(WebPreferencesKey::modernMediaControlsEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::ModernMediaControlsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setModernMediaControlsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ModernMediaControlsEnabled));
 
 #if ENABLE(ENCRYPTED_MEDIA)
-    RuntimeEnabledFeatures::sharedFeatures().setEncryptedMediaAPIEnabled(store.getBoolValueForKey(WebPreferencesKey::encryptedMediaAPIEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::EncryptedMediaAPIEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setEncryptedMediaAPIEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::EncryptedMediaAPIEnabled));
 #endif
 
 #if ENABLE(INTERSECTION_OBSERVER)
-    RuntimeEnabledFeatures::sharedFeatures().setIntersectionObserverEnabled(store.getBoolValueForKey(WebPreferencesKey::intersectionObserverEnabledKey()));
-#endif
-
-    RuntimeEnabledFeatures::sharedFeatures().setDisplayContentsEnabled(store.getBoolValueForKey(WebPreferencesKey::displayContentsEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setUserTimingEnabled(store.getBoolValueForKey(WebPreferencesKey::userTimingEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setResourceTimingEnabled(store.getBoolValueForKey(WebPreferencesKey::resourceTimingEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setLinkPreloadEnabled(store.getBoolValueForKey(WebPreferencesKey::linkPreloadEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setMediaPreloadingEnabled(store.getBoolValueForKey(WebPreferencesKey::mediaPreloadingEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setCredentialManagementEnabled(store.getBoolValueForKey(WebPreferencesKey::credentialManagementEnabledKey()));
-    RuntimeEnabledFeatures::sharedFeatures().setIsSecureContextAttributeEnabled(store.getBoolValueForKey(WebPreferencesKey::isSecureContextAttributeEnabledKey()));
-
-    bool processSuppressionEnabled = store.getBoolValueForKey(WebPreferencesKey::pageVisibilityBasedProcessSuppressionEnabledKey());
-    if (m_processSuppressionEnabled != processSuppressionEnabled) {
-        m_processSuppressionEnabled = processSuppressionEnabled;
-        updateThrottleState();
+    if (store.hasChanged(WebPreferencesKeyIndex::IntersectionObserverEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setIntersectionObserverEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::IntersectionObserverEnabled));
+#endif
+
+    if (store.hasChanged(WebPreferencesKeyIndex::DisplayContentsEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setDisplayContentsEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::DisplayContentsEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::UserTimingEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setUserTimingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::UserTimingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::ResourceTimingEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setResourceTimingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::ResourceTimingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::LinkPreloadEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setLinkPreloadEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LinkPreloadEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaPreloadingEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setMediaPreloadingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaPreloadingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::CredentialManagementEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setCredentialManagementEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::CredentialManagementEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::IsSecureContextAttributeEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setIsSecureContextAttributeEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::IsSecureContextAttributeEnabled));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::PageVisibilityBasedProcessSuppressionEnabled)) {
+        bool processSuppressionEnabled = store.getBoolValueForKey(WebPreferencesKeyIndex::PageVisibilityBasedProcessSuppressionEnabled);
+        if (m_processSuppressionEnabled != processSuppressionEnabled) {
+            m_processSuppressionEnabled = processSuppressionEnabled;
+            updateThrottleState();
+        }
     }
 
-    settings.setSubresourceIntegrityEnabled(store.getBoolValueForKey(WebPreferencesKey::subresourceIntegrityEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::SubresourceIntegrityEnabled))
+        settings.setSubresourceIntegrityEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::SubresourceIntegrityEnabled));
 
     platformPreferencesDidChange(store);
 
@@ -3375,21 +3684,33 @@ void WebPage::updatePreferences(const WebPreferencesStore& store)
         m_drawingArea->updatePreferences(store);
 
 #if PLATFORM(IOS)
-    m_ignoreViewportScalingConstraints = store.getBoolValueForKey(WebPreferencesKey::ignoreViewportScalingConstraintsKey());
-    m_viewportConfiguration.setCanIgnoreScalingConstraints(m_ignoreViewportScalingConstraints);
-    setForceAlwaysUserScalable(m_forceAlwaysUserScalable || store.getBoolValueForKey(WebPreferencesKey::forceAlwaysUserScalableKey()));
-#endif
-    settings.setLargeImageAsyncDecodingEnabled(store.getBoolValueForKey(WebPreferencesKey::largeImageAsyncDecodingEnabledKey()));
-    settings.setAnimatedImageAsyncDecodingEnabled(store.getBoolValueForKey(WebPreferencesKey::animatedImageAsyncDecodingEnabledKey()));
-    settings.setShouldSuppressTextInputFromEditingDuringProvisionalNavigation(store.getBoolValueForKey(WebPreferencesKey::shouldSuppressTextInputFromEditingDuringProvisionalNavigationKey()));
-    settings.setMediaContentTypesRequiringHardwareSupport(store.getStringValueForKey(WebPreferencesKey::mediaContentTypesRequiringHardwareSupportKey()));
-    settings.setAllowMediaContentTypesRequiringHardwareSupportAsFallback(store.getBoolValueForKey(WebPreferencesKey::allowMediaContentTypesRequiringHardwareSupportAsFallbackKey()));
-
-    settings.setMediaDocumentEntersFullscreenAutomatically(store.getBoolValueForKey(WebPreferencesKey::mediaDocumentEntersFullscreenAutomaticallyKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::IgnoreViewportScalingConstraints)) {
+        m_ignoreViewportScalingConstraints = store.getBoolValueForKey(WebPreferencesKeyIndex::IgnoreViewportScalingConstraints);
+        m_viewportConfiguration.setCanIgnoreScalingConstraints(m_ignoreViewportScalingConstraints);
+    }
+    if (store.hasChanged(WebPreferencesKeyIndex::ForceAlwaysUserScalable))
+        setForceAlwaysUserScalable(m_forceAlwaysUserScalable || store.getBoolValueForKey(WebPreferencesKeyIndex::ForceAlwaysUserScalable));
+#endif
+    if (store.hasChanged(WebPreferencesKeyIndex::LargeImageAsyncDecodingEnabled))
+        settings.setLargeImageAsyncDecodingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LargeImageAsyncDecodingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::AnimatedImageAsyncDecodingEnabled))
+        settings.setAnimatedImageAsyncDecodingEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::AnimatedImageAsyncDecodingEnabled));
+    if (store.hasChanged(WebPreferencesKeyIndex::ShouldSuppressTextInputFromEditingDuringProvisionalNavigation))
+        settings.setShouldSuppressTextInputFromEditingDuringProvisionalNavigation(store.getBoolValueForKey(WebPreferencesKeyIndex::ShouldSuppressTextInputFromEditingDuringProvisionalNavigation));
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaContentTypesRequiringHardwareSupport))
+        settings.setMediaContentTypesRequiringHardwareSupport(store.getStringValueForKey(WebPreferencesKeyIndex::MediaContentTypesRequiringHardwareSupport));
+    if (store.hasChanged(WebPreferencesKeyIndex::AllowMediaContentTypesRequiringHardwareSupportAsFallback))
+        settings.setAllowMediaContentTypesRequiringHardwareSupportAsFallback(store.getBoolValueForKey(WebPreferencesKeyIndex::AllowMediaContentTypesRequiringHardwareSupportAsFallback));
+
+    if (store.hasChanged(WebPreferencesKeyIndex::MediaDocumentEntersFullscreenAutomatically))
+        settings.setMediaDocumentEntersFullscreenAutomatically(store.getBoolValueForKey(WebPreferencesKeyIndex::MediaDocumentEntersFullscreenAutomatically));
 
 #if ENABLE(LEGACY_ENCRYPTED_MEDIA)
-    RuntimeEnabledFeatures::sharedFeatures().setLegacyEncryptedMediaAPIEnabled(store.getBoolValueForKey(WebPreferencesKey::legacyEncryptedMediaAPIEnabledKey()));
+    if (store.hasChanged(WebPreferencesKeyIndex::LegacyEncryptedMediaAPIEnabled))
+        RuntimeEnabledFeatures::sharedFeatures().setLegacyEncryptedMediaAPIEnabled(store.getBoolValueForKey(WebPreferencesKeyIndex::LegacyEncryptedMediaAPIEnabled));
 #endif
+
+    store.clearChangedKeys();
 }
 
 #if ENABLE(DATA_DETECTION)
@@ -5327,6 +5648,13 @@ void WebPage::didCommitLoad(WebFrame* frame)
     if (!frame->isMainFrame())
         return;
 
+    // Creating the storage area starts sending its values from the UI process, so they are likely to be here by the time script first uses localStorage.
+    m_preloadedLocalStorageArea = nullptr;
+    if (auto* document = frame->coreFrame()->document()) {
+        if (m_page->settings().localStorageEnabled() && !document->securityOrigin().isUnique())
+            m_preloadedLocalStorageArea = m_page->storageNamespaceProvider().localStorageArea(*document);
+    }
+
     // If previous URL is invalid, then it's not a real page that's being navigated away from.
     // Most likely, this is actually the first load to be committed in this page.
     if (frame->coreFrame()->loader().previousURL().isValid())
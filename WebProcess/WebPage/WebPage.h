@@ -45,6 +45,7 @@
 #include "SandboxExtension.h"
 #include "SharedMemory.h"
 #include "UserData.h"
+#include "WebPreferencesStore.h"
 #include "WebURLSchemeHandler.h"
 #include <WebCore/ActivityState.h>
 #include <WebCore/DictionaryPopupInfo.h>
@@ -132,6 +133,7 @@ class ResourceResponse;
 class ResourceRequest;
 class SelectionRect;
 class SharedBuffer;
+class StorageArea;
 class SubstituteData;
 class TextCheckingRequest;
 class URL;
@@ -203,7 +205,6 @@ struct LoadParameters;
 struct PrintInfo;
 struct WebsitePolicies;
 struct WebPageCreationParameters;
-struct WebPreferencesStore;
 struct WebSelectionData;
 
 typedef uint32_t SnapshotOptions;
@@ -810,7 +811,7 @@ public:
     void contextMenuShowing() { m_isShowingContextMenu = true; }
 #endif
 
-    void wheelEvent(const WebWheelEvent&);
+    void wheelEvent(const WebWheelEvent&, unsigned coalescedEventCount);
 
     void wheelEventHandlersChanged(bool);
     void recomputeShortCircuitHorizontalWheelEventsState();
@@ -1122,10 +1123,14 @@ private:
     void runJavaScriptInMainFrame(const String&, bool forceUserGesture, CallbackID);
     void forceRepaint(CallbackID);
     void takeSnapshot(WebCore::IntRect snapshotRect, WebCore::IntSize bitmapSize, uint32_t options, CallbackID);
+    void takeTiledSnapshot(WebCore::IntRect snapshotRect, uint32_t tileHeight, uint32_t options, uint64_t snapshotID);
+    void releaseSnapshotTile(uint64_t snapshotID, uint32_t bitmapIndex);
+    void cancelTiledSnapshot(uint64_t snapshotID);
 
     void preferencesDidChange(const WebPreferencesStore&);
+    void preferenceValuesDidChange(const WebPreferencesStore::Changes&);
     void platformPreferencesDidChange(const WebPreferencesStore&);
-    void updatePreferences(const WebPreferencesStore&);
+    void updatePreferences();
 
 #if PLATFORM(MAC)
     void didReceivePolicyDecision(uint64_t frameID, uint64_t listenerID, uint32_t policyAction, uint64_t navigationID, const DownloadID&);
@@ -1291,6 +1296,7 @@ private:
     void urlSchemeTaskDidComplete(uint64_t handlerIdentifier, uint64_t taskIdentifier, const WebCore::ResourceError&);
 
     RefPtr<WebImage> snapshotAtSize(const WebCore::IntRect&, const WebCore::IntSize& bitmapSize, SnapshotOptions);
+    void paintNextSnapshotTile(uint64_t snapshotID, uint32_t bitmapIndex);
     RefPtr<WebImage> snapshotNode(WebCore::Node&, SnapshotOptions, unsigned maximumPixelCount = std::numeric_limits<unsigned>::max());
 #if USE(CF)
     RetainPtr<CFDataRef> pdfSnapshotAtSize(const WebCore::IntRect&, const WebCore::IntSize& bitmapSize, SnapshotOptions);
@@ -1304,6 +1310,9 @@ private:
 
     RefPtr<WebPageGroupProxy> m_pageGroup;
 
+    // Keeps the main frame origin's localStorage alive so that its preloaded values are not thrown away before script uses them.
+    RefPtr<WebCore::StorageArea> m_preloadedLocalStorageArea;
+
     String m_userAgent;
 
     WebCore::IntSize m_viewSize;
@@ -1319,6 +1328,9 @@ private:
 
     WebCore::Color m_underlayColor;
 
+    // Preferences last received from the UI process. Their changed keys are the settings updatePreferences() still has to apply.
+    WebPreferencesStore m_preferencesStore;
+
     bool m_isInRedo { false };
     bool m_isClosed { false };
     bool m_tabToLinks { false };
@@ -1387,6 +1399,19 @@ private:
 
     HashMap<uint64_t, RefPtr<WebUndoStep>> m_undoStepMap;
 
+    // A snapshot painted a tile at a time into a few bitmaps, that are reused once the UI process releases them.
+    // The page keeps running between tiles, so the snapshot is not atomic; it fails if the contents size changes.
+    struct TiledSnapshot {
+        WebCore::IntRect rect;
+        uint32_t tileHeight;
+        SnapshotOptions options;
+        WebCore::IntSize contentsSize;
+        uint32_t tileCount;
+        uint32_t nextTileIndex { 0 };
+        Vector<RefPtr<WebImage>> images;
+    };
+    HashMap<uint64_t, std::unique_ptr<TiledSnapshot>> m_tiledSnapshots;
+
 #if ENABLE(CONTEXT_MENUS)
     std::unique_ptr<API::InjectedBundle::PageContextMenuClient> m_contextMenuClient;
 #endif
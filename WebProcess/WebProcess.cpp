@@ -251,6 +251,9 @@ void WebProcess::initializeWebProcess(WebProcessCreationParameters&& parameters)
 
     WebCore::setPresentingApplicationPID(parameters.presentingApplicationPID);
 
+    if (parameters.usesPackedIPCEncoding)
+        parentProcessConnection()->setEncodingFormat(IPC::EncodingFormat::Packed);
+
 #if OS(LINUX)
     if (parameters.memoryPressureMonitorHandle.fileDescriptor() != -1)
         MemoryPressureHandler::singleton().setMemoryPressureMonitorHandle(parameters.memoryPressureMonitorHandle.releaseFileDescriptor());
@@ -1029,6 +1032,12 @@ void WebProcess::getWebCoreStatistics(uint64_t callbackID)
     // Gather glyph page statistics.
     data.statisticsNumbers.set(ASCIILiteral("GlyphPageCount"), GlyphPage::count());
     
+    // Gather event coalescing statistics.
+    data.statisticsNumbers.set(ASCIILiteral("CoalescedWheelEventCount"), m_eventDispatcher->coalescedWheelEventCount());
+#if ENABLE(IOS_TOUCH_EVENTS)
+    data.statisticsNumbers.set(ASCIILiteral("CoalescedTouchEventCount"), m_eventDispatcher->coalescedTouchEventCount());
+#endif
+
     // Get WebCore memory cache statistics
     getWebCoreMemoryCacheStatistics(data.webCoreCacheStatistics);
     